@@ -0,0 +1,561 @@
+/**
+ * @file bench/RenderBench.cpp
+ * @brief Renders a scripted scene headless and reports the CPU frame timings as JSON, optionally against a baseline.
+ *
+ * Usage: jacRenderBench <scene> [--warmup N] [--frames M] [--output report.json]
+ *                       [--baseline baseline.json] [--threshold 0.10]
+ *        jacRenderBench <scene> --validate-culling <samples>
+ *
+ * The scene file is plain text, one "<key> <values...>" per line, '#' starts a comment:
+ *   model <path>                           model to load, repeatable, instances cycle through the models
+ *   instances <count>                      number of retained instances
+ *   layout grid <spacing> <scale>          square grid on the XZ plane
+ *   layout random <extent> <scale> <seed>  uniformly scattered on the XZ plane in [-extent, extent]
+ *   lights <count>                         point lights on a fixed circle above the scene
+ *   camera <x> <y> <z> <tx> <ty> <tz>      camera path keyframe, position then target
+ *   extent <width> <height>                size of the offscreen images
+ *   frames <warmup> <measured>             defaults for --warmup and --frames
+ *   gpu_driven | occlusion_culling | depth_prepass <0|1>, record_threads <count>   renderer config
+ *   staging_mb <size>                      staging ring size in MiB
+ *
+ * The camera moves along the keyframes by frame index, not by time, so every run renders the same frames.
+ * Exits with 1 when a percentile regressed past the threshold relative to the baseline, 2 on errors.
+ *
+ * --validate-culling renders the scene once with CPU frustum culling and once GPU-driven, stops the camera
+ * at evenly spaced points of its path and compares the visible mesh counts of both. Exits with 1 when they
+ * differ by more than MAX_CULLING_MISMATCH, e.g. in CI on lavapipe:
+ *   VK_ICD_FILENAMES=/usr/share/vulkan/icd.d/lvp_icd.x86_64.json jacRenderBench grid.scene --validate-culling 16
+ */
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <cstdlib>
+#include <filesystem>
+#include <format>
+#include <fstream>
+#include <optional>
+#include <print>
+#include <random>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include <glm/glm.hpp>
+#include <glm/gtc/constants.hpp>
+#include <glm/gtc/matrix_transform.hpp>
+
+#include "graphics/Renderer.hpp"
+
+namespace {
+
+using clock_type = std::chrono::steady_clock;
+
+// Differences below this are timer noise whatever the relative change
+constexpr double MIN_REGRESSION_MS = 0.05;
+
+// Relative to the tested meshes. Spheres grazing a plane may land on either side of it with the GPU's
+// float precision, and the CPU path rejects whole instances by their box before testing the spheres
+constexpr double MAX_CULLING_MISMATCH = 0.01;
+
+struct Keyframe {
+    glm::vec3 position;
+    glm::vec3 target;
+};
+
+struct Scene {
+    std::vector<std::filesystem::path> models{};
+    uint32_t instances{0};
+
+    enum class Layout { GRID, RANDOM } layout{Layout::GRID};
+    float spacing{1.f};     // Grid spacing or random extent
+    float scale{1.f};
+    uint32_t seed{0};
+
+    uint32_t lights{0};
+    std::vector<Keyframe> cameraPath{};
+
+    VkExtent2D extent{1280, 720};
+    uint32_t warmupFrames{60};
+    uint32_t measuredFrames{600};
+
+    graphics::Renderer::Config config{};
+};
+
+struct Summary {
+    double mean;
+    double p50;
+    double p95;
+    double p99;
+    double max;
+};
+
+// Per frame samples, named as in the JSON report
+struct Metric {
+    std::string_view name;
+    std::vector<double> samples{};
+};
+
+auto load_scene(const std::filesystem::path& path) -> Scene {
+    std::ifstream file(path);
+    if (!file) {
+        throw std::runtime_error("Failed to open scene file: " + path.string());
+    }
+
+    Scene scene{};
+    std::string line;
+    uint32_t lineNumber = 0;
+
+    while (std::getline(file, line)) {
+        lineNumber++;
+        line = line.substr(0, line.find('#'));
+
+        std::istringstream tokens(line);
+        std::string key;
+        if (!(tokens >> key)) {
+            continue;
+        }
+
+        if (key == "model") {
+            std::string model;
+            tokens >> model;
+            scene.models.emplace_back(model);
+        } else if (key == "instances") {
+            tokens >> scene.instances;
+        } else if (key == "layout") {
+            std::string kind;
+            tokens >> kind;
+            if (kind == "grid") {
+                scene.layout = Scene::Layout::GRID;
+                tokens >> scene.spacing >> scene.scale;
+            } else if (kind == "random") {
+                scene.layout = Scene::Layout::RANDOM;
+                tokens >> scene.spacing >> scene.scale >> scene.seed;
+            } else {
+                tokens.setstate(std::ios::failbit);
+            }
+        } else if (key == "lights") {
+            tokens >> scene.lights;
+        } else if (key == "camera") {
+            Keyframe keyframe{};
+            tokens >> keyframe.position.x >> keyframe.position.y >> keyframe.position.z
+                   >> keyframe.target.x >> keyframe.target.y >> keyframe.target.z;
+            scene.cameraPath.push_back(keyframe);
+        } else if (key == "extent") {
+            tokens >> scene.extent.width >> scene.extent.height;
+        } else if (key == "frames") {
+            tokens >> scene.warmupFrames >> scene.measuredFrames;
+        } else if (key == "gpu_driven") {
+            tokens >> scene.config.gpuDriven;
+        } else if (key == "occlusion_culling") {
+            tokens >> scene.config.occlusionCulling;
+        } else if (key == "depth_prepass") {
+            tokens >> scene.config.depthPrepass;
+        } else if (key == "record_threads") {
+            tokens >> scene.config.recordThreads;
+        } else if (key == "staging_mb") {
+            VkDeviceSize megabytes = 0;
+            tokens >> megabytes;
+            scene.config.stagingSize = megabytes << 20;
+        } else {
+            tokens.setstate(std::ios::failbit);
+        }
+
+        if (tokens.fail()) {
+            throw std::runtime_error(std::format("{}:{}: invalid line '{}'", path.string(), lineNumber, line));
+        }
+    }
+
+    if (scene.models.empty() || scene.cameraPath.empty()) {
+        throw std::runtime_error("Scene needs at least one model and one camera keyframe: " + path.string());
+    }
+
+    return scene;
+}
+
+auto make_transforms(const Scene& scene) -> std::vector<glm::mat4> {
+    std::vector<glm::mat4> transforms;
+    transforms.reserve(scene.instances);
+
+    const glm::mat4 base = glm::scale(glm::mat4{1.f}, glm::vec3{scene.scale});
+
+    if (scene.layout == Scene::Layout::GRID) {
+        const auto side = static_cast<uint32_t>(std::ceil(std::sqrt(static_cast<float>(scene.instances))));
+        const float offset = 0.5f * static_cast<float>(side - 1) * scene.spacing;
+
+        for (uint32_t i = 0; i < scene.instances; i++) {
+            const glm::vec3 position{
+                static_cast<float>(i % side) * scene.spacing - offset,
+                0.f,
+                static_cast<float>(i / side) * scene.spacing - offset
+            };
+            transforms.push_back(glm::translate(base, position));
+        }
+    } else {
+        std::mt19937 rng{scene.seed};
+        std::uniform_real_distribution<float> position{-scene.spacing, scene.spacing};
+        std::uniform_real_distribution<float> rotation{0.f, glm::two_pi<float>()};
+
+        for (uint32_t i = 0; i < scene.instances; i++) {
+            const glm::mat4 translated = glm::translate(base, glm::vec3{position(rng), 0.f, position(rng)});
+            transforms.push_back(glm::rotate(translated, rotation(rng), glm::vec3{0.f, 1.f, 0.f}));
+        }
+    }
+
+    return transforms;
+}
+
+// Camera at t in [0, 1] along the path, keyframes are evenly spaced
+auto sample_path(const std::vector<Keyframe>& path, float t) -> Keyframe {
+    if (path.size() == 1) {
+        return path.front();
+    }
+
+    const float position = std::clamp(t, 0.f, 1.f) * static_cast<float>(path.size() - 1);
+    const size_t index = std::min(static_cast<size_t>(position), path.size() - 2);
+    const float fraction = position - static_cast<float>(index);
+
+    return {
+        .position = glm::mix(path[index].position, path[index + 1].position, fraction),
+        .target = glm::mix(path[index].target, path[index + 1].target, fraction)
+    };
+}
+
+// Nearest-rank percentiles
+auto summarize(std::vector<double> samples) -> Summary {
+    if (samples.empty()) {
+        return {};
+    }
+
+    std::ranges::sort(samples);
+
+    const auto percentile = [&](double p) {
+        const auto rank = static_cast<size_t>(std::ceil(p / 100.0 * static_cast<double>(samples.size())));
+        return samples[std::clamp<size_t>(rank, 1, samples.size()) - 1];
+    };
+
+    double sum = 0.0;
+    for (const double sample : samples) {
+        sum += sample;
+    }
+
+    return {
+        .mean = sum / static_cast<double>(samples.size()),
+        .p50 = percentile(50.0),
+        .p95 = percentile(95.0),
+        .p99 = percentile(99.0),
+        .max = samples.back()
+    };
+}
+
+auto to_json(
+    const std::filesystem::path& scenePath,
+    const Scene& scene,
+    const std::vector<std::pair<std::string_view, Summary>>& metrics
+) -> std::string {
+    std::string json = std::format(
+        "{{\n  \"scene\": \"{}\",\n  \"headless\": true,\n  \"extent\": [{}, {}],\n"
+        "  \"instances\": {},\n  \"warmupFrames\": {},\n  \"frames\": {},\n  \"metrics\": {{\n",
+        scenePath.generic_string(), scene.extent.width, scene.extent.height,
+        scene.instances, scene.warmupFrames, scene.measuredFrames
+    );
+
+    for (size_t i = 0; i < metrics.size(); i++) {
+        const auto& [name, summary] = metrics[i];
+        json += std::format(
+            "    \"{}\": {{ \"mean\": {:.4f}, \"p50\": {:.4f}, \"p95\": {:.4f}, \"p99\": {:.4f}, \"max\": {:.4f} }}{}\n",
+            name, summary.mean, summary.p50, summary.p95, summary.p99, summary.max,
+            i + 1 < metrics.size() ? "," : ""
+        );
+    }
+
+    json += "  }\n}\n";
+    return json;
+}
+
+// Only reads reports written by to_json, finds "<stat>" inside the object following "<metric>"
+auto find_value(std::string_view json, std::string_view metric, std::string_view stat) -> std::optional<double> {
+    const size_t metricStart = json.find(std::format("\"{}\"", metric));
+    if (metricStart == std::string_view::npos) {
+        return std::nullopt;
+    }
+
+    const size_t objectEnd = json.find('}', metricStart);
+    const size_t statStart = json.find(std::format("\"{}\":", stat), metricStart);
+    if (statStart == std::string_view::npos || statStart > objectEnd) {
+        return std::nullopt;
+    }
+
+    const std::string value{json.substr(statStart + stat.size() + 3, 32)};
+    return std::strtod(value.c_str(), nullptr);
+}
+
+// Prints the comparison, returns the number of regressed values
+auto compare(
+    const std::filesystem::path& baselinePath,
+    const std::vector<std::pair<std::string_view, Summary>>& metrics,
+    double threshold
+) -> uint32_t {
+    std::ifstream file(baselinePath);
+    if (!file) {
+        throw std::runtime_error("Failed to open baseline: " + baselinePath.string());
+    }
+    const std::string baseline{std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>()};
+
+    std::println("\n{:<14} {:>5} {:>10} {:>10} {:>9}", "metric", "stat", "baseline", "current", "change");
+
+    uint32_t regressions = 0;
+    for (const auto& [name, summary] : metrics) {
+        const std::array<std::pair<std::string_view, double>, 3> stats{{
+            {"p50", summary.p50}, {"p95", summary.p95}, {"p99", summary.p99}
+        }};
+
+        for (const auto& [stat, current] : stats) {
+            const auto previous = find_value(baseline, name, stat);
+            if (!previous) {
+                std::println("{:<14} {:>5} {:>10} {:>10.3f}", name, stat, "-", current);
+                continue;
+            }
+
+            const double change = *previous > 0.0 ? current / *previous - 1.0 : 0.0;
+            const bool regressed = change > threshold && current - *previous > MIN_REGRESSION_MS;
+            regressions += regressed ? 1 : 0;
+
+            std::println(
+                "{:<14} {:>5} {:>10.3f} {:>10.3f} {:>+8.1f}%{}",
+                name, stat, *previous, current, 100.0 * change, regressed ? "  REGRESSION" : ""
+            );
+        }
+    }
+
+    return regressions;
+}
+
+// Models, instances & lights of the scene
+auto populate(graphics::Renderer& renderer, const Scene& scene) -> void {
+    std::vector<graphics::Renderer::ModelID> models;
+    for (const auto& path : scene.models) {
+        const auto model = renderer.loadModel(path);
+        if (!model) {
+            throw std::runtime_error("Failed to load model: " + path.string());
+        }
+        models.push_back(*model);
+    }
+
+    const auto transforms = make_transforms(scene);
+    for (size_t i = 0; i < transforms.size(); i++) {
+        [[maybe_unused]] const auto instance = renderer.createInstance(models[i % models.size()], transforms[i]);
+    }
+
+    for (uint32_t i = 0; i < scene.lights; i++) {
+        const float angle = glm::two_pi<float>() * static_cast<float>(i) / static_cast<float>(scene.lights);
+        renderer.getLightingSystem().addPointLight({
+            .position = {10.f * std::cos(angle), 5.f, 10.f * std::sin(angle)},
+            .color = {1.0f, 1.0f, 1.0f},
+            .intensity = 10.0f,
+            .decay = 2.0f
+        });
+    }
+}
+
+// Culling counts with the camera stopped at evenly spaced points of the path
+auto cull_counts(const Scene& scene, const graphics::Renderer::Config& config, uint32_t samples) -> std::vector<systems::CullingStats> {
+    graphics::Renderer renderer(config);
+    populate(renderer, scene);
+
+    auto& camera = renderer.getCamera();
+    std::vector<systems::CullingStats> counts;
+    counts.reserve(samples);
+
+    for (uint32_t sample = 0; sample < samples; sample++) {
+        const float t = samples > 1 ? static_cast<float>(sample) / static_cast<float>(samples - 1) : 0.f;
+        const auto keyframe = sample_path(scene.cameraPath, t);
+        camera.lookAt(keyframe.position, keyframe.target);
+
+        // The GPU counts are read back when the frame's resources come around again, frameCount frames later
+        for (uint32_t frame = 0; frame <= config.frameCount; frame++) {
+            renderer.render();
+        }
+        counts.push_back(renderer.getCullingStats());
+    }
+    renderer.waitIdle();
+
+    return counts;
+}
+
+auto validate_culling(const std::filesystem::path& scenePath, Scene scene, uint32_t samples) -> int {
+    scene.config.extent = scene.extent;
+    scene.config.instanceCapacity = std::max(scene.config.instanceCapacity, scene.instances);
+    scene.config.frustumCulling = true;
+    scene.config.occlusionCulling = false;
+    scene.config.softwareOcclusion = false;
+
+    auto cpuConfig = scene.config;
+    cpuConfig.gpuDriven = false;
+    auto gpuConfig = scene.config;
+    gpuConfig.gpuDriven = true;
+
+    const auto cpu = cull_counts(scene, cpuConfig, samples);
+    const auto gpu = cull_counts(scene, gpuConfig, samples);
+
+    std::println("{}: {} instances, CPU & GPU frustum culling at {} camera positions", scenePath.string(), scene.instances, samples);
+    std::println("\n{:>6} {:>10} {:>10} {:>10} {:>10}", "sample", "tested", "cpu", "gpu", "gpu - cpu");
+
+    uint32_t mismatches = 0;
+    for (uint32_t i = 0; i < samples; i++) {
+        // Both count every (instance, mesh) pair once, visible or culled
+        const uint32_t tested = cpu[i].visible + cpu[i].frustumCulled;
+        const uint32_t difference = cpu[i].visible > gpu[i].visible
+            ? cpu[i].visible - gpu[i].visible
+            : gpu[i].visible - cpu[i].visible;
+
+        const bool mismatch = tested != gpu[i].visible + gpu[i].frustumCulled
+            || static_cast<double>(difference) > MAX_CULLING_MISMATCH * static_cast<double>(tested);
+        mismatches += mismatch ? 1 : 0;
+
+        std::println(
+            "{:>6} {:>10} {:>10} {:>10} {:>+10}{}",
+            i, tested, cpu[i].visible, gpu[i].visible,
+            static_cast<int64_t>(gpu[i].visible) - static_cast<int64_t>(cpu[i].visible),
+            mismatch ? "  MISMATCH" : ""
+        );
+    }
+
+    if (mismatches > 0) {
+        std::println("\n{} of {} samples differ by more than {:.0f}%", mismatches, samples, 100.0 * MAX_CULLING_MISMATCH);
+        return 1;
+    }
+    return 0;
+}
+
+auto run(
+    const std::filesystem::path& scenePath,
+    Scene scene,
+    const std::optional<std::filesystem::path>& outputPath,
+    const std::optional<std::filesystem::path>& baselinePath,
+    double threshold
+) -> int {
+    scene.config.extent = scene.extent;
+    scene.config.instanceCapacity = std::max(scene.config.instanceCapacity, scene.instances);
+
+    graphics::Renderer renderer(scene.config);
+    populate(renderer, scene);
+
+    // Warm-up frames stay on the first keyframe, pipelines & caches settle before measuring
+    auto& camera = renderer.getCamera();
+    camera.lookAt(scene.cameraPath.front().position, scene.cameraPath.front().target);
+    for (uint32_t frame = 0; frame < scene.warmupFrames; frame++) {
+        renderer.render();
+    }
+
+    std::array<Metric, 4> metrics{{{"frame_ms"}, {"record_ms"}, {"submit_ms"}, {"fence_wait_ms"}}};
+    for (auto& metric : metrics) {
+        metric.samples.reserve(scene.measuredFrames);
+    }
+
+    for (uint32_t frame = 0; frame < scene.measuredFrames; frame++) {
+        const float t = scene.measuredFrames > 1
+            ? static_cast<float>(frame) / static_cast<float>(scene.measuredFrames - 1)
+            : 0.f;
+        const auto keyframe = sample_path(scene.cameraPath, t);
+        camera.lookAt(keyframe.position, keyframe.target);
+
+        const auto start = clock_type::now();
+        renderer.render();
+        const std::chrono::duration<double, std::milli> duration = clock_type::now() - start;
+
+        const auto& timings = renderer.getFrameTimings();
+        metrics[0].samples.push_back(duration.count());
+        metrics[1].samples.push_back(timings.recordMs);
+        metrics[2].samples.push_back(timings.submitMs);
+        metrics[3].samples.push_back(timings.waitMs);
+    }
+    renderer.waitIdle();
+
+    std::vector<std::pair<std::string_view, Summary>> summaries;
+    for (const auto& metric : metrics) {
+        summaries.emplace_back(metric.name, summarize(metric.samples));
+    }
+
+    std::println("{}: {} instances, {} warm-up + {} measured frames at {}x{}",
+        scenePath.string(), scene.instances, scene.warmupFrames, scene.measuredFrames,
+        scene.extent.width, scene.extent.height);
+    for (const auto& [name, summary] : summaries) {
+        std::println("  {:<14} mean {:8.3f}  p50 {:8.3f}  p95 {:8.3f}  p99 {:8.3f}  max {:8.3f} ms",
+            name, summary.mean, summary.p50, summary.p95, summary.p99, summary.max);
+    }
+
+    if (outputPath) {
+        std::ofstream output(*outputPath);
+        if (!output) {
+            throw std::runtime_error("Failed to write report: " + outputPath->string());
+        }
+        output << to_json(scenePath, scene, summaries);
+    }
+
+    if (baselinePath) {
+        const uint32_t regressions = compare(*baselinePath, summaries, threshold);
+        if (regressions > 0) {
+            std::println("\n{} values regressed by more than {:.0f}%", regressions, 100.0 * threshold);
+            return 1;
+        }
+    }
+
+    return 0;
+}
+
+} // namespace
+
+auto main(int argc, char** argv) -> int {
+    if (argc < 2) {
+        std::println(stderr, "Usage: {} <scene> [--warmup N] [--frames M] [--output report.json] "
+                             "[--baseline baseline.json] [--threshold 0.10]\n"
+                             "       {} <scene> --validate-culling <samples>", argv[0], argv[0]);
+        return 2;
+    }
+
+    try {
+        const std::filesystem::path scenePath{argv[1]};
+        Scene scene = load_scene(scenePath);
+
+        std::optional<std::filesystem::path> outputPath;
+        std::optional<std::filesystem::path> baselinePath;
+        double threshold = 0.10;
+        uint32_t cullingSamples = 0;
+
+        for (int i = 2; i < argc; i += 2) {
+            const std::string_view option{argv[i]};
+            if (i + 1 >= argc) {
+                throw std::invalid_argument(std::format("Missing value for '{}'", option));
+            }
+            const char* value = argv[i + 1];
+
+            if (option == "--warmup") {
+                scene.warmupFrames = static_cast<uint32_t>(std::stoul(value));
+            } else if (option == "--frames") {
+                scene.measuredFrames = static_cast<uint32_t>(std::stoul(value));
+            } else if (option == "--output") {
+                outputPath = value;
+            } else if (option == "--baseline") {
+                baselinePath = value;
+            } else if (option == "--threshold") {
+                threshold = std::stod(value);
+            } else if (option == "--validate-culling") {
+                cullingSamples = static_cast<uint32_t>(std::stoul(value));
+            } else {
+                throw std::invalid_argument(std::format("Unknown option '{}'", option));
+            }
+        }
+
+        if (cullingSamples > 0) {
+            return validate_culling(scenePath, std::move(scene), cullingSamples);
+        }
+        return run(scenePath, std::move(scene), outputPath, baselinePath, threshold);
+    } catch (const std::exception& e) {
+        std::println(stderr, "{}", e.what());
+        return 2;
+    }
+}
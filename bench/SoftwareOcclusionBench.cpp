@@ -0,0 +1,176 @@
+/**
+ * @file bench/SoftwareOcclusionBench.cpp
+ * @brief Checks systems::SoftwareOcclusion against known visible/occluded boxes and times rasterization & queries.
+ *
+ * Usage: softwareOcclusionBench [occluder count] [query count]   (default 2000 100000)
+ */
+#include <chrono>
+#include <cstdlib>
+#include <print>
+#include <random>
+#include <thread>
+#include <vector>
+
+#include <glm/glm.hpp>
+#include <glm/gtc/matrix_transform.hpp>
+
+#include "systems/SoftwareOcclusion.hpp"
+#include "systems/JobSystem.hpp"
+
+namespace {
+
+using systems::SoftwareOcclusion;
+using clock_type = std::chrono::steady_clock;
+
+constexpr uint32_t RASTERIZE_RUNS = 20;
+
+template <typename F>
+[[nodiscard]]
+auto measure_ms(F&& function) -> double {
+    const auto start = clock_type::now();
+    function();
+    return std::chrono::duration<double, std::milli>(clock_type::now() - start).count();
+}
+
+// Unit cube centered on the origin, 12 triangles
+const std::vector<glm::vec3> CUBE_POSITIONS{
+    {-0.5f, -0.5f, -0.5f}, { 0.5f, -0.5f, -0.5f}, { 0.5f,  0.5f, -0.5f}, {-0.5f,  0.5f, -0.5f},
+    {-0.5f, -0.5f,  0.5f}, { 0.5f, -0.5f,  0.5f}, { 0.5f,  0.5f,  0.5f}, {-0.5f,  0.5f,  0.5f}
+};
+
+const std::vector<uint32_t> CUBE_INDICES{
+    0, 2, 1,  0, 3, 2,      // -z
+    4, 5, 6,  4, 6, 7,      // +z
+    0, 1, 5,  0, 5, 4,      // -y
+    3, 6, 2,  3, 7, 6,      // +y
+    0, 4, 7,  0, 7, 3,      // -x
+    1, 2, 6,  1, 6, 5       // +x
+};
+
+[[nodiscard]]
+auto box(const glm::vec3& center, const glm::vec3& size) -> glm::mat4 {
+    return glm::scale(glm::translate(glm::mat4{1.f}, center), size);
+}
+
+[[nodiscard]]
+auto view_projection() -> glm::mat4 {
+    return
+        glm::perspective(glm::radians(60.f), 16.f / 9.f, 0.5f, 1000.f) *
+        glm::lookAt(glm::vec3{0.f}, glm::vec3{0.f, 0.f, -1.f}, glm::vec3{0.f, 1.f, 0.f});
+}
+
+// A wall in front of the camera, then boxes that are clearly hidden or clearly visible
+auto validate(systems::JobSystem& jobSystem) -> bool {
+    SoftwareOcclusion occlusion;
+    occlusion.begin(view_projection());
+    occlusion.addOccluder(box({0.f, 0.f, -20.f}, {30.f, 20.f, 1.f}), CUBE_POSITIONS, CUBE_INDICES);
+    occlusion.rasterize(&jobSystem);
+
+    const glm::vec3 unitMin{-0.5f};
+    const glm::vec3 unitMax{0.5f};
+
+    struct Case {
+        const char* name;
+        glm::mat4 transform;
+        bool occluded;
+    };
+
+    const std::vector<Case> cases{
+        {"behind the wall",             box({0.f, 0.f, -40.f}, glm::vec3{2.f}),    true},
+        {"far behind the wall",         box({3.f, -2.f, -400.f}, glm::vec3{20.f}), true},
+        {"in front of the wall",        box({0.f, 0.f, -10.f}, glm::vec3{2.f}),    false},
+        {"past the wall edge",          box({30.f, 0.f, -40.f}, glm::vec3{6.f}),   false},
+        {"crossing the near plane",     box({0.f, 0.f, 0.f}, glm::vec3{2.f}),      false},
+        {"intersecting the wall",       box({0.f, 0.f, -20.f}, glm::vec3{2.f}),    false},
+        {"just behind the wall",        box({0.f, 0.f, -21.f}, glm::vec3{2.f}),    true}
+    };
+
+    bool valid = true;
+    for (const auto& [name, transform, occluded] : cases) {
+        if (occlusion.isOccluded(transform, unitMin, unitMax) != occluded) {
+            std::println("  MISMATCH: box {} should be {}", name, occluded ? "occluded" : "visible");
+            valid = false;
+        }
+    }
+
+    // Banded rasterization must produce the exact same depth as a single band
+    SoftwareOcclusion serial;
+    serial.begin(view_projection());
+    serial.addOccluder(box({0.f, 0.f, -20.f}, {30.f, 20.f, 1.f}), CUBE_POSITIONS, CUBE_INDICES);
+    serial.rasterize();
+
+    if (!std::ranges::equal(serial.getDepth(), occlusion.getDepth())) {
+        std::println("  MISMATCH: banded and serial depth differ");
+        valid = false;
+    }
+
+    return valid;
+}
+
+auto run(systems::JobSystem& jobSystem, uint32_t occluderCount, uint32_t queryCount) -> void {
+    std::mt19937 rng{occluderCount};
+    std::uniform_real_distribution<float> spread{-60.f, 60.f};
+    std::uniform_real_distribution<float> distance{-200.f, -10.f};
+    std::uniform_real_distribution<float> size{1.f, 8.f};
+
+    std::vector<glm::mat4> occluders(occluderCount);
+    for (auto& transform : occluders) {
+        transform = box({spread(rng), spread(rng) * 0.5f, distance(rng)}, {size(rng), size(rng), size(rng)});
+    }
+
+    SoftwareOcclusion occlusion;
+
+    const double setupMs = measure_ms([&] {
+        occlusion.begin(view_projection());
+        for (const auto& transform : occluders) {
+            occlusion.addOccluder(transform, CUBE_POSITIONS, CUBE_INDICES);
+        }
+    });
+
+    const double serialMs = measure_ms([&] {
+        for (uint32_t i = 0; i < RASTERIZE_RUNS; i++) {
+            occlusion.rasterize();
+        }
+    }) / RASTERIZE_RUNS;
+
+    const double parallelMs = measure_ms([&] {
+        for (uint32_t i = 0; i < RASTERIZE_RUNS; i++) {
+            occlusion.rasterize(&jobSystem);
+        }
+    }) / RASTERIZE_RUNS;
+
+    std::vector<glm::mat4> queries(queryCount);
+    for (auto& transform : queries) {
+        transform = box({spread(rng), spread(rng) * 0.5f, distance(rng) * 2.f}, glm::vec3{size(rng) * 0.5f});
+    }
+
+    size_t occludedCount = 0;
+    const double queryMs = measure_ms([&] {
+        for (const auto& transform : queries) {
+            occludedCount += occlusion.isOccluded(transform, glm::vec3{-0.5f}, glm::vec3{0.5f}) ? 1 : 0;
+        }
+    });
+
+    std::println(
+        "{} occluders, {} triangles after clipping, {}x{} depth",
+        occluderCount, occlusion.getTriangleCount(), occlusion.getWidth(), occlusion.getHeight()
+    );
+    std::println("  setup     {:10.3f} ms", setupMs);
+    std::println("  rasterize {:10.3f} ms   {} bands {:10.3f} ms", serialMs, jobSystem.getWorkerCount() + 1, parallelMs);
+    std::println("  queries   {:10.3f} ms   ({} of {} occluded)", queryMs, occludedCount, queryCount);
+}
+
+} // namespace
+
+auto main(int argc, char** argv) -> int
+{
+    const uint32_t occluderCount = argc > 1 ? static_cast<uint32_t>(std::strtoul(argv[1], nullptr, 10)) : 2000;
+    const uint32_t queryCount = argc > 2 ? static_cast<uint32_t>(std::strtoul(argv[2], nullptr, 10)) : 100'000;
+
+    systems::JobSystem jobSystem{std::max(std::thread::hardware_concurrency(), 2u) - 1};
+
+    const bool valid = validate(jobSystem);
+    run(jobSystem, occluderCount, queryCount);
+
+    return valid ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -0,0 +1,260 @@
+/**
+ * @file bench/SpatialIndexBench.cpp
+ * @brief Compares build, refit, incremental update and query cost of systems::SpatialIndex against brute force loops.
+ *
+ * Usage: spatialIndexBench [instance counts...]   (default 10000 100000 1000000)
+ */
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <print>
+#include <random>
+#include <vector>
+
+#include <glm/glm.hpp>
+#include <glm/gtc/matrix_transform.hpp>
+
+#include "systems/SpatialIndex.hpp"
+
+namespace {
+
+using systems::SpatialIndex;
+using clock_type = std::chrono::steady_clock;
+
+constexpr uint32_t QUERY_COUNT = 1000;
+constexpr uint32_t CHURN_BATCH = 16;    // Instances created or destroyed between two commits
+
+template <typename F>
+[[nodiscard]]
+auto measure_ms(F&& function) -> double {
+    const auto start = clock_type::now();
+    function();
+    return std::chrono::duration<double, std::milli>(clock_type::now() - start).count();
+}
+
+[[nodiscard]]
+auto make_frustum(const glm::mat4& viewProj) -> SpatialIndex::Frustum {
+    const auto row = [&](int i) { return glm::vec4{viewProj[0][i], viewProj[1][i], viewProj[2][i], viewProj[3][i]}; };
+
+    SpatialIndex::Frustum planes{
+        row(3) + row(0), row(3) - row(0),
+        row(3) + row(1), row(3) - row(1),
+        row(3) + row(2), row(3) - row(2)
+    };
+
+    for (auto& plane : planes) {
+        plane /= glm::length(glm::vec3{plane});
+    }
+    return planes;
+}
+
+[[nodiscard]]
+auto outside(const SpatialIndex::Frustum& frustum, const SpatialIndex::AABB& box) -> bool {
+    for (const auto& plane : frustum) {
+        const glm::vec3 normal{plane};
+        const glm::vec3 positive = glm::mix(box.min, box.max, glm::greaterThanEqual(normal, glm::vec3{0.f}));
+        if (glm::dot(normal, positive) + plane.w < 0.f) {
+            return true;
+        }
+    }
+    return false;
+}
+
+[[nodiscard]]
+auto touches(const glm::vec3& center, float radius, const SpatialIndex::AABB& box) -> bool {
+    const glm::vec3 offset = glm::clamp(center, box.min, box.max) - center;
+    return glm::dot(offset, offset) <= radius * radius;
+}
+
+[[nodiscard]]
+auto ray_distance(const glm::vec3& origin, const glm::vec3& inverseDirection, const SpatialIndex::AABB& box) -> float {
+    const glm::vec3 t0 = (box.min - origin) * inverseDirection;
+    const glm::vec3 t1 = (box.max - origin) * inverseDirection;
+    const glm::vec3 tNear = glm::min(t0, t1);
+    const glm::vec3 tFar = glm::max(t0, t1);
+
+    const float enter = std::max({tNear.x, tNear.y, tNear.z, 0.f});
+    const float exit = std::min({tFar.x, tFar.y, tFar.z});
+    return enter <= exit ? enter : std::numeric_limits<float>::max();
+}
+
+auto run(uint32_t instanceCount) -> bool {
+    std::mt19937 rng{instanceCount};
+
+    // Constant density, the world grows with the instance count
+    const float worldSize = 4.f * std::cbrt(static_cast<float>(instanceCount));
+    std::uniform_real_distribution<float> position{-worldSize, worldSize};
+    std::uniform_real_distribution<float> jitter{-0.5f, 0.5f};
+
+    const SpatialIndex::AABB unitBox{glm::vec3{-0.5f}, glm::vec3{0.5f}};
+
+    std::vector<glm::mat4> transforms(instanceCount, glm::mat4{1.f});
+    std::vector<SpatialIndex::AABB> bounds(instanceCount);
+    for (uint32_t i = 0; i < instanceCount; i++) {
+        transforms[i][3] = glm::vec4{position(rng), position(rng), position(rng), 1.f};
+        bounds[i] = SpatialIndex::transform(unitBox, transforms[i]);
+    }
+
+    SpatialIndex index;
+    std::vector<SpatialIndex::Handle> handles(instanceCount);
+
+    const double buildMs = measure_ms([&] {
+        for (uint32_t i = 0; i < instanceCount; i++) {
+            handles[i] = index.insert(bounds[i]);
+        }
+        index.commit();
+    });
+
+    // Small per-frame motion of every instance, refitted then rebuilt for comparison
+    for (uint32_t i = 0; i < instanceCount; i++) {
+        transforms[i][3] += glm::vec4{jitter(rng), jitter(rng), jitter(rng), 0.f};
+        bounds[i] = SpatialIndex::transform(unitBox, transforms[i]);
+    }
+
+    const double refitMs = measure_ms([&] {
+        for (uint32_t i = 0; i < instanceCount; i++) {
+            index.setBounds(handles[i], bounds[i]);
+        }
+        index.refit();
+    });
+    const double rebuildMs = measure_ms([&] { index.build(); });
+
+    // Frustum query from the world corner looking at the center
+    const glm::mat4 viewProj =
+        glm::perspective(glm::radians(60.f), 16.f / 9.f, 0.5f, worldSize * 2.f) *
+        glm::lookAt(glm::vec3{worldSize}, glm::vec3{0.f}, glm::vec3{0.f, 1.f, 0.f});
+    const auto frustum = make_frustum(viewProj);
+
+    std::vector<SpatialIndex::Handle> results;
+    results.reserve(instanceCount);
+
+    const double frustumMs = measure_ms([&] { index.queryFrustum(frustum, results); });
+    const size_t frustumHits = results.size();
+
+    size_t bruteFrustumHits = 0;
+    const double bruteFrustumMs = measure_ms([&] {
+        for (const auto& box : bounds) {
+            bruteFrustumHits += outside(frustum, box) ? 0 : 1;
+        }
+    });
+
+    // Sphere queries the size of a point light range
+    std::vector<glm::vec3> centers(QUERY_COUNT);
+    for (auto& center : centers) {
+        center = {position(rng), position(rng), position(rng)};
+    }
+    constexpr float radius = 8.f;
+
+    size_t sphereHits = 0;
+    const double sphereMs = measure_ms([&] {
+        for (const auto& center : centers) {
+            results.clear();
+            index.querySphere(center, radius, results);
+            sphereHits += results.size();
+        }
+    });
+
+    size_t bruteSphereHits = 0;
+    const double bruteSphereMs = measure_ms([&] {
+        for (const auto& center : centers) {
+            for (const auto& box : bounds) {
+                bruteSphereHits += touches(center, radius, box) ? 1 : 0;
+            }
+        }
+    });
+
+    // Picking rays from the camera position towards random points
+    std::vector<glm::vec3> directions(QUERY_COUNT);
+    for (size_t i = 0; i < QUERY_COUNT; i++) {
+        directions[i] = glm::normalize(centers[i] - glm::vec3{worldSize});
+    }
+
+    uint32_t rayMismatches = 0;
+    std::vector<float> rayDistances(QUERY_COUNT, std::numeric_limits<float>::max());
+    const double rayMs = measure_ms([&] {
+        for (size_t i = 0; i < QUERY_COUNT; i++) {
+            if (const auto hit = index.queryRay(glm::vec3{worldSize}, directions[i])) {
+                rayDistances[i] = hit->distance;
+            }
+        }
+    });
+
+    const double bruteRayMs = measure_ms([&] {
+        for (size_t i = 0; i < QUERY_COUNT; i++) {
+            const glm::vec3 inverseDirection = 1.f / directions[i];
+            float closest = std::numeric_limits<float>::max();
+            for (const auto& box : bounds) {
+                closest = std::min(closest, ray_distance(glm::vec3{worldSize}, inverseDirection, box));
+            }
+            rayMismatches += closest != rayDistances[i] ? 1 : 0;
+        }
+    });
+
+    // 1% of the instances added then removed again in commits of CHURN_BATCH, placed like the others
+    const uint32_t churnCount = std::max(instanceCount / 100, 1u);
+    std::vector<SpatialIndex::Handle> churned(churnCount);
+
+    const double insertMs = measure_ms([&] {
+        for (uint32_t i = 0; i < churnCount; i++) {
+            const glm::vec3 center{position(rng), position(rng), position(rng)};
+            churned[i] = index.insert({center - unitBox.max, center + unitBox.max});
+            if ((i + 1) % CHURN_BATCH == 0) {
+                index.commit();
+            }
+        }
+        index.commit();
+    });
+
+    const double removeMs = measure_ms([&] {
+        for (uint32_t i = 0; i < churnCount; i++) {
+            index.remove(churned[i]);
+            if ((i + 1) % CHURN_BATCH == 0) {
+                index.commit();
+            }
+        }
+        index.commit();
+    });
+
+    // Back to the original instances, the frustum has to see the same ones
+    results.clear();
+    index.queryFrustum(frustum, results);
+    const size_t churnFrustumHits = results.size();
+
+    std::println("{} instances, {} nodes", instanceCount, index.getNodeCount());
+    std::println("  build   {:10.3f} ms   refit {:10.3f} ms   rebuild {:10.3f} ms", buildMs, refitMs, rebuildMs);
+    std::println("  frustum {:10.3f} ms   brute {:10.3f} ms   ({} visible)", frustumMs, bruteFrustumMs, frustumHits);
+    std::println("  sphere  {:10.3f} ms   brute {:10.3f} ms   ({} queries)", sphereMs, bruteSphereMs, QUERY_COUNT);
+    std::println("  ray     {:10.3f} ms   brute {:10.3f} ms   ({} queries)", rayMs, bruteRayMs, QUERY_COUNT);
+    std::println("  insert  {:10.3f} ms   remove {:9.3f} ms   ({} instances, {} per commit)", insertMs, removeMs, churnCount, CHURN_BATCH);
+
+    const bool valid =
+        frustumHits == bruteFrustumHits && sphereHits == bruteSphereHits && rayMismatches == 0 &&
+        churnFrustumHits == frustumHits;
+    if (!valid) {
+        std::println(
+            "  MISMATCH: frustum {}/{}, sphere {}/{}, rays {}, frustum after churn {}",
+            frustumHits, bruteFrustumHits, sphereHits, bruteSphereHits, rayMismatches, churnFrustumHits
+        );
+    }
+    return valid;
+}
+
+} // namespace
+
+auto main(int argc, char** argv) -> int
+{
+    std::vector<uint32_t> counts{10'000, 100'000, 1'000'000};
+    if (argc > 1) {
+        counts.clear();
+        for (int i = 1; i < argc; i++) {
+            counts.push_back(static_cast<uint32_t>(std::strtoul(argv[i], nullptr, 10)));
+        }
+    }
+
+    bool valid = true;
+    for (const uint32_t count : counts) {
+        valid &= run(count);
+    }
+
+    return valid ? EXIT_SUCCESS : EXIT_FAILURE;
+}
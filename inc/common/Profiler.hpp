@@ -0,0 +1,96 @@
+/**
+ * @file common/Profiler.hpp
+ * @brief CPU instrumentation zones (PROFILE_SCOPE) recorded per thread and exported as a Chrome trace.
+ *
+ * Zones are only recorded when built with ENABLE_PROFILING, otherwise PROFILE_SCOPE expands to nothing.
+ * The trace opens in chrome://tracing and https://ui.perfetto.dev.
+ */
+#pragma once
+
+#include <atomic>
+#include <array>
+#include <chrono>
+#include <cstdint>
+#include <filesystem>
+
+namespace common {
+
+class Profiler {
+public:
+    // Zones kept per thread, the oldest ones are overwritten
+    static constexpr size_t RING_CAPACITY = 1 << 16;
+
+    struct Zone {
+        const char* name;   // String literal, only the pointer is stored
+        uint64_t start;     // Nanoseconds since the profiler started
+        uint64_t end;
+    };
+
+    [[nodiscard]]
+    static auto now() noexcept -> uint64_t {
+        return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::steady_clock::now() - epoch()
+        ).count());
+    }
+
+    /// @brief Append a zone to the ring buffer of the calling thread, lock-free after the thread's first zone
+    static auto record(const char* name, uint64_t start, uint64_t end) noexcept -> void;
+
+    /**
+     * @brief Write the zones of every thread as Chrome trace event JSON
+     *
+     * Zones recorded while writing may be torn, dump between frames or once the threads are idle.
+     */
+    static auto writeChromeTrace(const std::filesystem::path& path) -> void;
+
+    /// @brief Write the trace to path when the program exits
+    static auto dumpOnExit(const std::filesystem::path& path) -> void;
+private:
+    // Written by its thread only, read by writeChromeTrace
+    struct ThreadBuffer {
+        uint32_t threadIndex;
+        std::atomic<uint64_t> count{0};
+        std::array<Zone, RING_CAPACITY> zones{};
+    };
+
+    [[nodiscard]]
+    static auto epoch() noexcept -> std::chrono::steady_clock::time_point {
+        static const auto start = std::chrono::steady_clock::now();
+        return start;
+    }
+
+    struct Registry;
+    static auto registry() -> Registry&;
+    static auto register_thread() -> ThreadBuffer&;
+};
+
+/// @brief Records the time between its construction and destruction as a zone
+class ProfileScope {
+public:
+    explicit ProfileScope(const char* name) noexcept
+    : m_name(name)
+    , m_start(Profiler::now())
+    {}
+
+    ~ProfileScope() { Profiler::record(m_name, m_start, Profiler::now()); }
+
+    ProfileScope(const ProfileScope&) = delete;
+    ProfileScope(ProfileScope&&) = delete;
+    auto operator=(const ProfileScope&) -> ProfileScope& = delete;
+    auto operator=(ProfileScope&&) -> ProfileScope& = delete;
+private:
+    const char* m_name;
+    uint64_t m_start;
+};
+
+} // namespace common
+
+#define JAC_PROFILE_CONCAT_IMPL(a, b) a##b
+#define JAC_PROFILE_CONCAT(a, b) JAC_PROFILE_CONCAT_IMPL(a, b)
+
+#ifdef ENABLE_PROFILING
+    // Time the rest of the enclosing scope, name must be a string literal
+    #define PROFILE_SCOPE(name) const ::common::ProfileScope JAC_PROFILE_CONCAT(profileScope_, __LINE__){name}
+#else
+    #define PROFILE_SCOPE(name)
+#endif
@@ -6,20 +6,55 @@
 
 #include <vulkan/vulkan.h>
 
+#include <array>
+#include <cstddef>
+#include <span>
+#include <string_view>
+#include <vector>
+
 #include "core/memory/Buffer.hpp"
 #include "core/memory/Image.hpp"
 #include "vulkan/utils.hpp"
 #include "core/commands/Command.hpp"
+#include "core/commands/GpuProfiler.hpp"
 
 #include "core/pipeline/Pipeline.hpp"
+#include "core/pipeline/ComputePipeline.hpp"
 
 namespace core::commands {
 
 class CommandBuffer {
 public:
+    /// @brief Counters of the commands recorded since the last begin()
+    struct Stats {
+        uint32_t issued{0};             // Forwarded to Vulkan
+        uint32_t skipped{0};            // Dropped as redundant
+        uint32_t drawCalls{0};          // Direct & indirect draw commands
+        uint32_t instances{0};          // Of direct draws, indirect draws are counted by the GPU only
+        uint64_t triangles{0};          // Of direct draws
+        uint32_t pipelineBinds{0};
+        uint32_t descriptorBinds{0};
+        uint32_t bufferBinds{0};
+        uint64_t bytesCopied{0};        // Buffer to buffer & buffer to image copies
+
+        auto operator+=(const Stats& other) noexcept -> Stats& {
+            issued += other.issued;
+            skipped += other.skipped;
+            drawCalls += other.drawCalls;
+            instances += other.instances;
+            triangles += other.triangles;
+            pipelineBinds += other.pipelineBinds;
+            descriptorBinds += other.descriptorBinds;
+            bufferBinds += other.bufferBinds;
+            bytesCopied += other.bytesCopied;
+            return *this;
+        }
+    };
+
     CommandBuffer(
         VkDevice,
-        VkCommandPool);
+        VkCommandPool,
+        VkCommandBufferLevel = VK_COMMAND_BUFFER_LEVEL_PRIMARY);
     CommandBuffer(CommandBuffer&&);
     ~CommandBuffer();
 
@@ -33,18 +68,38 @@ public:
     auto reset() -> void;
 
     auto begin(bool oneTimeSubmit = false) -> void;
+    /// @brief Begin a secondary command buffer that continues the render pass described by inheritanceInfo
+    auto begin(const VkCommandBufferInheritanceInfo& inheritanceInfo) -> void;
     auto end() -> void;
 
     auto beginRenderPass(
         const VkRenderPass&,
         const VkFramebuffer&,
         const VkExtent2D&,
-        const vulkan::ClearColor& = vulkan::get_default<vulkan::ClearColor>()) -> void;
+        const vulkan::ClearColor& = vulkan::get_default<vulkan::ClearColor>(),
+        VkSubpassContents = VK_SUBPASS_CONTENTS_INLINE) -> void;
+    /// @brief Begin a render pass with one clear value per attachment, in attachment order
+    auto beginRenderPass(
+        VkRenderPass renderPass,
+        VkFramebuffer frameBuffer,
+        const VkExtent2D& extent,
+        std::span<const VkClearValue> clearValues,
+        VkSubpassContents contents = VK_SUBPASS_CONTENTS_INLINE) -> void;
     auto endRenderPass() -> void;
 
+    /// @brief Execute secondary command buffers from this primary command buffer
+    auto execute(const std::vector<VkCommandBuffer>& secondaryBuffers) -> void;
+
     auto bind(const pipeline::Pipeline&) -> void;
+    auto bind(const pipeline::ComputePipeline&) -> void;
     auto bind(const memory::Buffer&) -> void;
-    auto bind(const VkDescriptorSet&, const VkPipelineLayout&) -> void;
+    /// @brief Bind a descriptor set, binds with dynamic offsets are never skipped as redundant
+    auto bind(
+        const VkDescriptorSet&,
+        const VkPipelineLayout&,
+        uint32_t set = 0,
+        VkPipelineBindPoint = VK_PIPELINE_BIND_POINT_GRAPHICS,
+        std::span<const uint32_t> dynamicOffsets = {}) -> void;
     auto bindDescriptorSets(
         const std::vector<VkDescriptorSet>& descriptorSets,
         const VkPipelineLayout& pipelineLayout,
@@ -74,6 +129,12 @@ public:
         VkDeviceSize srcOffset = 0,
         VkDeviceSize dstOffset = 0) -> void;
 
+    /// @brief Record a single command copying several regions between two buffers
+    auto copy(
+        memory::Buffer& srcBuffer,
+        memory::Buffer& dstBuffer,
+        std::span<const VkBufferCopy> regions) -> void;
+
     /// @brief Record a command for copying data from a buffer to an image
     auto copy(
         memory::Buffer& srcBuffer,
@@ -81,10 +142,83 @@ public:
         VkExtent3D extent,
         VkDeviceSize srcOffset = 0) -> void;
 
+    /// @brief Fill a buffer range with a repeated 32-bit value
+    auto fill(
+        memory::Buffer& buffer,
+        uint32_t data,
+        VkDeviceSize offset = 0,
+        VkDeviceSize size = VK_WHOLE_SIZE) -> void;
+
+    /// @brief Record a global memory barrier between two pipeline stages
+    auto barrier(
+        VkPipelineStageFlags srcStage,
+        VkAccessFlags srcAccess,
+        VkPipelineStageFlags dstStage,
+        VkAccessFlags dstAccess) -> void;
+
+    /// @brief Record an image memory barrier, transitioning the subresources from oldLayout to newLayout
+    auto barrier(
+        VkImage image,
+        const VkImageSubresourceRange& range,
+        VkImageLayout oldLayout,
+        VkImageLayout newLayout,
+        VkPipelineStageFlags srcStage,
+        VkAccessFlags srcAccess,
+        VkPipelineStageFlags dstStage,
+        VkAccessFlags dstAccess) -> void;
+
+    /// @brief Record a single pipeline barrier made of several global memory and image memory barriers
+    auto barrier(
+        VkPipelineStageFlags srcStage,
+        VkPipelineStageFlags dstStage,
+        std::span<const VkMemoryBarrier> memoryBarriers,
+        std::span<const VkImageMemoryBarrier> imageBarriers) -> void;
+
+    /// @brief Dispatch compute work with the currently bound compute pipeline
+    auto dispatch(uint32_t groupCountX, uint32_t groupCountY = 1, uint32_t groupCountZ = 1) -> void;
+
+    /// @brief Draw indexed triangles with the bound vertex & index buffers
+    auto drawIndexed(
+        uint32_t indexCount,
+        uint32_t instanceCount = 1,
+        uint32_t firstIndex = 0,
+        int32_t vertexOffset = 0,
+        uint32_t firstInstance = 0) -> void;
+
+    /// @brief Draw indexed geometry with parameters read from a buffer of VkDrawIndexedIndirectCommand
+    auto drawIndexedIndirect(
+        const memory::Buffer& buffer,
+        VkDeviceSize offset,
+        uint32_t drawCount,
+        uint32_t stride = sizeof(VkDrawIndexedIndirectCommand)) -> void;
+
+    /// @brief Same as drawIndexedIndirect, but the draw count is read from countBuffer (Vulkan 1.2 drawIndirectCount)
+    auto drawIndexedIndirectCount(
+        const memory::Buffer& buffer,
+        VkDeviceSize offset,
+        const memory::Buffer& countBuffer,
+        VkDeviceSize countOffset,
+        uint32_t maxDrawCount,
+        uint32_t stride = sizeof(VkDrawIndexedIndirectCommand)) -> void;
+
     /// @brief Record a command into the command buffer
     /// @param command The command to record which implements CommandI interface
     auto record(const CommandI& command) -> void;
 
+    /// @brief Time the following scopes with profiler, nullptr turns beginScope/endScope into no-ops
+    auto setProfiler(GpuProfiler* profiler) noexcept -> void { m_profiler = profiler; }
+
+    /// @brief Open a named GPU timing scope, closed by the matching endScope, scopes nest
+    auto beginScope(std::string_view name) -> void;
+    auto endScope() -> void;
+
+    /// @brief Forget the tracked bound state, needed after recording directly into getCommandBuffer()
+    auto invalidateState() noexcept -> void;
+
+    /// @brief Get the counters of the commands recorded since the last begin()
+    [[nodiscard]]
+    auto getStats() const noexcept -> const Stats& { return m_stats; }
+
     /// @brief Get the underlying VkCommandBuffer 
     [[nodiscard]]
     auto getCommandBuffer() noexcept -> VkCommandBuffer& { return m_commandBuffer; }
@@ -92,6 +226,32 @@ private:
     VkCommandBuffer m_commandBuffer;
     VkDevice m_device;
     VkCommandPool m_commandPool;
+
+    // Currently bound state, used to skip binds that would not change anything
+    static constexpr uint32_t MAX_TRACKED_SETS = 4;
+    static constexpr uint32_t MAX_TRACKED_PUSH_CONSTANTS = 128; // Minimum maxPushConstantsSize guaranteed by the spec
+
+    struct BoundState {
+        VkPipeline pipeline{VK_NULL_HANDLE};
+        VkPipeline computePipeline{VK_NULL_HANDLE};
+        VkBuffer vertexBuffer{VK_NULL_HANDLE};
+        VkBuffer indexBuffer{VK_NULL_HANDLE};
+
+        // Graphics bind point only, compute descriptor sets are always bound
+        VkPipelineLayout layout{VK_NULL_HANDLE};
+        std::array<VkDescriptorSet, MAX_TRACKED_SETS> descriptorSets{};
+
+        VkPipelineLayout pushConstantLayout{VK_NULL_HANDLE};
+        VkShaderStageFlags pushConstantStages{0};
+        uint32_t pushConstantOffset{0};
+        uint32_t pushConstantSize{0};
+        std::array<std::byte, MAX_TRACKED_PUSH_CONSTANTS> pushConstants{};
+    } m_bound{};
+
+    Stats m_stats{};
+    GpuProfiler* m_profiler{nullptr};
+
+    auto track_layout(VkPipelineLayout layout) noexcept -> void;
 };
 
 } // namespace core::commands
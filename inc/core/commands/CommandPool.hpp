@@ -26,11 +26,16 @@ public:
      * @param queueFamilyIndex Index of the queue family to use for this command pool
      * @param allocateBufferCount Number of command buffers to allocate initially and store
      *      for the CommandPool instance.
+     * @param level Level of the allocated command buffers
+     * @param flags Creation flags, pools that are only reset as a whole don't need
+     *      VK_COMMAND_POOL_CREATE_RESET_COMMAND_BUFFER_BIT
      */
     CommandPool(
         device::Device& device,
         uint32_t queueFamilyIndex,
-        size_t allocateBufferCount = 1);
+        size_t allocateBufferCount = 1,
+        VkCommandBufferLevel level = VK_COMMAND_BUFFER_LEVEL_PRIMARY,
+        VkCommandPoolCreateFlags flags = VK_COMMAND_POOL_CREATE_RESET_COMMAND_BUFFER_BIT);
     ~CommandPool();
 
     CommandPool(const CommandPool&) = delete;
@@ -38,6 +43,7 @@ public:
     auto operator=(const CommandPool&) -> CommandPool& = delete;
     auto operator=(CommandPool&&) -> CommandPool& = delete;
 
+    /// @brief Reset all command buffers allocated from the pool at once
     auto reset() -> void;
 
     auto getCmdBuffer(size_t index) -> CommandBuffer&;
@@ -0,0 +1,169 @@
+/**
+ * @file core/commands/GpuProfiler.hpp
+ * @brief Timestamp & pipeline statistics query based GPU profiler with named scopes, see CommandBuffer::beginScope.
+ */
+#pragma once
+
+#include <vulkan/vulkan.h>
+
+#include <array>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "core/device/Device.hpp"
+
+namespace core::commands {
+
+/**
+ * @brief Times named scopes of command buffers with timestamp queries & counts the frame's pipeline statistics,
+ * with query pools per frame in flight.
+ *
+ * The queries of a frame are read back when the frame slot comes around again, after its fence was
+ * waited on, so reading never stalls. Without timestamp support the scopes are no-ops, without the
+ * pipelineStatisticsQuery feature the statistics stay zero.
+ *
+ * Command buffers submitted outside of the frame, e.g. upload batches on a transfer queue, are timed
+ * as a whole with beginSubmission/endSubmission. Their queries are reset from the host, so any queue
+ * family reporting timestamp valid bits works, and polled by every beginFrame() until available.
+ */
+class GpuProfiler {
+public:
+    // Scopes recorded per frame, further scopes are ignored
+    static constexpr uint32_t MAX_SCOPES = 64;
+    // Frames the rolling averages are computed over
+    static constexpr uint32_t AVERAGE_FRAMES = 64;
+    // Separate submissions timed at once, further ones are not timed until the oldest was resolved
+    static constexpr uint32_t MAX_SUBMISSIONS = 16;
+    static constexpr uint32_t NO_SUBMISSION = UINT32_MAX;
+
+    // Counters of the graphics pipeline stages between beginStatistics and endStatistics
+    struct PipelineStatistics {
+        uint64_t inputVertices{0};
+        uint64_t vertexShaderInvocations{0};
+        uint64_t clippingPrimitives{0};         // Primitives output by the clipping stage
+        uint64_t fragmentShaderInvocations{0};
+    };
+
+    // Written in order of increasing bits, as the members of PipelineStatistics
+    static constexpr VkQueryPipelineStatisticFlags STATISTICS =
+        VK_QUERY_PIPELINE_STATISTIC_INPUT_ASSEMBLY_VERTICES_BIT |
+        VK_QUERY_PIPELINE_STATISTIC_VERTEX_SHADER_INVOCATIONS_BIT |
+        VK_QUERY_PIPELINE_STATISTIC_CLIPPING_PRIMITIVES_BIT |
+        VK_QUERY_PIPELINE_STATISTIC_FRAGMENT_SHADER_INVOCATIONS_BIT;
+
+    struct Scope {
+        std::string name;
+        float lastMs{0.f};      // Sum of the scopes with this name in the last resolved frame
+        float averageMs{0.f};   // Rolling average of lastMs over AVERAGE_FRAMES resolved frames
+    };
+
+    GpuProfiler(device::Device& device, uint32_t frameCount);
+    ~GpuProfiler();
+
+    GpuProfiler(const GpuProfiler&) = delete;
+    GpuProfiler(GpuProfiler&&) = delete;
+    auto operator=(const GpuProfiler&) -> GpuProfiler& = delete;
+    auto operator=(GpuProfiler&&) -> GpuProfiler& = delete;
+
+    /**
+     * @brief Resolve the timestamps previously written for frame and reset its queries
+     * @param commandBuffer Command buffer of the frame, recording & outside of a render pass
+     * @param frame Frame in flight index, its fence must have been waited on
+     */
+    auto beginFrame(VkCommandBuffer commandBuffer, uint32_t frame) -> void;
+
+    /// @brief Write the start timestamp of a scope, scopes nest, prefer CommandBuffer::beginScope
+    auto beginScope(VkCommandBuffer commandBuffer, std::string_view name) -> void;
+    /// @brief Write the end timestamp of the innermost open scope
+    auto endScope(VkCommandBuffer commandBuffer) -> void;
+
+    /**
+     * @brief Write the start timestamp of a command buffer submitted on its own, right after it began
+     * @param queueFamily Family of the queue it is submitted to, not timed if its timestamps have no valid bits
+     * @return Index to pass to endSubmission, NO_SUBMISSION when not timed
+     *
+     * The time counts towards the scope name of the frame that resolves it, once the GPU executed it.
+     */
+    [[nodiscard]]
+    auto beginSubmission(VkCommandBuffer commandBuffer, uint32_t queueFamily, std::string_view name) -> uint32_t;
+    /// @brief Write the end timestamp before the command buffer ends, nothing for NO_SUBMISSION
+    auto endSubmission(VkCommandBuffer commandBuffer, uint32_t submission) -> void;
+
+    /// @brief Count the pipeline statistics of the frame from here on, outside of a render pass
+    auto beginStatistics(VkCommandBuffer commandBuffer) -> void;
+    /// @brief Stop counting, in the same command buffer, outside of a render pass
+    auto endStatistics(VkCommandBuffer commandBuffer) -> void;
+
+    [[nodiscard]]
+    auto isSupported() const noexcept -> bool { return m_supported; }
+
+    /// @brief Whether submissions on queues of the family can be timed
+    [[nodiscard]]
+    auto isSupported(uint32_t queueFamily) const noexcept -> bool {
+        return m_submissionPool != VK_NULL_HANDLE && m_familyMasks[queueFamily] != 0;
+    }
+
+    [[nodiscard]]
+    auto isStatisticsSupported() const noexcept -> bool { return m_statisticsSupported; }
+
+    /// @brief Statistics of the last resolved frame
+    [[nodiscard]]
+    auto getPipelineStatistics() const noexcept -> const PipelineStatistics& { return m_statistics; }
+
+    /// @brief Timings of every scope name seen so far, in order of first appearance
+    [[nodiscard]]
+    auto getScopes() const noexcept -> const std::vector<Scope>& { return m_scopes; }
+private:
+    VkDevice m_device;
+    bool m_supported{false};
+    bool m_statisticsSupported{false};
+    float m_timestampPeriod{1.f};   // Nanoseconds per tick
+    uint64_t m_timestampMask{~0ull};
+    std::vector<uint64_t> m_familyMasks{};  // Valid timestamp bits of every queue family, 0 without timestamps
+
+    struct FrameQueries {
+        VkQueryPool pool{VK_NULL_HANDLE};
+        std::vector<uint32_t> scopes{};     // Index into m_scopes of every recorded scope, query 2i & 2i+1
+        bool pending{false};
+
+        VkQueryPool statisticsPool{VK_NULL_HANDLE};
+        bool statisticsPending{false};
+    };
+
+    std::vector<FrameQueries> m_frames{};
+    uint32_t m_currentFrame{0};
+    std::vector<uint32_t> m_openScopes{};   // Recorded scope indices, UINT32_MAX for ignored ones
+
+    struct Submission {
+        uint32_t scope{0};
+        uint64_t mask{0};       // Of the family it was submitted to
+        bool pending{false};    // Ended, its queries are read once available
+    };
+
+    VkQueryPool m_submissionPool{VK_NULL_HANDLE};   // Queries 2i & 2i+1 of m_submissions[i], null without hostQueryReset
+    std::array<Submission, MAX_SUBMISSIONS> m_submissions{};
+    uint32_t m_nextSubmission{0};
+
+    struct History {
+        std::array<float, AVERAGE_FRAMES> samples{};
+        uint32_t next{0};
+        uint32_t count{0};
+        float sum{0.f};
+    };
+
+    std::vector<Scope> m_scopes{};
+    std::vector<History> m_history{};
+    std::vector<float> m_frameTotals{};
+    std::vector<uint32_t> m_resolvedScopes{};   // Scopes with a time in m_frameTotals, may repeat
+    PipelineStatistics m_statistics{};
+
+    auto resolve(FrameQueries& frame) -> void;
+    auto resolve_submissions() -> void;
+    auto add_time(uint32_t scope, uint64_t begin, uint64_t end, uint64_t mask) -> void;
+    auto update_history() -> void;
+    auto resolve_statistics(FrameQueries& frame) -> void;
+    auto scope_index(std::string_view name) -> uint32_t;
+};
+
+} // namespace core::commands
@@ -113,6 +113,10 @@ public:
         return vkdescriptorSets;
     }
 
+    /// @brief Number of descriptor sets allocated from the pool so far
+    [[nodiscard]]
+    auto getAllocatedCount() const noexcept -> size_t { return m_descriptorSets.size(); }
+
 private:
     VkDescriptorPool m_descriptorPool;
     VkDevice m_device;
@@ -6,6 +6,7 @@
 
 #include <vulkan/vulkan.h>
 
+#include <memory>
 #include <optional>
 
 #include "core/device/Instance.hpp"
@@ -13,13 +14,28 @@
 
 #include "core/device/Queue.hpp"
 
+namespace core::sync {
+class QueueTimeline;
+} // namespace core::sync
+
 namespace core::device {
 
 class Device {
 public:
+    /// @brief Optional features that were available and got enabled on the logical device
+    struct Features {
+        bool multiDrawIndirect{false};
+        bool drawIndirectFirstInstance{false};
+        bool drawIndirectCount{false};     // Vulkan 1.2
+        bool pipelineStatisticsQuery{false};
+        bool inheritedQueries{false};      // Secondary command buffers executed while a query is active
+        bool hostQueryReset{false};        // Vulkan 1.2
+    };
+
+    /// @param surface Surface to present to, nullptr for a headless device without present queue nor swapchain extension
     Device(
         Instance& instance,
-        Surface& surface,
+        Surface* surface,
         std::vector<const char*> extensions = get_default_extensions(),
         std::optional<VkPhysicalDevice> physDevice = std::nullopt
     );
@@ -39,19 +55,35 @@ public:
     [[nodiscard]]
     auto getGraphicsQueue() noexcept -> Queue& { return m_graphicsQueue; }
 
+    /// @brief The graphics queue on a headless device
     [[nodiscard]]
     auto getPresentQueue() noexcept -> Queue& { return m_presentQueue; }
 
     [[nodiscard]]
     auto getTransferQueue() noexcept -> Queue& { return m_transferQueue; }
+
+    /// @brief GPU progress of the graphics queue, every graphics submission should go through it
+    [[nodiscard]]
+    auto getGraphicsTimeline() noexcept -> sync::QueueTimeline& { return *m_graphicsTimeline; }
+
+    /// @brief GPU progress of the transfer queue, separate from the graphics one even when they share a queue
+    [[nodiscard]]
+    auto getTransferTimeline() noexcept -> sync::QueueTimeline& { return *m_transferTimeline; }
+
+    [[nodiscard]]
+    auto getFeatures() const noexcept -> const Features& { return m_features; }
 private:
     VkPhysicalDevice m_physDevice{VK_NULL_HANDLE};
     VkDevice m_device{VK_NULL_HANDLE};
+    Features m_features{};
 
     Queue m_graphicsQueue;
     Queue m_presentQueue;
     Queue m_transferQueue;
 
+    std::unique_ptr<sync::QueueTimeline> m_graphicsTimeline;
+    std::unique_ptr<sync::QueueTimeline> m_transferTimeline;
+
     [[nodiscard]]
     constexpr static auto get_default_extensions() noexcept -> std::vector<const char*>
     {
@@ -6,6 +6,7 @@
 
 #include <vulkan/vulkan.h>
 
+#include <array>
 #include <span>
 
 namespace core::device {
@@ -19,7 +20,14 @@ struct Queue {
         VkSemaphore waitSemaphore{VK_NULL_HANDLE};
         VkSemaphore signalSemaphore{VK_NULL_HANDLE};
         VkFence fence{VK_NULL_HANDLE};
-        VkPipelineStageFlags waitStage{VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT};  
+        VkPipelineStageFlags waitStage{VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT};
+
+        // Timeline semaphores, waited on until they reached waitValue & set to signalValue, see sync::QueueTimeline
+        VkSemaphore waitTimeline{VK_NULL_HANDLE};
+        uint64_t waitValue{0};
+        VkPipelineStageFlags waitTimelineStage{VK_PIPELINE_STAGE_ALL_COMMANDS_BIT};
+        VkSemaphore signalTimeline{VK_NULL_HANDLE};
+        uint64_t signalValue{0};
     };
 
     auto submit(const SubmitInfo& info) const -> void {
@@ -29,22 +37,55 @@ struct Queue {
         submitInfo.commandBufferCount = static_cast<uint32_t>(info.commandBuffers.size());
         submitInfo.pCommandBuffers = info.commandBuffers.data();
 
+        // Binary & timeline semaphores share the arrays, the values of binary ones are ignored
+        std::array<VkSemaphore, 2> waitSemaphores{};
+        std::array<VkPipelineStageFlags, 2> waitStages{};
+        std::array<uint64_t, 2> waitValues{};
+        uint32_t waitCount = 0;
+
         if (info.waitSemaphore != VK_NULL_HANDLE) {
-            submitInfo.waitSemaphoreCount = 1;
-            submitInfo.pWaitSemaphores = &info.waitSemaphore;
-            submitInfo.pWaitDstStageMask = &info.waitStage;
-        } else {
-            submitInfo.waitSemaphoreCount = 0;
-            submitInfo.pWaitSemaphores = nullptr;
-            submitInfo.pWaitDstStageMask = nullptr;
+            waitSemaphores[waitCount] = info.waitSemaphore;
+            waitStages[waitCount] = info.waitStage;
+            waitCount++;
         }
+        if (info.waitTimeline != VK_NULL_HANDLE) {
+            waitSemaphores[waitCount] = info.waitTimeline;
+            waitStages[waitCount] = info.waitTimelineStage;
+            waitValues[waitCount] = info.waitValue;
+            waitCount++;
+        }
+
+        std::array<VkSemaphore, 2> signalSemaphores{};
+        std::array<uint64_t, 2> signalValues{};
+        uint32_t signalCount = 0;
 
         if (info.signalSemaphore != VK_NULL_HANDLE) {
-            submitInfo.signalSemaphoreCount = 1;
-            submitInfo.pSignalSemaphores = &info.signalSemaphore;
-        } else {
-            submitInfo.signalSemaphoreCount = 0;
-            submitInfo.pSignalSemaphores = nullptr;
+            signalSemaphores[signalCount] = info.signalSemaphore;
+            signalCount++;
+        }
+        if (info.signalTimeline != VK_NULL_HANDLE) {
+            signalSemaphores[signalCount] = info.signalTimeline;
+            signalValues[signalCount] = info.signalValue;
+            signalCount++;
+        }
+
+        submitInfo.waitSemaphoreCount = waitCount;
+        submitInfo.pWaitSemaphores = waitCount > 0 ? waitSemaphores.data() : nullptr;
+        submitInfo.pWaitDstStageMask = waitCount > 0 ? waitStages.data() : nullptr;
+        submitInfo.signalSemaphoreCount = signalCount;
+        submitInfo.pSignalSemaphores = signalCount > 0 ? signalSemaphores.data() : nullptr;
+
+        const VkTimelineSemaphoreSubmitInfo timelineInfo{
+            .sType = VK_STRUCTURE_TYPE_TIMELINE_SEMAPHORE_SUBMIT_INFO,
+            .pNext = nullptr,
+            .waitSemaphoreValueCount = waitCount,
+            .pWaitSemaphoreValues = waitValues.data(),
+            .signalSemaphoreValueCount = signalCount,
+            .pSignalSemaphoreValues = signalValues.data()
+        };
+
+        if (info.waitTimeline != VK_NULL_HANDLE || info.signalTimeline != VK_NULL_HANDLE) {
+            submitInfo.pNext = &timelineInfo;
         }
 
         vkQueueSubmit(queue, 1, &submitInfo, info.fence);
@@ -61,12 +102,6 @@ struct Queue {
     explicit operator bool() const noexcept {
         return queue != VK_NULL_HANDLE;
     }
-
-    auto waitIdle() const -> void {
-        if (queue != VK_NULL_HANDLE) {
-            vkQueueWaitIdle(queue);
-        }
-    }
 };
 
 } // namespace core::device
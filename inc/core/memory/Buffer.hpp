@@ -15,8 +15,11 @@ enum class BufferType {
     VERTEX,         // Vertex data
     INDEX,          // Index data
     UNIFORM,        // Uniform variables
-    // STORAGE,        // Large data storage available in shaders (SSBO)
-    STAGING         // Temporary buffer for transferring data between CPU and GPU
+    STORAGE,        // Large data storage available in shaders (SSBO)
+    INDIRECT,       // GPU written storage, usable as indirect draw arguments & counts
+    STAGING,        // Temporary buffer for transferring data between CPU and GPU
+    READBACK,       // GPU written storage mapped for reading on the CPU
+    DYNAMIC         // Persistently mapped per-frame data, bound as uniform or storage buffer with dynamic offsets
 };
 
 class Buffer {
@@ -40,6 +43,7 @@ public:
     , allocation(other.allocation)
     , allocator(other.allocator)
     , type(other.type)
+    , size(other.size)
     , mappedData(other.mappedData)
     {
         other.buffer = VK_NULL_HANDLE;
@@ -48,6 +52,28 @@ public:
         other.mappedData = nullptr;
     }
 
+    auto operator=(Buffer&& other) noexcept -> Buffer& {
+        if (this != &other) {
+            if (allocation != VK_NULL_HANDLE) {
+                vmaDestroyBuffer(allocator, buffer, allocation);
+            }
+
+            buffer = other.buffer;
+            allocation = other.allocation;
+            allocator = other.allocator;
+            type = other.type;
+            size = other.size;
+            mappedData = other.mappedData;
+
+            other.buffer = VK_NULL_HANDLE;
+            other.allocation = VK_NULL_HANDLE;
+            other.allocator = VK_NULL_HANDLE;
+            other.mappedData = nullptr;
+        }
+
+        return *this;
+    }
+
     ~Buffer() {
         if (allocation != VK_NULL_HANDLE) {
             vmaDestroyBuffer(allocator, buffer, allocation);
@@ -56,7 +82,6 @@ public:
 
     Buffer(const Buffer&) = delete;
     auto operator=(const Buffer&) -> Buffer& = delete;
-    auto operator=(Buffer&& other) -> Buffer& = delete;
 
     [[nodiscard]]
     auto getBuffer() const -> VkBuffer { return buffer; }
@@ -72,8 +97,9 @@ public:
 
     [[nodiscard]]
     auto getMappedData() -> void* {
-        if (type != BufferType::STAGING && type != BufferType::UNIFORM) {
-            throw std::invalid_argument("Only STAGING & UNIFORM buffers can be mapped.");
+        if (type != BufferType::STAGING && type != BufferType::UNIFORM && type != BufferType::STORAGE &&
+            type != BufferType::READBACK && type != BufferType::DYNAMIC) {
+            throw std::invalid_argument("Only STAGING, UNIFORM, STORAGE, READBACK & DYNAMIC buffers can be mapped.");
         }
 
         return mappedData;
@@ -14,7 +14,9 @@ namespace core::memory {
 
 enum class ImageType {
     TEXTURE_2D,   // 2D texture
-    DEPTH_2D      // 2D depth image
+    DEPTH_2D,     // 2D depth image, also sampled by the depth pyramid build
+    DEPTH_PYRAMID, // Min/max depth mip chain, written & sampled by compute shaders
+    COLOR_TARGET  // Offscreen color attachment standing in for a swapchain image, can be copied out
 };
 
 class Image {
@@ -25,13 +27,15 @@ public:
         VmaAllocation allocation,
         VmaAllocator allocator,
         VkDevice device,
-        ImageType type)
+        ImageType type,
+        VkFormat format)
     : image(image)
     , view(view)
     , allocation(allocation)
     , allocator(allocator)
     , device(device)
     , type(type)
+    , format(format)
     {}
 
     Image(Image&& other) noexcept
@@ -41,6 +45,7 @@ public:
     , allocator(other.allocator)
     , device(other.device)
     , type(other.type)
+    , format(other.format)
     {
         other.image = VK_NULL_HANDLE;
         other.allocation = VK_NULL_HANDLE;
@@ -65,6 +70,7 @@ public:
     auto getImage() -> VkImage& { return image; }
     auto getAllocation() -> VmaAllocation& { return allocation; }
     auto getView() -> VkImageView& { return view; }
+    auto getFormat() const noexcept -> VkFormat { return format; }
 private:
     VkImage image;
     VkImageView view;
@@ -75,6 +81,7 @@ private:
 
     [[maybe_unused]]
     ImageType type;
+    VkFormat format;
 };
 
 } // namespace core::memory
@@ -0,0 +1,48 @@
+/**
+ * @file core/pipeline/ComputePipeline.hpp
+ * @brief This file contains the ComputePipeline class which manages a compute pipeline and its layout.
+ */
+#pragma once
+
+#include <vulkan/vulkan.h>
+
+#include <vector>
+
+#include "core/device/Device.hpp"
+#include "core/pipeline/Shader.hpp"
+
+namespace core::pipeline {
+
+class ComputePipeline {
+public:
+    /**
+     * @brief Create a compute pipeline from a single compute shader
+     * @param device Device to create the pipeline on
+     * @param shader Compute shader, must be of Shader::Type::Compute
+     * @param setLayouts Descriptor set layouts used by the shader, in set order
+     * @param pushConstantSize Size of the push constant range visible to the compute stage, 0 for none
+     */
+    ComputePipeline(
+        device::Device& device,
+        const Shader& shader,
+        const std::vector<VkDescriptorSetLayout>& setLayouts,
+        uint32_t pushConstantSize = 0);
+    ~ComputePipeline();
+
+    ComputePipeline(const ComputePipeline&) = delete;
+    ComputePipeline& operator=(const ComputePipeline&) = delete;
+    ComputePipeline(ComputePipeline&&) = delete;
+    ComputePipeline& operator=(ComputePipeline&&) = delete;
+
+    [[nodiscard]]
+    auto getPipeline() const noexcept -> const VkPipeline& { return m_pipeline; }
+
+    [[nodiscard]]
+    auto getPipelineLayout() const noexcept -> const VkPipelineLayout& { return m_pipelineLayout; }
+private:
+    VkPipelineLayout m_pipelineLayout{VK_NULL_HANDLE};
+    VkPipeline m_pipeline{VK_NULL_HANDLE};
+    const VkDevice m_device;
+};
+
+} // namespace core::pipeline
@@ -9,21 +9,53 @@
 #include <vector>
 
 #include "core/device/Device.hpp"
-#include "core/pipeline/Swapchain.hpp"
 #include "core/pipeline/Shader.hpp"
 
 namespace core::pipeline {
 
 class Pipeline {
 public:
-    // TODO: add configuration options for pipeline creation
+    // Fixed function state that differs between the passes drawing the same geometry
+    struct Config {
+        bool depthTest{true};
+        bool depthWrite{true};
+        VkCompareOp depthCompareOp{VK_COMPARE_OP_LESS};
+        // 0 for depth only pipelines, which may then leave out the fragment shader
+        VkColorComponentFlags colorWriteMask{
+            VK_COLOR_COMPONENT_R_BIT | VK_COLOR_COMPONENT_G_BIT | VK_COLOR_COMPONENT_B_BIT | VK_COLOR_COMPONENT_A_BIT
+        };
+        bool blend{true};
+        // Only the position attribute is fetched, the vertex shader must not declare the others
+        bool positionOnly{false};
+        // Of the render pass, see graphics::RenderGraph::getColorAttachmentCount()
+        uint32_t colorAttachmentCount{1};
+    };
+
+    /// @param renderPass Render pass of a render graph raster pass, the pipeline can be used in any render pass compatible with it
+    /// @param extent Size of the viewport & scissor
     Pipeline(
         device::Device& device,
-        const Swapchain& swapchain,
+        VkRenderPass renderPass,
+        VkExtent2D extent,
         const std::vector<Shader>& shaders,
         VkDescriptorSetLayout globalSetLayout,
         VkDescriptorSetLayout materialSetLayout,
+        const Config& config = Config{},
         VkDescriptorSetLayout instanceSetLayout = VK_NULL_HANDLE);
+
+    /**
+     * @brief Pipeline sharing the layout of layoutOwner, which must be destroyed after it
+     *
+     * Descriptor sets & push constants stay bound when switching between pipelines of the same
+     * layout, CommandBuffer only skips their redundant binds while the layout doesn't change.
+     */
+    Pipeline(
+        device::Device& device,
+        VkRenderPass renderPass,
+        VkExtent2D extent,
+        const std::vector<Shader>& shaders,
+        const Pipeline& layoutOwner,
+        const Config& config = Config{});
     ~Pipeline();
 
     Pipeline(const Pipeline&) = delete;
@@ -31,22 +63,23 @@ public:
     Pipeline(Pipeline&&) = delete;
     Pipeline& operator=(Pipeline&&) = delete;
 
-    [[nodiscard]]
-    auto getRenderPass() const noexcept -> const VkRenderPass& { return m_renderPass; }
-
     [[nodiscard]]
     auto getGraphicsPipeline() const noexcept -> const VkPipeline& { return m_graphicsPipeline; }
 
     [[nodiscard]]
     auto getPipelineLayout() const noexcept -> const VkPipelineLayout& { return m_pipelineLayout; }
 private:
-    VkRenderPass m_renderPass{VK_NULL_HANDLE};
     VkPipelineLayout m_pipelineLayout{VK_NULL_HANDLE};
+    bool m_ownsLayout{true};
     VkPipeline m_graphicsPipeline{VK_NULL_HANDLE};
     const VkDevice m_device;
 
-    [[nodiscard]]
-    auto create_render_pass(const Swapchain& swapchain) -> VkRenderPass;
+    auto create_pipeline(
+        VkRenderPass renderPass,
+        VkExtent2D extent,
+        const std::vector<Shader>& shaders,
+        const Config& config) -> void;
+
     [[nodiscard]]
     auto create_pipeline_layout(
         VkDescriptorSetLayout globalSetLayout,
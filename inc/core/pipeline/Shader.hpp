@@ -18,7 +18,7 @@ public:
         None = 0,
         Vertex = 1 << 0,
         Fragment = 1 << 1,
-        // Compute,
+        Compute = 1 << 2,
         // Geometry,
         // etc. if needed
     };
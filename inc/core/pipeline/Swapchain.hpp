@@ -42,6 +42,9 @@ public:
     [[nodiscard]]
     auto getFormat() const noexcept -> VkFormat;
 
+    [[nodiscard]]
+    auto getImages() const noexcept -> const std::vector<VkImage>&;
+
     [[nodiscard]]
     auto getImageViews() const noexcept -> const std::vector<VkImageView>&;
 
@@ -0,0 +1,81 @@
+/**
+ * @file core/sync/QueueTimeline.hpp
+ * @brief GPU progress of a queue as a timeline semaphore value, with completion checks, waits & callbacks.
+ */
+#pragma once
+
+#include <vulkan/vulkan.h>
+
+#include <functional>
+#include <map>
+
+#include "core/device/Queue.hpp"
+#include "core/sync/Sync.hpp"
+
+namespace core::sync {
+
+/**
+ * @brief Numbers the submissions of a queue, each one signals the next value of a timeline semaphore.
+ *
+ * A value is complete once the GPU finished the submission that signals it and every one before it
+ * on the queue. Work depending on a submission keys off its value instead of a fence or a queue
+ * drain: check it with isComplete(), block on it with wait() or attach a callback with onComplete().
+ * Callbacks run on the thread calling poll(), wait() or onComplete(), the timeline isn't thread-safe.
+ */
+class QueueTimeline {
+public:
+    using Callback = std::move_only_function<void()>;
+
+    QueueTimeline(device::Device& device, const device::Queue& queue);
+    ~QueueTimeline();
+
+    QueueTimeline(const QueueTimeline&) = delete;
+    QueueTimeline(QueueTimeline&&) = delete;
+    auto operator=(const QueueTimeline&) -> QueueTimeline& = delete;
+    auto operator=(QueueTimeline&&) -> QueueTimeline& = delete;
+
+    /// @brief Submit to the queue, signaling the next value of the timeline
+    /// @return Value reached once the submission completed
+    auto submit(device::Queue::SubmitInfo info) -> uint64_t;
+
+    /// @brief Value of the last submission, 0 before the first one
+    [[nodiscard]]
+    auto getSubmittedValue() const noexcept -> uint64_t { return m_submitted; }
+
+    /// @brief Value of the last completed submission, queried from the semaphore
+    [[nodiscard]]
+    auto getCompletedValue() -> uint64_t;
+
+    [[nodiscard]]
+    auto isComplete(uint64_t value) -> bool;
+
+    /// @brief Wait for value & run the callbacks it completed, VK_TIMEOUT if it wasn't reached within timeout nanoseconds
+    auto wait(uint64_t value, uint64_t timeout = UINT64_MAX) -> VkResult;
+
+    /// @brief Wait for every submission so far, without draining submissions of other timelines on the queue
+    auto waitIdle() -> void { wait(m_submitted); }
+
+    /// @brief Run callback once value completed, right away if it already did
+    auto onComplete(uint64_t value, Callback callback) -> void;
+
+    /// @brief Run the callbacks of the completed values, in value order
+    auto poll() -> void;
+
+    [[nodiscard]]
+    auto getSemaphore() const noexcept -> VkSemaphore { return m_semaphore; }
+
+    [[nodiscard]]
+    auto getQueue() const noexcept -> const device::Queue& { return m_queue; }
+private:
+    const device::Queue& m_queue;
+    TimelineSemaphore m_semaphore;
+
+    uint64_t m_submitted{0};
+    uint64_t m_completed{0};    // Cached, the semaphore may be further already
+
+    std::multimap<uint64_t, Callback> m_callbacks{};
+
+    auto run_callbacks() -> void;
+};
+
+} // namespace core::sync
@@ -9,6 +9,7 @@
 #include <stdexcept>
 #include <format>
 
+#include "common/Profiler.hpp"
 #include "core/device/Device.hpp"
 #include "vulkan/utils.hpp"
 #include "vulkan/api.hpp"
@@ -102,6 +103,7 @@ public:
     }
 
     auto wait(const uint64_t timeout = UINT64_MAX) const -> VkResult {
+        PROFILE_SCOPE("Fence::wait");
         return vulkan::WaitForFences(m_device, 1, &m_fence, VK_TRUE, timeout);
     }
 
@@ -118,4 +120,83 @@ private:
     const VkDevice m_device{VK_NULL_HANDLE};
 };
 
+/// @brief Semaphore with a 64-bit counter, signaled & waited on with increasing values, see QueueTimeline
+class TimelineSemaphore {
+public:
+    TimelineSemaphore(device::Device& device, uint64_t initialValue = 0) : m_device{device.getDevice()} {
+        VkSemaphoreTypeCreateInfo typeInfo{};
+        typeInfo.sType = VK_STRUCTURE_TYPE_SEMAPHORE_TYPE_CREATE_INFO;
+        typeInfo.semaphoreType = VK_SEMAPHORE_TYPE_TIMELINE;
+        typeInfo.initialValue = initialValue;
+
+        VkSemaphoreCreateInfo semaphoreInfo{};
+        semaphoreInfo.sType = VK_STRUCTURE_TYPE_SEMAPHORE_CREATE_INFO;
+        semaphoreInfo.pNext = &typeInfo;
+
+        vulkan::CreateSemaphore(
+            m_device,
+            &semaphoreInfo,
+            nullptr,
+            &m_semaphore
+        );
+    }
+
+    ~TimelineSemaphore() {
+        if (m_semaphore != VK_NULL_HANDLE) {
+            vulkan::DestroySemaphore(m_device, m_semaphore, nullptr);
+            m_semaphore = VK_NULL_HANDLE;
+        }
+    }
+
+    TimelineSemaphore(const TimelineSemaphore&) = delete;
+    TimelineSemaphore& operator=(const TimelineSemaphore&) = delete;
+    TimelineSemaphore(TimelineSemaphore&& other) noexcept :
+        m_semaphore{other.m_semaphore},
+        m_device{other.m_device} {
+        other.m_semaphore = VK_NULL_HANDLE; // Transfer ownership
+    }
+    TimelineSemaphore& operator=(TimelineSemaphore&&) = delete;
+
+    [[nodiscard]]
+    operator VkSemaphore() const noexcept {
+        return m_semaphore;
+    }
+
+    /// @brief Largest value signaled so far
+    [[nodiscard]]
+    auto getValue() const -> uint64_t {
+        uint64_t value = 0;
+        vulkan::GetSemaphoreCounterValue(m_device, m_semaphore, &value);
+        return value;
+    }
+
+    /// @brief Wait until the counter reached value, VK_TIMEOUT if it didn't within timeout nanoseconds
+    auto wait(uint64_t value, const uint64_t timeout = UINT64_MAX) const -> VkResult {
+        PROFILE_SCOPE("TimelineSemaphore::wait");
+        const VkSemaphoreWaitInfo waitInfo{
+            .sType = VK_STRUCTURE_TYPE_SEMAPHORE_WAIT_INFO,
+            .pNext = nullptr,
+            .flags = 0,
+            .semaphoreCount = 1,
+            .pSemaphores = &m_semaphore,
+            .pValues = &value
+        };
+        return vulkan::WaitSemaphores(m_device, &waitInfo, timeout);
+    }
+
+    /// @brief Set the counter from the host, value has to be larger than the current one
+    auto signal(uint64_t value) const -> void {
+        const VkSemaphoreSignalInfo signalInfo{
+            .sType = VK_STRUCTURE_TYPE_SEMAPHORE_SIGNAL_INFO,
+            .pNext = nullptr,
+            .semaphore = m_semaphore,
+            .value = value
+        };
+        vulkan::SignalSemaphore(m_device, &signalInfo);
+    }
+private:
+    VkSemaphore m_semaphore{VK_NULL_HANDLE};
+    const VkDevice m_device{VK_NULL_HANDLE};
+};
+
 } // namespace core::sync
@@ -6,6 +6,8 @@
 
 #include <GLFW/glfw3.h>
 
+#include <array>
+
 #include <glm/glm.hpp>
 #include <glm/gtc/matrix_transform.hpp>
 
@@ -19,6 +21,7 @@ class Camera
         using normal = glm::vec3;
         using angle = glm::float32;
         using matrix = glm::mat4;
+        using plane = glm::vec4; // xyz normal pointing inside, w distance
 
         Camera(
             resolution res,
@@ -41,6 +44,9 @@ class Camera
         auto roll(const angle delta) noexcept -> void;
         auto resetRotation() noexcept -> void;
 
+        /// @brief Place the camera at position facing target, with the world Y axis up
+        auto lookAt(const vector position, const vector target) noexcept -> void;
+
         [[nodiscard]] inline auto getView() const noexcept -> const matrix& { return m_view; }
         [[nodiscard]] inline auto getProjection() const noexcept -> const matrix& { return m_projection; }
 
@@ -48,8 +54,16 @@ class Camera
         [[nodiscard]] inline auto getForward() const noexcept -> const normal& { return m_forward; }
         [[nodiscard]] inline auto getUp() const noexcept -> const normal& { return m_up; }
         [[nodiscard]] inline auto getRight() const noexcept -> const normal& { return m_right; }
+
+        [[nodiscard]] inline auto getNear() const noexcept -> float { return m_near; }
+        [[nodiscard]] inline auto getFar() const noexcept -> float { return m_far; }
+
+        /// @brief World space frustum planes (left, right, bottom, top, near, far), normalized
+        [[nodiscard]] auto getFrustum() const noexcept -> std::array<plane, 6>;
     private:
         angle m_fov = 75.f;
+        float m_near = 0.5f;
+        float m_far = 20000.f;
         resolution m_resolution{};
 
         vector m_position{};
@@ -0,0 +1,85 @@
+/**
+ * @file graphics/DrawList.hpp
+ * @brief Flat list of draws identified by 64-bit sort keys, sorted every frame to minimize state changes.
+ */
+#pragma once
+
+#include <cstdint>
+#include <vector>
+#include <span>
+
+namespace graphics {
+
+/**
+ * @brief Per-frame list of (sort key, payload) pairs.
+ *
+ * The key is laid out from the most to the least significant bits as
+ * [pipeline | material | mesh | depth], so after sorting draws sharing state end up next
+ * to each other and draws with the same state are ordered front-to-back. The payload is an
+ * opaque index chosen by the caller. Storage is reserved once and only cleared between frames.
+ */
+class DrawList {
+public:
+    struct Entry {
+        uint64_t key;
+        uint32_t payload;
+    };
+
+    static constexpr uint32_t PIPELINE_BITS = 8;
+    static constexpr uint32_t MATERIAL_BITS = 16;
+    static constexpr uint32_t MESH_BITS = 16;
+    static constexpr uint32_t DEPTH_BITS = 24;
+
+    static_assert(PIPELINE_BITS + MATERIAL_BITS + MESH_BITS + DEPTH_BITS == 64);
+
+    DrawList() = default;
+    ~DrawList() = default;
+
+    DrawList(const DrawList&) = delete;
+    DrawList(DrawList&&) = delete;
+    auto operator=(const DrawList&) -> DrawList& = delete;
+    auto operator=(DrawList&&) -> DrawList& = delete;
+
+    /**
+     * @brief Build a sort key, ids wider than their field are truncated.
+     * @param pipeline Pipeline id, most significant part of the key
+     * @param material Material id
+     * @param mesh Mesh id
+     * @param depth View depth normalized to [0, 1], clamped and quantized to DEPTH_BITS
+     */
+    [[nodiscard]]
+    static auto makeKey(
+        uint32_t pipeline,
+        uint32_t material,
+        uint32_t mesh,
+        float depth
+    ) noexcept -> uint64_t;
+
+    auto reserve(size_t count) -> void;
+    auto clear() noexcept -> void { m_entries.clear(); }
+
+    auto push(uint64_t key, uint32_t payload) -> void { m_entries.push_back({key, payload}); }
+
+    /**
+     * @brief Sort the entries by key with a LSD radix sort (8-bit digits).
+     * Passes in which every key has the same digit are skipped.
+     */
+    auto sort() -> void;
+
+    [[nodiscard]]
+    auto getEntries() const noexcept -> std::span<const Entry> { return m_entries; }
+
+    [[nodiscard]]
+    auto size() const noexcept -> size_t { return m_entries.size(); }
+
+    [[nodiscard]]
+    auto empty() const noexcept -> bool { return m_entries.empty(); }
+
+    [[nodiscard]]
+    static constexpr auto getStateBits(uint64_t key) noexcept -> uint64_t { return key >> DEPTH_BITS; }
+private:
+    std::vector<Entry> m_entries{};
+    std::vector<Entry> m_scratch{};
+};
+
+} // namespace graphics
@@ -6,31 +6,167 @@
 
 #include <assimp/mesh.h>
 
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <span>
+#include <utility>
+#include <vector>
+
 #include "core/memory/Buffer.hpp"
 #include "shaders/generic/Vertex.hpp"
 #include "systems/MemoryManager.hpp"
+#include "systems/MeshSimplifier.hpp"
 
 namespace graphics {
 
 class Mesh {
 public:
+    struct AABB {
+        glm::vec3 min;
+        glm::vec3 max;
+    };
+
+    // Largest number of detail levels per mesh, the first one being the full resolution
+    static constexpr uint32_t MAX_LODS = 5;
+
+    // Range of the index buffer drawing one level of detail, all levels share the vertex buffer
+    struct Lod {
+        uint32_t firstIndex;
+        uint32_t indexCount;
+        float error;        // Largest distance to the full resolution surface, in model space units
+    };
+
+    // CPU copy of the coarsest level, only loaded for the meshes rasterized as occluders
+    struct OccluderGeometry {
+        std::vector<glm::vec3> positions;   // Model space, only the vertices the level uses
+        std::vector<uint32_t> indices;      // Triangle list indexing positions
+    };
+
     Mesh(
         systems::MemoryManager& memoryManager,
         const aiMesh* mesh,
         aiMatrix4x4 transform)
-    : m_vertexBuffer(
-        memoryManager.createBuffer(
-            sizeof(shaders::generic::Vertex) * mesh->mNumVertices,
-            core::memory::BufferType::VERTEX
-        ))
-    , m_indexBuffer(
-        memoryManager.createBuffer(
-            sizeof(uint32_t) * mesh->mNumFaces * 3,
-            core::memory::BufferType::INDEX
-        ))
-    , m_indexCount(mesh->mNumFaces * 3)
-    , m_materialIndex(mesh->mMaterialIndex)
+    : Mesh(memoryManager, load_geometry(mesh, transform), mesh->mMaterialIndex)
+    {}
+
+    /// @brief Vertex buffer of the arena page holding the mesh, shared with other meshes
+    [[nodiscard]]
+    auto getVertexBuffer() const -> const core::memory::Buffer& { return m_arena.getVertexBuffer(m_geometry.getPage()); }
+
+    /// @brief Index buffer of the arena page holding the mesh, shared with other meshes
+    [[nodiscard]]
+    auto getIndexBuffer() const -> const core::memory::Buffer& { return m_arena.getIndexBuffer(m_geometry.getPage()); }
+
+    /// @brief vertexOffset of the draws, the indices are relative to it
+    [[nodiscard]]
+    auto getVertexOffset() const -> int32_t { return m_geometry.getVertexOffset(); }
+
+    /// @brief Position of the mesh in the index buffer, Lod::firstIndex is relative to it
+    [[nodiscard]]
+    auto getFirstIndex() const -> uint32_t { return m_geometry.getFirstIndex(); }
+
+    /// @brief Index count of the full resolution level
+    [[nodiscard]]
+    auto getIndexCount() const -> uint32_t { return m_lods.front().indexCount; }
+
+    /// @brief Levels of detail from the finest to the coarsest, at least the full resolution one
+    [[nodiscard]]
+    auto getLods() const -> std::span<const Lod> { return m_lods; }
+
+    /**
+     * @brief Coarsest level whose error stays under one unit once scaled
+     * @param errorScale Screen space size of one model space unit divided by the tolerated error
+     */
+    [[nodiscard]]
+    auto selectLod(float errorScale) const noexcept -> uint32_t {
+        uint32_t lod = 0;
+        while (lod + 1 < m_lods.size() && m_lods[lod + 1].error * errorScale <= 1.f) {
+            lod++;
+        }
+        return lod;
+    }
+
+    [[nodiscard]]
+    auto getMaterialIndex() const -> uint32_t { return m_materialIndex; }
+
+    /// @brief Axis aligned bounding box in model space
+    [[nodiscard]]
+    auto getAABB() const -> const AABB& { return m_aabb; }
+
+    /// @brief Bounding sphere in model space, xyz is the center and w the radius
+    [[nodiscard]]
+    auto getBoundingSphere() const -> const glm::vec4& { return m_boundingSphere; }
+
+    /// @brief Geometry for the software occlusion culling, empty unless set by the model
+    [[nodiscard]]
+    auto getOccluderGeometry() const -> const OccluderGeometry& { return m_occluder; }
+
+    auto setOccluderGeometry(OccluderGeometry occluder) -> void { m_occluder = std::move(occluder); }
+
+    /**
+     * @brief Build the occluder geometry of an assimp mesh, from the same levels as the constructor
+     *
+     * The levels are simplified again, the meshes only keep their GPU copy once uploaded.
+     */
+    [[nodiscard]]
+    static auto loadOccluder(const aiMesh* mesh, aiMatrix4x4 transform) -> OccluderGeometry {
+        const auto geometry = load_geometry(mesh, transform);
+        const Lod& lod = geometry.lods.back();
+
+        constexpr uint32_t UNUSED_VERTEX = std::numeric_limits<uint32_t>::max();
+        std::vector<uint32_t> remap(geometry.vertices.size(), UNUSED_VERTEX);
+
+        OccluderGeometry occluder;
+        occluder.indices.reserve(lod.indexCount);
+
+        for (uint32_t i = lod.firstIndex; i < lod.firstIndex + lod.indexCount; i++) {
+            const uint32_t index = geometry.indices[i];
+            if (remap[index] == UNUSED_VERTEX) {
+                remap[index] = static_cast<uint32_t>(occluder.positions.size());
+                occluder.positions.push_back(geometry.vertices[index].position);
+            }
+            occluder.indices.push_back(remap[index]);
+        }
+
+        return occluder;
+    }
+
+private:
+    systems::GeometryArena& m_arena;
+    systems::GeometryArena::Allocation m_geometry;
+
+    uint32_t m_materialIndex;
+    std::vector<Lod> m_lods;
+
+    AABB m_aabb{glm::vec3{0.f}, glm::vec3{0.f}};
+    glm::vec4 m_boundingSphere{0.f};
+
+    OccluderGeometry m_occluder{};
+
+    struct Geometry {
+        std::vector<shaders::generic::Vertex> vertices;
+        std::vector<uint32_t> indices;
+        std::vector<Lod> lods;
+    };
+
+    Mesh(
+        systems::MemoryManager& memoryManager,
+        Geometry geometry,
+        uint32_t materialIndex)
+    : m_arena(memoryManager.getGeometryArena())
+    , m_geometry(m_arena.allocate(geometry.vertices, geometry.indices))
+    , m_materialIndex(materialIndex)
+    , m_lods(std::move(geometry.lods))
     {
+        const auto& vertices = geometry.vertices;
+
+        m_aabb = compute_aabb(vertices);
+        m_boundingSphere = compute_bounding_sphere(vertices, m_aabb);
+    }
+
+    [[nodiscard]]
+    static auto load_geometry(const aiMesh* mesh, aiMatrix4x4 transform) -> Geometry {
         if (!mesh->HasPositions() || !mesh->HasFaces()) {
             throw std::runtime_error("Mesh is missing positions or faces.");
         }
@@ -94,37 +230,98 @@ public:
             indices.push_back(face.mIndices[2]);
         }
 
-        memoryManager.copyDataToBuffer(
-            vertices.data(),
-            sizeof(shaders::generic::Vertex) * vertices.size(),
-            m_vertexBuffer
-        );
-
-        memoryManager.copyDataToBuffer(
-            indices.data(),
-            sizeof(uint32_t) * indices.size(),
-            m_indexBuffer
-        );
+        auto lods = build_lods(vertices, indices);
+        return {std::move(vertices), std::move(indices), std::move(lods)};
     }
 
+    /**
+     * @brief Append simplified levels to indices, each one with about half the triangles of the previous
+     *
+     * The chain ends early when a level cannot be reduced enough without going over the error
+     * limit, so small or heavily locked meshes get fewer levels.
+     */
     [[nodiscard]]
-    auto getVertexBuffer() const -> const core::memory::Buffer& { return m_vertexBuffer; }
+    static auto build_lods(
+        const std::vector<shaders::generic::Vertex>& vertices,
+        std::vector<uint32_t>& indices
+    ) -> std::vector<Lod> {
+        constexpr float LOD_REDUCTION = 0.5f;       // Target index count of a level relative to the previous one
+        constexpr float LOD_MIN_REDUCTION = 0.8f;   // Levels keeping more than this are not worth drawing
+        constexpr uint32_t LOD_MIN_INDICES = 3 * 64;
+        constexpr float LOD_MAX_ERROR = 0.05f;      // Relative to the mesh extent
 
-    [[nodiscard]]
-    auto getIndexBuffer() const -> const core::memory::Buffer& { return m_indexBuffer; }
+        std::vector<Lod> lods{{0, static_cast<uint32_t>(indices.size()), 0.f}};
+        if (indices.size() < 2 * LOD_MIN_INDICES) {
+            return lods;
+        }
+
+        std::vector<glm::vec3> positions;
+        positions.reserve(vertices.size());
+        for (const auto& vertex : vertices) {
+            positions.push_back(vertex.position);
+        }
+
+        const AABB aabb = compute_aabb(vertices);
+        const glm::vec3 extent = aabb.max - aabb.min;
+        const float maxError = LOD_MAX_ERROR * std::max({extent.x, extent.y, extent.z});
+
+        systems::MeshSimplifier simplifier{positions, indices};
+
+        while (lods.size() < MAX_LODS) {
+            const uint32_t previousCount = lods.back().indexCount;
+            const auto target = static_cast<size_t>(static_cast<float>(previousCount) * LOD_REDUCTION) / 3 * 3;
+            if (target < LOD_MIN_INDICES) {
+                break;
+            }
+
+            const float error = simplifier.simplify(target, maxError);
+            const auto lodIndices = simplifier.getIndices();
+            if (static_cast<float>(lodIndices.size()) > static_cast<float>(previousCount) * LOD_MIN_REDUCTION) {
+                break;
+            }
+
+            lods.push_back({
+                static_cast<uint32_t>(indices.size()),
+                static_cast<uint32_t>(lodIndices.size()),
+                error
+            });
+            indices.insert(indices.end(), lodIndices.begin(), lodIndices.end());
+        }
+
+        return lods;
+    }
 
     [[nodiscard]]
-    auto getIndexCount() const -> uint32_t { return m_indexCount; }
+    static auto compute_aabb(const std::vector<shaders::generic::Vertex>& vertices) -> AABB {
+        AABB aabb{
+            glm::vec3{std::numeric_limits<float>::max()},
+            glm::vec3{std::numeric_limits<float>::lowest()}
+        };
+
+        for (const auto& vertex : vertices) {
+            aabb.min = glm::min(aabb.min, vertex.position);
+            aabb.max = glm::max(aabb.max, vertex.position);
+        }
+
+        return aabb;
+    }
 
     [[nodiscard]]
-    auto getMaterialIndex() const -> uint32_t { return m_materialIndex; }
+    static auto compute_bounding_sphere(
+        const std::vector<shaders::generic::Vertex>& vertices,
+        const AABB& aabb
+    ) -> glm::vec4 {
+        // Centered on the AABB, not minimal but cheap and good enough for culling
+        const glm::vec3 center = (aabb.min + aabb.max) * 0.5f;
 
-private:
-    core::memory::Buffer m_vertexBuffer;
-    core::memory::Buffer m_indexBuffer;
+        float radiusSquared = 0.f;
+        for (const auto& vertex : vertices) {
+            const glm::vec3 offset = vertex.position - center;
+            radiusSquared = std::max(radiusSquared, glm::dot(offset, offset));
+        }
 
-    uint32_t m_indexCount;
-    uint32_t m_materialIndex;
+        return {center, std::sqrt(radiusSquared)};
+    }
 };
 
 } // namespace graphics
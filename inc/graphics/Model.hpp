@@ -5,10 +5,13 @@
 #pragma once
 
 #include <stack>
+#include <stdexcept>
+#include <utility>
 #include <vector>
 
 #include <assimp/scene.h>
 
+#include "common/Profiler.hpp"
 #include "graphics/Mesh.hpp"
 #include "graphics/Material.hpp"
 #include "systems/ResourceManager.hpp"
@@ -17,14 +20,9 @@ namespace graphics {
 
 namespace {
 
-[[nodiscard]]
-auto load_meshes(
-    const aiScene* scene,
-    systems::MemoryManager& memoryManager
-) -> std::vector<Mesh> {
-    std::vector<Mesh> meshes;
-    meshes.reserve(scene->mNumMeshes);
-
+// Visit the meshes of the node hierarchy with their combined transform, always in the same order
+template<typename F>
+auto for_each_mesh(const aiScene* scene, F&& visit) -> void {
     std::stack<
         std::pair<
             const aiNode*,
@@ -41,14 +39,27 @@ auto load_meshes(
         aiMatrix4x4 currentTransform = parentTransform * node->mTransformation;
 
         for (size_t i = 0; i < node->mNumMeshes; i++) {
-            aiMesh* mesh = scene->mMeshes[node->mMeshes[i]];
-            meshes.emplace_back(memoryManager, mesh, currentTransform);
+            visit(scene->mMeshes[node->mMeshes[i]], currentTransform);
         }
 
         for (size_t i = 0; i < node->mNumChildren; i++) {
             nodeStack.push({node->mChildren[i], currentTransform});
         }
     }
+}
+
+[[nodiscard]]
+auto load_meshes(
+    const aiScene* scene,
+    systems::MemoryManager& memoryManager
+) -> std::vector<Mesh> {
+    PROFILE_SCOPE("Model::load_meshes");
+    std::vector<Mesh> meshes;
+    meshes.reserve(scene->mNumMeshes);
+
+    for_each_mesh(scene, [&](const aiMesh* mesh, const aiMatrix4x4& transform) {
+        meshes.emplace_back(memoryManager, mesh, transform);
+    });
 
     return meshes;
 }
@@ -60,6 +71,7 @@ auto load_materials(
     systems::ResourceManager& resourceManager,
     systems::MemoryManager& memoryManager
 ) -> std::vector<Material> {
+    PROFILE_SCOPE("Model::load_materials");
     std::vector<Material> materials;
 
     for (size_t i = 0; i < scene->mNumMaterials; i++) {
@@ -88,23 +100,79 @@ public:
         std::string_view directory)
     : m_meshes{load_meshes(scene, memoryManager)}
     , m_materials{load_materials(scene, directory, resourceManager, memoryManager)}
-    {}
-
-    auto getDrawables() const -> std::vector<Drawable> {
-        std::vector<Drawable> drawables;
-        drawables.reserve(m_meshes.size());
+    {
+        // Pointers stay valid when the model is moved, the vectors keep their heap storage
+        m_drawables.reserve(m_meshes.size());
+        m_boundingSpheres.reserve(m_meshes.size());
 
         for (const auto& mesh : m_meshes) {
             const Material* material = &m_materials[mesh.getMaterialIndex()];
-            drawables.emplace_back(&mesh, material);
+            m_drawables.emplace_back(&mesh, material);
+            m_boundingSpheres.push_back(mesh.getBoundingSphere());
+
+            m_aabb.min = glm::min(m_aabb.min, mesh.getAABB().min);
+            m_aabb.max = glm::max(m_aabb.max, mesh.getAABB().max);
+        }
+
+        if (m_meshes.empty()) {
+            m_aabb = {glm::vec3{0.f}, glm::vec3{0.f}};
+        }
+    }
+
+    [[nodiscard]]
+    auto getDrawables() const -> const std::vector<Drawable>& { return m_drawables; }
+
+    /// @brief Model space bounding spheres of the meshes, in the same order as getDrawables()
+    [[nodiscard]]
+    auto getBoundingSpheres() const -> const std::vector<glm::vec4>& { return m_boundingSpheres; }
+
+    /// @brief Model space bounding box enclosing all meshes
+    [[nodiscard]]
+    auto getAABB() const -> const Mesh::AABB& { return m_aabb; }
+
+    [[nodiscard]]
+    auto getMaterialCount() const -> size_t { return m_materials.size(); }
+
+    /// @brief Build the occluder geometry of every mesh, scene must be the one the model was loaded from
+    auto loadOccluders(const aiScene* scene) -> void {
+        PROFILE_SCOPE("Model::loadOccluders");
+        std::vector<Mesh::OccluderGeometry> occluders;
+        occluders.reserve(m_meshes.size());
+
+        for_each_mesh(scene, [&](const aiMesh* mesh, const aiMatrix4x4& transform) {
+            occluders.push_back(Mesh::loadOccluder(mesh, transform));
+        });
+
+        if (occluders.size() != m_meshes.size()) {
+            throw std::runtime_error("Scene does not match the meshes of the model.");
         }
 
-        return drawables;
+        for (size_t i = 0; i < m_meshes.size(); i++) {
+            m_meshes[i].setOccluderGeometry(std::move(occluders[i]));
+        }
+        m_occluders = true;
     }
 
+    auto releaseOccluders() -> void {
+        for (auto& mesh : m_meshes) {
+            mesh.setOccluderGeometry({});
+        }
+        m_occluders = false;
+    }
+
+    [[nodiscard]]
+    auto hasOccluders() const noexcept -> bool { return m_occluders; }
+
 private:
     std::vector<Mesh> m_meshes;
     std::vector<Material> m_materials;
+    std::vector<Drawable> m_drawables{};
+    std::vector<glm::vec4> m_boundingSpheres{};
+    bool m_occluders{false};
+    Mesh::AABB m_aabb{
+        glm::vec3{std::numeric_limits<float>::max()},
+        glm::vec3{std::numeric_limits<float>::lowest()}
+    };
 };
 
 } // namespace graphics
\ No newline at end of file
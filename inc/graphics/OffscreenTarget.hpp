@@ -0,0 +1,63 @@
+/**
+ * @file graphics/OffscreenTarget.hpp
+ * @brief Color images rendered into in place of a swapchain, for headless rendering.
+ */
+#pragma once
+
+#include <vulkan/vulkan.h>
+
+#include <vector>
+
+#include "core/memory/Image.hpp"
+#include "systems/MemoryManager.hpp"
+
+namespace graphics {
+
+/**
+ * @brief VMA allocated color images handed out in turn, like swapchain images that are never presented.
+ *
+ * Images are reused in order, an image is free again once the fence of the frame that rendered
+ * into it was waited on, so one image per frame in flight is enough.
+ */
+class OffscreenTarget {
+public:
+    // Format of core::memory::ImageType::COLOR_TARGET images
+    static constexpr VkFormat FORMAT = VK_FORMAT_R8G8B8A8_SRGB;
+
+    OffscreenTarget(systems::MemoryManager& memoryManager, VkExtent2D extent, uint32_t imageCount);
+    ~OffscreenTarget() = default;
+
+    OffscreenTarget(const OffscreenTarget&) = delete;
+    OffscreenTarget(OffscreenTarget&&) = delete;
+    auto operator=(const OffscreenTarget&) -> OffscreenTarget& = delete;
+    auto operator=(OffscreenTarget&&) -> OffscreenTarget& = delete;
+
+    /// @brief Index of the image to render the next frame into
+    [[nodiscard]]
+    auto acquireNextImage() noexcept -> uint32_t;
+
+    [[nodiscard]]
+    auto getExtent() const noexcept -> VkExtent2D { return m_extent; }
+
+    [[nodiscard]]
+    auto getFormat() const noexcept -> VkFormat { return FORMAT; }
+
+    [[nodiscard]]
+    auto getImages() const noexcept -> const std::vector<VkImage>& { return m_images; }
+
+    [[nodiscard]]
+    auto getImageViews() const noexcept -> const std::vector<VkImageView>& { return m_imageViews; }
+
+    [[nodiscard]]
+    auto getImageCount() const noexcept -> size_t { return m_images.size(); }
+private:
+    const VkExtent2D m_extent;
+
+    std::vector<core::memory::Image> m_targets{};
+    std::vector<VkImage> m_images{};
+    std::vector<VkImageView> m_imageViews{};
+
+    uint32_t m_nextImage{0};
+};
+
+} // namespace graphics
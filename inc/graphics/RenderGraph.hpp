@@ -0,0 +1,285 @@
+/**
+ * @file graphics/RenderGraph.hpp
+ * @brief Frame graph of raster & compute passes declaring the resources they use, synchronized and allocated by the graph.
+ */
+#pragma once
+
+#include <vulkan/vulkan.h>
+
+#include <functional>
+#include <map>
+#include <optional>
+#include <string>
+#include <vector>
+
+#include "core/device/Device.hpp"
+#include "core/commands/CommandBuffer.hpp"
+#include "systems/MemoryManager.hpp"
+
+namespace graphics {
+
+/**
+ * @brief Passes declared in execution order with the images & buffers they use, compiled once and executed every frame.
+ *
+ * compile() drops the passes none of whose writes is read by a later pass or reaches an output
+ * (see setOutput() and PassBuilder::sideEffects()), then derives from the declared usages:
+ *  - the barriers before every pass, merged into a single vkCmdPipelineBarrier, only for layout
+ *    changes and for hazards that an earlier barrier of the same write doesn't already cover,
+ *  - one VkRenderPass per raster pass, loading an attachment only if an earlier pass wrote it and
+ *    storing it only if a later pass or an output reads it,
+ *  - the memory of the transient images: an image living within a single raster pass gets lazily
+ *    allocated memory where the device has it, the others share allocations with the images whose
+ *    lifetimes don't overlap theirs.
+ *
+ * Buffers are only synchronized, with global memory barriers, their memory belongs to the caller.
+ * The content of every image is undefined at the start of an execution.
+ */
+class RenderGraph {
+public:
+    using ResourceID = uint32_t;
+
+    static constexpr ResourceID INVALID_RESOURCE = ~0u;
+
+    // How a pass uses a resource, a pass may declare several usages of the same buffer
+    enum class Usage : uint8_t {
+        COLOR_ATTACHMENT,   // Written by the draws of a raster pass
+        DEPTH_ATTACHMENT,   // Tested & written by the draws of a raster pass
+        SAMPLED_COMPUTE,    // Sampled by compute shaders, depth images in the read-only depth layout
+        SAMPLED_FRAGMENT,   // Sampled by fragment shaders, depth images in the read-only depth layout
+        STORAGE_READ,       // Read by compute shaders
+        STORAGE_WRITE,      // Read & written by compute shaders
+        TRANSFER_WRITE,     // Copies & fills
+        INDIRECT_READ,      // Buffers only, commands & counts of indirect draws
+        VERTEX_READ,        // Buffers only, storage data of vertex shaders
+        PRESENT,            // Final usage of a swapchain image, see setOutput()
+        HOST_READ           // Final usage of a buffer read back after the frame's fence, see setOutput()
+    };
+
+    struct ImageDesc {
+        VkFormat format;
+        VkExtent2D extent;
+        VkImageAspectFlags aspect;
+    };
+
+    // Render pass a raster pass records in, everything is VK_NULL_HANDLE for compute passes
+    struct PassContext {
+        VkRenderPass renderPass;
+        VkFramebuffer framebuffer;
+        VkExtent2D extent;
+    };
+
+    using RecordFunction = std::function<void(core::commands::CommandBuffer&, const PassContext&)>;
+
+    // Figures of the last compile(), the barriers are those recorded by every execute()
+    struct Stats {
+        uint32_t passCount{0};
+        uint32_t culledPassCount{0};
+        uint32_t barrierCount{0};           // vkCmdPipelineBarrier calls
+        uint32_t imageBarrierCount{0};      // Image memory barriers within them
+        uint32_t transientImageCount{0};
+        uint32_t lazyImageCount{0};         // Backed by lazily allocated memory
+        uint32_t aliasedImageCount{0};      // Sharing their memory with other images
+        VkDeviceSize transientMemory{0};    // Allocated for the other transient images
+        VkDeviceSize unaliasedMemory{0};    // What they would take without aliasing
+    };
+
+    class PassBuilder {
+    public:
+        /// @brief Declare a usage of a resource, resources are written in the declaration order of the passes
+        auto use(ResourceID resource, Usage usage) -> PassBuilder&;
+
+        /// @brief Use an image as an attachment cleared at the start of the pass rather than loaded
+        auto clear(ResourceID resource, const VkClearValue& value) -> PassBuilder&;
+
+        /// @brief The pass executes secondary command buffers rather than recording its draws inline
+        auto secondaryCommandBuffers() -> PassBuilder&;
+
+        /// @brief Keep the pass even if nothing reads its writes, e.g. when it updates state the next frame uses
+        auto sideEffects() -> PassBuilder&;
+
+        /// @brief Index of the pass, to query its render pass once compiled
+        [[nodiscard]]
+        auto getPass() const noexcept -> uint32_t { return m_pass; }
+    private:
+        friend class RenderGraph;
+
+        PassBuilder(RenderGraph& graph, uint32_t pass) : m_graph(graph), m_pass(pass) {}
+
+        RenderGraph& m_graph;
+        const uint32_t m_pass;
+    };
+
+    RenderGraph(core::device::Device& device, systems::MemoryManager& memoryManager);
+    ~RenderGraph();
+
+    RenderGraph(const RenderGraph&) = delete;
+    RenderGraph(RenderGraph&&) = delete;
+    auto operator=(const RenderGraph&) -> RenderGraph& = delete;
+    auto operator=(RenderGraph&&) -> RenderGraph& = delete;
+
+    /// @brief Declare an image created by the graph, its usage flags & memory are decided by compile()
+    [[nodiscard]]
+    auto createImage(std::string name, const ImageDesc& desc) -> ResourceID;
+
+    /// @brief Declare an image created elsewhere, set with setImportedImage() before every execute()
+    [[nodiscard]]
+    auto importImage(std::string name, const ImageDesc& desc) -> ResourceID;
+
+    [[nodiscard]]
+    auto importBuffer(std::string name) -> ResourceID;
+
+    /// @brief The resource is used after the graph, transitioned to finalUsage at its end if given
+    auto setOutput(ResourceID resource, std::optional<Usage> finalUsage = std::nullopt) -> void;
+
+    [[nodiscard]]
+    auto addRasterPass(std::string name, RecordFunction record) -> PassBuilder;
+
+    [[nodiscard]]
+    auto addComputePass(std::string name, RecordFunction record) -> PassBuilder;
+
+    /// @brief Cull the passes, create the render passes & transient images and plan the barriers
+    auto compile() -> void;
+
+    /// @brief Set the image an imported image stands for in the next executions
+    auto setImportedImage(ResourceID resource, VkImage image, VkImageView view) -> void;
+
+    /// @brief Record the compiled passes & their barriers, outside of a render pass
+    auto execute(core::commands::CommandBuffer& cmd) -> void;
+
+    /// @brief Forget every declaration, what compile() created is retired until the frames recorded with it completed
+    auto reset() -> void;
+
+    /**
+     * @brief Render pass of a compiled raster pass, the pipelines drawing in it are created against it
+     *
+     * Any render pass with the same attachment formats is compatible, the pipelines stay usable in
+     * later passes with the same attachments. VK_NULL_HANDLE if the pass was culled.
+     */
+    [[nodiscard]]
+    auto getRenderPass(uint32_t pass) const -> VkRenderPass { return m_passes.at(pass).renderPass; }
+
+    /// @brief Color attachments of a compiled raster pass, 0 for a depth only pass
+    [[nodiscard]]
+    auto getColorAttachmentCount(uint32_t pass) const -> uint32_t { return m_passes.at(pass).colorAttachmentCount; }
+
+    /// @brief View of an image, transient images have one once compiled
+    [[nodiscard]]
+    auto getImageView(ResourceID resource) const -> VkImageView { return m_resources.at(resource).view; }
+
+    [[nodiscard]]
+    auto getStats() const noexcept -> const Stats& { return m_stats; }
+
+    /// @brief Passes in execution order with their barriers & attachments ops, then the transient memory
+    [[nodiscard]]
+    auto getReport() const -> std::string;
+private:
+    // Stages & access a barrier synchronizes with, and the layout an image must be in
+    struct Access {
+        VkPipelineStageFlags stages{0};
+        VkAccessFlags access{0};
+        VkImageLayout layout{VK_IMAGE_LAYOUT_UNDEFINED};
+        bool write{false};
+        bool read{false};   // Depends on the content written before, attachments unless cleared
+    };
+
+    // Where the last write of a resource is and which reads it was made visible to since
+    struct SyncState {
+        VkImageLayout layout{VK_IMAGE_LAYOUT_UNDEFINED};
+        VkPipelineStageFlags writeStages{0};
+        VkAccessFlags writeAccess{0};
+        VkPipelineStageFlags readStages{0};
+        VkPipelineStageFlags visibleStages{0};
+        VkAccessFlags visibleAccess{0};
+        bool used{false};
+    };
+
+    struct Resource {
+        std::string name;
+        bool image;
+        bool imported;
+        ImageDesc desc{};
+        VkImage handle{VK_NULL_HANDLE};
+        VkImageView view{VK_NULL_HANDLE};
+        bool output{false};
+        std::optional<Usage> finalUsage{};
+
+        // Set by compile(), pass indices are positions in m_order
+        VkImageUsageFlags usageFlags{0};
+        uint32_t firstPass{0};
+        uint32_t lastPass{0};
+        bool lazy{false};
+        VkMemoryRequirements requirements{};
+        // Scope the first use of an execution waits for: the last use of the previous image in its memory
+        VkPipelineStageFlags initialStages{0};
+        VkAccessFlags initialAccess{0};
+    };
+
+    struct ResourceUse {
+        ResourceID resource;
+        Access access;
+        VkImageUsageFlags imageUsage;
+        bool attachment;
+        bool clear;
+        VkClearValue clearValue;
+    };
+
+    // One vkCmdPipelineBarrier, buffers share a global memory barrier
+    struct BarrierBatch {
+        VkPipelineStageFlags srcStages{0};
+        VkPipelineStageFlags dstStages{0};
+        std::vector<VkMemoryBarrier> memoryBarriers{};
+        std::vector<VkImageMemoryBarrier> imageBarriers{};
+        std::vector<ResourceID> images{};   // Resolved into imageBarriers at execute time
+    };
+
+    struct Pass {
+        std::string name;
+        bool raster;
+        RecordFunction record;
+        std::vector<ResourceUse> uses{};
+        bool secondary{false};
+        bool sideEffects{false};
+
+        // Set by compile()
+        bool culled{false};
+        BarrierBatch barriers{};
+        VkRenderPass renderPass{VK_NULL_HANDLE};
+        uint32_t colorAttachmentCount{0};
+        std::vector<ResourceID> attachments{};
+        std::vector<VkAttachmentLoadOp> loadOps{};
+        std::vector<VkAttachmentStoreOp> storeOps{};
+        std::vector<VkClearValue> clearValues{};
+        VkExtent2D extent{};
+        std::map<std::vector<VkImageView>, VkFramebuffer> framebuffers{};
+    };
+
+    const VkDevice m_device;
+    systems::MemoryManager& m_memoryManager;
+
+    std::vector<Resource> m_resources{};
+    std::vector<Pass> m_passes{};
+
+    std::vector<uint32_t> m_order{};        // Passes kept by compile()
+    BarrierBatch m_finalBarriers{};
+    std::vector<VmaAllocation> m_allocations{};
+    std::vector<VkImageView> m_viewScratch{};
+    Stats m_stats{};
+
+    [[nodiscard]]
+    auto add_resource(std::string name, bool image, bool imported, const ImageDesc& desc) -> ResourceID;
+    auto add_use(uint32_t pass, ResourceID resource, Usage usage, const VkClearValue* clearValue) -> void;
+
+    auto cull_passes() -> void;
+    auto allocate_images() -> void;
+    auto create_render_pass(Pass& pass, uint32_t position, const std::vector<bool>& written) -> void;
+    [[nodiscard]]
+    auto is_read_after(ResourceID resource, uint32_t position) const -> bool;
+    auto plan_barriers() -> void;
+    auto add_barrier(BarrierBatch& batch, ResourceID resource, const Access& access, SyncState& state) -> void;
+    auto record_barriers(core::commands::CommandBuffer& cmd, BarrierBatch& batch) -> void;
+    [[nodiscard]]
+    auto get_framebuffer(Pass& pass) -> VkFramebuffer;
+    auto release() -> void;
+};
+
+} // namespace graphics
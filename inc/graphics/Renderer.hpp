@@ -5,8 +5,11 @@
  */
 #pragma once
 
+#include <array>
+#include <mutex>
 #include <memory>
-#include <queue>
+#include <span>
+#include <unordered_map>
 #include <expected>
 #include <filesystem>
 
@@ -17,32 +20,72 @@
 #include "core/device/Device.hpp"
 #include "core/pipeline/Swapchain.hpp"
 #include "core/pipeline/Pipeline.hpp"
-#include "core/pipeline/Framebuffer.hpp"
 
 #include "core/commands/CommandPool.hpp"
+#include "core/commands/GpuProfiler.hpp"
 #include "core/descriptors/DescriptorPool.hpp"
 #include "core/sync/Sync.hpp"
 
 #include "graphics/Texture.hpp"
 #include "graphics/Model.hpp"
+#include "graphics/DrawList.hpp"
+#include "graphics/RenderGraph.hpp"
+#include "graphics/OffscreenTarget.hpp"
 #include "systems/ResourceManager.hpp"
 #include "systems/LightingSystem.hpp"
+#include "systems/JobSystem.hpp"
+#include "systems/GpuCulling.hpp"
+#include "systems/InstanceRegistry.hpp"
+#include "systems/InstanceBuffer.hpp"
+#include "systems/IdRangeAllocator.hpp"
+#include "systems/SpatialIndex.hpp"
+#include "systems/FrameRingBuffer.hpp"
+#include "systems/CullingSystem.hpp"
+#include "systems/SoftwareOcclusion.hpp"
 #include "graphics/Camera.hpp"
+#include "shaders/generic/Descriptors.hpp"
 
 namespace graphics {
 
 class Renderer {
 public:
     using ModelID = size_t;
+    // Generational, a handle of a destroyed instance stays invalid after its slot was reused
+    using InstanceHandle = systems::InstanceRegistry::Handle;
 
     struct Config {
-        // Here I'll put configuration options for the renderer in the future
+        // Initial number of instances the per-frame ring buffer regions can hold, grow on demand
+        uint32_t instanceCapacity{16384};
+        // Number of threads recording secondary command buffers, 0 records everything inline on the render thread
+        uint32_t recordThreads{0};
+        // Cull instances in a compute pass and draw them with indirect commands, ignores recordThreads
+        bool gpuDriven{false};
+        // Skip meshes outside of the camera frustum on the CPU, split over the recording threads if any.
+        // Retained instances are rejected by the spatial index first, only the meshes of the others are tested
+        bool frustumCulling{true};
+        // Two-phase Hi-Z occlusion culling against the previous frame's depth, requires gpuDriven
+        bool occlusionCulling{false};
+        // Rasterize the occluder models (see setOccluder) on the CPU and skip the meshes hidden behind them, CPU path only
+        bool softwareOcclusion{false};
+        // Shifts the level of detail selection, every +1 doubles the tolerated screen space error
+        float lodBias{0.f};
+        // Lay down depth with a position-only pass first, then shade with an EQUAL depth test (see setDepthPrepass)
+        bool depthPrepass{false};
+        // Headless only: size of the offscreen color images, a window renders at the size of its swapchain
+        VkExtent2D extent{1280, 720};
+        // Headless only: frames in flight, each with its own color image, a window uses one per swapchain image
+        uint32_t frameCount{2};
+        // Persistently mapped staging memory all uploads go through, see RenderStats::stagingHighWater to size it
+        VkDeviceSize stagingSize{systems::StagingRing::DEFAULT_SIZE};
     };
 
     Renderer(
         Window& window,
         const Config& config = Config{}
     );
+
+    /// @brief Headless renderer drawing into offscreen color images, no window, surface nor swapchain
+    explicit Renderer(const Config& config);
     ~Renderer();
 
     Renderer(const Renderer&) = delete;
@@ -54,61 +97,343 @@ public:
 
     };
 
+    // CPU time spent in the phases of the last render() call
+    struct FrameTimings {
+        float waitMs{0.f};      // Frame fence & swapchain image acquisition
+        float recordMs{0.f};    // Draw preparation, data upload & command recording
+        float submitMs{0.f};    // Queue submission & present
+    };
+
+    // What the CPU recorded & the GPU executed in a frame, tells overdraw, vertex load & CPU overhead apart
+    struct RenderStats {
+        // CPU side, counted while recording the frame
+        uint32_t drawCalls{0};                  // Direct & indirect draw commands
+        uint32_t instances{0};                  // Of direct draws, the GPU-driven path only knows them on the GPU
+        uint64_t triangles{0};                  // Of direct draws
+        uint32_t pipelineBinds{0};
+        uint32_t descriptorBinds{0};
+        uint32_t bufferBinds{0};
+        uint64_t bytesUploaded{0};              // Frame ring data, copies recorded into the frame & upload batches submitted since the previous one
+        uint32_t descriptorSetsAllocated{0};    // Since the previous frame, by model loading
+        uint64_t stagingHighWater{0};           // Peak bytes of the staging ring in use since the previous frame
+        uint64_t stagingSpilled{0};             // Bytes too large for the staging ring, staged in temporary buffers
+        uint32_t stagingStalls{0};              // Waits for uploads to free space in the staging ring
+
+        // GPU side, pipeline statistics of the whole frame, zero without the pipelineStatisticsQuery feature
+        core::commands::GpuProfiler::PipelineStatistics pipeline{};
+    };
+
     auto loadModel(const std::filesystem::path& fpath) -> std::expected<ModelID, Error>;
+    /// @brief Stop drawing a model, its GPU resources are destroyed once the frames in flight completed
     auto unloadModel(const ModelID model) -> void;
 
+    /// @brief Draw a model this frame only, for transient objects
     auto submit(const ModelID model, const glm::mat4& modelMatrix) -> void;
 
+    /**
+     * @brief Add a model instance drawn every frame until destroyed
+     *
+     * Only changes are uploaded, the CPU path re-sorts the visible instances only when an instance
+     * or the camera changed. The world space box of the instance is kept in the spatial index.
+     */
+    [[nodiscard]]
+    auto createInstance(const ModelID model, const glm::mat4& modelMatrix) -> InstanceHandle;
+    auto setTransform(const InstanceHandle instance, const glm::mat4& modelMatrix) -> void;
+    auto destroyInstance(const InstanceHandle instance) -> void;
+
+    /// @brief World space boxes of the retained instances as of the last rendered frame, see getSpatialInstance()
+    [[nodiscard]]
+    auto getSpatialIndex() const noexcept -> const systems::SpatialIndex& { return m_spatialIndex; }
+
+    /// @brief Instance of a handle returned by the spatial index queries
+    [[nodiscard]]
+    auto getSpatialInstance(const systems::SpatialIndex::Handle handle) const -> InstanceHandle { return m_spatialInstances[handle]; }
+
+    /**
+     * @brief Use the meshes of a model as occluders for the software occlusion culling, occluders are never culled by it
+     *
+     * The CPU geometry of the occluders is loaded from the model file on the first call, released when cleared.
+     */
+    auto setOccluder(const ModelID model, bool occluder) -> void;
+
     auto render() -> void;
     auto recreateSwapchain() -> void;
 
+    /// @brief Block until the GPU finished every submitted frame
+    auto waitIdle() -> void { vulkan::DeviceWaitIdle(m_device.getDevice()); }
+
     auto getCamera() -> Camera& { return m_camera; }
     auto getLightingSystem() -> systems::LightingSystem& { return m_lightingSystem; }
 
+    [[nodiscard]]
+    auto isHeadless() const noexcept -> bool { return m_offscreenTarget != nullptr; }
+
+    /// @brief Images a headless renderer draws into, nullptr with a window
+    [[nodiscard]]
+    auto getOffscreenTarget() const noexcept -> const OffscreenTarget* { return m_offscreenTarget.get(); }
+
+    [[nodiscard]]
+    auto getFrameTimings() const noexcept -> const FrameTimings& { return m_frameTimings; }
+
+    /**
+     * @brief Counters of the last rendered frame, its pipeline statistics come from the frame before
+     *
+     * The counters of a frame are gathered first and published as a whole once complete. Returned
+     * by value, may be called from another thread.
+     */
+    [[nodiscard]]
+    auto getRenderStats() const -> RenderStats {
+        std::lock_guard lock{m_renderStatsMutex};
+        return m_renderStats;
+    }
+
+    /// @brief GPU time of the whole frame, of every render graph pass & of the upload batches ("upload"), a frame late, empty without timestamp support
+    [[nodiscard]]
+    auto getGpuTimings() const noexcept -> const std::vector<core::commands::GpuProfiler::Scope>& {
+        return m_gpuProfiler.getScopes();
+    }
+
+    /// @brief Command counters of the last recorded frame, over the primary & secondary command buffers
+    [[nodiscard]]
+    auto getCommandStats() const noexcept -> const core::commands::CommandBuffer::Stats& { return m_commandStats; }
+
+    /// @brief Toggle occlusion culling at runtime, no-op unless the renderer is GPU-driven
+    auto setOcclusionCulling(bool enabled) noexcept -> void {
+        if (m_gpuCulling) {
+            m_gpuCulling->setOcclusionCulling(enabled);
+        }
+    }
+
+    /// @brief Shared mesh geometry buffers, see GeometryArena::getReport() for their usage & fragmentation
+    [[nodiscard]]
+    auto getGeometryArena() -> const systems::GeometryArena& { return m_resourceManager.getMemoryManager().getGeometryArena(); }
+
+    /// @brief Shift the level of detail selection, positive values switch to coarser levels closer to the camera
+    auto setLodBias(float bias) noexcept -> void { m_lodBias = bias; }
+
+    [[nodiscard]]
+    auto getLodBias() const noexcept -> float { return m_lodBias; }
+
+    /// @brief Toggle the depth pre-pass, takes effect on the next frame
+    auto setDepthPrepass(bool enabled) noexcept -> void { m_depthPrepass = enabled; }
+
+    [[nodiscard]]
+    auto isDepthPrepass() const noexcept -> bool { return m_depthPrepass; }
+
+    /// @brief Visible & culled mesh counts, of the current frame on the CPU path and of a completed frame in GPU-driven mode
+    [[nodiscard]]
+    auto getCullingStats() const noexcept -> const systems::CullingStats& { return m_cullingStats; }
+
+    /// @brief Passes of the frame, see RenderGraph::getReport() for their barriers & transient memory
+    [[nodiscard]]
+    auto getRenderGraph() const noexcept -> const RenderGraph& { return m_renderGraph; }
+
     bool DEBUG_1{false};
 private:
-    Window& m_window;
+    Window* m_window;   // nullptr when headless
     core::device::Instance m_instance;
-    core::device::Surface m_surface;
+    std::unique_ptr<core::device::Surface> m_surface;
     core::device::Device m_device;
     systems::ResourceManager m_resourceManager;
     systems::LightingSystem m_lightingSystem;
 
-    core::pipeline::Swapchain m_swapchain;
+    // Exactly one of them, the images of a frame are rendered into one of theirs
+    std::unique_ptr<core::pipeline::Swapchain> m_swapchain;
+    std::unique_ptr<OffscreenTarget> m_offscreenTarget;
     const uint8_t m_maxFramesInFlight;
 
     core::descriptors::DescriptorPool m_descriptorPool;
     std::vector<VkDescriptorSet> m_globalDescriptorSets;
+    std::vector<bool> m_staleGlobalSets{};          // Pointing at a retired frame ring buffer
 
-    core::memory::Image m_depthImage;
-    core::pipeline::Pipeline m_pipeline;
-    core::pipeline::Framebuffer m_framebuffer;
+    // Created against the render graph's main pass, again whenever the graph is rebuilt
+    std::unique_ptr<core::pipeline::Pipeline> m_pipeline{};
+    std::unique_ptr<core::pipeline::Pipeline> m_prepassPipeline{};     // Depth only, no fragment shader
+    std::unique_ptr<core::pipeline::Pipeline> m_equalPipeline{};       // Shading over the pre-pass depth, EQUAL test without writes
+    RenderGraph m_renderGraph;
+    RenderGraph::ResourceID m_backbuffer{RenderGraph::INVALID_RESOURCE};
+    bool m_graphOcclusionCulling{false};            // Occlusion culling state the render graph was built for
     core::commands::CommandPool m_commandPool;
+    core::commands::GpuProfiler m_gpuProfiler;
+    // Secondary command buffers need inheritedQueries to run inside the statistics query
+    bool m_pipelineStatistics{false};
+
+    const uint32_t m_recordThreads;
+    std::unique_ptr<systems::JobSystem> m_jobSystem{};
+    // Indexed by [frame * m_recordThreads + chunk], reset as whole pools every frame
+    std::vector<std::unique_ptr<core::commands::CommandPool>> m_secondaryPools{};
+    std::vector<VkCommandBuffer> m_secondaryBuffers{};
 
-    std::vector<core::memory::Buffer> m_cameraUBOs{};
-    std::vector<core::memory::Buffer> m_lightUBOs{};
+    std::unique_ptr<systems::GpuCulling> m_gpuCulling{};
+
+    const bool m_frustumCulling;
+    systems::CullingSystem m_cullingSystem{};
+    systems::CullingStats m_cullingStats{};
+    std::unique_ptr<systems::SoftwareOcclusion> m_softwareOcclusion{};
+    std::unique_ptr<systems::JobSystem> m_occlusionJobSystem{};     // Only without recording threads, m_jobSystem otherwise
+
+    // Screen space error in pixels a level of detail may introduce at a bias of 0
+    static constexpr float LOD_PIXEL_ERROR = 1.f;
+    float m_lodBias;
+
+    bool m_depthPrepass;
+
+    // Camera, lights & (CPU path) drawn instance indices of every frame, bound through the dynamic offsets of the global set
+    systems::FrameRingBuffer m_frameRing;
+    std::array<uint32_t, shaders::generic::GLOBAL_DYNAMIC_OFFSET_COUNT> m_globalOffsets{};
+    uint32_t m_instanceBase{0};     // Index of the frame's first drawn instance in the region bound to the draw instance binding
+
+    // CPU path only, transforms of the retained & submitted instances, the indices above point into it
+    std::unique_ptr<systems::InstanceBuffer> m_instanceBuffer{};
 
     std::vector<core::sync::Semaphore> m_imageAvailableVec{};
     std::vector<core::sync::Semaphore> m_renderFinishedVec{};
     std::vector<core::sync::Fence> m_inFlightVec{};
 
     uint8_t m_currentFrame{0};
+    core::commands::CommandBuffer::Stats m_commandStats{};
+    FrameTimings m_frameTimings{};
+    // Held for the copies only, a reader never sees the counters of two frames mixed
+    mutable std::mutex m_renderStatsMutex{};
+    RenderStats m_renderStats{};
+    size_t m_descriptorSetCount{0};         // Allocated by the end of the previous frame
 
     Camera m_camera;
 
+    struct LoadedModel {
+        Model model;
+        // Sort key ids of the meshes & materials of the model, returned for reuse on unload.
+        // Every mesh reserves Mesh::MAX_LODS consecutive ids, one per level
+        systems::IdRangeAllocator::Range meshIDs;
+        systems::IdRangeAllocator::Range materialIDs;
+        std::filesystem::path path;     // Read again for the occluder geometry
+        bool occluder{false};
+    };
+
     std::unordered_map<
         ModelID,
-        Model
+        LoadedModel
     > m_loadedModels{};
 
+    // Id spaces of the mesh & material fields of the draw list sort keys
+    systems::IdRangeAllocator m_meshIDs{1u << DrawList::MESH_BITS};
+    systems::IdRangeAllocator m_materialIDs{1u << DrawList::MATERIAL_BITS};
+
     struct DrawCall {
-        const ModelID model;
-        const glm::mat4 modelMatrix;
+        ModelID model;
+        glm::mat4 modelMatrix;
+    };
+
+    // Single mesh of an instance, referenced by the payload of a draw list entry
+    struct DrawItem {
+        const Mesh* mesh;
+        const Material* material;
+        uint32_t instance;  // In the instance buffer, a retained slot or past them a submitted draw call
+        uint64_t key;
+        uint32_t lod;
+        bool occluder;
+    };
+
+    // Run of sorted draw items sharing mesh & material, recorded as a single instanced draw
+    struct DrawBatch {
+        const Mesh* mesh;
+        const Material* material;
+        uint32_t lod;
+        uint32_t firstInstance;
+        uint32_t instanceCount;
+    };
+
+    // Draw data of the CPU path, the sorted batches are rebuilt when an input changed and kept as is otherwise.
+    // The vectors are cleared on rebuild but keep their capacity
+    std::vector<DrawCall> m_drawCalls{};     // Submitted for the current frame only
+    systems::InstanceRegistry m_instances{};
+    systems::SpatialIndex m_spatialIndex{};
+    std::vector<systems::SpatialIndex::Handle> m_spatialHandles{};  // Indexed by instance slot
+    std::vector<InstanceHandle> m_spatialInstances{};               // Indexed by spatial handle
+    std::vector<systems::SpatialIndex::Handle> m_visibleHandles{};  // Frustum query result of the frame
+    std::vector<systems::InstanceRegistry::Range> m_dirtyInstanceRanges{};
+    std::vector<DrawItem> m_drawItems{};
+    DrawList m_drawList{};
+    std::vector<uint32_t> m_drawInstances{};  // Instance buffer index of every drawn instance, in batch order
+    std::vector<DrawBatch> m_drawBatches{};
+
+    // Inputs the draw batches were built from, besides the retained instances tracked by their dirty slots
+    glm::mat4 m_batchViewProjection{0.f};
+    float m_batchLodScale{0.f};
+    bool m_drawBatchesDirty{true};  // Models, occluders or last frame's submitted draw calls changed
+    uint64_t m_drawBatchesVersion{0};
+
+    // m_drawInstances copy held by the frame ring region of every frame, rewritten only when the batches changed
+    struct FrameInstances {
+        uint64_t version;
+        uint32_t offset;
     };
+    std::vector<FrameInstances> m_frameInstances{};
+
+    // Meshes sharing vertex/index buffers & material, drawn by a single indirect call in GPU-driven mode
+    struct GpuBucket {
+        const Mesh* mesh;
+        const Material* material;
+        uint32_t firstCommand;
+        uint32_t commandCount;
+    };
+
+    std::vector<GpuBucket> m_gpuBuckets{};
+    std::unordered_map<ModelID, uint32_t> m_gpuModelSlots{};
+    std::vector<uint32_t> m_gpuModelInstanceCounts{};
+    bool m_gpuDrawsDirty{true};
+
+    Renderer(Window* window, const Config& config);
+
+    [[nodiscard]]
+    auto get_extent() const noexcept -> VkExtent2D {
+        return m_swapchain ? m_swapchain->getExtent() : m_offscreenTarget->getExtent();
+    }
+
+    [[nodiscard]]
+    auto get_color_format() const noexcept -> VkFormat {
+        return m_swapchain ? m_swapchain->getFormat() : m_offscreenTarget->getFormat();
+    }
+
+    /// @brief Pixels covered by one model space unit at distance 1, divided by the error tolerated at the current bias
+    [[nodiscard]]
+    auto lod_scale() const -> float;
+
+    /// @brief World space box of a model drawn with modelMatrix, the bare instance origin if the model is not loaded
+    [[nodiscard]]
+    auto instance_bounds(ModelID model, const glm::mat4& modelMatrix) const -> systems::SpatialIndex::AABB;
+
+    /// @brief Stage the changed retained & the submitted instance transforms of the CPU path, true if a retained one changed
+    auto upload_instances() -> bool;
+    /// @brief Transform of an instance buffer index, valid until the submitted draw calls are cleared
+    [[nodiscard]]
+    auto instance_transform(uint32_t instance) const -> const glm::mat4&;
+    auto build_draw_batches() -> void;
+    auto rebuild_gpu_draws() -> void;
+    auto prepare_gpu_culling() -> void;
+    auto begin_draws(core::commands::CommandBuffer& cmd, const core::pipeline::Pipeline& pipeline) -> void;
+    /// @brief Record the batches with the shading pipeline, or with the depth only one when depthOnly is set
+    auto record_draws(core::commands::CommandBuffer& cmd, std::span<const DrawBatch> batches, bool depthOnly = false) -> void;
+    auto record_indirect_draws(core::commands::CommandBuffer& cmd, bool depthOnly = false) -> void;
+    auto record_draws_parallel(core::commands::CommandBuffer& primary, const RenderGraph::PassContext& pass) -> void;
+    /// @brief Pre-pass (if enabled) then shading of everything drawn by the current render pass
+    auto record_passes(core::commands::CommandBuffer& cmd) -> void;
+    auto draw(core::commands::CommandBuffer& cmd, const DrawBatch& batch, bool depthOnly) -> void;
+
+    /// @brief Declare the frame's passes, again whenever the occlusion culling is toggled
+    auto build_render_graph() -> void;
+    /// @brief (Re)create the pipelines against a compiled raster pass of the graph
+    auto create_pipelines(uint32_t pass) -> void;
+    auto publish_render_stats() -> void;
 
-    std::queue<DrawCall> m_drawQueue{};
+    [[nodiscard]]
+    auto shading_pipeline() const noexcept -> const core::pipeline::Pipeline& {
+        return m_depthPrepass ? *m_equalPipeline : *m_pipeline;
+    }
 
-    auto draw(const ModelID modelID, const glm::mat4& modelMatrix) -> void;
+    /// @brief Write the frame's camera, lights & drawn instances to the ring buffer and keep their offsets
+    auto write_frame_data() -> void;
+    auto update_global_descriptor_set(size_t frame) -> void;
 };
 
 } // namespace graphics
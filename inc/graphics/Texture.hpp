@@ -9,6 +9,7 @@
 
 #include "stb_image.h"
 
+#include "common/Profiler.hpp"
 #include "systems/MemoryManager.hpp"
 #include "core/memory/Image.hpp"
 
@@ -18,38 +19,33 @@ class Texture {
 public:
     Texture(systems::MemoryManager& memoryManager, const std::filesystem::path& fPath)
     {
+        PROFILE_SCOPE("Texture::Texture");
+
         int32_t width, height, channels;
-        stbi_uc* pixels = stbi_load(
-            fPath.string().c_str(),
-            &width, &height,
-            &channels,
-            STBI_rgb_alpha);
+        stbi_uc* pixels = nullptr;
+        {
+            PROFILE_SCOPE("Texture::decode");
+            pixels = stbi_load(
+                fPath.string().c_str(),
+                &width, &height,
+                &channels,
+                STBI_rgb_alpha);
+        }
 
         if (!pixels) {
             throw std::runtime_error("Failed to load texture image: " + fPath.string());
         }
 
         const size_t memorySize = width * height * 4;
-        auto stagingBuffer = memoryManager.createBuffer(
-            memorySize,
-            core::memory::BufferType::STAGING,
-            systems::MemoryUsage::CPU_TO_GPU
-        );
-        memoryManager.copyDataToBuffer(
-            pixels,
-            memorySize,
-            stagingBuffer
-        );
-
-        stbi_image_free(pixels);
+        const VkExtent3D extent{
+            static_cast<uint32_t>(width),
+            static_cast<uint32_t>(height),
+            1
+        };
 
         m_Image = std::make_unique<core::memory::Image>(
             memoryManager.createImage(
-                {
-                    static_cast<uint32_t>(width),
-                    static_cast<uint32_t>(height),
-                    1
-                },
+                extent,
                 core::memory::ImageType::TEXTURE_2D,
                 systems::MemoryUsage::GPU_ONLY
             )
@@ -60,20 +56,20 @@ public:
             VK_IMAGE_LAYOUT_UNDEFINED,
             VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL
         );
-        memoryManager.copy(
-            stagingBuffer,
+        // Staged in the staging ring, the pixels can be freed right after
+        memoryManager.copyDataToImage(
+            pixels,
+            memorySize,
             *m_Image,
-            {
-                static_cast<uint32_t>(width),
-                static_cast<uint32_t>(height),
-                1
-            }
+            extent
         );
         memoryManager.transitionImageLayout(
             *m_Image,
             VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
             VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL
         );
+
+        stbi_image_free(pixels);
     }
     Texture(Texture&& other) = default;
 
@@ -58,6 +58,10 @@ public:
     [[nodiscard]]
     auto getWindow() const noexcept -> const GLFWwindow* { return m_window; }
 
+    /// @brief Instance extensions the surfaces of the window need
+    [[nodiscard]]
+    auto getRequiredInstanceExtensions() const -> std::vector<const char*>;
+
     [[nodiscard]]
     auto getWindow() noexcept -> GLFWwindow* { return m_window; }
 
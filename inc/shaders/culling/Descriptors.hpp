@@ -0,0 +1,147 @@
+/**
+ * @file shaders/culling/Descriptors.hpp
+ * @brief Buffer layouts, descriptor set layouts and push constants of the GPU culling & depth pyramid compute shaders.
+ */
+#pragma once
+
+#include <array>
+#include <vector>
+
+#define GLM_FORCE_DEFAULT_ALIGNED_GENTYPES
+#include <glm/glm.hpp>
+
+#include "vulkan/api.hpp"
+
+namespace shaders::culling {
+
+// Number of invocations in a workgroup of cull.comp & compact.comp
+constexpr uint32_t WORKGROUP_SIZE = 64;
+
+// Width & height of a hiz.comp workgroup
+constexpr uint32_t PYRAMID_WORKGROUP_SIZE = 8;
+
+// CullInstance::modelIndex of a free slot, skipped by cull.comp
+constexpr glm::uint32 INVALID_MODEL = 0xFFFFFFFF;
+
+// Submitted instance, input of cull.comp (binding 0)
+struct CullInstance {
+    glm::mat4 model;
+    glm::uint32 modelIndex;
+    glm::uint32 padding[3];
+};
+
+static_assert(sizeof(CullInstance) % 16 == 0, "CullInstance must be 16-byte aligned for std430");
+
+// Range of draws belonging to a loaded model (binding 1)
+struct CullModel {
+    glm::uint32 firstDraw;
+    glm::uint32 drawCount;
+    glm::uint32 padding[2];
+};
+
+// Level of detail of a mesh/material pair of a model (binding 2), the levels of a mesh are contiguous
+struct CullDraw {
+    glm::vec4 boundingSphere;       // Model space, xyz center & w radius
+    glm::uint32 indexCount;
+    glm::uint32 firstIndex;
+    glm::int32 vertexOffset;
+    glm::uint32 instanceOffset;     // Start of the draw's region in the visible instance buffer
+    glm::uint32 bucket;             // Index of the count in the bucket count buffer
+    glm::uint32 bucketFirstCommand; // First command slot of the bucket, draws of a bucket are contiguous
+    float lodError;                 // Model space error of the level, see graphics::Mesh::Lod
+    glm::uint32 lodCount;           // Number of levels of the mesh, the same for each of them
+};
+
+static_assert(sizeof(CullDraw) % 16 == 0, "CullDraw must be 16-byte aligned for std430");
+
+// cull.comp phases
+enum class CullPhase : glm::uint32 {
+    FRUSTUM = 0,        // Frustum test only, occlusion culling disabled
+    FIRST = 1,          // Frustum & previous frame's pyramid, occluded pairs are appended to the rejected list
+    SECOND = 2          // Rejected pairs tested against the pyramid of this frame's first pass depth
+};
+
+// Shared by cull.comp and compact.comp
+struct CullPushConstants {
+    glm::uint32 instanceCount;
+    glm::uint32 drawCount;
+    glm::uint32 compactCommands;    // 1 when drawing with vkCmdDrawIndexedIndirectCount
+    CullPhase phase;
+};
+
+// Per-frame view data of cull.comp (binding 7), std140
+struct CullUniforms {
+    std::array<glm::vec4, 6> frustum;
+    glm::mat4 view;
+    glm::mat4 previousView;
+    glm::vec4 projection;           // P00, P11, P22, P32 of the (not y flipped) projection
+    glm::vec4 previousProjection;
+    glm::vec2 pyramidSize;          // Size of mip 0 of the depth pyramid
+    float nearPlane;
+    glm::uint32 previousPyramidValid; // 0 until the pyramid was built with the previous view
+    float lodScale;                 // Pixels per model space unit at distance 1 over the tolerated error
+    float padding[3];
+};
+
+static_assert(sizeof(CullUniforms) == 288, "CullUniforms must match the std140 layout of cull.comp");
+
+// Header of the rejected list (binding 9), followed by uvec2 (instance, draw) pairs
+struct CullRejectedHeader {
+    glm::uint32 count;
+    glm::uint32 padding[3];
+};
+
+// Culling counters of a frame (binding 10), per (instance, draw) pair
+struct CullStats {
+    glm::uint32 frustumCulled;
+    glm::uint32 occlusionCulled;
+    glm::uint32 visible;
+    glm::uint32 padding;
+};
+
+// hiz.comp, reduces one mip level of the depth pyramid
+struct DepthPyramidPushConstants {
+    glm::uvec2 srcSize;
+    glm::uvec2 dstSize;
+    glm::uint32 srcIsDepth;         // 1 when the source is the depth buffer, min & max are then the same texel
+    glm::uint32 padding[3];
+};
+
+/*
+ * Set 0 bindings:
+ *  0 - CullInstance[]      (copied from CPU written staging buffers)
+ *  1 - CullModel[]         (CPU written)
+ *  2 - CullDraw[]          (CPU written)
+ *  3 - uint[]              visible instance count per draw
+ *  4 - InstanceData[]      visible instances, binding 2 of the generic global set
+ *  5 - VkDrawIndexedIndirectCommand[]
+ *  6 - uint[]              command count per bucket
+ *  7 - CullUniforms        (uniform buffer, CPU written)
+ *  8 - sampler2D           depth pyramid
+ *  9 - CullRejectedHeader + uvec2[]
+ * 10 - CullStats           (read back on the CPU)
+ */
+constexpr uint32_t BINDING_COUNT = 11;
+constexpr uint32_t UNIFORM_BINDING = 7;
+constexpr uint32_t PYRAMID_BINDING = 8;
+
+/*
+ * Depth pyramid set 0 bindings, one set per mip level:
+ *  0 - sampler2D           source, the depth buffer for mip 0 or the previous mip
+ *  1 - image2D (rg32f)     destination mip
+ */
+constexpr uint32_t PYRAMID_BINDING_COUNT = 2;
+
+[[nodiscard]]
+auto create_cull_descset_layout(VkDevice device) -> VkDescriptorSetLayout;
+
+[[nodiscard]]
+auto get_cull_desc_pool_sizes(uint32_t descCount) -> std::vector<VkDescriptorPoolSize>;
+
+[[nodiscard]]
+auto create_depth_pyramid_descset_layout(VkDevice device) -> VkDescriptorSetLayout;
+
+[[nodiscard]]
+auto get_depth_pyramid_desc_pool_sizes(uint32_t descCount) -> std::vector<VkDescriptorPoolSize>;
+
+} // namespace shaders::culling
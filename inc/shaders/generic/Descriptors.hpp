@@ -38,6 +38,23 @@ struct LightUBO {
     glm::float32 ambientLight{0.50f};
 };
 
+// Per-instance data, read from a storage buffer by gl_InstanceIndex, or by the draw instance it indexes
+// when PushConstants::indexedInstances is set
+struct InstanceData {
+    glm::mat4 model;
+};
+
+static_assert(sizeof(InstanceData) % 16 == 0, "InstanceData must be 16-byte aligned for std430");
+
+// Bindings of the global set are dynamic, their offsets are passed when binding it in this order
+enum GlobalDynamicOffset : uint32_t {
+    CAMERA_OFFSET = 0,
+    LIGHT_OFFSET = 1,
+    INSTANCE_OFFSET = 2,
+    DRAW_INSTANCE_OFFSET = 3,   // uint per drawn instance, the sorted visible instances of the CPU path
+    GLOBAL_DYNAMIC_OFFSET_COUNT = 4
+};
+
 [[nodiscard]]
 auto create_global_descset_layout(VkDevice device) -> VkDescriptorSetLayout;
 
@@ -55,13 +72,13 @@ auto create_material_descset_layout(VkDevice device) -> VkDescriptorSetLayout;
 [[nodiscard]]
 auto get_material_desc_pool_sizes(uint32_t descCount) -> std::vector<VkDescriptorPoolSize>;
 
-// Instance Push Constants
+// Push Constants, per-instance data lives in the InstanceData storage buffer
 struct PushConstants {
-    glm::mat4 model;
     glm::vec4 color;
     glm::float32 time;
     glm::uint32 objectId;
-    glm::vec2 padding;
+    glm::uint32 indexedInstances;   // gl_InstanceIndex goes through the draw instance indices first
+    glm::float32 padding;
 };
 
 static_assert(sizeof(PushConstants) <= 128);
@@ -0,0 +1,87 @@
+/**
+ * @file systems/CullingSystem.hpp
+ * @brief CPU frustum culling of bounding spheres stored as structure of arrays and tested with SSE/AVX.
+ */
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include <span>
+#include <vector>
+
+#include <glm/glm.hpp>
+
+#include "systems/JobSystem.hpp"
+
+namespace systems {
+
+// Culling counts of a frame, in meshes of the submitted instances
+struct CullingStats {
+    uint32_t visible{0};
+    uint32_t frustumCulled{0};
+    uint32_t occlusionCulled{0};
+};
+
+/**
+ * @brief Per-frame list of world space bounding spheres culled against a frustum.
+ *
+ * Spheres are pushed one instance at a time (a transform and the model space spheres of its
+ * meshes) and kept as separate x/y/z/radius arrays so the plane tests run on 8 (AVX) or 4 (SSE)
+ * spheres at once. Storage is reserved once and only cleared between frames.
+ */
+class CullingSystem {
+public:
+    using Frustum = std::array<glm::vec4, 6>;  // xyz normal pointing inside, w distance
+
+    CullingSystem() = default;
+    ~CullingSystem() = default;
+
+    CullingSystem(const CullingSystem&) = delete;
+    CullingSystem(CullingSystem&&) = delete;
+    auto operator=(const CullingSystem&) -> CullingSystem& = delete;
+    auto operator=(CullingSystem&&) -> CullingSystem& = delete;
+
+    auto reserve(size_t count) -> void;
+    auto clear() noexcept -> void;
+
+    /**
+     * @brief Append the spheres of one instance, transformed to world space
+     * @param transform Model matrix of the instance, the radius is scaled by its largest axis
+     * @param spheres Model space spheres, xyz center & w radius
+     */
+    auto push(const glm::mat4& transform, std::span<const glm::vec4> spheres) -> void;
+
+    /**
+     * @brief Test every sphere against the frustum, results are read with isVisible()
+     * @param jobSystem Splits the spheres into chunks culled in parallel when not null
+     */
+    auto cull(const Frustum& frustum, JobSystem* jobSystem = nullptr) -> void;
+
+    [[nodiscard]]
+    auto isVisible(size_t index) const noexcept -> bool { return m_visible[index] != 0; }
+
+    [[nodiscard]]
+    auto size() const noexcept -> size_t { return m_radius.size(); }
+
+    [[nodiscard]]
+    auto getVisibleCount() const noexcept -> size_t { return m_visibleCount; }
+
+    /// @brief Number of spheres tested per SIMD iteration of the build (8 AVX, 4 SSE, 1 otherwise)
+    [[nodiscard]]
+    static auto getLaneCount() noexcept -> uint32_t;
+private:
+    std::vector<float> m_centerX{};
+    std::vector<float> m_centerY{};
+    std::vector<float> m_centerZ{};
+    std::vector<float> m_radius{};
+
+    std::vector<uint8_t> m_visible{};
+    size_t m_visibleCount{0};
+
+    // Spheres below this count are not worth waking the workers for
+    static constexpr size_t MIN_PARALLEL_CHUNK = 16384;
+
+    auto cull_range(const Frustum& frustum, size_t first, size_t last) -> size_t;
+};
+
+} // namespace systems
@@ -0,0 +1,106 @@
+/**
+ * @file systems/DepthPyramid.hpp
+ * @brief Hierarchical depth (Hi-Z) pyramid built from the depth buffer by a compute shader, used for occlusion culling.
+ */
+#pragma once
+
+#include <vulkan/vulkan.h>
+
+#include <memory>
+#include <vector>
+
+#include "core/device/Device.hpp"
+#include "core/memory/Image.hpp"
+#include "core/commands/CommandBuffer.hpp"
+#include "core/descriptors/DescriptorPool.hpp"
+#include "core/pipeline/ComputePipeline.hpp"
+#include "graphics/Texture.hpp"
+#include "systems/MemoryManager.hpp"
+
+namespace systems {
+
+/**
+ * @brief Min/max depth mip chain of a depth buffer.
+ *
+ * Mip 0 is half the depth buffer size (rounded up), every texel of a level holds the minimum (r)
+ * and maximum (g) depth of the texels it covers in the level below, odd sizes included, so a
+ * footprint of at most 2x2 texels of any level bounds the depth of the screen rectangle it covers.
+ * The image stays in VK_IMAGE_LAYOUT_GENERAL and is read through getView() & getSampler().
+ */
+class DepthPyramid {
+public:
+    /**
+     * @param depthExtent Size of the depth buffer, see setSource()
+     * @param frameCount Frames in flight, each one reads the depth buffer through a set of its own
+     */
+    DepthPyramid(
+        core::device::Device& device,
+        MemoryManager& memoryManager,
+        VkExtent2D depthExtent,
+        uint32_t frameCount);
+    ~DepthPyramid();
+
+    DepthPyramid(const DepthPyramid&) = delete;
+    DepthPyramid(DepthPyramid&&) = delete;
+    auto operator=(const DepthPyramid&) -> DepthPyramid& = delete;
+    auto operator=(DepthPyramid&&) -> DepthPyramid& = delete;
+
+    /**
+     * @brief Set the depth buffer the pyramid is built from, must happen before the first build()
+     *
+     * The view is sampled in VK_IMAGE_LAYOUT_DEPTH_STENCIL_READ_ONLY_OPTIMAL. Nothing is written
+     * right away, the frames in flight may still read the previous source: the set of every frame
+     * is rewritten by its next build().
+     */
+    auto setSource(VkImageView depthView) -> void;
+
+    /**
+     * @brief Record the reduction of every mip level, outside of a render pass
+     *
+     * The depth buffer must be in VK_IMAGE_LAYOUT_DEPTH_STENCIL_READ_ONLY_OPTIMAL with its writes
+     * made visible to the compute stage. The pyramid is readable by compute shaders afterwards.
+     * The previous submission of frame must have completed.
+     */
+    auto build(core::commands::CommandBuffer& cmd, uint32_t frame) -> void;
+
+    [[nodiscard]]
+    auto getView() noexcept -> VkImageView { return m_image.getView(); }
+
+    [[nodiscard]]
+    auto getSampler() const noexcept -> VkSampler { return m_sampler.getSampler(); }
+
+    [[nodiscard]]
+    auto getExtent() const noexcept -> VkExtent2D { return m_extent; }
+
+    [[nodiscard]]
+    auto getMipCount() const noexcept -> uint32_t { return m_mipCount; }
+private:
+    const VkDevice m_device;
+    const VkExtent2D m_depthExtent;
+    const VkExtent2D m_extent;
+    const uint32_t m_mipCount;
+    const uint32_t m_frameCount;
+
+    core::memory::Image m_image;                        // Its view covers every mip level
+    std::vector<VkImageView> m_mipViews{};
+    graphics::TextureSampler m_sampler;
+
+    core::descriptors::DescriptorPool m_descriptorPool;
+    // Mip 0 of every frame reading the depth buffer, then one per mip level above it
+    std::vector<VkDescriptorSet> m_descriptorSets{};
+    std::unique_ptr<core::pipeline::ComputePipeline> m_pipeline;
+
+    VkImageView m_sourceView{VK_NULL_HANDLE};
+    std::vector<bool> m_staleSourceSets{};      // Indexed by frame, still pointing at a previous source
+
+    bool m_initialized{false};  // Layout transitioned from UNDEFINED
+
+    [[nodiscard]]
+    auto level_set(uint32_t level, uint32_t frame) const noexcept -> VkDescriptorSet {
+        return level == 0 ? m_descriptorSets[frame] : m_descriptorSets[m_frameCount + level - 1];
+    }
+
+    auto update_descriptor_set(VkDescriptorSet set, uint32_t level, VkImageView srcView, VkImageLayout srcLayout) -> void;
+};
+
+} // namespace systems
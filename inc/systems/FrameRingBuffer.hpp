@@ -0,0 +1,104 @@
+/**
+ * @file systems/FrameRingBuffer.hpp
+ * @brief Persistently mapped buffer split into per-frame regions, bump allocated for the dynamic data of a frame.
+ */
+#pragma once
+
+#include <vulkan/vulkan.h>
+
+#include <cstring>
+
+#include "core/memory/Buffer.hpp"
+
+namespace systems {
+
+class MemoryManager;
+
+/**
+ * @brief One DYNAMIC buffer with a region per frame in flight, allocations are a pointer bump.
+ *
+ * begin() restarts the region of a frame, which must only happen once the frame's fence was waited
+ * on. The data is bound with UNIFORM_BUFFER_DYNAMIC / STORAGE_BUFFER_DYNAMIC descriptors written
+ * once against this buffer, the offset of an allocation is the dynamic offset of its binding.
+ * Regions start on REGION_ALIGNMENT, the largest offset alignment Vulkan allows, so a storage
+ * binding of a whole region can use the region start as its dynamic offset.
+ */
+class FrameRingBuffer {
+public:
+    static constexpr VkDeviceSize REGION_ALIGNMENT = 256;
+
+    struct Allocation {
+        void* data;
+        uint32_t offset;    // From the start of the buffer
+    };
+
+    FrameRingBuffer(MemoryManager& memoryManager, uint32_t frameCount, VkDeviceSize frameSize);
+    ~FrameRingBuffer() = default;
+
+    FrameRingBuffer(const FrameRingBuffer&) = delete;
+    FrameRingBuffer(FrameRingBuffer&&) = delete;
+    auto operator=(const FrameRingBuffer&) -> FrameRingBuffer& = delete;
+    auto operator=(FrameRingBuffer&&) -> FrameRingBuffer& = delete;
+
+    /// @brief Make the region of frame the current one and drop its previous allocations
+    auto begin(uint32_t frame) noexcept -> void;
+
+    /**
+     * @brief Grow the regions to at least frameSize bytes, the previous buffer is retired until the frames in flight completed
+     * @return true if the buffer was recreated, the descriptors of every frame have to be rewritten before it is recorded again
+     */
+    [[nodiscard]]
+    auto reserve(VkDeviceSize frameSize) -> bool;
+
+    /// @brief Bump allocate from the current region, throws if the region is full
+    [[nodiscard]]
+    auto allocate(VkDeviceSize size, VkDeviceSize alignment) -> Allocation;
+
+    [[nodiscard]]
+    auto allocateUniform(VkDeviceSize size) -> Allocation { return allocate(size, m_uniformAlignment); }
+
+    [[nodiscard]]
+    auto allocateStorage(VkDeviceSize size) -> Allocation { return allocate(size, m_storageAlignment); }
+
+    /// @brief Copy value into a uniform allocation, returns its dynamic offset
+    template <typename T>
+    [[nodiscard]]
+    auto pushUniform(const T& value) -> uint32_t {
+        const Allocation allocation = allocateUniform(sizeof(T));
+        std::memcpy(allocation.data, &value, sizeof(T));
+        return allocation.offset;
+    }
+
+    [[nodiscard]]
+    auto getBuffer() const noexcept -> const core::memory::Buffer& { return m_buffer; }
+
+    [[nodiscard]]
+    auto getFrameSize() const noexcept -> VkDeviceSize { return m_frameSize; }
+
+    /// @brief Start of the region of the current frame
+    [[nodiscard]]
+    auto getFrameOffset() const noexcept -> uint32_t { return static_cast<uint32_t>(m_frame * m_frameSize); }
+
+    /// @brief Bytes allocated from the current region, including alignment padding
+    [[nodiscard]]
+    auto getUsed() const noexcept -> VkDeviceSize { return m_cursor; }
+
+    /// @brief Upper bound of the space taken by allocations of the given sizes, whatever their alignment
+    [[nodiscard]]
+    static constexpr auto worstCaseSize(VkDeviceSize size, uint32_t allocationCount) noexcept -> VkDeviceSize {
+        return size + allocationCount * REGION_ALIGNMENT;
+    }
+private:
+    MemoryManager& m_memoryManager;
+    const uint32_t m_frameCount;
+    const VkDeviceSize m_uniformAlignment;
+    const VkDeviceSize m_storageAlignment;
+
+    VkDeviceSize m_frameSize;
+    core::memory::Buffer m_buffer;
+
+    uint32_t m_frame{0};
+    VkDeviceSize m_cursor{0};   // Relative to the start of the current region
+};
+
+} // namespace systems
@@ -0,0 +1,141 @@
+/**
+ * @file systems/GeometryArena.hpp
+ * @brief Large shared vertex & index buffers the meshes are sub-allocated from.
+ */
+#pragma once
+
+#include <vulkan/vulkan.h>
+#include "core/memory/vma.hpp"
+
+#include <span>
+#include <string>
+#include <vector>
+
+#include "core/memory/Buffer.hpp"
+#include "shaders/generic/Vertex.hpp"
+
+namespace systems {
+
+class MemoryManager;
+
+/**
+ * @brief Pages of one vertex and one index buffer, ranges are handed out by VMA virtual blocks.
+ *
+ * Virtual blocks count vertices and indices rather than bytes, so an allocation offset is directly
+ * the vertexOffset / firstIndex of a draw. Both ranges of a mesh live in the same page, a new page
+ * is only created when no existing one fits, so in practice every draw uses the same two buffers
+ * and the redundant binds are skipped by the command buffer. Freed ranges are merged with their
+ * free neighbours by the TLSF allocator of the block.
+ */
+class GeometryArena {
+public:
+    // Page capacities, a larger mesh gets a page of its own size
+    static constexpr uint32_t PAGE_VERTICES = 1u << 19;
+    static constexpr uint32_t PAGE_INDICES = 1u << 21;
+
+    // Vertex & index ranges of a mesh in one page, returned to the arena on destruction
+    class Allocation {
+    public:
+        Allocation() = default;
+        ~Allocation();
+
+        Allocation(Allocation&& other) noexcept;
+        auto operator=(Allocation&& other) noexcept -> Allocation&;
+
+        Allocation(const Allocation&) = delete;
+        auto operator=(const Allocation&) -> Allocation& = delete;
+
+        [[nodiscard]]
+        auto getPage() const noexcept -> uint32_t { return m_page; }
+
+        /// @brief First vertex of the range, vertexOffset of the draws
+        [[nodiscard]]
+        auto getVertexOffset() const noexcept -> int32_t { return m_vertexOffset; }
+
+        [[nodiscard]]
+        auto getVertexCount() const noexcept -> uint32_t { return m_vertexCount; }
+
+        [[nodiscard]]
+        auto getFirstIndex() const noexcept -> uint32_t { return m_firstIndex; }
+
+        [[nodiscard]]
+        auto getIndexCount() const noexcept -> uint32_t { return m_indexCount; }
+    private:
+        friend class GeometryArena;
+
+        GeometryArena* m_arena{nullptr};
+        uint32_t m_page{0};
+        int32_t m_vertexOffset{0};
+        uint32_t m_vertexCount{0};
+        uint32_t m_firstIndex{0};
+        uint32_t m_indexCount{0};
+        VmaVirtualAllocation m_vertexAllocation{VK_NULL_HANDLE};
+        VmaVirtualAllocation m_indexAllocation{VK_NULL_HANDLE};
+
+        auto release() noexcept -> void;
+    };
+
+    // Usage of the vertex or index side of all pages, sizes in vertices or indices
+    struct RangeStats {
+        uint64_t capacity;
+        uint64_t used;
+        uint32_t allocationCount;
+        uint32_t freeRangeCount;
+        uint64_t largestFreeRange;
+
+        /// @brief 0 when the free space is a single range, close to 1 when it is split in many small ones
+        [[nodiscard]]
+        auto fragmentation() const noexcept -> float;
+    };
+
+    struct Stats {
+        uint32_t pageCount;
+        RangeStats vertices;
+        RangeStats indices;
+    };
+
+    explicit GeometryArena(MemoryManager& memoryManager);
+    ~GeometryArena();
+
+    GeometryArena(const GeometryArena&) = delete;
+    GeometryArena(GeometryArena&&) = delete;
+    auto operator=(const GeometryArena&) -> GeometryArena& = delete;
+    auto operator=(GeometryArena&&) -> GeometryArena& = delete;
+
+    /// @brief Sub-allocate ranges for a mesh and upload its geometry, indices are relative to the first vertex
+    [[nodiscard]]
+    auto allocate(
+        std::span<const shaders::generic::Vertex> vertices,
+        std::span<const uint32_t> indices) -> Allocation;
+
+    [[nodiscard]]
+    auto getVertexBuffer(uint32_t page) const -> const core::memory::Buffer& { return m_pages[page].vertexBuffer; }
+
+    [[nodiscard]]
+    auto getIndexBuffer(uint32_t page) const -> const core::memory::Buffer& { return m_pages[page].indexBuffer; }
+
+    [[nodiscard]]
+    auto getStats() const -> Stats;
+
+    /// @brief Human readable usage & fragmentation of every page
+    [[nodiscard]]
+    auto getReport() const -> std::string;
+private:
+    struct Page {
+        core::memory::Buffer vertexBuffer;
+        core::memory::Buffer indexBuffer;
+        VmaVirtualBlock vertexBlock;
+        VmaVirtualBlock indexBlock;
+        uint32_t vertexCapacity;
+        uint32_t indexCapacity;
+    };
+
+    MemoryManager& m_memoryManager;
+    std::vector<Page> m_pages{};
+
+    auto add_page(uint32_t vertexCapacity, uint32_t indexCapacity) -> void;
+    auto try_allocate(uint32_t page, uint32_t vertexCount, uint32_t indexCount, Allocation& allocation) -> bool;
+    auto free(Allocation& allocation) noexcept -> void;
+};
+
+} // namespace systems
@@ -0,0 +1,210 @@
+/**
+ * @file systems/GpuCulling.hpp
+ * @brief GPU-driven rendering support: compute frustum & Hi-Z occlusion culling of instances producing indirect draw commands.
+ */
+#pragma once
+
+#include <vulkan/vulkan.h>
+
+#include <array>
+#include <memory>
+#include <span>
+#include <vector>
+
+#include "core/device/Device.hpp"
+#include "core/memory/Buffer.hpp"
+#include "core/commands/CommandBuffer.hpp"
+#include "core/descriptors/DescriptorPool.hpp"
+#include "core/pipeline/ComputePipeline.hpp"
+#include "systems/MemoryManager.hpp"
+#include "systems/DepthPyramid.hpp"
+#include "systems/CullingSystem.hpp"
+#include "systems/InstanceRegistry.hpp"
+#include "shaders/culling/Descriptors.hpp"
+
+namespace systems {
+
+/**
+ * @brief Owns the cull/compact compute pipelines and the per-frame buffers they work on.
+ *
+ * Instances live in a persistent GPU buffer: the retained slots first, then the instances submitted
+ * for the current frame only. Every frame the changed slot ranges and the transient instances are
+ * written to a staging buffer and copied in place at the start of the frame's commands, so a static
+ * scene uploads nothing. cull.comp tests each instance against the bounding spheres of its model's meshes, picks a level of detail from the
+ * projected size and appends the visible transforms to the region of that level's draw. compact.comp then writes one
+ * VkDrawIndexedIndirectCommand per non-empty draw, packed per bucket, so a bucket is drawn with a
+ * single vkCmdDrawIndexedIndirectCount. Without drawIndirectCount support commands are written in
+ * place and drawn with vkCmdDrawIndexedIndirect, culled draws having an instanceCount of 0.
+ *
+ * With occlusion culling the frame is drawn in two passes. record() also tests the frustum
+ * survivors against the depth pyramid of the previous frame and sets the occluded ones aside,
+ * recordSecondPhase() builds a pyramid from the depth of the first pass and draws what was
+ * wrongly rejected, recordPyramidUpdate() rebuilds the pyramid from the final depth for the next
+ * frame. Culling counts are read back once the frame's fence was waited on.
+ *
+ * Only the barriers between its own dispatches are recorded here. Making the culling output
+ * visible to the draws & the host, and the depth buffer to the pyramid build, is left to the
+ * caller, i.e. to the accesses its render graph passes declare.
+ */
+class GpuCulling {
+public:
+    // Camera state the instances are culled with
+    struct View {
+        std::array<glm::vec4, 6> frustum;
+        glm::mat4 view;
+        glm::mat4 projection;   // Not flipped for Vulkan's y axis
+        float nearPlane;
+        float lodScale;         // Pixels per model space unit at distance 1 over the tolerated level of detail error
+    };
+
+    /// @param depthExtent Size of the depth buffer the occlusion pyramid is built from, see setDepthSource()
+    GpuCulling(
+        core::device::Device& device,
+        MemoryManager& memoryManager,
+        uint32_t frameCount,
+        uint32_t instanceCapacity,
+        VkExtent2D depthExtent);
+    ~GpuCulling() = default;
+
+    GpuCulling(const GpuCulling&) = delete;
+    GpuCulling(GpuCulling&&) = delete;
+    auto operator=(const GpuCulling&) -> GpuCulling& = delete;
+    auto operator=(GpuCulling&&) -> GpuCulling& = delete;
+
+    /**
+     * @brief Replace the set of drawable models, called when models are loaded or unloaded
+     * @param models Draw range of every model, indexed by CullInstance::modelIndex
+     * @param draws Draws of all models, ordered by bucket with bucketFirstCommand being the first draw of the bucket
+     */
+    auto setDraws(
+        std::vector<shaders::culling::CullModel> models,
+        std::vector<shaders::culling::CullDraw> draws) -> void;
+
+    /**
+     * @brief Grow the persistent instance buffer to hold instanceCount instances, the previous one is retired
+     * @return true if the buffer was recreated, its previous content is lost and every slot has to be uploaded again
+     */
+    [[nodiscard]]
+    auto reserveInstances(uint32_t instanceCount) -> bool;
+
+    /**
+     * @brief Get a mapped staging array for the instances the frame uploads, copied by the next record()
+     * @param ranges Slot ranges to upload, their instances come first in the array, range after range
+     * @param transientFirst Slot of the first transient instance, i.e. the number of retained slots
+     * @param transientCount Instances of this frame only, written after those of the ranges
+     */
+    [[nodiscard]]
+    auto mapInstanceUpload(
+        uint32_t frame,
+        std::span<const InstanceRegistry::Range> ranges,
+        uint32_t transientFirst,
+        uint32_t transientCount) -> shaders::culling::CullInstance*;
+
+    /// @brief Set the depth buffer the pyramid is built from, required before occlusion culling records anything. Never waits for the GPU
+    auto setDepthSource(VkImageView depthView) -> void { m_depthPyramid.setSource(depthView); }
+
+    /// @brief Enable the two-phase occlusion culling, takes effect on the next record()
+    auto setOcclusionCulling(bool enabled) noexcept -> void;
+
+    [[nodiscard]]
+    auto isOcclusionCulling() const noexcept -> bool { return m_occlusionCulling; }
+
+    /**
+     * @brief Upload the per-frame draw data once the instances are written, also reads back the culling counts of the frame's previous use
+     * @param modelInstanceCounts Number of instances written for each model
+     * @return true if the visible instance buffer of the frame was recreated and has to be rebound
+     */
+    [[nodiscard]]
+    auto prepare(
+        uint32_t frame,
+        uint32_t instanceCount,
+        std::span<const uint32_t> modelInstanceCounts) -> bool;
+
+    /// @brief Record the culling & compaction passes, must be outside of a render pass
+    auto record(
+        core::commands::CommandBuffer& cmd,
+        uint32_t frame,
+        const View& view) -> void;
+
+    /**
+     * @brief Record the occlusion test of the instances record() rejected, against the depth drawn since
+     *
+     * Must follow the render pass that drew the first phase, with its depth in
+     * VK_IMAGE_LAYOUT_DEPTH_STENCIL_READ_ONLY_OPTIMAL and its draws done reading the culling output.
+     */
+    auto recordSecondPhase(core::commands::CommandBuffer& cmd, uint32_t frame) -> void;
+
+    /// @brief Build the pyramid the next frame's first phase is tested against from the final depth of this one
+    auto recordPyramidUpdate(core::commands::CommandBuffer& cmd, uint32_t frame) -> void;
+
+    /// @brief Record the indirect draws of a bucket, the geometry and material must be bound already
+    auto drawBucket(
+        core::commands::CommandBuffer& cmd,
+        uint32_t frame,
+        uint32_t bucket,
+        uint32_t firstCommand,
+        uint32_t commandCount) -> void;
+
+    [[nodiscard]]
+    auto getVisibleInstanceBuffer(uint32_t frame) const -> const core::memory::Buffer& { return m_frames[frame].visibleInstances; }
+
+    [[nodiscard]]
+    auto usesDrawCount() const noexcept -> bool { return m_features.drawIndirectCount; }
+
+    /// @brief Culling counts of the last frame read back by prepare(), per (instance, mesh) pair
+    [[nodiscard]]
+    auto getStats() const noexcept -> const CullingStats& { return m_stats; }
+private:
+    MemoryManager& m_memoryManager;
+    const core::device::Device::Features m_features;
+
+    core::descriptors::DescriptorPool m_descriptorPool;
+    std::vector<VkDescriptorSet> m_descriptorSets;
+
+    std::unique_ptr<core::pipeline::ComputePipeline> m_cullPipeline;
+    std::unique_ptr<core::pipeline::ComputePipeline> m_compactPipeline;
+
+    DepthPyramid m_depthPyramid;
+
+    core::memory::Buffer m_instances;           // CullInstance[], persistent & shared by the frames
+
+    struct FrameBuffers {
+        core::memory::Buffer instanceUpload;    // Staging CullInstance[], copied into m_instances
+        std::vector<VkBufferCopy> uploadRegions;
+        core::memory::Buffer models;            // CullModel[], CPU written
+        core::memory::Buffer draws;             // CullDraw[], CPU written
+        core::memory::Buffer visibleCounts;     // uint per draw
+        core::memory::Buffer visibleInstances;  // InstanceData[]
+        core::memory::Buffer commands;          // VkDrawIndexedIndirectCommand per draw
+        core::memory::Buffer bucketCounts;      // uint per bucket
+        core::memory::Buffer uniforms;          // CullUniforms, CPU written
+        core::memory::Buffer rejected;          // CullRejectedHeader & (instance, draw) pairs
+        core::memory::Buffer stats;             // CullStats, read back
+        bool staleDescriptorSet{false};         // Still points at a retired instance buffer
+    };
+
+    std::vector<FrameBuffers> m_frames{};
+
+    std::vector<shaders::culling::CullModel> m_models{};
+    std::vector<shaders::culling::CullDraw> m_draws{};
+    uint32_t m_bucketCount{0};
+
+    shaders::culling::CullPushConstants m_pushConstants{};
+    uint32_t m_visibleCapacity{0};
+
+    bool m_occlusionCulling{false};
+    bool m_pyramidValid{false};         // Built from the depth of the previous frame
+    View m_pyramidView{};               // Camera the pyramid was rendered with
+    CullingStats m_stats{};
+
+    auto update_descriptor_set(uint32_t frame) -> void;
+    auto dispatch_cull(core::commands::CommandBuffer& cmd, uint32_t frame, uint32_t invocationCount) -> void;
+    auto dispatch_compact(core::commands::CommandBuffer& cmd, uint32_t frame) -> void;
+    auto reserve(
+        core::memory::Buffer& buffer,
+        VkDeviceSize size,
+        core::memory::BufferType type,
+        MemoryUsage usage) -> bool;
+};
+
+} // namespace systems
@@ -0,0 +1,52 @@
+/**
+ * @file systems/IdRangeAllocator.hpp
+ * @brief Reusable ranges of consecutive ids out of a fixed size id space.
+ */
+#pragma once
+
+#include <vulkan/vulkan.h>
+#include "core/memory/vma.hpp"
+
+#include <cstdint>
+#include <optional>
+
+namespace systems {
+
+/**
+ * @brief Hands out ranges of consecutive ids below a fixed capacity, freed ranges are reused.
+ *
+ * Used for the ids packed into sort key fields, which only have room for a fixed number of
+ * them. Ranges come from a VMA virtual block like the geometry arena ranges, so freed ranges
+ * are merged with their free neighbours and load / unload cycles don't exhaust the id space.
+ */
+class IdRangeAllocator {
+public:
+    struct Range {
+        uint32_t first{0};
+        uint32_t count{0};
+        VmaVirtualAllocation allocation{VK_NULL_HANDLE};
+    };
+
+    explicit IdRangeAllocator(uint32_t capacity);
+    ~IdRangeAllocator();
+
+    IdRangeAllocator(const IdRangeAllocator&) = delete;
+    IdRangeAllocator(IdRangeAllocator&&) = delete;
+    auto operator=(const IdRangeAllocator&) -> IdRangeAllocator& = delete;
+    auto operator=(IdRangeAllocator&&) -> IdRangeAllocator& = delete;
+
+    /// @brief Range of count consecutive ids, nullopt when no free range is large enough
+    [[nodiscard]]
+    auto allocate(uint32_t count) -> std::optional<Range>;
+
+    /// @brief Return the ids of the range for reuse, the range is left empty
+    auto free(Range& range) noexcept -> void;
+
+    [[nodiscard]]
+    auto getCapacity() const noexcept -> uint32_t { return m_capacity; }
+private:
+    uint32_t m_capacity;
+    VmaVirtualBlock m_block{VK_NULL_HANDLE};
+};
+
+} // namespace systems
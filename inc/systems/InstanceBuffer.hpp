@@ -0,0 +1,76 @@
+/**
+ * @file systems/InstanceBuffer.hpp
+ * @brief Persistent GPU copy of the instance transforms drawn by the CPU path, updated from dirty slot ranges.
+ */
+#pragma once
+
+#include <vulkan/vulkan.h>
+
+#include <span>
+#include <vector>
+
+#include "core/memory/Buffer.hpp"
+#include "core/commands/CommandBuffer.hpp"
+#include "systems/MemoryManager.hpp"
+#include "systems/InstanceRegistry.hpp"
+#include "shaders/generic/Descriptors.hpp"
+
+namespace systems {
+
+/**
+ * @brief Instance transforms in GPU only memory, the retained slots first, then the frame's transient instances
+ *
+ * Same layout & upload scheme as the instances of GpuCulling: every frame only the changed slot
+ * ranges and the transient instances are written to the frame's staging buffer, record() copies
+ * them in place. The draws index it through the frame's sorted list of visible instances, so a
+ * moving camera re-sorts indices but uploads no transforms.
+ */
+class InstanceBuffer {
+public:
+    InstanceBuffer(MemoryManager& memoryManager, uint32_t frameCount, uint32_t instanceCapacity);
+    ~InstanceBuffer() = default;
+
+    InstanceBuffer(const InstanceBuffer&) = delete;
+    InstanceBuffer(InstanceBuffer&&) = delete;
+    auto operator=(const InstanceBuffer&) -> InstanceBuffer& = delete;
+    auto operator=(InstanceBuffer&&) -> InstanceBuffer& = delete;
+
+    /**
+     * @brief Grow the buffer to hold instanceCount instances, the frames in flight keep reading the previous one
+     * @return true if the buffer was recreated, every slot has to be uploaded again & the descriptors pointing at it rewritten
+     */
+    [[nodiscard]]
+    auto reserve(uint32_t instanceCount) -> bool;
+
+    /**
+     * @brief Get a mapped staging array for the instances the frame uploads, copied by the next record()
+     * @param ranges Slot ranges to upload, their instances come first in the array, range after range
+     * @param transientFirst Slot of the first transient instance, i.e. the number of retained slots
+     * @param transientCount Instances of this frame only, written after those of the ranges
+     */
+    [[nodiscard]]
+    auto map(
+        uint32_t frame,
+        std::span<const InstanceRegistry::Range> ranges,
+        uint32_t transientFirst,
+        uint32_t transientCount) -> shaders::generic::InstanceData*;
+
+    /// @brief Copy the frame's staged instances, before the vertex shaders of the frame read them
+    auto record(core::commands::CommandBuffer& cmd, uint32_t frame) -> void;
+
+    [[nodiscard]]
+    auto getBuffer() const noexcept -> const core::memory::Buffer& { return m_instances; }
+
+private:
+    MemoryManager& m_memoryManager;
+    core::memory::Buffer m_instances;
+
+    struct FrameUpload {
+        core::memory::Buffer staging;   // InstanceData[], host written
+        std::vector<VkBufferCopy> regions;
+    };
+
+    std::vector<FrameUpload> m_frames{};
+};
+
+} // namespace systems
@@ -0,0 +1,130 @@
+/**
+ * @file systems/InstanceRegistry.hpp
+ * @brief Retained instances identified by stable handles, with dirty range tracking for delta uploads.
+ */
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <unordered_map>
+#include <vector>
+
+#include <glm/glm.hpp>
+
+namespace systems {
+
+/**
+ * @brief Slot array of (model, transform) pairs, a handle is the slot of the instance and its generation.
+ *
+ * Every change marks its slot dirty. consumeDirtyRanges() hands the dirty slots out as sorted
+ * ranges, merging ranges separated by at most COALESCE_GAP clean slots, so an upload needs a few
+ * large copies rather than one per instance. Destroyed slots are dirty too, they have to be
+ * cleared on the GPU side, and are reused by the next create().
+ *
+ * The generation of a slot is bumped when its instance is destroyed, so a stale handle to a reused
+ * slot is rejected by destroy() & setTransform() instead of changing the new instance. The slot
+ * accessors (isAlive(), getModel(), getTransform()) take slot indices, as found in the dirty ranges.
+ */
+class InstanceRegistry {
+public:
+    // Slot index in the low INDEX_BITS, generation of the slot in the bits above
+    using Handle = uint32_t;
+
+    static constexpr uint32_t INDEX_BITS = 24;
+    static constexpr uint32_t GENERATION_BITS = 8;
+    static constexpr uint32_t MAX_SLOTS = 1u << INDEX_BITS;
+
+    static_assert(INDEX_BITS + GENERATION_BITS == 32);
+
+    // Slots a range may absorb to merge with the next one, re-uploading them is cheaper than another copy region
+    static constexpr uint32_t COALESCE_GAP = 32;
+
+    struct Range {
+        uint32_t first;
+        uint32_t count;
+    };
+
+    InstanceRegistry() = default;
+    ~InstanceRegistry() = default;
+
+    InstanceRegistry(const InstanceRegistry&) = delete;
+    InstanceRegistry(InstanceRegistry&&) = delete;
+    auto operator=(const InstanceRegistry&) -> InstanceRegistry& = delete;
+    auto operator=(InstanceRegistry&&) -> InstanceRegistry& = delete;
+
+    /// @brief Slot of the instance a handle refers to, whether or not it is still alive
+    [[nodiscard]]
+    static constexpr auto getSlot(Handle handle) noexcept -> uint32_t { return handle & (MAX_SLOTS - 1); }
+
+    /// @brief Throws once MAX_SLOTS instances are alive
+    [[nodiscard]]
+    auto create(size_t model, const glm::mat4& transform) -> Handle;
+
+    /// @brief Destroying a stale handle does nothing
+    auto destroy(Handle handle) -> void;
+
+    /// @brief Moving a stale handle does nothing
+    auto setTransform(Handle handle, const glm::mat4& transform) -> void;
+
+    /// @brief Whether the handle refers to a live instance, false once it was destroyed, even if its slot was reused
+    [[nodiscard]]
+    auto contains(Handle handle) const noexcept -> bool {
+        const uint32_t slot = getSlot(handle);
+        return isAlive(slot) && make_handle(slot) == handle;
+    }
+
+    /// @brief Mark every slot dirty, e.g. when the uploaded copy was lost or has to be rewritten
+    auto markAllDirty() -> void;
+
+    /// @brief Mark every slot clean without collecting the ranges, for users that read the slots directly
+    auto clearDirty() -> void;
+
+    /// @brief Replace the content of ranges with the dirty slots as sorted, coalesced ranges and mark them clean
+    auto consumeDirtyRanges(std::vector<Range>& ranges) -> void;
+
+    [[nodiscard]]
+    auto hasDirtySlots() const noexcept -> bool { return !m_dirtySlots.empty(); }
+
+    [[nodiscard]]
+    auto isAlive(uint32_t slot) const noexcept -> bool { return slot < m_alive.size() && m_alive[slot]; }
+
+    [[nodiscard]]
+    auto getModel(uint32_t slot) const -> size_t { return m_models[slot]; }
+
+    [[nodiscard]]
+    auto getTransform(uint32_t slot) const -> const glm::mat4& { return m_transforms[slot]; }
+
+    /// @brief Handle of the instance currently living in a slot
+    [[nodiscard]]
+    auto getHandle(uint32_t slot) const noexcept -> Handle { return make_handle(slot); }
+
+    /// @brief One past the highest slot ever used, live and destroyed slots alike
+    [[nodiscard]]
+    auto getSlotCount() const noexcept -> uint32_t { return static_cast<uint32_t>(m_alive.size()); }
+
+    [[nodiscard]]
+    auto size() const noexcept -> size_t { return m_alive.size() - m_freeSlots.size(); }
+
+    /// @brief Number of live instances of every model that has any
+    [[nodiscard]]
+    auto getModelCounts() const noexcept -> const std::unordered_map<size_t, uint32_t>& { return m_modelCounts; }
+private:
+    std::vector<glm::mat4> m_transforms{};  // Indexed by slot
+    std::vector<size_t> m_models{};
+    std::vector<uint8_t> m_alive{};
+    std::vector<uint8_t> m_dirty{};
+    std::vector<uint8_t> m_generations{};
+    std::vector<uint32_t> m_freeSlots{};
+
+    std::vector<uint32_t> m_dirtySlots{};   // Unsorted, every slot at most once
+    std::unordered_map<size_t, uint32_t> m_modelCounts{};
+
+    [[nodiscard]]
+    auto make_handle(uint32_t slot) const noexcept -> Handle {
+        return slot | (static_cast<Handle>(m_generations[slot]) << INDEX_BITS);
+    }
+
+    auto mark_dirty(uint32_t slot) -> void;
+};
+
+} // namespace systems
@@ -0,0 +1,64 @@
+/**
+ * @file systems/JobSystem.hpp
+ * @brief Small pool of persistent worker threads used to split per-frame CPU work into parallel tasks.
+ */
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <exception>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <utility>
+#include <vector>
+
+namespace systems {
+
+class JobSystem {
+public:
+    using Task = std::function<void(uint32_t taskIndex)>;
+
+    /**
+     * @brief Start the worker threads
+     * @param workerCount Number of threads to spawn, the thread calling parallel_for() works as well
+     */
+    explicit JobSystem(uint32_t workerCount);
+    ~JobSystem();
+
+    JobSystem(const JobSystem&) = delete;
+    JobSystem(JobSystem&&) = delete;
+    auto operator=(const JobSystem&) -> JobSystem& = delete;
+    auto operator=(JobSystem&&) -> JobSystem& = delete;
+
+    /**
+     * @brief Run task(0) ... task(taskCount - 1) on the workers and the calling thread, returns
+     * once all of them are finished. The first exception thrown by a task is rethrown here.
+     */
+    auto parallel_for(uint32_t taskCount, const Task& task) -> void;
+
+    [[nodiscard]]
+    auto getWorkerCount() const noexcept -> uint32_t { return static_cast<uint32_t>(m_workers.size()); }
+private:
+    std::vector<std::thread> m_workers{};
+
+    std::mutex m_mutex{};
+    std::condition_variable m_wakeWorkers{};
+    std::condition_variable m_batchDone{};
+
+    // State of the batch currently being executed, guarded by m_mutex except for the atomics
+    const Task* m_task{nullptr};
+    uint32_t m_taskCount{0};
+    uint64_t m_generation{0};
+    uint32_t m_activeWorkers{0};
+    bool m_stop{false};
+    std::exception_ptr m_exception{};
+
+    std::atomic<uint32_t> m_nextTask{0};
+
+    auto worker_loop() -> void;
+    auto run_tasks(const Task& task, uint32_t taskCount) -> void;
+};
+
+} // namespace systems
@@ -7,6 +7,8 @@
 #include <vulkan/vulkan.h>
 #include "core/memory/vma.hpp"
 
+#include <deque>
+#include <functional>
 #include <memory>
 
 #include "core/memory/Buffer.hpp"
@@ -16,6 +18,9 @@
 #include "core/descriptors/DescriptorPool.hpp"
 #include "core/device/Instance.hpp"
 #include "core/device/Device.hpp"
+#include "systems/GeometryArena.hpp"
+#include "systems/StagingRing.hpp"
+#include "systems/UploadBatch.hpp"
 
 namespace systems {
 
@@ -24,12 +29,17 @@ enum class MemoryUsage {
     CPU_ONLY,       // RAM only, no GPU access
     CPU_TO_GPU,     // CPU accessible memory that can be transferred to GPU
     GPU_TO_CPU,     // GPU accessible memory that can be read by CPU
+    GPU_LAZILY_ALLOCATED,   // Transient attachments only, backed by tile memory where available
     AUTO            // VMA will automatically choose the best memory type
 };
 
 class MemoryManager {
 public:
-    MemoryManager(core::device::Instance& instance, core::device::Device& device);
+    /// @param stagingSize Size of the staging ring all uploads to GPU only memory go through
+    MemoryManager(
+        core::device::Instance& instance,
+        core::device::Device& device,
+        VkDeviceSize stagingSize = StagingRing::DEFAULT_SIZE);
     ~MemoryManager();
 
     MemoryManager(const MemoryManager&) = delete;
@@ -44,13 +54,16 @@ public:
         MemoryUsage usage = MemoryUsage::AUTO
     ) -> core::memory::Buffer;
 
+    /// @brief Create an image and a view over all of its mip levels
     [[nodiscard]]
     auto createImage(
         const VkExtent3D& extent,
         core::memory::ImageType type,
-        MemoryUsage usage = MemoryUsage::AUTO
+        MemoryUsage usage = MemoryUsage::AUTO,
+        uint32_t mipLevels = 1
     ) -> core::memory::Image;
 
+    /// @brief Write data to a buffer, through the staging ring for GPU only (VERTEX, INDEX) buffers
     auto copyDataToBuffer(
         const void* data,
         VkDeviceSize size,
@@ -58,6 +71,57 @@ public:
         VkDeviceSize offset = 0
     ) -> void;
 
+    /// @brief Write tightly packed texels to the first mip level of an image in TRANSFER_DST_OPTIMAL layout
+    auto copyDataToImage(
+        const void* data,
+        VkDeviceSize size,
+        core::memory::Image& image,
+        VkExtent3D extent
+    ) -> void;
+
+    /**
+     * @brief Allocate memory without a resource, images are bound to it with bindImageMemory()
+     *
+     * Several images with disjoint lifetimes may be bound to the same allocation, their content is
+     * undefined whenever another one was used in between.
+     */
+    [[nodiscard]]
+    auto allocateMemory(const VkMemoryRequirements& requirements, MemoryUsage usage = MemoryUsage::GPU_ONLY) -> VmaAllocation;
+    auto bindImageMemory(VmaAllocation allocation, VkImage image) -> void;
+    auto freeMemory(VmaAllocation allocation) -> void;
+
+    /// @brief Whether a memory type can be lazily allocated, i.e. GPU_LAZILY_ALLOCATED allocations can succeed
+    [[nodiscard]]
+    auto supportsLazilyAllocatedMemory() const -> bool;
+
+    /// @brief Limits of the physical device, e.g. the offset alignments of uniform & storage buffer bindings
+    [[nodiscard]]
+    auto getLimits() const -> const VkPhysicalDeviceLimits&;
+
+    /// @brief Make GPU writes to a mapped (READBACK) buffer visible to the CPU, needed on non-coherent memory
+    auto invalidate(core::memory::Buffer& buffer) -> void;
+
+    /**
+     * @brief Record the uploads of copy(), transitionImageLayout() & copyDataToBuffer() into one batch
+     *
+     * Without an open batch every upload is submitted on its own, not waited on: its completion value
+     * is getUploadBatch().getSubmittedValue(). Opening an already open batch does nothing.
+     */
+    auto beginUploads() -> void;
+    /// @brief Submit the open batch without waiting, its staging buffers are kept until it completed
+    auto submitUploads() -> void;
+    /// @brief Close the open batch without submitting it, for uploads whose destinations are gone
+    auto discardUploads() -> void;
+    /// @brief Wait for the submitted batch, does nothing if none is in flight
+    auto waitUploads() -> void;
+
+    [[nodiscard]]
+    auto getUploadBatch() -> UploadBatch& { return m_uploads; }
+
+    /// @brief Staging memory of the uploads, see StagingRing::endFrame() for its usage
+    [[nodiscard]]
+    auto getStagingRing() -> StagingRing& { return *m_stagingRing; }
+
     auto copy(
         core::memory::Buffer& srcBuffer,
         core::memory::Buffer& dstBuffer,
@@ -79,6 +143,30 @@ public:
         VkImageLayout newLayout
     ) -> void;
 
+    /**
+     * @brief Destroy a resource once the GPU is done with the work submitted so far, instead of right away
+     *
+     * The resource is tagged with the last value of the graphics timeline & with the upload batch that
+     * may still write it, the open one if any, and destroyed by collectRetired() once both completed.
+     * Commands recorded after the call mustn't use it. Anything owning GPU memory can be retired: a
+     * Buffer, an Image or a whole model.
+     */
+    template <typename T>
+    auto retire(T&& resource) -> void {
+        static_assert(!std::is_lvalue_reference_v<T>, "Retired resources are moved into the deletion queue");
+        defer([resource = std::make_unique<T>(std::move(resource))]() mutable { resource.reset(); });
+    }
+
+    /// @brief Run destroy when a resource retired now would be destroyed, for raw Vulkan handles
+    auto defer(std::move_only_function<void()> destroy) -> void;
+
+    /// @brief Destroy the retired resources the GPU is done with, once per frame
+    auto collectRetired() -> void;
+
+    /// @brief Resources waiting for the GPU before being destroyed
+    [[nodiscard]]
+    auto getRetiredCount() const noexcept -> size_t { return m_retired.size(); }
+
     // TODO: descriptor sets management
     [[nodiscard]]
     auto getDescriptorPool() -> core::descriptors::DescriptorPool& { return m_descriptorPool; }
@@ -93,6 +181,16 @@ public:
         return m_device;
     }
 
+    /// @brief Progress of the graphics queue, the frames & the uploaded resources' acquires are submitted on it
+    [[nodiscard]]
+    auto getGraphicsTimeline() -> core::sync::QueueTimeline& {
+        return m_graphicsTimeline;
+    }
+
+    /// @brief Shared vertex & index buffers the meshes are sub-allocated from
+    [[nodiscard]]
+    auto getGeometryArena() -> GeometryArena& { return *m_geometryArena; }
+
     // [[nodiscard]]
     // auto map(const core::memory::Buffer& buffer) -> void*;
     // auto unmap(const core::memory::Buffer& buffer) -> void;
@@ -100,11 +198,6 @@ public:
     // [[nodiscard]]
     // auto map(const core::memory::Image& image) -> void*;
     // auto unmap(const core::memory::Image& image) -> void;
-
-    // transfer buffer/image from transformQueue to targetQueue (e.g. graphics queue)
-    //  for now we'll use only one transfer queue, so this is a no-op
-    auto transfer(const core::memory::Buffer& buffer, const core::device::Queue& targetQueue) -> void;
-    auto transfer(const core::memory::Image& image, const core::device::Queue& targetQueue) -> void;
 private:
     VmaAllocator m_allocator;
     VkDevice m_device;
@@ -112,9 +205,33 @@ private:
     // Descriptors
     core::descriptors::DescriptorPool m_descriptorPool;
 
-    // Transfer
+    // Transfer, uploads are handed over to the graphics queue family by the batch
     core::device::Queue& m_transferQueue;
-    core::commands::CommandPool m_commandPool;
+    core::sync::QueueTimeline& m_graphicsTimeline;
+    UploadBatch m_uploads;
+    bool m_batchingUploads{false};
+
+    // Buffers of this manager, released before the allocator
+    std::unique_ptr<StagingRing> m_stagingRing;
+    std::unique_ptr<GeometryArena> m_geometryArena;
+
+    // Deletion queue, in retirement order so the tagged values only grow
+    struct Retired {
+        uint64_t graphicsValue;     // Last frame or acquire submitted on the graphics timeline
+        uint64_t uploadSerial;      // Last upload batch, the one being recorded if any, see UploadBatch::getRecordingSerial()
+        std::move_only_function<void()> destroy;
+    };
+    std::deque<Retired> m_retired{};
+
+    [[nodiscard]]
+    auto is_uploaded(uint64_t uploadSerial) const -> bool;
+
+    // Stage data & record its copy, large data spills to a temporary staging buffer kept by the batch
+    template <typename Record>
+    auto stage(const void* data, VkDeviceSize size, Record&& record) -> void;
+
+    // Submit uploads recorded outside of a batch, without waiting
+    auto flush_uploads() -> void;
 };
 
 } // namespace systems
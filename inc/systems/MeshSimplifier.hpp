@@ -0,0 +1,101 @@
+/**
+ * @file systems/MeshSimplifier.hpp
+ * @brief Quadric error metric simplification of indexed triangle meshes, used to build mesh LOD chains.
+ */
+#pragma once
+
+#include <cstdint>
+#include <span>
+#include <vector>
+
+#include <glm/glm.hpp>
+
+namespace systems {
+
+/**
+ * @brief Edge collapse simplifier keeping the original vertices, so every level indexes the same vertex buffer.
+ *
+ * Every vertex accumulates the error quadrics of the triangle planes around it (Garland & Heckbert).
+ * A pass sorts the candidate collapses of the current triangles by the error of moving a vertex onto
+ * one of its neighbours and applies the cheapest ones whose neighbourhoods do not overlap, skipping
+ * collapses that would flip a triangle. Quadrics are kept between calls, so simplify() can be called
+ * with decreasing targets to build a chain where each level is derived from the previous one.
+ *
+ * Vertices sharing a position (attribute seams) are welded for the topology. Vertices on borders,
+ * seams or non-manifold edges are never moved, which keeps the silhouette and the texture layout
+ * intact at the cost of a lower reduction on heavily split meshes.
+ */
+class MeshSimplifier {
+public:
+    MeshSimplifier(std::span<const glm::vec3> positions, std::span<const uint32_t> indices);
+    ~MeshSimplifier() = default;
+
+    MeshSimplifier(const MeshSimplifier&) = delete;
+    MeshSimplifier(MeshSimplifier&&) = delete;
+    auto operator=(const MeshSimplifier&) -> MeshSimplifier& = delete;
+    auto operator=(MeshSimplifier&&) -> MeshSimplifier& = delete;
+
+    /**
+     * @brief Collapse edges of the current triangles until at most targetIndexCount indices are left
+     * @param maxError Largest error a collapse may introduce, in model space units
+     * @return Error of the current triangles, stops early when no collapse stays under maxError
+     */
+    auto simplify(size_t targetIndexCount, float maxError) -> float;
+
+    [[nodiscard]]
+    auto getIndices() const noexcept -> std::span<const uint32_t> { return m_indices; }
+
+    /// @brief Largest distance of the current surface to the original one, estimated from the quadrics
+    [[nodiscard]]
+    auto getError() const noexcept -> float { return m_error; }
+private:
+    // Symmetric 4x4 matrix of the summed squared plane distances, weighted by triangle area
+    struct Quadric {
+        double a2, ab, ac, ad;
+        double b2, bc, bd;
+        double c2, cd;
+        double d2;
+        double weight;
+
+        auto operator+=(const Quadric& other) noexcept -> Quadric&;
+
+        /// @brief Mean squared distance of p to the accumulated planes
+        [[nodiscard]]
+        auto evaluate(const glm::vec3& p) const noexcept -> double;
+    };
+
+    struct Collapse {
+        uint32_t from;
+        uint32_t to;
+        double cost;
+    };
+
+    std::vector<glm::vec3> m_positions;
+    std::vector<uint32_t> m_indices;
+
+    std::vector<uint32_t> m_welded;     // First vertex with the same position, quadrics are kept there
+    std::vector<uint8_t> m_locked;      // Indexed by welded vertex
+    std::vector<Quadric> m_quadrics;    // Indexed by welded vertex
+
+    // Scratch of a pass, kept to avoid reallocations between passes
+    std::vector<uint32_t> m_triangleOffsets{};
+    std::vector<uint32_t> m_vertexTriangles{};
+    std::vector<Collapse> m_collapses{};
+    std::vector<uint32_t> m_remap{};
+    std::vector<uint8_t> m_touched{};
+
+    float m_error{0.f};
+
+    auto weld() -> void;
+    auto lock_boundaries() -> void;
+    auto compute_quadrics() -> void;
+    auto build_adjacency() -> void;
+
+    /// @brief Apply one pass of non-overlapping collapses, returns the number applied
+    auto collapse_pass(size_t targetIndexCount, double maxCost) -> size_t;
+
+    [[nodiscard]]
+    auto flips(uint32_t from, uint32_t to) const -> bool;
+};
+
+} // namespace systems
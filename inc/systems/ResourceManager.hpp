@@ -15,8 +15,11 @@ namespace systems {
 
 class ResourceManager {
 public:
-    ResourceManager(core::device::Instance& instance, core::device::Device& device)
-    : memoryManager(instance, device)
+    ResourceManager(
+        core::device::Instance& instance,
+        core::device::Device& device,
+        VkDeviceSize stagingSize = StagingRing::DEFAULT_SIZE)
+    : memoryManager(instance, device, stagingSize)
     , m_defaultDiffuse(std::make_shared<graphics::Texture>(memoryManager, "textures/fallback/white.bmp"))
     , m_defaultNormal(std::make_shared<graphics::Texture>(memoryManager, "textures/fallback/normal_default.bmp"))
     , m_defaultSpecular(std::make_shared<graphics::Texture>(memoryManager, "textures/fallback/black.bmp"))
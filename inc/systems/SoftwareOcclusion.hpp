@@ -0,0 +1,108 @@
+/**
+ * @file systems/SoftwareOcclusion.hpp
+ * @brief CPU occlusion culling: low resolution SIMD depth rasterizer for occluder meshes and box visibility tests.
+ */
+#pragma once
+
+#include <cstdint>
+#include <span>
+#include <vector>
+
+#include <glm/glm.hpp>
+
+#include "systems/JobSystem.hpp"
+
+namespace systems {
+
+/**
+ * @brief Small depth buffer the designated occluders are rasterized into once per frame.
+ *
+ * Depth is stored as 1/w (0 is empty, larger is closer), which interpolates linearly in screen
+ * space. Triangles are transformed, near-clipped and set up serially by addOccluder(), then
+ * rasterize() fills horizontal bands of tile rows in parallel, 4 pixels per SSE iteration.
+ * Every TILE_SIZE x TILE_SIZE tile keeps the farthest depth of its pixels, isOccluded() projects
+ * a box and compares its closest point against the tiles it covers, so a test costs a handful of
+ * tile reads no matter how large the box is on screen.
+ *
+ * Clip space follows graphics::Camera: OpenGL depth range with the near plane at z = -w.
+ */
+class SoftwareOcclusion {
+public:
+    static constexpr uint32_t TILE_SIZE = 8;
+
+    /// @param width, height Resolution of the depth buffer, rounded up to whole tiles
+    explicit SoftwareOcclusion(uint32_t width = 320, uint32_t height = 192);
+    ~SoftwareOcclusion() = default;
+
+    SoftwareOcclusion(const SoftwareOcclusion&) = delete;
+    SoftwareOcclusion(SoftwareOcclusion&&) = delete;
+    auto operator=(const SoftwareOcclusion&) -> SoftwareOcclusion& = delete;
+    auto operator=(SoftwareOcclusion&&) -> SoftwareOcclusion& = delete;
+
+    /// @brief Drop the occluders of the previous frame and start one seen through viewProj
+    auto begin(const glm::mat4& viewProj) -> void;
+
+    /**
+     * @brief Queue the triangles of an occluder, off-screen triangles are dropped here
+     * @param model Model matrix of the occluder instance
+     * @param positions Model space vertex positions
+     * @param indices Triangle list into positions
+     */
+    auto addOccluder(
+        const glm::mat4& model,
+        std::span<const glm::vec3> positions,
+        std::span<const uint32_t> indices) -> void;
+
+    /// @brief Rasterize the queued triangles, one band of tile rows per task when jobSystem is not null
+    auto rasterize(JobSystem* jobSystem = nullptr) -> void;
+
+    /**
+     * @brief Test a box against the rasterized occluders
+     * @param model Transform of the box
+     * @param min, max Model space bounds
+     * @return true only if the whole box is behind the occluders, boxes crossing the near plane or off-screen are not
+     */
+    [[nodiscard]]
+    auto isOccluded(const glm::mat4& model, const glm::vec3& min, const glm::vec3& max) const -> bool;
+
+    [[nodiscard]]
+    auto getWidth() const noexcept -> uint32_t { return m_width; }
+
+    [[nodiscard]]
+    auto getHeight() const noexcept -> uint32_t { return m_height; }
+
+    /// @brief Triangles left after clipping, i.e. rasterized by the next rasterize()
+    [[nodiscard]]
+    auto getTriangleCount() const noexcept -> size_t { return m_triangles.size(); }
+
+    /// @brief Row major 1/w per pixel, for debug views
+    [[nodiscard]]
+    auto getDepth() const noexcept -> std::span<const float> { return m_depth; }
+private:
+    // Edge functions a * x + b * y + c are >= 0 inside, depth is the 1/w plane
+    struct Triangle {
+        float edgeA[3];
+        float edgeB[3];
+        float edgeC[3];
+        float depthA, depthB, depthC;
+        int32_t minX, maxX;
+        int32_t minY, maxY;
+    };
+
+    const uint32_t m_width;
+    const uint32_t m_height;
+    const uint32_t m_tilesX;
+    const uint32_t m_tilesY;
+
+    glm::mat4 m_viewProj{1.f};
+
+    std::vector<Triangle> m_triangles{};
+    std::vector<glm::vec4> m_clipVertices{};  // Scratch for the occluder being added
+    std::vector<float> m_depth{};
+    std::vector<float> m_tileDepth{};   // Farthest (smallest) 1/w of every tile
+
+    auto setup_triangle(const glm::vec4& v0, const glm::vec4& v1, const glm::vec4& v2) -> void;
+    auto rasterize_band(uint32_t firstTileRow, uint32_t lastTileRow) -> void;
+};
+
+} // namespace systems
@@ -0,0 +1,144 @@
+/**
+ * @file systems/SpatialIndex.hpp
+ * @brief Bounding volume hierarchy over world space instance bounds, used for culling and spatial queries.
+ */
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include <limits>
+#include <optional>
+#include <vector>
+
+#include <glm/glm.hpp>
+
+namespace systems {
+
+/**
+ * @brief BVH of axis aligned boxes identified by stable handles.
+ *
+ * Changes are applied on the next commit(). Moving an item refits the node bounds bottom-up,
+ * an inserted item descends to the leaf whose surface area grows the least, growing the nodes on
+ * the way, and a removed one leaves its leaf, whose ancestors shrink again. Full leaves are split
+ * with the binned SAH of build(), emptied ones are replaced by their sibling. The tree is only
+ * rebuilt when these changes made it too expensive (surface area heuristic cost grown past
+ * REBUILD_COST_RATIO), when they left too many unused nodes & items behind, or when more items
+ * are inserted at once than it holds. Queries return handles and reject whole subtrees, subtrees
+ * fully inside a frustum or sphere are accepted without testing their items.
+ */
+class SpatialIndex {
+public:
+    using Handle = uint32_t;
+
+    struct AABB {
+        glm::vec3 min;
+        glm::vec3 max;
+    };
+
+    struct RayHit {
+        Handle handle;
+        float distance;     // Along the ray direction to the box entry point
+    };
+
+    using Frustum = std::array<glm::vec4, 6>;  // xyz normal pointing inside, w distance
+
+    // Rebuild once a refit makes the tree this many times more expensive than when it was built
+    static constexpr float REBUILD_COST_RATIO = 1.5f;
+
+    SpatialIndex() = default;
+    ~SpatialIndex() = default;
+
+    SpatialIndex(const SpatialIndex&) = delete;
+    SpatialIndex(SpatialIndex&&) = delete;
+    auto operator=(const SpatialIndex&) -> SpatialIndex& = delete;
+    auto operator=(SpatialIndex&&) -> SpatialIndex& = delete;
+
+    [[nodiscard]]
+    auto insert(const AABB& bounds) -> Handle;
+    /// @brief Queries keep returning the item until the next commit(), only then is its handle reused
+    auto remove(Handle handle) -> void;
+    auto setBounds(Handle handle, const AABB& bounds) -> void;
+
+    /// @brief Apply pending changes, refit or rebuild as needed. Queries see the state of the last commit
+    auto commit() -> void;
+
+    /// @brief Rebuild the whole tree from the current bounds
+    auto build() -> void;
+
+    /// @brief Recompute node bounds bottom-up without changing the tree topology
+    auto refit() -> void;
+
+    auto queryFrustum(const Frustum& frustum, std::vector<Handle>& out) const -> void;
+    auto querySphere(const glm::vec3& center, float radius, std::vector<Handle>& out) const -> void;
+
+    /// @brief Closest box hit by the ray within maxDistance, direction does not need to be normalized
+    [[nodiscard]]
+    auto queryRay(
+        const glm::vec3& origin,
+        const glm::vec3& direction,
+        float maxDistance = std::numeric_limits<float>::max()
+    ) const -> std::optional<RayHit>;
+
+    [[nodiscard]]
+    auto getBounds(Handle handle) const -> const AABB& { return m_bounds[handle]; }
+
+    [[nodiscard]]
+    auto size() const noexcept -> size_t { return m_bounds.size() - m_freeHandles.size() - m_pendingRemovals.size(); }
+
+    /// @brief Nodes of the tree, without those left unused by removals until the next rebuild
+    [[nodiscard]]
+    auto getNodeCount() const noexcept -> size_t { return m_nodes.size() - m_unusedNodes; }
+
+    /// @brief World space box of a model space box moved by transform
+    [[nodiscard]]
+    static auto transform(const AABB& bounds, const glm::mat4& transform) noexcept -> AABB;
+private:
+    struct Node {
+        AABB bounds;
+        uint32_t first;     // First child (the second is first + 1) or first item in m_items for leaves, UNUSED_NODE if unused
+        uint32_t count;     // Item count, 0 for inner nodes
+        uint32_t parent;    // NO_NODE for the root
+    };
+
+    static constexpr uint32_t MAX_LEAF_ITEMS = 4;
+    static constexpr uint32_t SAH_BINS = 12;
+    static constexpr uint32_t NO_NODE = std::numeric_limits<uint32_t>::max();
+    static constexpr uint32_t UNUSED_NODE = std::numeric_limits<uint32_t>::max();
+
+    std::vector<AABB> m_bounds{};           // Indexed by handle
+    std::vector<uint8_t> m_alive{};
+    std::vector<uint32_t> m_leaves{};       // Indexed by handle, NO_NODE while not in the tree
+    std::vector<Handle> m_freeHandles{};
+    std::vector<Handle> m_pendingInserts{};
+    std::vector<Handle> m_pendingRemovals{};
+
+    // Children are always stored after their parent, refit() relies on it
+    std::vector<Node> m_nodes{};
+    std::vector<Handle> m_items{};          // Leaf ranges point into this array
+    std::vector<glm::vec3> m_centroids{};   // Indexed by handle, only valid while splitting
+
+    uint32_t m_itemCount{0};                // Items in the tree
+    uint32_t m_unusedNodes{0};              // Left behind by removals, reclaimed by the next build()
+    uint32_t m_unusedItems{0};              // Slots of m_items no leaf range covers anymore
+    bool m_boundsDirty{false};
+    float m_cost{0.f};                      // Surface area heuristic cost of the tree, not relative to the root yet
+    float m_builtCost{0.f};
+
+    auto split(uint32_t nodeIndex) -> void;
+    /// @brief Add an item to the leaf its box grows the least on the way down, split the leaf once full
+    auto insert_item(Handle handle) -> void;
+    /// @brief Take an item out of its leaf, an emptied leaf is replaced by its sibling
+    auto remove_item(Handle handle) -> void;
+    /// @brief Recompute the bounds of a node, then those of its ancestors until one is unchanged
+    auto refit_path(uint32_t nodeIndex) -> void;
+    /// @brief Point the items or children of a node back at it after it moved
+    auto adopt(uint32_t nodeIndex) -> void;
+    [[nodiscard]]
+    static auto node_cost(const Node& node) noexcept -> float;
+    [[nodiscard]]
+    auto compute_cost() const -> float;
+    [[nodiscard]]
+    auto relative_cost() const noexcept -> float;
+};
+
+} // namespace systems
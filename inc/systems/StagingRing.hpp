@@ -0,0 +1,91 @@
+/**
+ * @file systems/StagingRing.hpp
+ * @brief Persistently mapped staging buffer the uploads are bump allocated from, reclaimed as upload batches complete.
+ */
+#pragma once
+
+#include <vulkan/vulkan.h>
+
+#include <deque>
+#include <optional>
+
+#include "core/memory/Buffer.hpp"
+#include "systems/UploadBatch.hpp"
+
+namespace systems {
+
+class MemoryManager;
+
+/**
+ * @brief One STAGING buffer used as a ring, allocations are a pointer bump tagged with the serial of their upload batch.
+ *
+ * The space of a batch is reclaimed once the batch completed. When the ring is full the batches
+ * holding it are submitted & waited on, counted as a stall. Uploads larger than half the ring spill
+ * to a temporary buffer instead, so a single large texture doesn't flush everything staged before it.
+ */
+class StagingRing {
+public:
+    static constexpr VkDeviceSize DEFAULT_SIZE = 64ull << 20;
+    // Satisfies the copy offset alignment of buffers & of images with texels up to 16 bytes
+    static constexpr VkDeviceSize ALIGNMENT = 16;
+
+    // Usage between two endFrame() calls, to size the ring
+    struct FrameStats {
+        VkDeviceSize highWater{0};  // Peak bytes in use, including alignment & wrap-around padding
+        VkDeviceSize staged{0};     // Bytes staged in the ring
+        VkDeviceSize spilled{0};    // Bytes staged in temporary buffers
+        uint32_t stalls{0};         // Waits for the GPU to free space in the ring
+    };
+
+    StagingRing(MemoryManager& memoryManager, UploadBatch& uploads, VkDeviceSize size);
+    ~StagingRing() = default;
+
+    StagingRing(const StagingRing&) = delete;
+    StagingRing(StagingRing&&) = delete;
+    auto operator=(const StagingRing&) -> StagingRing& = delete;
+    auto operator=(StagingRing&&) -> StagingRing& = delete;
+
+    /**
+     * @brief Copy data into the ring for a copy recorded into the upload batch right after
+     * @return Offset of the data in getBuffer(), nullopt if it is too large for the ring and has to spill
+     */
+    [[nodiscard]]
+    auto stage(const void* data, VkDeviceSize size) -> std::optional<VkDeviceSize>;
+
+    /// @brief Count a spilled upload, see stage()
+    auto countSpill(VkDeviceSize size) noexcept -> void { m_frameStats.spilled += size; }
+
+    /// @brief Usage since the previous call, restarts the counters
+    auto endFrame() noexcept -> FrameStats;
+
+    [[nodiscard]]
+    auto getBuffer() noexcept -> core::memory::Buffer& { return m_buffer; }
+
+    [[nodiscard]]
+    auto getCapacity() const noexcept -> VkDeviceSize { return m_capacity; }
+
+    /// @brief Bytes held by batches not known to be complete yet
+    [[nodiscard]]
+    auto getUsed() const noexcept -> VkDeviceSize;
+private:
+    UploadBatch& m_uploads;
+    const VkDeviceSize m_capacity;
+    core::memory::Buffer m_buffer;
+
+    // End of the space taken by every batch still holding some, oldest first
+    struct Region {
+        uint64_t serial;
+        VkDeviceSize end;
+    };
+
+    std::deque<Region> m_regions{};
+    VkDeviceSize m_head{0};     // Next allocation starts here
+    VkDeviceSize m_tail{0};     // Start of the oldest region in use
+
+    FrameStats m_frameStats{};
+
+    auto release(uint64_t completedSerial) noexcept -> void;
+    auto try_allocate(VkDeviceSize size, uint64_t serial) noexcept -> std::optional<VkDeviceSize>;
+};
+
+} // namespace systems
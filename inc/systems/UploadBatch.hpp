@@ -0,0 +1,166 @@
+/**
+ * @file systems/UploadBatch.hpp
+ * @brief Copies & layout transitions recorded into one command buffer and submitted at once, tracked on a queue timeline.
+ */
+#pragma once
+
+#include <vulkan/vulkan.h>
+
+#include <array>
+#include <utility>
+#include <vector>
+
+#include "core/commands/CommandPool.hpp"
+#include "core/commands/GpuProfiler.hpp"
+#include "core/device/Device.hpp"
+#include "core/device/Queue.hpp"
+#include "core/memory/Buffer.hpp"
+#include "core/memory/Image.hpp"
+#include "core/sync/Sync.hpp"
+#include "core/sync/QueueTimeline.hpp"
+
+namespace systems {
+
+/**
+ * @brief Records uploads into a single command buffer, submitted once instead of a queue drain per copy.
+ *
+ * Commands are recorded until submit(), which doesn't block, completion is the timeline value of
+ * the last submission of the batch. Batches are recorded into a small pool of command buffers, each
+ * tagged with the completion value of the last batch recorded into it, so up to
+ * MAX_BATCHES_IN_FLIGHT batches run at once and recording only waits when the oldest one's buffer is
+ * needed again. Staging buffers handed to retain() are released by a timeline callback once the
+ * batch completed.
+ *
+ * When the uploads run on a queue of another family than the one using the resources, e.g. a
+ * dedicated transfer queue, the written buffer ranges & the images transitioned to
+ * SHADER_READ_ONLY_OPTIMAL are released to the owner family. A second submission on the owner
+ * queue waits on the upload's timeline value & acquires them, later submissions on the owner
+ * queue are ordered after it. On the same family the upload ends with a barrier making the transfer
+ * writes visible to every later vertex, index & shader read instead.
+ */
+class UploadBatch {
+public:
+    // Command buffers batches are recorded into, round-robin
+    static constexpr uint32_t MAX_BATCHES_IN_FLIGHT = 4;
+
+    /**
+     * @param timeline Timeline of the queue the uploads are submitted to
+     * @param ownerTimeline Timeline of the queue using the uploaded resources, they're handed over to its family if it differs
+     */
+    UploadBatch(core::device::Device& device, core::sync::QueueTimeline& timeline, core::sync::QueueTimeline& ownerTimeline);
+    ~UploadBatch();
+
+    UploadBatch(const UploadBatch&) = delete;
+    UploadBatch(UploadBatch&&) = delete;
+    auto operator=(const UploadBatch&) -> UploadBatch& = delete;
+    auto operator=(UploadBatch&&) -> UploadBatch& = delete;
+
+    auto copy(
+        core::memory::Buffer& srcBuffer,
+        core::memory::Buffer& dstBuffer,
+        VkDeviceSize size = VK_WHOLE_SIZE,
+        VkDeviceSize srcOffset = 0,
+        VkDeviceSize dstOffset = 0
+    ) -> void;
+
+    /// @brief Copy into the first mip level of an image in TRANSFER_DST_OPTIMAL layout
+    auto copy(
+        core::memory::Buffer& srcBuffer,
+        core::memory::Image& dstImage,
+        VkExtent3D extent,
+        VkDeviceSize srcOffset = 0
+    ) -> void;
+
+    /// @brief Supports UNDEFINED -> TRANSFER_DST_OPTIMAL and TRANSFER_DST_OPTIMAL -> SHADER_READ_ONLY_OPTIMAL
+    auto transition(
+        core::memory::Image& image,
+        VkImageLayout oldLayout,
+        VkImageLayout newLayout
+    ) -> void;
+
+    /// @brief Keep a buffer alive until the recorded commands completed, released right away if nothing is recorded
+    auto retain(core::memory::Buffer&& buffer) -> void;
+
+    /// @brief Submit the recorded commands without waiting, does nothing if none were recorded
+    auto submit() -> void;
+
+    /// @brief Drop the recorded commands & their retained buffers, e.g. when their destinations were destroyed
+    auto discard() -> void;
+
+    /// @brief Wait for the submitted batches, their retained buffers are released by the timeline
+    auto wait() -> void;
+
+    /// @brief Whether no commands were recorded since the last submit
+    [[nodiscard]]
+    auto empty() const noexcept -> bool { return !m_recording; }
+
+    /// @brief Whether the last submitted batch completed, true if none is in flight
+    [[nodiscard]]
+    auto isComplete() const -> bool;
+
+    /// @brief Serial of the batch being recorded, batches are numbered from 1 in submission order
+    [[nodiscard]]
+    auto getRecordingSerial() const noexcept -> uint64_t { return m_submitCount + 1; }
+
+    /// @brief Serial of the last batch known to be complete, 0 if none is
+    [[nodiscard]]
+    auto getCompletedSerial() const -> uint64_t;
+
+    /// @brief Commands recorded into the batch being recorded
+    [[nodiscard]]
+    auto getCommandCount() const noexcept -> uint32_t { return m_commandCount; }
+
+    /// @brief Bytes copied by the batches submitted since the previous call, restarts the count
+    auto endFrame() noexcept -> uint64_t { return std::exchange(m_bytesSubmitted, 0); }
+
+    /// @brief Time every following batch as an "upload" scope of profiler, nullptr stops timing
+    auto setProfiler(core::commands::GpuProfiler* profiler) noexcept -> void { m_profiler = profiler; }
+
+    /// @brief Whether the resources change queue family ownership, i.e. uploads run on a dedicated queue
+    [[nodiscard]]
+    auto transfersOwnership() const noexcept -> bool { return m_transfersOwnership; }
+
+    /// @brief Timeline the batches complete on, the owner's when ownership is transferred
+    [[nodiscard]]
+    auto getCompletionTimeline() const noexcept -> core::sync::QueueTimeline& { return m_completionTimeline; }
+
+    /// @brief Value of the completion timeline reached by the last submitted batch, 0 before the first one
+    [[nodiscard]]
+    auto getSubmittedValue() const noexcept -> uint64_t { return m_submittedValue; }
+private:
+    core::sync::QueueTimeline& m_timeline;
+    core::sync::QueueTimeline& m_ownerTimeline;
+    const core::device::Queue& m_queue;
+    const core::device::Queue& m_ownerQueue;
+    const bool m_transfersOwnership;
+    core::sync::QueueTimeline& m_completionTimeline;
+
+    // A command buffer per batch in flight, the batch of serial s uses (s - 1) % MAX_BATCHES_IN_FLIGHT
+    core::commands::CommandPool m_commandPool;
+    core::commands::CommandPool m_acquirePool;  // Of the owner family, for the acquire barriers
+    std::array<uint64_t, MAX_BATCHES_IN_FLIGHT> m_slotValues{};    // Completion value of the last batch of each slot, 0 if none
+
+    // Ownership transfers of the batch being recorded, as acquired by the owner family
+    std::vector<VkBufferMemoryBarrier> m_bufferAcquires{};
+    std::vector<VkImageMemoryBarrier> m_imageAcquires{};
+
+    std::vector<core::memory::Buffer> m_retained{};     // Of the batch being recorded
+
+    core::commands::GpuProfiler* m_profiler{nullptr};
+    uint32_t m_profilerSubmission{core::commands::GpuProfiler::NO_SUBMISSION};    // Of the batch being recorded
+
+    uint64_t m_submittedValue{0};
+    uint64_t m_submitCount{0};
+    uint64_t m_bytesSubmitted{0};   // Since the last endFrame(), discarded batches don't count
+    uint32_t m_commandCount{0};
+    bool m_recording{false};
+    bool m_buffersWritten{false};
+
+    [[nodiscard]]
+    auto current_slot() const noexcept -> uint32_t { return static_cast<uint32_t>(m_submitCount % MAX_BATCHES_IN_FLIGHT); }
+
+    auto begin_recording() -> core::commands::CommandBuffer&;
+    auto submit_acquire(uint64_t uploadValue) -> uint64_t;
+};
+
+} // namespace systems
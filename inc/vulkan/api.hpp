@@ -44,6 +44,57 @@ void CmdDrawIndexed(
     uint32_t                                    firstInstance,
     const std::source_location&                 location = std::source_location::current());
 
+/// @see https://registry.khronos.org/vulkan/specs/latest/man/html/vkCmdDrawIndexedIndirect.html
+void CmdDrawIndexedIndirect(
+    VkCommandBuffer                             commandBuffer,
+    VkBuffer                                    buffer,
+    VkDeviceSize                                offset,
+    uint32_t                                    drawCount,
+    uint32_t                                    stride,
+    const std::source_location&                 location = std::source_location::current());
+
+/// @see https://registry.khronos.org/vulkan/specs/latest/man/html/vkCmdDrawIndexedIndirectCount.html
+void CmdDrawIndexedIndirectCount(
+    VkCommandBuffer                             commandBuffer,
+    VkBuffer                                    buffer,
+    VkDeviceSize                                offset,
+    VkBuffer                                    countBuffer,
+    VkDeviceSize                                countBufferOffset,
+    uint32_t                                    maxDrawCount,
+    uint32_t                                    stride,
+    const std::source_location&                 location = std::source_location::current());
+
+/// @see https://registry.khronos.org/vulkan/specs/latest/man/html/vkCmdDispatch.html
+void CmdDispatch(
+    VkCommandBuffer                             commandBuffer,
+    uint32_t                                    groupCountX,
+    uint32_t                                    groupCountY,
+    uint32_t                                    groupCountZ,
+    const std::source_location&                 location = std::source_location::current());
+
+/// @see https://registry.khronos.org/vulkan/specs/latest/man/html/vkCmdPipelineBarrier.html
+void CmdPipelineBarrier(
+    VkCommandBuffer                             commandBuffer,
+    VkPipelineStageFlags                        srcStageMask,
+    VkPipelineStageFlags                        dstStageMask,
+    VkDependencyFlags                           dependencyFlags,
+    uint32_t                                    memoryBarrierCount,
+    const VkMemoryBarrier*                      pMemoryBarriers,
+    uint32_t                                    bufferMemoryBarrierCount,
+    const VkBufferMemoryBarrier*                pBufferMemoryBarriers,
+    uint32_t                                    imageMemoryBarrierCount,
+    const VkImageMemoryBarrier*                 pImageMemoryBarriers,
+    const std::source_location&                 location = std::source_location::current());
+
+/// @see https://registry.khronos.org/vulkan/specs/latest/man/html/vkCmdFillBuffer.html
+void CmdFillBuffer(
+    VkCommandBuffer                             commandBuffer,
+    VkBuffer                                    dstBuffer,
+    VkDeviceSize                                dstOffset,
+    VkDeviceSize                                size,
+    uint32_t                                    data,
+    const std::source_location&                 location = std::source_location::current());
+
 /// @see https://registry.khronos.org/vulkan/specs/latest/man/html/vkAcquireNextImageKHR.html
 void AcquireNextImageKHR(
     VkDevice                                    device,
@@ -155,6 +206,27 @@ VkResult GetFenceStatus(
     VkFence                                     fence,
     const std::source_location&                 location = std::source_location::current());
 
+/// @brief VK_TIMEOUT is not an error, the result is returned like WaitForFences
+/// @see https://registry.khronos.org/vulkan/specs/latest/man/html/vkWaitSemaphores.html
+VkResult WaitSemaphores(
+    VkDevice                                    device,
+    const VkSemaphoreWaitInfo*                  pWaitInfo,
+    uint64_t                                    timeout,
+    const std::source_location&                 location = std::source_location::current());
+
+/// @see https://registry.khronos.org/vulkan/specs/latest/man/html/vkGetSemaphoreCounterValue.html
+void GetSemaphoreCounterValue(
+    VkDevice                                    device,
+    VkSemaphore                                 semaphore,
+    uint64_t*                                   pValue,
+    const std::source_location&                 location = std::source_location::current());
+
+/// @see https://registry.khronos.org/vulkan/specs/latest/man/html/vkSignalSemaphore.html
+void SignalSemaphore(
+    VkDevice                                    device,
+    const VkSemaphoreSignalInfo*                pSignalInfo,
+    const std::source_location&                 location = std::source_location::current());
+
 // Device functions
 /// @see https://registry.khronos.org/vulkan/specs/latest/man/html/vkEnumeratePhysicalDevices.html
 void EnumeratePhysicalDevices(
@@ -286,6 +358,13 @@ void GetSwapchainImagesKHR(
     VkImage*                                    pSwapchainImages,
     const std::source_location&                 location = std::source_location::current());
 
+/// @see https://registry.khronos.org/vulkan/specs/latest/man/html/vkGetImageMemoryRequirements.html
+void GetImageMemoryRequirements(
+    VkDevice                                    device,
+    VkImage                                     image,
+    VkMemoryRequirements*                       pMemoryRequirements,
+    const std::source_location&                 location = std::source_location::current());
+
 /// @see https://registry.khronos.org/vulkan/specs/latest/man/html/vkCreateImageView.html
 void CreateImageView(
     VkDevice                                    device,
@@ -379,6 +458,13 @@ void DestroyCommandPool(
     const VkAllocationCallbacks*                pAllocator,
     const std::source_location&                 location = std::source_location::current());
 
+/// @see https://registry.khronos.org/vulkan/specs/latest/man/html/vkResetCommandPool.html
+void ResetCommandPool(
+    VkDevice                                    device,
+    VkCommandPool                               commandPool,
+    VkCommandPoolResetFlags                     flags,
+    const std::source_location&                 location = std::source_location::current());
+
 /// @see https://registry.khronos.org/vulkan/specs/latest/man/html/vkAllocateCommandBuffers.html
 void AllocateCommandBuffers(
     VkDevice                                    device,
@@ -423,6 +509,13 @@ void CmdEndRenderPass(
     VkCommandBuffer                             commandBuffer,
     const std::source_location&                 location = std::source_location::current());
 
+/// @see https://registry.khronos.org/vulkan/specs/latest/man/html/vkCmdExecuteCommands.html
+void CmdExecuteCommands(
+    VkCommandBuffer                             commandBuffer,
+    uint32_t                                    commandBufferCount,
+    const VkCommandBuffer*                      pCommandBuffers,
+    const std::source_location&                 location = std::source_location::current());
+
 /// @see https://registry.khronos.org/vulkan/specs/latest/man/html/vkCmdBindPipeline.html
 void CmdBindPipeline(
     VkCommandBuffer                             commandBuffer,
@@ -505,6 +598,16 @@ void CreateGraphicsPipelines(
     VkPipeline*                                 pPipelines,
     const std::source_location&                 location = std::source_location::current());
 
+/// @see https://registry.khronos.org/vulkan/specs/latest/man/html/vkCreateComputePipelines.html
+void CreateComputePipelines(
+    VkDevice                                    device,
+    VkPipelineCache                             pipelineCache,
+    uint32_t                                    createInfoCount,
+    const VkComputePipelineCreateInfo*          pCreateInfos,
+    const VkAllocationCallbacks*                pAllocator,
+    VkPipeline*                                 pPipelines,
+    const std::source_location&                 location = std::source_location::current());
+
 /// @see https://registry.khronos.org/vulkan/specs/latest/man/html/vkDestroyPipeline.html
 void DestroyPipeline(
     VkDevice                                    device,
@@ -622,4 +725,72 @@ void DestroyImage(
     const VkAllocationCallbacks*                pAllocator,
     const std::source_location&                 location = std::source_location::current());
 
+/// Query functions
+/// @see https://registry.khronos.org/vulkan/specs/latest/man/html/vkCreateQueryPool.html
+void CreateQueryPool(
+    VkDevice                                    device,
+    const VkQueryPoolCreateInfo*                pCreateInfo,
+    const VkAllocationCallbacks*                pAllocator,
+    VkQueryPool*                                pQueryPool,
+    const std::source_location&                 location = std::source_location::current());
+
+/// @see https://registry.khronos.org/vulkan/specs/latest/man/html/vkDestroyQueryPool.html
+void DestroyQueryPool(
+    VkDevice                                    device,
+    VkQueryPool                                 queryPool,
+    const VkAllocationCallbacks*                pAllocator,
+    const std::source_location&                 location = std::source_location::current());
+
+/// @see https://registry.khronos.org/vulkan/specs/latest/man/html/vkCmdResetQueryPool.html
+void CmdResetQueryPool(
+    VkCommandBuffer                             commandBuffer,
+    VkQueryPool                                 queryPool,
+    uint32_t                                    firstQuery,
+    uint32_t                                    queryCount,
+    const std::source_location&                 location = std::source_location::current());
+
+/// @see https://registry.khronos.org/vulkan/specs/latest/man/html/vkResetQueryPool.html
+void ResetQueryPool(
+    VkDevice                                    device,
+    VkQueryPool                                 queryPool,
+    uint32_t                                    firstQuery,
+    uint32_t                                    queryCount,
+    const std::source_location&                 location = std::source_location::current());
+
+/// @see https://registry.khronos.org/vulkan/specs/latest/man/html/vkCmdWriteTimestamp.html
+void CmdWriteTimestamp(
+    VkCommandBuffer                             commandBuffer,
+    VkPipelineStageFlagBits                     pipelineStage,
+    VkQueryPool                                 queryPool,
+    uint32_t                                    query,
+    const std::source_location&                 location = std::source_location::current());
+
+/// @see https://registry.khronos.org/vulkan/specs/latest/man/html/vkCmdBeginQuery.html
+void CmdBeginQuery(
+    VkCommandBuffer                             commandBuffer,
+    VkQueryPool                                 queryPool,
+    uint32_t                                    query,
+    VkQueryControlFlags                         flags,
+    const std::source_location&                 location = std::source_location::current());
+
+/// @see https://registry.khronos.org/vulkan/specs/latest/man/html/vkCmdEndQuery.html
+void CmdEndQuery(
+    VkCommandBuffer                             commandBuffer,
+    VkQueryPool                                 queryPool,
+    uint32_t                                    query,
+    const std::source_location&                 location = std::source_location::current());
+
+/// @brief VK_NOT_READY is not an error, the result is returned like GetFenceStatus
+/// @see https://registry.khronos.org/vulkan/specs/latest/man/html/vkGetQueryPoolResults.html
+VkResult GetQueryPoolResults(
+    VkDevice                                    device,
+    VkQueryPool                                 queryPool,
+    uint32_t                                    firstQuery,
+    uint32_t                                    queryCount,
+    size_t                                      dataSize,
+    void*                                       pData,
+    VkDeviceSize                                stride,
+    VkQueryResultFlags                          flags,
+    const std::source_location&                 location = std::source_location::current());
+
 } // namespace vulkan
@@ -46,4 +46,8 @@ auto get_default<ClearColor>() noexcept -> ClearColor {
 [[nodiscard]]
 auto get_default_validation_layers() noexcept -> std::vector<const char*>;
 
+/// @brief Bytes per texel of an uncompressed format, throws for the formats the renderer never creates
+[[nodiscard]]
+auto get_format_size(const VkFormat format) -> uint32_t;
+
 } // namespace vulkan
@@ -0,0 +1,44 @@
+#version 460 core
+
+// Depth pre-pass, writes the depth the shading pass is then tested against with EQUAL.
+// gl_Position must be computed exactly like in generic.vert, both declare it invariant.
+
+layout(set = 0, binding = 0) uniform CameraUBO {
+    mat4 view;
+    mat4 proj;
+    vec3 position;
+    uint debugConfig;
+} camera;
+
+struct InstanceData {
+    mat4 model;
+};
+
+layout(std430, set = 0, binding = 2) readonly buffer InstanceBuffer {
+    InstanceData instances[];
+} instanceData;
+
+layout(std430, set = 0, binding = 3) readonly buffer DrawInstanceBuffer {
+    uint indices[];
+} drawInstances;
+
+// Same block as generic.vert, only indexedInstances is read
+layout(push_constant) uniform PushConstants {
+    vec4 color;
+    float time;
+    uint objectId;
+    uint indexedInstances;
+    float padding;
+} pc;
+
+layout(location = 0) in vec3 inPosition;
+
+invariant gl_Position;
+
+void main() {
+    const uint instance = pc.indexedInstances != 0 ? drawInstances.indices[gl_InstanceIndex] : gl_InstanceIndex;
+    const mat4 model = instanceData.instances[instance].model;
+    mat4 mvp = camera.proj * camera.view * model;
+
+    gl_Position = mvp * vec4(inPosition, 1.0);
+}
@@ -37,7 +37,6 @@ layout(set = 1, binding = 4) uniform sampler2D emissive_tex;
 
 // Push constants
 layout(push_constant) uniform PushConstant {
-    mat4 model;
     vec4 color;
     float time;
     uint objectId;
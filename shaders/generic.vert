@@ -21,6 +21,20 @@ layout(set = 0, binding = 1) uniform LightUBO {
     uint pointLightCount;
 } lights;
 
+// Per-instance data, indexed by gl_InstanceIndex (includes firstInstance of the draw)
+struct InstanceData {
+    mat4 model;
+};
+
+layout(std430, set = 0, binding = 2) readonly buffer InstanceBuffer {
+    InstanceData instances[];
+} instanceData;
+
+// Sorted visible instances of the CPU path, indexed by gl_InstanceIndex when pc.indexedInstances is set
+layout(std430, set = 0, binding = 3) readonly buffer DrawInstanceBuffer {
+    uint indices[];
+} drawInstances;
+
 // Set 1: Material UBOs
 layout(set = 1, binding = 0) uniform MaterialUBO {
     float placeholder;
@@ -30,11 +44,11 @@ layout(set = 1, binding = 0) uniform MaterialUBO {
 
 // Push constants
 layout(push_constant) uniform PushConstants {
-    mat4 model;
     vec4 color;
     float time;
     uint objectId;
-    vec2 padding;
+    uint indexedInstances;
+    float padding;
 } pc;
 
 // Input attributes
@@ -49,12 +63,17 @@ layout(location = 1) out vec3 fragNormal;
 layout(location = 2) out vec3 fragTangent;
 layout(location = 3) out vec2 fragTexCoord;
 
+// Tested with EQUAL against the depth written by depth.vert when the pre-pass is enabled
+invariant gl_Position;
+
 void main() {
-    mat4 mvp = camera.proj * camera.view * pc.model;
+    const uint instance = pc.indexedInstances != 0 ? drawInstances.indices[gl_InstanceIndex] : gl_InstanceIndex;
+    const mat4 model = instanceData.instances[instance].model;
+    mat4 mvp = camera.proj * camera.view * model;
 
-    fragPosition = vec3(pc.model * vec4(inPosition, 1.0));
-    fragNormal = normalize(mat3(transpose(inverse(pc.model))) * inNormal);
-    fragTangent = normalize(mat3(pc.model) * inTangent);
+    fragPosition = vec3(model * vec4(inPosition, 1.0));
+    fragNormal = normalize(mat3(transpose(inverse(model))) * inNormal);
+    fragTangent = normalize(mat3(model) * inTangent);
     fragTexCoord = inTexCoord;
 
     gl_Position = mvp * vec4(inPosition, 1.0);
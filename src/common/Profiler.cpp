@@ -0,0 +1,120 @@
+#include "common/Profiler.hpp"
+
+#include <cstdlib>
+#include <format>
+#include <fstream>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+namespace common {
+
+namespace {
+
+auto escape(const char* name) -> std::string {
+    std::string escaped;
+    for (const char* c = name; *c != '\0'; c++) {
+        if (*c == '"' || *c == '\\') {
+            escaped += '\\';
+        }
+        escaped += *c;
+    }
+    return escaped;
+}
+
+} // namespace
+
+// Buffers outlive their threads so zones of finished jobs still end up in the trace
+struct Profiler::Registry {
+    std::mutex mutex;
+    std::vector<std::unique_ptr<ThreadBuffer>> buffers;
+    std::filesystem::path exitPath;
+};
+
+auto Profiler::record(const char* name, uint64_t start, uint64_t end) noexcept -> void
+{
+    thread_local ThreadBuffer* buffer = &register_thread();
+
+    const uint64_t count = buffer->count.load(std::memory_order_relaxed);
+    buffer->zones[count % RING_CAPACITY] = Zone{name, start, end};
+    buffer->count.store(count + 1, std::memory_order_release);
+}
+
+auto Profiler::writeChromeTrace(const std::filesystem::path& path) -> void
+{
+    std::ofstream file(path);
+    if (!file) {
+        throw std::runtime_error("Failed to open trace file: " + path.string());
+    }
+
+    file << "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n";
+    bool first = true;
+
+    auto& reg = registry();
+    const std::scoped_lock lock(reg.mutex);
+
+    for (const auto& threadBuffer : reg.buffers) {
+        const auto& buffer = *threadBuffer;
+        const uint64_t count = buffer.count.load(std::memory_order_acquire);
+        const uint64_t begin = count > RING_CAPACITY ? count - RING_CAPACITY : 0;
+
+        for (uint64_t i = begin; i < count; i++) {
+            const Zone& zone = buffer.zones[i % RING_CAPACITY];
+
+            // Complete events, timestamps in microseconds
+            file << std::format(
+                "{}{{\"name\":\"{}\",\"cat\":\"cpu\",\"ph\":\"X\",\"pid\":1,\"tid\":{},\"ts\":{:.3f},\"dur\":{:.3f}}}",
+                first ? "" : ",\n",
+                escape(zone.name),
+                buffer.threadIndex,
+                static_cast<double>(zone.start) * 1e-3,
+                static_cast<double>(zone.end - zone.start) * 1e-3
+            );
+            first = false;
+        }
+    }
+
+    file << "\n]}\n";
+}
+
+auto Profiler::dumpOnExit(const std::filesystem::path& path) -> void
+{
+    // Constructed before the handler is registered, so destroyed after it ran
+    auto& reg = registry();
+    const bool registered = !reg.exitPath.empty();
+    reg.exitPath = path;
+
+    if (!registered) {
+        std::atexit([] {
+            try {
+                writeChromeTrace(registry().exitPath);
+            } catch (...) {
+                // Nothing left to report the failure to
+            }
+        });
+    }
+}
+
+    /**   PRIVATE   **/
+
+auto Profiler::registry() -> Registry&
+{
+    static Registry instance;
+    return instance;
+}
+
+auto Profiler::register_thread() -> ThreadBuffer&
+{
+    auto& reg = registry();
+    const std::scoped_lock lock(reg.mutex);
+
+    reg.buffers.push_back(std::unique_ptr<ThreadBuffer>(
+        new ThreadBuffer{.threadIndex = static_cast<uint32_t>(reg.buffers.size())}
+    ));
+
+    return *reg.buffers.back();
+}
+
+} // namespace common
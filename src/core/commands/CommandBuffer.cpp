@@ -1,10 +1,16 @@
 #include "core/commands/CommandBuffer.hpp"
 
+#include <cstring>
+#include <algorithm>
+
+#include "vulkan/utils.hpp"
+
 namespace core::commands {
 
 CommandBuffer::CommandBuffer(
     VkDevice device,
-    VkCommandPool commandPool)
+    VkCommandPool commandPool,
+    VkCommandBufferLevel level)
 : m_device(device)
 , m_commandPool(commandPool)
 {
@@ -12,7 +18,7 @@ CommandBuffer::CommandBuffer(
     VkCommandBufferAllocateInfo bufferAllocateInfo{};
     bufferAllocateInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
     bufferAllocateInfo.commandPool = m_commandPool;
-    bufferAllocateInfo.level = VK_COMMAND_BUFFER_LEVEL_PRIMARY;
+    bufferAllocateInfo.level = level;
     bufferAllocateInfo.commandBufferCount = 1;
 
     vulkan::AllocateCommandBuffers(
@@ -25,6 +31,9 @@ CommandBuffer::CommandBuffer(CommandBuffer&& other)
 : m_commandBuffer(other.m_commandBuffer)
 , m_device(other.m_device)
 , m_commandPool(other.m_commandPool)
+, m_bound(other.m_bound)
+, m_stats(other.m_stats)
+, m_profiler(other.m_profiler)
 {
     other.m_commandBuffer = VK_NULL_HANDLE;
     other.m_device = VK_NULL_HANDLE;
@@ -41,6 +50,7 @@ CommandBuffer::~CommandBuffer()
 auto CommandBuffer::reset() -> void
 {
     vulkan::ResetCommandBuffer(m_commandBuffer, 0);
+    invalidateState();
 }
 
 auto CommandBuffer::begin(bool oneTimeSubmit) -> void
@@ -53,6 +63,26 @@ auto CommandBuffer::begin(bool oneTimeSubmit) -> void
     };
 
     vulkan::BeginCommandBuffer(m_commandBuffer, &beginInfo);
+
+    // Nothing is bound at the start of a command buffer
+    invalidateState();
+    m_stats = Stats{};
+}
+
+auto CommandBuffer::begin(const VkCommandBufferInheritanceInfo& inheritanceInfo) -> void
+{
+    VkCommandBufferBeginInfo beginInfo{
+        .sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO,
+        .pNext = nullptr,
+        .flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT | VK_COMMAND_BUFFER_USAGE_RENDER_PASS_CONTINUE_BIT,
+        .pInheritanceInfo = &inheritanceInfo
+    };
+
+    vulkan::BeginCommandBuffer(m_commandBuffer, &beginInfo);
+
+    // Secondary command buffers don't inherit any bound state from the primary one
+    invalidateState();
+    m_stats = Stats{};
 }
 
 auto CommandBuffer::end() -> void
@@ -64,7 +94,8 @@ auto CommandBuffer::beginRenderPass(
     const VkRenderPass& renderPass,
     const VkFramebuffer& frameBuffer,
     const VkExtent2D& extent,
-    const vulkan::ClearColor& clearValue) -> void
+    const vulkan::ClearColor& clearValue,
+    VkSubpassContents contents) -> void
 {
     std::array<VkClearValue, 2> clearValues{
         VkClearValue{ .color = clearValue.color },
@@ -84,48 +115,150 @@ auto CommandBuffer::beginRenderPass(
         .pClearValues = clearValues.data()
     };
 
-    vulkan::CmdBeginRenderPass(m_commandBuffer, &renderPassInfo, VK_SUBPASS_CONTENTS_INLINE);
+    vulkan::CmdBeginRenderPass(m_commandBuffer, &renderPassInfo, contents);
+    m_stats.issued++;
+}
+
+auto CommandBuffer::beginRenderPass(
+    VkRenderPass renderPass,
+    VkFramebuffer frameBuffer,
+    const VkExtent2D& extent,
+    std::span<const VkClearValue> clearValues,
+    VkSubpassContents contents) -> void
+{
+    VkRenderPassBeginInfo renderPassInfo{
+        .sType = VK_STRUCTURE_TYPE_RENDER_PASS_BEGIN_INFO,
+        .pNext = nullptr,
+        .renderPass = renderPass,
+        .framebuffer = frameBuffer,
+        .renderArea = {
+            .offset = {0, 0},
+            .extent = extent
+        },
+        .clearValueCount = static_cast<uint32_t>(clearValues.size()),
+        .pClearValues = clearValues.data()
+    };
+
+    vulkan::CmdBeginRenderPass(m_commandBuffer, &renderPassInfo, contents);
+    m_stats.issued++;
 }
 
 auto CommandBuffer::endRenderPass() -> void
 {
     vulkan::CmdEndRenderPass(m_commandBuffer);
+    m_stats.issued++;
+}
+
+auto CommandBuffer::execute(const std::vector<VkCommandBuffer>& secondaryBuffers) -> void
+{
+    if (secondaryBuffers.empty()) {
+        return;
+    }
+
+    vulkan::CmdExecuteCommands(
+        m_commandBuffer,
+        static_cast<uint32_t>(secondaryBuffers.size()),
+        secondaryBuffers.data());
+    m_stats.issued++;
+
+    // Executed command buffers leave the bound state undefined
+    invalidateState();
 }
 
 auto CommandBuffer::bind(const pipeline::Pipeline& pipeline) -> void
 {
-    vulkan::CmdBindPipeline(m_commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, pipeline.getGraphicsPipeline());
+    const VkPipeline graphicsPipeline = pipeline.getGraphicsPipeline();
+    if (graphicsPipeline == m_bound.pipeline) {
+        m_stats.skipped++;
+        return;
+    }
+
+    vulkan::CmdBindPipeline(m_commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, graphicsPipeline);
+    m_bound.pipeline = graphicsPipeline;
+    m_stats.issued++;
+    m_stats.pipelineBinds++;
+}
+
+auto CommandBuffer::bind(const pipeline::ComputePipeline& pipeline) -> void
+{
+    if (pipeline.getPipeline() == m_bound.computePipeline) {
+        m_stats.skipped++;
+        return;
+    }
+
+    vulkan::CmdBindPipeline(m_commandBuffer, VK_PIPELINE_BIND_POINT_COMPUTE, pipeline.getPipeline());
+    m_bound.computePipeline = pipeline.getPipeline();
+    m_stats.issued++;
+    m_stats.pipelineBinds++;
 }
 
 auto CommandBuffer::bind(const memory::Buffer& buffer) -> void
 {
     switch(buffer.getType()) {
         case memory::BufferType::VERTEX: {
+            if (buffer.getBuffer() == m_bound.vertexBuffer) {
+                m_stats.skipped++;
+                return;
+            }
+
             VkDeviceSize offsets[] = {0};
             VkBuffer vertexBuffers[] = {buffer.getBuffer()};
             vkCmdBindVertexBuffers(m_commandBuffer, 0, 1, vertexBuffers, offsets);
+            m_bound.vertexBuffer = buffer.getBuffer();
             break;
         }
         case memory::BufferType::INDEX: {
+            if (buffer.getBuffer() == m_bound.indexBuffer) {
+                m_stats.skipped++;
+                return;
+            }
+
             vkCmdBindIndexBuffer(m_commandBuffer, buffer.getBuffer(), 0, VK_INDEX_TYPE_UINT32);
+            m_bound.indexBuffer = buffer.getBuffer();
             break;
         }
         default:
             throw std::invalid_argument("Unsupported buffer type for binding.");
     }
+
+    m_stats.issued++;
+    m_stats.bufferBinds++;
 }
 
-auto CommandBuffer::bind(const VkDescriptorSet& descriptorSet, const VkPipelineLayout& pipelineLayout) -> void
+auto CommandBuffer::bind(
+    const VkDescriptorSet& descriptorSet,
+    const VkPipelineLayout& pipelineLayout,
+    uint32_t set,
+    VkPipelineBindPoint bindPoint,
+    std::span<const uint32_t> dynamicOffsets) -> void
 {
+    const bool tracked = bindPoint == VK_PIPELINE_BIND_POINT_GRAPHICS && set < MAX_TRACKED_SETS;
+
+    if (tracked) {
+        track_layout(pipelineLayout);
+
+        if (dynamicOffsets.empty() && m_bound.descriptorSets[set] == descriptorSet) {
+            m_stats.skipped++;
+            return;
+        }
+    }
+
     vulkan::CmdBindDescriptorSets(
         m_commandBuffer,
-        VK_PIPELINE_BIND_POINT_GRAPHICS,
+        bindPoint,
         pipelineLayout,
-        0,
+        set,
         1,
         &descriptorSet,
-        0,
-        nullptr);
+        static_cast<uint32_t>(dynamicOffsets.size()),
+        dynamicOffsets.data());
+
+    // The offsets are not tracked, a later bind of the same set without them must not be skipped
+    if (tracked) {
+        m_bound.descriptorSets[set] = dynamicOffsets.empty() ? descriptorSet : VK_NULL_HANDLE;
+    }
+    m_stats.issued++;
+    m_stats.descriptorBinds++;
 }
 
 auto CommandBuffer::bindDescriptorSets(
@@ -133,6 +266,19 @@ auto CommandBuffer::bindDescriptorSets(
     const VkPipelineLayout& pipelineLayout,
     uint32_t firstSet) -> void
 {
+    track_layout(pipelineLayout);
+
+    const auto count = static_cast<uint32_t>(descriptorSets.size());
+    const bool tracked = firstSet + count <= MAX_TRACKED_SETS;
+
+    if (tracked && std::equal(
+            descriptorSets.begin(),
+            descriptorSets.end(),
+            m_bound.descriptorSets.begin() + firstSet)) {
+        m_stats.skipped++;
+        return;
+    }
+
     vulkan::CmdBindDescriptorSets(
         m_commandBuffer,
         VK_PIPELINE_BIND_POINT_GRAPHICS,
@@ -142,16 +288,24 @@ auto CommandBuffer::bindDescriptorSets(
         descriptorSets.data(),
         0,
         nullptr);
+
+    for (uint32_t i = 0; i < count && firstSet + i < MAX_TRACKED_SETS; i++) {
+        m_bound.descriptorSets[firstSet + i] = descriptorSets[i];
+    }
+    m_stats.issued++;
+    m_stats.descriptorBinds++;
 }
 
 auto CommandBuffer::set(const VkViewport& viewport) -> void
 {
     vulkan::CmdSetViewport(m_commandBuffer, 0, 1, &viewport);
+    m_stats.issued++;
 }
 
 auto CommandBuffer::set(const VkRect2D& scissors) -> void
 {
     vulkan::CmdSetScissor(m_commandBuffer, 0, 1, &scissors);
+    m_stats.issued++;
 }
 
 auto CommandBuffer::pushConstants(
@@ -161,7 +315,30 @@ auto CommandBuffer::pushConstants(
     uint32_t size,
     const void* pValues) -> void
 {
+    const bool tracked = offset + size <= MAX_TRACKED_PUSH_CONSTANTS;
+
+    if (tracked
+        && pipelineLayout == m_bound.pushConstantLayout
+        && stageFlags == m_bound.pushConstantStages
+        && offset == m_bound.pushConstantOffset
+        && size == m_bound.pushConstantSize
+        && std::memcmp(m_bound.pushConstants.data() + offset, pValues, size) == 0) {
+        m_stats.skipped++;
+        return;
+    }
+
     vulkan::CmdPushConstants(m_commandBuffer, pipelineLayout, stageFlags, offset, size, pValues);
+    m_stats.issued++;
+
+    if (tracked) {
+        m_bound.pushConstantLayout = pipelineLayout;
+        m_bound.pushConstantStages = stageFlags;
+        m_bound.pushConstantOffset = offset;
+        m_bound.pushConstantSize = size;
+        std::memcpy(m_bound.pushConstants.data() + offset, pValues, size);
+    } else {
+        m_bound.pushConstantLayout = VK_NULL_HANDLE;
+    }
 }
 
 auto CommandBuffer::copy(
@@ -178,6 +355,30 @@ auto CommandBuffer::copy(
     };
 
     vulkan::CmdCopyBuffer(m_commandBuffer, srcBuffer.getBuffer(), dstBuffer.getBuffer(), 1, &copyRegion);
+    m_stats.issued++;
+    m_stats.bytesCopied += size == VK_WHOLE_SIZE ? srcBuffer.getSize() - srcOffset : size;
+}
+
+auto CommandBuffer::copy(
+    memory::Buffer& srcBuffer,
+    memory::Buffer& dstBuffer,
+    std::span<const VkBufferCopy> regions) -> void
+{
+    if (regions.empty()) {
+        return;
+    }
+
+    vulkan::CmdCopyBuffer(
+        m_commandBuffer,
+        srcBuffer.getBuffer(),
+        dstBuffer.getBuffer(),
+        static_cast<uint32_t>(regions.size()),
+        regions.data());
+    m_stats.issued++;
+
+    for (const auto& region : regions) {
+        m_stats.bytesCopied += region.size;
+    }
 }
 
 auto CommandBuffer::copy(
@@ -207,11 +408,185 @@ auto CommandBuffer::copy(
         VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
         1,
         &region);
+    m_stats.issued++;
+    // Tightly packed texels, the source may be a region of a larger staging buffer
+    m_stats.bytesCopied += static_cast<uint64_t>(extent.width) * extent.height * extent.depth * vulkan::get_format_size(dstImage.getFormat());
+}
+
+auto CommandBuffer::fill(
+    memory::Buffer& buffer,
+    uint32_t data,
+    VkDeviceSize offset,
+    VkDeviceSize size) -> void
+{
+    vulkan::CmdFillBuffer(m_commandBuffer, buffer.getBuffer(), offset, size, data);
+    m_stats.issued++;
+}
+
+auto CommandBuffer::barrier(
+    VkPipelineStageFlags srcStage,
+    VkAccessFlags srcAccess,
+    VkPipelineStageFlags dstStage,
+    VkAccessFlags dstAccess) -> void
+{
+    const VkMemoryBarrier memoryBarrier{
+        .sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER,
+        .pNext = nullptr,
+        .srcAccessMask = srcAccess,
+        .dstAccessMask = dstAccess
+    };
+
+    vulkan::CmdPipelineBarrier(
+        m_commandBuffer,
+        srcStage,
+        dstStage,
+        0,
+        1, &memoryBarrier,
+        0, nullptr,
+        0, nullptr);
+    m_stats.issued++;
+}
+
+auto CommandBuffer::barrier(
+    VkImage image,
+    const VkImageSubresourceRange& range,
+    VkImageLayout oldLayout,
+    VkImageLayout newLayout,
+    VkPipelineStageFlags srcStage,
+    VkAccessFlags srcAccess,
+    VkPipelineStageFlags dstStage,
+    VkAccessFlags dstAccess) -> void
+{
+    const VkImageMemoryBarrier imageBarrier{
+        .sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER,
+        .pNext = nullptr,
+        .srcAccessMask = srcAccess,
+        .dstAccessMask = dstAccess,
+        .oldLayout = oldLayout,
+        .newLayout = newLayout,
+        .srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
+        .dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
+        .image = image,
+        .subresourceRange = range
+    };
+
+    vulkan::CmdPipelineBarrier(
+        m_commandBuffer,
+        srcStage,
+        dstStage,
+        0,
+        0, nullptr,
+        0, nullptr,
+        1, &imageBarrier);
+    m_stats.issued++;
+}
+
+auto CommandBuffer::barrier(
+    VkPipelineStageFlags srcStage,
+    VkPipelineStageFlags dstStage,
+    std::span<const VkMemoryBarrier> memoryBarriers,
+    std::span<const VkImageMemoryBarrier> imageBarriers) -> void
+{
+    if (memoryBarriers.empty() && imageBarriers.empty()) {
+        return;
+    }
+
+    vulkan::CmdPipelineBarrier(
+        m_commandBuffer,
+        srcStage,
+        dstStage,
+        0,
+        static_cast<uint32_t>(memoryBarriers.size()), memoryBarriers.data(),
+        0, nullptr,
+        static_cast<uint32_t>(imageBarriers.size()), imageBarriers.data());
+    m_stats.issued++;
+}
+
+auto CommandBuffer::dispatch(uint32_t groupCountX, uint32_t groupCountY, uint32_t groupCountZ) -> void
+{
+    vulkan::CmdDispatch(m_commandBuffer, groupCountX, groupCountY, groupCountZ);
+    m_stats.issued++;
+}
+
+auto CommandBuffer::drawIndexed(
+    uint32_t indexCount,
+    uint32_t instanceCount,
+    uint32_t firstIndex,
+    int32_t vertexOffset,
+    uint32_t firstInstance) -> void
+{
+    vulkan::CmdDrawIndexed(m_commandBuffer, indexCount, instanceCount, firstIndex, vertexOffset, firstInstance);
+    m_stats.issued++;
+    m_stats.drawCalls++;
+    m_stats.instances += instanceCount;
+    m_stats.triangles += static_cast<uint64_t>(indexCount / 3) * instanceCount;
+}
+
+auto CommandBuffer::drawIndexedIndirect(
+    const memory::Buffer& buffer,
+    VkDeviceSize offset,
+    uint32_t drawCount,
+    uint32_t stride) -> void
+{
+    vulkan::CmdDrawIndexedIndirect(m_commandBuffer, buffer.getBuffer(), offset, drawCount, stride);
+    m_stats.issued++;
+    m_stats.drawCalls++;
+}
+
+auto CommandBuffer::drawIndexedIndirectCount(
+    const memory::Buffer& buffer,
+    VkDeviceSize offset,
+    const memory::Buffer& countBuffer,
+    VkDeviceSize countOffset,
+    uint32_t maxDrawCount,
+    uint32_t stride) -> void
+{
+    vulkan::CmdDrawIndexedIndirectCount(
+        m_commandBuffer,
+        buffer.getBuffer(),
+        offset,
+        countBuffer.getBuffer(),
+        countOffset,
+        maxDrawCount,
+        stride);
+    m_stats.issued++;
+    m_stats.drawCalls++;
 }
 
 auto CommandBuffer::record(const CommandI& command) -> void
 {
     command.record(m_commandBuffer);
+    m_stats.issued++;
+}
+
+auto CommandBuffer::beginScope(std::string_view name) -> void
+{
+    if (m_profiler) {
+        m_profiler->beginScope(m_commandBuffer, name);
+    }
+}
+
+auto CommandBuffer::endScope() -> void
+{
+    if (m_profiler) {
+        m_profiler->endScope(m_commandBuffer);
+    }
+}
+
+auto CommandBuffer::invalidateState() noexcept -> void
+{
+    m_bound = BoundState{};
+}
+
+    /**   PRIVATE   **/
+
+auto CommandBuffer::track_layout(VkPipelineLayout layout) noexcept -> void
+{
+    // Sets bound through a different layout may be disturbed, stop assuming anything about them
+    if (layout != m_bound.layout) {
+        m_bound.layout = layout;
+        m_bound.descriptorSets.fill(VK_NULL_HANDLE);
+    }
 }
 
 } // namespace core::commands
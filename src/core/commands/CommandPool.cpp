@@ -5,13 +5,15 @@ namespace core::commands {
 CommandPool::CommandPool(
     device::Device& device,
     uint32_t queueFamilyIndex,
-    size_t allocateBufferCount)
+    size_t allocateBufferCount,
+    VkCommandBufferLevel level,
+    VkCommandPoolCreateFlags flags)
 : m_device{device.getDevice()}
 {
     // Create command pool
     VkCommandPoolCreateInfo poolCreateInfoP{};
     poolCreateInfoP.sType = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO;
-    poolCreateInfoP.flags = VK_COMMAND_POOL_CREATE_RESET_COMMAND_BUFFER_BIT; // Allow command buffers to be reset individually
+    poolCreateInfoP.flags = flags;
     poolCreateInfoP.queueFamilyIndex = queueFamilyIndex;
 
     vulkan::CreateCommandPool(
@@ -23,7 +25,7 @@ CommandPool::CommandPool(
     // Allocate command buffers
     m_commandBuffers.reserve(allocateBufferCount);
     for (size_t i = 0; i < allocateBufferCount; ++i) {
-        m_commandBuffers.emplace_back(m_device, m_commandPool);
+        m_commandBuffers.emplace_back(m_device, m_commandPool, level);
     }
 }
 
@@ -39,7 +41,11 @@ CommandPool::~CommandPool()
 
 auto CommandPool::reset() -> void
 {
-    vkResetCommandPool(m_device, m_commandPool, 0);
+    vulkan::ResetCommandPool(m_device, m_commandPool, 0);
+
+    for (auto& commandBuffer : m_commandBuffers) {
+        commandBuffer.invalidateState();
+    }
 }
 
 auto CommandPool::getCmdBuffer(size_t index) -> CommandBuffer&
@@ -0,0 +1,337 @@
+#include "core/commands/GpuProfiler.hpp"
+
+#include <algorithm>
+
+#include "vulkan/api.hpp"
+
+namespace core::commands {
+
+GpuProfiler::GpuProfiler(device::Device& device, uint32_t frameCount)
+: m_device(device.getDevice())
+, m_frames(frameCount)
+{
+    VkPhysicalDeviceProperties properties{};
+    vkGetPhysicalDeviceProperties(device.getPhysicalDevice(), &properties);
+
+    uint32_t queueFamilyCount = 0;
+    vulkan::GetPhysicalDeviceQueueFamilyProperties(device.getPhysicalDevice(), &queueFamilyCount, nullptr);
+    std::vector<VkQueueFamilyProperties> queueFamilies(queueFamilyCount);
+    vulkan::GetPhysicalDeviceQueueFamilyProperties(device.getPhysicalDevice(), &queueFamilyCount, queueFamilies.data());
+
+    // Timestamps are only meaningful on queues reporting valid bits
+    m_familyMasks.reserve(queueFamilyCount);
+    for (const auto& family : queueFamilies) {
+        const uint32_t bits = family.timestampValidBits;
+        m_familyMasks.push_back(bits == 0 ? 0 : bits >= 64 ? ~0ull : (1ull << bits) - 1);
+    }
+
+    const uint32_t validBits = queueFamilies[device.getGraphicsQueue().familyIndex].timestampValidBits;
+    m_supported = validBits > 0 && properties.limits.timestampPeriod > 0.f;
+    m_statisticsSupported = device.getFeatures().pipelineStatisticsQuery;
+    m_timestampPeriod = properties.limits.timestampPeriod;
+
+    if (m_supported) {
+        m_timestampMask = m_familyMasks[device.getGraphicsQueue().familyIndex];
+
+        const VkQueryPoolCreateInfo createInfo{
+            .sType = VK_STRUCTURE_TYPE_QUERY_POOL_CREATE_INFO,
+            .pNext = nullptr,
+            .flags = 0,
+            .queryType = VK_QUERY_TYPE_TIMESTAMP,
+            .queryCount = 2 * MAX_SCOPES,
+            .pipelineStatistics = 0
+        };
+
+        for (auto& frame : m_frames) {
+            vulkan::CreateQueryPool(m_device, &createInfo, nullptr, &frame.pool);
+            frame.scopes.reserve(MAX_SCOPES);
+        }
+    }
+
+    // Transfer only queues can't reset queries, the submissions are reset from the host
+    if (device.getFeatures().hostQueryReset && properties.limits.timestampPeriod > 0.f) {
+        const VkQueryPoolCreateInfo createInfo{
+            .sType = VK_STRUCTURE_TYPE_QUERY_POOL_CREATE_INFO,
+            .pNext = nullptr,
+            .flags = 0,
+            .queryType = VK_QUERY_TYPE_TIMESTAMP,
+            .queryCount = 2 * MAX_SUBMISSIONS,
+            .pipelineStatistics = 0
+        };
+
+        vulkan::CreateQueryPool(m_device, &createInfo, nullptr, &m_submissionPool);
+    }
+
+    if (m_statisticsSupported) {
+        const VkQueryPoolCreateInfo createInfo{
+            .sType = VK_STRUCTURE_TYPE_QUERY_POOL_CREATE_INFO,
+            .pNext = nullptr,
+            .flags = 0,
+            .queryType = VK_QUERY_TYPE_PIPELINE_STATISTICS,
+            .queryCount = 1,
+            .pipelineStatistics = STATISTICS
+        };
+
+        for (auto& frame : m_frames) {
+            vulkan::CreateQueryPool(m_device, &createInfo, nullptr, &frame.statisticsPool);
+        }
+    }
+}
+
+GpuProfiler::~GpuProfiler()
+{
+    for (const auto& frame : m_frames) {
+        if (frame.pool != VK_NULL_HANDLE) {
+            vulkan::DestroyQueryPool(m_device, frame.pool, nullptr);
+        }
+        if (frame.statisticsPool != VK_NULL_HANDLE) {
+            vulkan::DestroyQueryPool(m_device, frame.statisticsPool, nullptr);
+        }
+    }
+    if (m_submissionPool != VK_NULL_HANDLE) {
+        vulkan::DestroyQueryPool(m_device, m_submissionPool, nullptr);
+    }
+}
+
+auto GpuProfiler::beginFrame(VkCommandBuffer commandBuffer, uint32_t frame) -> void
+{
+    m_currentFrame = frame;
+    m_openScopes.clear();
+
+    auto& queries = m_frames[frame];
+    if (queries.statisticsPending) {
+        resolve_statistics(queries);
+    }
+    if (m_statisticsSupported) {
+        vulkan::CmdResetQueryPool(commandBuffer, queries.statisticsPool, 0, 1);
+    }
+
+    // The frame's scopes & the submissions completed since the previous frame
+    std::ranges::fill(m_frameTotals, 0.f);
+    m_resolvedScopes.clear();
+    resolve_submissions();
+    if (m_supported && queries.pending) {
+        resolve(queries);
+    }
+    update_history();
+
+    if (!m_supported) {
+        return;
+    }
+
+    // Queries must be reset before every reuse, also on first use
+    vulkan::CmdResetQueryPool(commandBuffer, queries.pool, 0, 2 * MAX_SCOPES);
+    queries.scopes.clear();
+    queries.pending = true;
+}
+
+auto GpuProfiler::beginScope(VkCommandBuffer commandBuffer, std::string_view name) -> void
+{
+    if (!m_supported) {
+        return;
+    }
+
+    auto& queries = m_frames[m_currentFrame];
+    if (queries.scopes.size() >= MAX_SCOPES) {
+        m_openScopes.push_back(UINT32_MAX);
+        return;
+    }
+
+    const auto query = static_cast<uint32_t>(queries.scopes.size());
+    queries.scopes.push_back(scope_index(name));
+    m_openScopes.push_back(query);
+
+    vulkan::CmdWriteTimestamp(commandBuffer, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, queries.pool, 2 * query);
+}
+
+auto GpuProfiler::endScope(VkCommandBuffer commandBuffer) -> void
+{
+    if (!m_supported || m_openScopes.empty()) {
+        return;
+    }
+
+    const uint32_t query = m_openScopes.back();
+    m_openScopes.pop_back();
+
+    if (query != UINT32_MAX) {
+        vulkan::CmdWriteTimestamp(commandBuffer, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, m_frames[m_currentFrame].pool, 2 * query + 1);
+    }
+}
+
+auto GpuProfiler::beginSubmission(VkCommandBuffer commandBuffer, uint32_t queueFamily, std::string_view name) -> uint32_t
+{
+    if (!isSupported(queueFamily)) {
+        return NO_SUBMISSION;
+    }
+
+    // The oldest submission still running on the GPU, its queries can't be reset yet
+    const uint32_t index = m_nextSubmission;
+    auto& submission = m_submissions[index];
+    if (submission.pending) {
+        return NO_SUBMISSION;
+    }
+    m_nextSubmission = (m_nextSubmission + 1) % MAX_SUBMISSIONS;
+
+    submission.scope = scope_index(name);
+    submission.mask = m_familyMasks[queueFamily];
+
+    vulkan::ResetQueryPool(m_device, m_submissionPool, 2 * index, 2);
+    vulkan::CmdWriteTimestamp(commandBuffer, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, m_submissionPool, 2 * index);
+
+    return index;
+}
+
+auto GpuProfiler::endSubmission(VkCommandBuffer commandBuffer, uint32_t submission) -> void
+{
+    if (submission == NO_SUBMISSION) {
+        return;
+    }
+
+    vulkan::CmdWriteTimestamp(commandBuffer, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, m_submissionPool, 2 * submission + 1);
+    m_submissions[submission].pending = true;
+}
+
+auto GpuProfiler::beginStatistics(VkCommandBuffer commandBuffer) -> void
+{
+    if (m_statisticsSupported) {
+        vulkan::CmdBeginQuery(commandBuffer, m_frames[m_currentFrame].statisticsPool, 0, 0);
+    }
+}
+
+auto GpuProfiler::endStatistics(VkCommandBuffer commandBuffer) -> void
+{
+    if (m_statisticsSupported) {
+        vulkan::CmdEndQuery(commandBuffer, m_frames[m_currentFrame].statisticsPool, 0);
+        m_frames[m_currentFrame].statisticsPending = true;
+    }
+}
+
+    /**   PRIVATE   **/
+
+auto GpuProfiler::resolve(FrameQueries& frame) -> void
+{
+    frame.pending = false;
+    if (frame.scopes.empty()) {
+        return;
+    }
+
+    const auto queryCount = static_cast<uint32_t>(2 * frame.scopes.size());
+    std::array<uint64_t, 2 * MAX_SCOPES> timestamps{};
+
+    // The frame's fence signaled, the results are available without waiting
+    const VkResult result = vulkan::GetQueryPoolResults(
+        m_device,
+        frame.pool,
+        0,
+        queryCount,
+        queryCount * sizeof(uint64_t),
+        timestamps.data(),
+        sizeof(uint64_t),
+        VK_QUERY_RESULT_64_BIT
+    );
+    if (result != VK_SUCCESS) {
+        return;
+    }
+
+    for (size_t i = 0; i < frame.scopes.size(); i++) {
+        add_time(frame.scopes[i], timestamps[2 * i], timestamps[2 * i + 1], m_timestampMask);
+    }
+}
+
+auto GpuProfiler::resolve_submissions() -> void
+{
+    for (uint32_t i = 0; i < MAX_SUBMISSIONS; i++) {
+        auto& submission = m_submissions[i];
+        if (!submission.pending) {
+            continue;
+        }
+
+        // Not waited on, VK_NOT_READY leaves a submission still running to a later frame
+        std::array<uint64_t, 2> timestamps{};
+        const VkResult result = vulkan::GetQueryPoolResults(
+            m_device,
+            m_submissionPool,
+            2 * i,
+            2,
+            sizeof(timestamps),
+            timestamps.data(),
+            sizeof(uint64_t),
+            VK_QUERY_RESULT_64_BIT
+        );
+        if (result != VK_SUCCESS) {
+            continue;
+        }
+
+        submission.pending = false;
+        add_time(submission.scope, timestamps[0], timestamps[1], submission.mask);
+    }
+}
+
+auto GpuProfiler::add_time(uint32_t scope, uint64_t begin, uint64_t end, uint64_t mask) -> void
+{
+    const uint64_t ticks = (end - begin) & mask;
+    m_frameTotals[scope] += static_cast<float>(static_cast<double>(ticks) * m_timestampPeriod * 1e-6);
+    m_resolvedScopes.push_back(scope);
+}
+
+auto GpuProfiler::update_history() -> void
+{
+    // Scopes not resolved this frame keep their last values
+    for (size_t i = 0; i < m_scopes.size(); i++) {
+        if (std::ranges::find(m_resolvedScopes, static_cast<uint32_t>(i)) == m_resolvedScopes.end()) {
+            continue;
+        }
+
+        auto& history = m_history[i];
+        history.sum += m_frameTotals[i] - history.samples[history.next];
+        history.samples[history.next] = m_frameTotals[i];
+        history.next = (history.next + 1) % AVERAGE_FRAMES;
+        history.count = std::min(history.count + 1, AVERAGE_FRAMES);
+
+        m_scopes[i].lastMs = m_frameTotals[i];
+        m_scopes[i].averageMs = history.sum / static_cast<float>(history.count);
+    }
+}
+
+auto GpuProfiler::resolve_statistics(FrameQueries& frame) -> void
+{
+    frame.statisticsPending = false;
+
+    std::array<uint64_t, 4> values{};
+    const VkResult result = vulkan::GetQueryPoolResults(
+        m_device,
+        frame.statisticsPool,
+        0,
+        1,
+        sizeof(values),
+        values.data(),
+        sizeof(values),
+        VK_QUERY_RESULT_64_BIT
+    );
+    if (result != VK_SUCCESS) {
+        return;
+    }
+
+    m_statistics = PipelineStatistics{
+        .inputVertices = values[0],
+        .vertexShaderInvocations = values[1],
+        .clippingPrimitives = values[2],
+        .fragmentShaderInvocations = values[3]
+    };
+}
+
+auto GpuProfiler::scope_index(std::string_view name) -> uint32_t
+{
+    const auto it = std::ranges::find(m_scopes, name, &Scope::name);
+    if (it != m_scopes.end()) {
+        return static_cast<uint32_t>(it - m_scopes.begin());
+    }
+
+    m_scopes.push_back(Scope{.name = std::string{name}});
+    m_history.emplace_back();
+    m_frameTotals.push_back(0.f);
+
+    return static_cast<uint32_t>(m_scopes.size() - 1);
+}
+
+} // namespace core::commands
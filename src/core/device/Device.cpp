@@ -5,18 +5,18 @@
 #include <vector>
 #include <format>
 #include <set>
+#include <string_view>
+#include <algorithm>
 
 #include "vulkan/api.hpp"
 #include "vulkan/utils.hpp"
 #include "common/defs.hpp"
+#include "core/sync/QueueTimeline.hpp"
 
 namespace {
 
 [[nodiscard]]
-auto get_physical_device(
-    const core::device::Instance& instance,
-    [[maybe_unused]] const core::device::Surface& surface
-) -> VkPhysicalDevice
+auto get_physical_device(const core::device::Instance& instance) -> VkPhysicalDevice
 {
     uint32_t deviceCount = 0;
     vulkan::EnumeratePhysicalDevices(instance.getInstance(), &deviceCount, nullptr);
@@ -39,8 +39,13 @@ auto get_physical_device(
         VkPhysicalDeviceFeatures deviceFeatures;
         vkGetPhysicalDeviceFeatures(device, &deviceFeatures);
 
+        // Timeline semaphores are core & mandatory since Vulkan 1.2
+        VkPhysicalDeviceProperties properties;
+        vkGetPhysicalDeviceProperties(device, &properties);
+
         if (memoryProps.memoryHeapCount > 0 &&
             deviceFeatures.samplerAnisotropy &&
+            properties.apiVersion >= VK_API_VERSION_1_2 &&
             (bestDevice == VK_NULL_HANDLE ||
              memoryProps.memoryHeaps[0].size > bestMemoryProps.memoryHeaps[0].size)) {
             bestDevice = device;
@@ -62,10 +67,10 @@ struct QueueFamilyIndices {
 };
 
 [[nodiscard]]
-auto is_complete(const QueueFamilyIndices& indices) -> bool {
+auto is_complete(const QueueFamilyIndices& indices, bool present) -> bool {
     return 
         indices.graphicsFamily.has_value() &&
-        indices.presentFamily.has_value() &&
+        (indices.presentFamily.has_value() || !present) &&
         indices.uniqueTransferFamily.has_value();
 }
 
@@ -96,7 +101,9 @@ auto get_queue_families(
         }
 
         VkBool32 presentSupport = false;
-        vulkan::GetPhysicalDeviceSurfaceSupportKHR(physDevice, i, surface, &presentSupport);
+        if (surface != VK_NULL_HANDLE) {
+            vulkan::GetPhysicalDeviceSurfaceSupportKHR(physDevice, i, surface, &presentSupport);
+        }
 
         if (presentSupport) {
             if (!indices.presentFamily.has_value()) {
@@ -104,12 +111,22 @@ auto get_queue_families(
             }
         }
 
-        if (is_complete(indices)) {
+        if (is_complete(indices, surface != VK_NULL_HANDLE)) {
             break;
         }
     }
 
-    if (!is_complete(indices)) {
+    // Software implementations like lavapipe have a single family, transfers then go through the graphics queue
+    if (!indices.uniqueTransferFamily.has_value()) {
+        indices.uniqueTransferFamily = indices.graphicsFamily;
+    }
+
+    // Nothing is presented without a surface, the present queue stands for the graphics queue
+    if (surface == VK_NULL_HANDLE) {
+        indices.presentFamily = indices.graphicsFamily;
+    }
+
+    if (!is_complete(indices, surface != VK_NULL_HANDLE)) {
         throw std::runtime_error("Failed to find suitable queue families.");
     }
 
@@ -149,26 +166,69 @@ namespace core::device {
 
 Device::Device(
     Instance& instance,
-    Surface& surface,
+    Surface* surface,
     std::vector<const char*> extensions,
     std::optional<VkPhysicalDevice> physDevice) :
     m_physDevice{
-        physDevice.value_or(get_physical_device(instance, surface))}
+        physDevice.value_or(get_physical_device(instance))}
 {
+    // A headless device renders into its own images, it has no swapchain
+    if (!surface) {
+        std::erase_if(extensions, [](std::string_view extension) {
+            return extension == VK_KHR_SWAPCHAIN_EXTENSION_NAME;
+        });
+    }
+
     VkDeviceCreateInfo createInfo{};
     createInfo.sType = VK_STRUCTURE_TYPE_DEVICE_CREATE_INFO;
 
     const QueueFamilyIndices queueFamilies = get_queue_families(
         m_physDevice,
-        surface.getSurface());
+        surface ? surface->getSurface() : VK_NULL_HANDLE);
 
     const auto queueCreateInfos = get_queue_create_infos(queueFamilies);
     createInfo.queueCreateInfoCount = static_cast<uint32_t>(queueCreateInfos.size());
     createInfo.pQueueCreateInfos = queueCreateInfos.data();
 
-    VkPhysicalDeviceFeatures deviceFeatures{};
-    deviceFeatures.samplerAnisotropy = VK_TRUE;
-    createInfo.pEnabledFeatures = &deviceFeatures;
+    // Query the optional features used by indirect rendering, get_physical_device() only picks Vulkan 1.2 devices
+    VkPhysicalDeviceVulkan12Features supportedFeatures12{};
+    supportedFeatures12.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_VULKAN_1_2_FEATURES;
+
+    VkPhysicalDeviceFeatures2 supportedFeatures{};
+    supportedFeatures.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_FEATURES_2;
+    supportedFeatures.pNext = &supportedFeatures12;
+    vkGetPhysicalDeviceFeatures2(m_physDevice, &supportedFeatures);
+
+    m_features.multiDrawIndirect = supportedFeatures.features.multiDrawIndirect;
+    m_features.drawIndirectFirstInstance = supportedFeatures.features.drawIndirectFirstInstance;
+    m_features.drawIndirectCount = supportedFeatures12.drawIndirectCount;
+    m_features.pipelineStatisticsQuery = supportedFeatures.features.pipelineStatisticsQuery;
+    m_features.inheritedQueries = supportedFeatures.features.inheritedQueries;
+    m_features.hostQueryReset = supportedFeatures12.hostQueryReset;
+
+    // The queue timelines track every submission
+    if (!supportedFeatures12.timelineSemaphore) {
+        throw std::runtime_error("The physical device doesn't support timeline semaphores.");
+    }
+
+    VkPhysicalDeviceVulkan12Features deviceFeatures12{};
+    deviceFeatures12.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_VULKAN_1_2_FEATURES;
+    deviceFeatures12.drawIndirectCount = m_features.drawIndirectCount;
+    deviceFeatures12.timelineSemaphore = VK_TRUE;
+    deviceFeatures12.hostQueryReset = m_features.hostQueryReset;
+
+    VkPhysicalDeviceFeatures2 deviceFeatures{};
+    deviceFeatures.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_FEATURES_2;
+    deviceFeatures.pNext = &deviceFeatures12;
+    deviceFeatures.features.samplerAnisotropy = VK_TRUE;
+    deviceFeatures.features.multiDrawIndirect = m_features.multiDrawIndirect;
+    deviceFeatures.features.drawIndirectFirstInstance = m_features.drawIndirectFirstInstance;
+    deviceFeatures.features.pipelineStatisticsQuery = m_features.pipelineStatisticsQuery;
+    deviceFeatures.features.inheritedQueries = m_features.inheritedQueries;
+
+    // Features are passed through the pNext chain, pEnabledFeatures has to stay null
+    createInfo.pNext = &deviceFeatures;
+    createInfo.pEnabledFeatures = nullptr;
 
     if (common::DEBUG) {
         createInfo.enabledLayerCount = static_cast<uint32_t>(instance.getValidationLayers().size());
@@ -210,10 +270,17 @@ Device::Device(
         0,
         &m_transferQueue.queue);
     m_transferQueue.familyIndex = queueFamilies.uniqueTransferFamily.value();
+
+    m_graphicsTimeline = std::make_unique<sync::QueueTimeline>(*this, m_graphicsQueue);
+    m_transferTimeline = std::make_unique<sync::QueueTimeline>(*this, m_transferQueue);
 }
 
 Device::~Device()
 {
+    // Wait for their submissions & run the remaining callbacks
+    m_transferTimeline.reset();
+    m_graphicsTimeline.reset();
+
     if (m_graphicsQueue) {
         vulkan::QueueWaitIdle(m_graphicsQueue.queue);
         m_graphicsQueue = {};
@@ -224,6 +291,11 @@ Device::~Device()
         m_presentQueue = {};
     }
 
+    if (m_transferQueue) {
+        vulkan::QueueWaitIdle(m_transferQueue.queue);
+        m_transferQueue = {};
+    }
+
     if (m_device != VK_NULL_HANDLE) {
         vulkan::DestroyDevice(m_device, nullptr);
         m_device = VK_NULL_HANDLE;
@@ -1,8 +1,5 @@
 #include "core/device/Instance.hpp"
 
-#define GLFW_INCLUDE_VULKAN
-#include <GLFW/glfw3.h>
-
 #include <string_view>
 #include <stdexcept>
 #include <format>
@@ -63,16 +60,10 @@ auto check_required_extensions(const std::vector<const char*>& extensions) -> bo
     return true;
 }
 
+// Window system extensions come from the caller, a headless instance has none
 auto get_required_extensions() -> std::vector<const char*>
 {
-    uint32_t extension_count{};
-    const char** extensions = glfwGetRequiredInstanceExtensions(&extension_count);
-
-    if (!extensions) {
-        throw std::runtime_error("Failed to get required instance extensions from GLFW.");
-    }
-
-    std::vector<const char*> required_extensions(extensions, extensions + extension_count);
+    std::vector<const char*> required_extensions;
 
     if (common::DEBUG) {
         required_extensions.push_back(VK_EXT_DEBUG_UTILS_EXTENSION_NAME);
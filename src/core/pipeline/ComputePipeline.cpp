@@ -0,0 +1,70 @@
+#include "core/pipeline/ComputePipeline.hpp"
+
+#include <stdexcept>
+
+#include "common/defs.hpp"
+#include "vulkan/api.hpp"
+
+namespace core::pipeline {
+
+ComputePipeline::ComputePipeline(
+    device::Device& device,
+    const Shader& shader,
+    const std::vector<VkDescriptorSetLayout>& setLayouts,
+    uint32_t pushConstantSize) :
+    m_device{device.getDevice()}
+{
+    if (shader.getType() != Shader::Type::Compute) {
+        throw std::invalid_argument("ComputePipeline requires a compute shader");
+    }
+
+    VkPushConstantRange pushConstantRange{};
+    pushConstantRange.stageFlags = VK_SHADER_STAGE_COMPUTE_BIT;
+    pushConstantRange.offset = 0;
+    pushConstantRange.size = pushConstantSize;
+
+    VkPipelineLayoutCreateInfo pipelineLayoutInfo{};
+    pipelineLayoutInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO;
+    pipelineLayoutInfo.setLayoutCount = static_cast<uint32_t>(setLayouts.size());
+    pipelineLayoutInfo.pSetLayouts = setLayouts.data();
+    pipelineLayoutInfo.pushConstantRangeCount = pushConstantSize > 0 ? 1 : 0;
+    pipelineLayoutInfo.pPushConstantRanges = pushConstantSize > 0 ? &pushConstantRange : nullptr;
+
+    vulkan::CreatePipelineLayout(
+        m_device,
+        &pipelineLayoutInfo,
+        nullptr,
+        &m_pipelineLayout
+    );
+
+    VkComputePipelineCreateInfo pipelineInfo{};
+    pipelineInfo.sType = VK_STRUCTURE_TYPE_COMPUTE_PIPELINE_CREATE_INFO;
+    pipelineInfo.stage.sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
+    pipelineInfo.stage.stage = VK_SHADER_STAGE_COMPUTE_BIT;
+    pipelineInfo.stage.module = shader.getShaderModule();
+    pipelineInfo.stage.pName = common::SHADER_ENTRY_POINT;
+    pipelineInfo.layout = m_pipelineLayout;
+    pipelineInfo.basePipelineHandle = VK_NULL_HANDLE;
+    pipelineInfo.basePipelineIndex = -1;
+
+    vulkan::CreateComputePipelines(
+        m_device,
+        VK_NULL_HANDLE, // No pipeline cache
+        1,
+        &pipelineInfo,
+        nullptr,
+        &m_pipeline
+    );
+}
+
+ComputePipeline::~ComputePipeline()
+{
+    if (m_pipeline != VK_NULL_HANDLE) {
+        vulkan::DestroyPipeline(m_device, m_pipeline, nullptr);
+    }
+    if (m_pipelineLayout != VK_NULL_HANDLE) {
+        vulkan::DestroyPipelineLayout(m_device, m_pipelineLayout, nullptr);
+    }
+}
+
+} // namespace core::pipeline
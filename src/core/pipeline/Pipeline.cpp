@@ -19,6 +19,8 @@ auto get_shader_stage_flag(const core::pipeline::Shader::Type type) -> VkShaderS
             return VK_SHADER_STAGE_VERTEX_BIT;
         case core::pipeline::Shader::Type::Fragment:
             return VK_SHADER_STAGE_FRAGMENT_BIT;
+        case core::pipeline::Shader::Type::Compute:
+            throw std::invalid_argument("Compute shaders belong in a ComputePipeline");
         // Add more cases for other shader types if needed
         default:
             throw std::invalid_argument("Unsupported shader type");
@@ -51,10 +53,12 @@ namespace core::pipeline {
 
 Pipeline::Pipeline(
     device::Device& device,
-    const Swapchain& swapchain,
+    VkRenderPass renderPass,
+    VkExtent2D extent,
     const std::vector<Shader>& shaders,
     VkDescriptorSetLayout globalSetLayout,
     VkDescriptorSetLayout materialSetLayout,
+    const Config& config,
     VkDescriptorSetLayout instanceSetLayout) :
     m_device{device.getDevice()}
 {
@@ -62,14 +66,51 @@ Pipeline::Pipeline(
         throw std::invalid_argument("At least one shader must be provided");
     }
 
-    // Create the render pass and pipeline layout
-    // These are essential for the graphics pipeline to function
-    m_renderPass = create_render_pass(swapchain);
+    // Create the pipeline layout, the render pass belongs to the render graph
     m_pipelineLayout = create_pipeline_layout(
         globalSetLayout,
         materialSetLayout,
         instanceSetLayout);
 
+    create_pipeline(renderPass, extent, shaders, config);
+}
+
+Pipeline::Pipeline(
+    device::Device& device,
+    VkRenderPass renderPass,
+    VkExtent2D extent,
+    const std::vector<Shader>& shaders,
+    const Pipeline& layoutOwner,
+    const Config& config) :
+    m_pipelineLayout{layoutOwner.getPipelineLayout()},
+    m_ownsLayout{false},
+    m_device{device.getDevice()}
+{
+    if (shaders.empty()) {
+        throw std::invalid_argument("At least one shader must be provided");
+    }
+
+    create_pipeline(renderPass, extent, shaders, config);
+}
+
+Pipeline::~Pipeline()
+{
+    if (m_graphicsPipeline != VK_NULL_HANDLE) {
+        vulkan::DestroyPipeline(m_device, m_graphicsPipeline, nullptr);
+    }
+    if (m_pipelineLayout != VK_NULL_HANDLE && m_ownsLayout) {
+        vulkan::DestroyPipelineLayout(m_device, m_pipelineLayout, nullptr);
+    }
+}
+
+    /**   PRIVATE   **/
+
+auto Pipeline::create_pipeline(
+    VkRenderPass renderPass,
+    VkExtent2D extent,
+    const std::vector<Shader>& shaders,
+    const Config& config) -> void
+{
     // Get the shader stages, which are the entry points for the shaders in our pipeline
     const auto shaderStages = create_shader_stages(shaders);
 
@@ -91,8 +132,9 @@ Pipeline::Pipeline(
     vertexInputInfo.vertexBindingDescriptionCount = 1;
     vertexInputInfo.pVertexBindingDescriptions = &bindingDescription;
 
+    // The position is the first attribute, a depth only pass can skip fetching the rest of the vertex
     const auto attributeDescriptions = shaders::generic::Vertex::get_attribute_descriptions();
-    vertexInputInfo.vertexAttributeDescriptionCount = static_cast<uint32_t>(attributeDescriptions.size());
+    vertexInputInfo.vertexAttributeDescriptionCount = config.positionOnly ? 1 : static_cast<uint32_t>(attributeDescriptions.size());
     vertexInputInfo.pVertexAttributeDescriptions = attributeDescriptions.data();
 
     // Setup the input assembly state, which describes how vertices are assembled into primitives
@@ -106,15 +148,15 @@ Pipeline::Pipeline(
     viewport.x = 0.0f;
     viewport.y = 0.0f;
 
-    viewport.width = static_cast<float>(swapchain.getExtent().width);
-    viewport.height = static_cast<float>(swapchain.getExtent().height);
+    viewport.width = static_cast<float>(extent.width);
+    viewport.height = static_cast<float>(extent.height);
 
     viewport.minDepth = 0.0f;
     viewport.maxDepth = 1.0f;
 
     VkRect2D scissor{};
     scissor.offset = {0, 0};
-    scissor.extent = swapchain.getExtent();
+    scissor.extent = extent;
 
     // Setup the viewport state, which combines the viewport and scissor
     VkPipelineViewportStateCreateInfo viewportState{};
@@ -154,12 +196,8 @@ Pipeline::Pipeline(
 
     // Setup the color blend attachment state, which describes how colors are blended
     VkPipelineColorBlendAttachmentState colorBlendAttachment{};
-    colorBlendAttachment.colorWriteMask =
-        VK_COLOR_COMPONENT_R_BIT |
-        VK_COLOR_COMPONENT_G_BIT |
-        VK_COLOR_COMPONENT_B_BIT |
-        VK_COLOR_COMPONENT_A_BIT; // Write all color components
-    colorBlendAttachment.blendEnable = VK_TRUE; // Enable blending
+    colorBlendAttachment.colorWriteMask = config.colorWriteMask;
+    colorBlendAttachment.blendEnable = config.blend ? VK_TRUE : VK_FALSE;
     colorBlendAttachment.srcColorBlendFactor = VK_BLEND_FACTOR_SRC_ALPHA;
     colorBlendAttachment.dstColorBlendFactor = VK_BLEND_FACTOR_ONE_MINUS_SRC_ALPHA;
     colorBlendAttachment.colorBlendOp = VK_BLEND_OP_ADD;
@@ -178,12 +216,15 @@ Pipeline::Pipeline(
     ---
     */
 
+    // Every color attachment of the render pass is blended the same way, none in depth only passes
+    const std::vector<VkPipelineColorBlendAttachmentState> colorBlendAttachments(config.colorAttachmentCount, colorBlendAttachment);
+
     VkPipelineColorBlendStateCreateInfo colorBlending{};
     colorBlending.sType = VK_STRUCTURE_TYPE_PIPELINE_COLOR_BLEND_STATE_CREATE_INFO;
     colorBlending.logicOpEnable = VK_FALSE; // No logic operations
     colorBlending.logicOp = VK_LOGIC_OP_COPY; // Default logic operation
-    colorBlending.attachmentCount = 1; // We have one color attachment
-    colorBlending.pAttachments = &colorBlendAttachment; // Pointer to the color blend attachment
+    colorBlending.attachmentCount = config.colorAttachmentCount;
+    colorBlending.pAttachments = colorBlendAttachments.empty() ? nullptr : colorBlendAttachments.data();
     colorBlending.blendConstants[0] = 0.0f;
     colorBlending.blendConstants[1] = 0.0f;
     colorBlending.blendConstants[2] = 0.0f;
@@ -191,9 +232,9 @@ Pipeline::Pipeline(
 
     VkPipelineDepthStencilStateCreateInfo depthStencil{};
     depthStencil.sType = VK_STRUCTURE_TYPE_PIPELINE_DEPTH_STENCIL_STATE_CREATE_INFO;
-    depthStencil.depthTestEnable = VK_TRUE;
-    depthStencil.depthWriteEnable = VK_TRUE;
-    depthStencil.depthCompareOp = VK_COMPARE_OP_LESS;
+    depthStencil.depthTestEnable = config.depthTest ? VK_TRUE : VK_FALSE;
+    depthStencil.depthWriteEnable = config.depthWrite ? VK_TRUE : VK_FALSE;
+    depthStencil.depthCompareOp = config.depthCompareOp;
     depthStencil.depthBoundsTestEnable = VK_FALSE;
     depthStencil.minDepthBounds = 0.0f; // Optional
     depthStencil.maxDepthBounds = 1.0f; // Optional
@@ -216,7 +257,7 @@ Pipeline::Pipeline(
     pipelineInfo.pDynamicState = &dynamicState;
     
     pipelineInfo.layout = m_pipelineLayout;
-    pipelineInfo.renderPass = m_renderPass;
+    pipelineInfo.renderPass = renderPass;
     pipelineInfo.subpass = 0; // We use the first subpass
     
     pipelineInfo.basePipelineHandle = VK_NULL_HANDLE; // No base pipeline (we're not recreating a pipeline)
@@ -232,101 +273,6 @@ Pipeline::Pipeline(
     );
 }
 
-Pipeline::~Pipeline()
-{
-    if (m_graphicsPipeline != VK_NULL_HANDLE) {
-        vulkan::DestroyPipeline(m_device, m_graphicsPipeline, nullptr);
-    }
-    if (m_pipelineLayout != VK_NULL_HANDLE) {
-        vulkan::DestroyPipelineLayout(m_device, m_pipelineLayout, nullptr);
-    }
-    if (m_renderPass != VK_NULL_HANDLE) {
-        vulkan::DestroyRenderPass(m_device, m_renderPass, nullptr);
-    }
-}
-
-auto Pipeline::create_render_pass(const Swapchain& swapchain) -> VkRenderPass
-{
-    VkRenderPass renderPass{VK_NULL_HANDLE};
-
-    // Setup the color attachment, which is the swapchain image
-    VkAttachmentDescription colorAttachment{};
-    colorAttachment.format = swapchain.getFormat();
-    colorAttachment.samples = VK_SAMPLE_COUNT_1_BIT; // Use 1 sample per pixel
-
-    colorAttachment.loadOp = VK_ATTACHMENT_LOAD_OP_CLEAR; // Clear the attachment at the start
-    colorAttachment.storeOp = VK_ATTACHMENT_STORE_OP_STORE; // Store the result in the swap
-
-    colorAttachment.stencilLoadOp = VK_ATTACHMENT_LOAD_OP_DONT_CARE; // No stencil buffer
-    colorAttachment.stencilStoreOp = VK_ATTACHMENT_STORE_OP_DONT_CARE; // No stencil buffer
-
-    colorAttachment.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED; // Initial layout is undefined
-    colorAttachment.finalLayout = VK_IMAGE_LAYOUT_PRESENT_SRC_KHR; // Final layout is present
-
-    // Create the color attachment reference, which is used in the subpass
-    VkAttachmentReference colorAttachmentRef{};
-    colorAttachmentRef.attachment = 0; // Index of the color attachment
-    colorAttachmentRef.layout = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL; // Layout for color attachment
-
-    // Setup the depth attachment, which is used for depth testing
-    VkAttachmentDescription depthAttachment{};
-    // TODO: Pick depth format based on device capabilities
-    depthAttachment.format = VK_FORMAT_D32_SFLOAT; // 32-bit float depth format
-    depthAttachment.samples = VK_SAMPLE_COUNT_1_BIT; // Use 1 sample per pixel
-    depthAttachment.loadOp = VK_ATTACHMENT_LOAD_OP_CLEAR; // Clear the depth at the start
-    depthAttachment.storeOp = VK_ATTACHMENT_STORE_OP_DONT_CARE;
-    depthAttachment.stencilLoadOp = VK_ATTACHMENT_LOAD_OP_DONT_CARE;
-    depthAttachment.stencilStoreOp = VK_ATTACHMENT_STORE_OP_DONT_CARE;
-    depthAttachment.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
-    depthAttachment.finalLayout = VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL;
-
-    VkAttachmentReference depthAttachmentRef{};
-    depthAttachmentRef.attachment = 1;
-    depthAttachmentRef.layout = VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL;
-
-    // Setup the subpass, which describes how the attachments are used
-    VkSubpassDescription subpass{};
-    subpass.pipelineBindPoint = VK_PIPELINE_BIND_POINT_GRAPHICS; // This is a graphics pipeline
-    subpass.colorAttachmentCount = 1; // We have one color attachment
-    subpass.pColorAttachments = &colorAttachmentRef; // Pointer to the color attachment reference
-    subpass.pDepthStencilAttachment = &depthAttachmentRef; // Pointer to the depth attachment reference
-
-    // Setup the render pass, which combines the attachments and subpasses
-    VkRenderPassCreateInfo renderPassInfo{};
-    renderPassInfo.sType = VK_STRUCTURE_TYPE_RENDER_PASS_CREATE_INFO;
-
-    std::array<VkAttachmentDescription, 2> attachments = {colorAttachment, depthAttachment};
-    renderPassInfo.attachmentCount = static_cast<uint32_t>(attachments.size());
-    renderPassInfo.pAttachments = attachments.data();
-
-    renderPassInfo.subpassCount = 1;
-    renderPassInfo.pSubpasses = &subpass;
-
-    // Subpass dependency is used to define the order of operations between subpasses
-    VkSubpassDependency dependency{};
-    dependency.srcSubpass = VK_SUBPASS_EXTERNAL; // This is an external subpass
-    dependency.dstSubpass = 0; // This is the first subpass
-
-    dependency.srcStageMask = // stage that should wait before starting the subpass
-        VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT | VK_PIPELINE_STAGE_LATE_FRAGMENT_TESTS_BIT;
-    dependency.srcAccessMask = VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT; // Source access is depth/stencil write
-
-    dependency.dstStageMask = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT | VK_PIPELINE_STAGE_EARLY_FRAGMENT_TESTS_BIT;
-    dependency.dstAccessMask = VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT | VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT;
-
-    renderPassInfo.dependencyCount = 1; // We have one dependency
-    renderPassInfo.pDependencies = &dependency; // Pointer to the dependency
-
-    vulkan::CreateRenderPass(
-        m_device,
-        &renderPassInfo,
-        nullptr,
-        &renderPass
-    );
-
-    return renderPass;
-}
-
 auto Pipeline::create_pipeline_layout(
         VkDescriptorSetLayout globalSetLayout,
         VkDescriptorSetLayout materialSetLayout,
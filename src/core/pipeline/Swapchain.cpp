@@ -250,6 +250,10 @@ auto Swapchain::getFormat() const noexcept -> VkFormat {
     return m_format;
 }
 
+auto Swapchain::getImages() const noexcept -> const std::vector<VkImage>& {
+    return m_images;
+}
+
 auto Swapchain::getImageViews() const noexcept -> const std::vector<VkImageView>& {
     return m_imageViews;
 }
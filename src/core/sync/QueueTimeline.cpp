@@ -0,0 +1,86 @@
+#include "core/sync/QueueTimeline.hpp"
+
+#include <algorithm>
+
+namespace core::sync {
+
+QueueTimeline::QueueTimeline(device::Device& device, const device::Queue& queue)
+: m_queue(queue)
+, m_semaphore{device, 0}
+{}
+
+QueueTimeline::~QueueTimeline()
+{
+    // Callbacks may release resources the GPU still uses
+    if (m_submitted > m_completed) {
+        wait(m_submitted);
+    }
+    m_callbacks.clear();
+}
+
+auto QueueTimeline::submit(device::Queue::SubmitInfo info) -> uint64_t
+{
+    info.signalTimeline = m_semaphore;
+    info.signalValue = m_submitted + 1;
+
+    m_queue.submit(info);
+    return ++m_submitted;
+}
+
+auto QueueTimeline::getCompletedValue() -> uint64_t
+{
+    m_completed = std::max(m_completed, m_semaphore.getValue());
+    return m_completed;
+}
+
+auto QueueTimeline::isComplete(uint64_t value) -> bool
+{
+    return value <= m_completed || value <= getCompletedValue();
+}
+
+auto QueueTimeline::wait(uint64_t value, uint64_t timeout) -> VkResult
+{
+    if (isComplete(value)) {
+        run_callbacks();
+        return VK_SUCCESS;
+    }
+
+    const VkResult result = m_semaphore.wait(value, timeout);
+    if (result == VK_SUCCESS) {
+        m_completed = std::max(m_completed, value);
+        run_callbacks();
+    }
+
+    return result;
+}
+
+auto QueueTimeline::onComplete(uint64_t value, Callback callback) -> void
+{
+    if (isComplete(value)) {
+        callback();
+        return;
+    }
+
+    m_callbacks.emplace(value, std::move(callback));
+}
+
+auto QueueTimeline::poll() -> void
+{
+    if (!m_callbacks.empty()) {
+        getCompletedValue();
+        run_callbacks();
+    }
+}
+
+    /**   PRIVATE   **/
+
+auto QueueTimeline::run_callbacks() -> void
+{
+    // Extracted one by one, a callback may add new ones
+    while (!m_callbacks.empty() && m_callbacks.begin()->first <= m_completed) {
+        auto node = m_callbacks.extract(m_callbacks.begin());
+        node.mapped()();
+    }
+}
+
+} // namespace core::sync
@@ -138,6 +138,38 @@ auto Camera::resetRotation() noexcept -> void
     updateView();
 }
 
+auto Camera::lookAt(const vector position, const vector target) noexcept -> void
+{
+    m_position = position;
+    m_forward = glm::normalize(target - position);
+    m_right = glm::normalize(glm::cross(m_forward, normal{0.f, 1.f, 0.f}));
+    m_up = glm::cross(m_right, m_forward);
+
+    updateView();
+}
+
+auto Camera::getFrustum() const noexcept -> std::array<plane, 6>
+{
+    // Gribb-Hartmann plane extraction from the rows of the view-projection matrix
+    const matrix viewProj = m_projection * m_view;
+    const auto row = [&](int i) { return glm::vec4{viewProj[0][i], viewProj[1][i], viewProj[2][i], viewProj[3][i]}; };
+
+    std::array<plane, 6> planes{
+        row(3) + row(0),
+        row(3) - row(0),
+        row(3) + row(1),
+        row(3) - row(1),
+        row(3) + row(2),
+        row(3) - row(2)
+    };
+
+    for (auto& p : planes) {
+        p /= glm::length(glm::vec3{p});
+    }
+
+    return planes;
+}
+
     /**   PRIVATE   **/
 
 auto Camera::updateView() noexcept -> void
@@ -150,8 +182,8 @@ auto Camera::updateProjection() noexcept -> void
     m_projection = glm::perspective(
         glm::radians(m_fov),
         static_cast<float>(m_resolution.x) / static_cast<float>(m_resolution.y),
-        0.5f,
-        20000.f
+        m_near,
+        m_far
     );
 }
 
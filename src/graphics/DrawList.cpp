@@ -0,0 +1,89 @@
+#include "graphics/DrawList.hpp"
+
+#include <array>
+#include <algorithm>
+
+namespace {
+
+constexpr uint32_t RADIX_BITS = 8;
+constexpr uint32_t RADIX_SIZE = 1u << RADIX_BITS;
+constexpr uint32_t RADIX_PASSES = 64 / RADIX_BITS;
+
+[[nodiscard]]
+constexpr auto field(uint32_t value, uint32_t bits) noexcept -> uint64_t {
+    return static_cast<uint64_t>(value) & ((uint64_t{1} << bits) - 1);
+}
+
+[[nodiscard]]
+constexpr auto digit(uint64_t key, uint32_t pass) noexcept -> uint32_t {
+    return static_cast<uint32_t>(key >> (pass * RADIX_BITS)) & (RADIX_SIZE - 1);
+}
+
+} // namespace
+
+namespace graphics {
+
+auto DrawList::makeKey(
+    uint32_t pipeline,
+    uint32_t material,
+    uint32_t mesh,
+    float depth
+) noexcept -> uint64_t {
+    constexpr uint32_t maxDepth = (1u << DEPTH_BITS) - 1;
+    const auto quantizedDepth = static_cast<uint32_t>(
+        std::clamp(depth, 0.f, 1.f) * static_cast<float>(maxDepth)
+    );
+
+    return (field(pipeline, PIPELINE_BITS) << (MATERIAL_BITS + MESH_BITS + DEPTH_BITS))
+         | (field(material, MATERIAL_BITS) << (MESH_BITS + DEPTH_BITS))
+         | (field(mesh, MESH_BITS) << DEPTH_BITS)
+         | field(quantizedDepth, DEPTH_BITS);
+}
+
+auto DrawList::reserve(size_t count) -> void
+{
+    m_entries.reserve(count);
+    m_scratch.reserve(count);
+}
+
+auto DrawList::sort() -> void
+{
+    const size_t count = m_entries.size();
+    if (count < 2) {
+        return;
+    }
+
+    // Histograms of all passes are gathered in a single sweep over the keys
+    std::array<std::array<uint32_t, RADIX_SIZE>, RADIX_PASSES> histograms{};
+    for (const auto& entry : m_entries) {
+        for (uint32_t pass = 0; pass < RADIX_PASSES; ++pass) {
+            histograms[pass][digit(entry.key, pass)]++;
+        }
+    }
+
+    m_scratch.resize(count);
+
+    for (uint32_t pass = 0; pass < RADIX_PASSES; ++pass) {
+        auto& histogram = histograms[pass];
+
+        // All keys share this digit, the pass would not change the order
+        if (histogram[digit(m_entries.front().key, pass)] == count) {
+            continue;
+        }
+
+        uint32_t offset = 0;
+        for (auto& bucket : histogram) {
+            const uint32_t bucketCount = bucket;
+            bucket = offset;
+            offset += bucketCount;
+        }
+
+        for (const auto& entry : m_entries) {
+            m_scratch[histogram[digit(entry.key, pass)]++] = entry;
+        }
+
+        m_entries.swap(m_scratch);
+    }
+}
+
+} // namespace graphics
@@ -0,0 +1,38 @@
+#include "graphics/OffscreenTarget.hpp"
+
+#include <stdexcept>
+
+namespace graphics {
+
+OffscreenTarget::OffscreenTarget(systems::MemoryManager& memoryManager, VkExtent2D extent, uint32_t imageCount)
+: m_extent(extent)
+{
+    if (imageCount == 0 || extent.width == 0 || extent.height == 0) {
+        throw std::invalid_argument("Offscreen target needs at least one image of a non-zero size.");
+    }
+
+    m_targets.reserve(imageCount);
+    m_images.reserve(imageCount);
+    m_imageViews.reserve(imageCount);
+
+    for (uint32_t i = 0; i < imageCount; i++) {
+        m_targets.push_back(memoryManager.createImage(
+            {extent.width, extent.height, 1},
+            core::memory::ImageType::COLOR_TARGET,
+            systems::MemoryUsage::GPU_ONLY
+        ));
+
+        m_images.push_back(m_targets.back().getImage());
+        m_imageViews.push_back(m_targets.back().getView());
+    }
+}
+
+auto OffscreenTarget::acquireNextImage() noexcept -> uint32_t
+{
+    const uint32_t image = m_nextImage;
+    m_nextImage = (m_nextImage + 1) % static_cast<uint32_t>(m_images.size());
+
+    return image;
+}
+
+} // namespace graphics
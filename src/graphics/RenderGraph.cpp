@@ -0,0 +1,950 @@
+#include "graphics/RenderGraph.hpp"
+
+#include <algorithm>
+#include <format>
+#include <stdexcept>
+
+#include "vulkan/api.hpp"
+
+namespace {
+
+using Usage = graphics::RenderGraph::Usage;
+
+constexpr VkAccessFlags WRITE_ACCESS =
+    VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT |
+    VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT |
+    VK_ACCESS_SHADER_WRITE_BIT |
+    VK_ACCESS_TRANSFER_WRITE_BIT |
+    VK_ACCESS_HOST_WRITE_BIT |
+    VK_ACCESS_MEMORY_WRITE_BIT;
+
+constexpr VkImageUsageFlags ATTACHMENT_USAGE =
+    VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT | VK_IMAGE_USAGE_DEPTH_STENCIL_ATTACHMENT_BIT;
+
+struct UsageInfo {
+    VkPipelineStageFlags stages;
+    VkAccessFlags access;
+    VkImageLayout layout;
+    VkImageUsageFlags imageUsage;
+    bool write;
+    bool image;     // Valid for images
+    bool buffer;    // Valid for buffers
+};
+
+[[nodiscard]]
+auto get_usage_info(Usage usage, VkImageAspectFlags aspect) -> UsageInfo
+{
+    const VkImageLayout sampledLayout = (aspect & VK_IMAGE_ASPECT_DEPTH_BIT) ?
+        VK_IMAGE_LAYOUT_DEPTH_STENCIL_READ_ONLY_OPTIMAL :
+        VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+
+    switch (usage) {
+        case Usage::COLOR_ATTACHMENT:
+            return {
+                VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT,
+                VK_ACCESS_COLOR_ATTACHMENT_READ_BIT | VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT,
+                VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL,
+                VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT,
+                true, true, false
+            };
+        case Usage::DEPTH_ATTACHMENT:
+            return {
+                VK_PIPELINE_STAGE_EARLY_FRAGMENT_TESTS_BIT | VK_PIPELINE_STAGE_LATE_FRAGMENT_TESTS_BIT,
+                VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_READ_BIT | VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT,
+                VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL,
+                VK_IMAGE_USAGE_DEPTH_STENCIL_ATTACHMENT_BIT,
+                true, true, false
+            };
+        case Usage::SAMPLED_COMPUTE:
+            return {
+                VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_ACCESS_SHADER_READ_BIT,
+                sampledLayout, VK_IMAGE_USAGE_SAMPLED_BIT,
+                false, true, false
+            };
+        case Usage::SAMPLED_FRAGMENT:
+            return {
+                VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT, VK_ACCESS_SHADER_READ_BIT,
+                sampledLayout, VK_IMAGE_USAGE_SAMPLED_BIT,
+                false, true, false
+            };
+        case Usage::STORAGE_READ:
+            return {
+                VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_ACCESS_SHADER_READ_BIT,
+                VK_IMAGE_LAYOUT_GENERAL, VK_IMAGE_USAGE_STORAGE_BIT,
+                false, true, true
+            };
+        case Usage::STORAGE_WRITE:
+            return {
+                VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT,
+                VK_IMAGE_LAYOUT_GENERAL, VK_IMAGE_USAGE_STORAGE_BIT,
+                true, true, true
+            };
+        case Usage::TRANSFER_WRITE:
+            return {
+                VK_PIPELINE_STAGE_TRANSFER_BIT, VK_ACCESS_TRANSFER_WRITE_BIT,
+                VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, VK_IMAGE_USAGE_TRANSFER_DST_BIT,
+                true, true, true
+            };
+        case Usage::INDIRECT_READ:
+            return {
+                VK_PIPELINE_STAGE_DRAW_INDIRECT_BIT, VK_ACCESS_INDIRECT_COMMAND_READ_BIT,
+                VK_IMAGE_LAYOUT_UNDEFINED, 0,
+                false, false, true
+            };
+        case Usage::VERTEX_READ:
+            return {
+                VK_PIPELINE_STAGE_VERTEX_SHADER_BIT, VK_ACCESS_SHADER_READ_BIT,
+                VK_IMAGE_LAYOUT_UNDEFINED, 0,
+                false, false, true
+            };
+        case Usage::PRESENT:
+            // The present waits on a semaphore signaled after the whole submission, no access to make visible
+            return {
+                VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, 0,
+                VK_IMAGE_LAYOUT_PRESENT_SRC_KHR, 0,
+                false, true, false
+            };
+        case Usage::HOST_READ:
+            return {
+                VK_PIPELINE_STAGE_HOST_BIT, VK_ACCESS_HOST_READ_BIT,
+                VK_IMAGE_LAYOUT_UNDEFINED, 0,
+                false, false, true
+            };
+        default:
+            throw std::invalid_argument("Unsupported render graph resource usage.");
+    }
+}
+
+[[nodiscard]]
+constexpr auto load_op_name(VkAttachmentLoadOp op) noexcept -> const char* {
+    switch (op) {
+        case VK_ATTACHMENT_LOAD_OP_LOAD: return "load";
+        case VK_ATTACHMENT_LOAD_OP_CLEAR: return "clear";
+        default: return "don't care";
+    }
+}
+
+[[nodiscard]]
+constexpr auto store_op_name(VkAttachmentStoreOp op) noexcept -> const char* {
+    return op == VK_ATTACHMENT_STORE_OP_STORE ? "store" : "don't care";
+}
+
+} // namespace
+
+namespace graphics {
+
+auto RenderGraph::PassBuilder::use(ResourceID resource, Usage usage) -> PassBuilder&
+{
+    m_graph.add_use(m_pass, resource, usage, nullptr);
+    return *this;
+}
+
+auto RenderGraph::PassBuilder::clear(ResourceID resource, const VkClearValue& value) -> PassBuilder&
+{
+    const auto& image = m_graph.m_resources.at(resource);
+    const Usage usage = (image.desc.aspect & VK_IMAGE_ASPECT_DEPTH_BIT) ? Usage::DEPTH_ATTACHMENT : Usage::COLOR_ATTACHMENT;
+
+    m_graph.add_use(m_pass, resource, usage, &value);
+    return *this;
+}
+
+auto RenderGraph::PassBuilder::secondaryCommandBuffers() -> PassBuilder&
+{
+    m_graph.m_passes[m_pass].secondary = true;
+    return *this;
+}
+
+auto RenderGraph::PassBuilder::sideEffects() -> PassBuilder&
+{
+    m_graph.m_passes[m_pass].sideEffects = true;
+    return *this;
+}
+
+RenderGraph::RenderGraph(core::device::Device& device, systems::MemoryManager& memoryManager)
+: m_device(device.getDevice())
+, m_memoryManager(memoryManager)
+{}
+
+RenderGraph::~RenderGraph()
+{
+    release();
+}
+
+auto RenderGraph::createImage(std::string name, const ImageDesc& desc) -> ResourceID
+{
+    return add_resource(std::move(name), true, false, desc);
+}
+
+auto RenderGraph::importImage(std::string name, const ImageDesc& desc) -> ResourceID
+{
+    return add_resource(std::move(name), true, true, desc);
+}
+
+auto RenderGraph::importBuffer(std::string name) -> ResourceID
+{
+    return add_resource(std::move(name), false, true, ImageDesc{});
+}
+
+auto RenderGraph::setOutput(ResourceID resource, std::optional<Usage> finalUsage) -> void
+{
+    auto& output = m_resources.at(resource);
+
+    if (finalUsage) {
+        const auto info = get_usage_info(*finalUsage, output.desc.aspect);
+        if (output.image ? !info.image : !info.buffer) {
+            throw std::invalid_argument(std::format("Invalid final usage of render graph resource {}.", output.name));
+        }
+    }
+
+    output.output = true;
+    output.finalUsage = finalUsage;
+}
+
+auto RenderGraph::addRasterPass(std::string name, RecordFunction record) -> PassBuilder
+{
+    m_passes.push_back(Pass{.name = std::move(name), .raster = true, .record = std::move(record)});
+    return PassBuilder{*this, static_cast<uint32_t>(m_passes.size() - 1)};
+}
+
+auto RenderGraph::addComputePass(std::string name, RecordFunction record) -> PassBuilder
+{
+    m_passes.push_back(Pass{.name = std::move(name), .raster = false, .record = std::move(record)});
+    return PassBuilder{*this, static_cast<uint32_t>(m_passes.size() - 1)};
+}
+
+auto RenderGraph::compile() -> void
+{
+    release();
+    m_stats = Stats{.passCount = static_cast<uint32_t>(m_passes.size())};
+
+    cull_passes();
+    allocate_images();
+
+    // Attachments are loaded if an earlier pass of the execution wrote them
+    std::vector<bool> written(m_resources.size(), false);
+    for (uint32_t position = 0; position < m_order.size(); position++) {
+        auto& pass = m_passes[m_order[position]];
+
+        if (pass.raster) {
+            create_render_pass(pass, position, written);
+        }
+
+        for (const auto& use : pass.uses) {
+            written[use.resource] = written[use.resource] || use.access.write;
+        }
+    }
+
+    plan_barriers();
+}
+
+auto RenderGraph::setImportedImage(ResourceID resource, VkImage image, VkImageView view) -> void
+{
+    auto& imported = m_resources.at(resource);
+    if (!imported.image || !imported.imported) {
+        throw std::invalid_argument(std::format("Render graph resource {} is not an imported image.", imported.name));
+    }
+
+    imported.handle = image;
+    imported.view = view;
+}
+
+auto RenderGraph::execute(core::commands::CommandBuffer& cmd) -> void
+{
+    for (const uint32_t index : m_order) {
+        auto& pass = m_passes[index];
+
+        record_barriers(cmd, pass.barriers);
+        cmd.beginScope(pass.name);
+
+        if (!pass.raster) {
+            pass.record(cmd, PassContext{VK_NULL_HANDLE, VK_NULL_HANDLE, VkExtent2D{}});
+            cmd.endScope();
+            continue;
+        }
+
+        const VkFramebuffer framebuffer = get_framebuffer(pass);
+        cmd.beginRenderPass(
+            pass.renderPass,
+            framebuffer,
+            pass.extent,
+            pass.clearValues,
+            pass.secondary ? VK_SUBPASS_CONTENTS_SECONDARY_COMMAND_BUFFERS : VK_SUBPASS_CONTENTS_INLINE
+        );
+        pass.record(cmd, PassContext{pass.renderPass, framebuffer, pass.extent});
+        cmd.endRenderPass();
+        cmd.endScope();
+    }
+
+    record_barriers(cmd, m_finalBarriers);
+}
+
+auto RenderGraph::reset() -> void
+{
+    release();
+
+    m_resources.clear();
+    m_passes.clear();
+    m_stats = Stats{};
+}
+
+auto RenderGraph::getReport() const -> std::string
+{
+    std::string report = std::format(
+        "Render graph: {} passes, {} culled, {} barriers with {} image barriers\n",
+        m_stats.passCount, m_stats.culledPassCount, m_stats.barrierCount, m_stats.imageBarrierCount
+    );
+
+    for (const auto& pass : m_passes) {
+        if (pass.culled) {
+            report += std::format(" {}: culled\n", pass.name);
+            continue;
+        }
+
+        report += std::format(
+            " {}: {}, {} image & {} memory barriers before\n",
+            pass.name, pass.raster ? "raster" : "compute",
+            pass.barriers.imageBarriers.size(), pass.barriers.memoryBarriers.size()
+        );
+
+        for (size_t i = 0; i < pass.attachments.size(); i++) {
+            report += std::format(
+                "  {:12} {:10} / {}\n",
+                m_resources[pass.attachments[i]].name, load_op_name(pass.loadOps[i]), store_op_name(pass.storeOps[i])
+            );
+        }
+    }
+
+    report += std::format(
+        "Transient images: {}, {} lazily allocated, {} sharing memory, {} bytes for the others ({} without aliasing)\n",
+        m_stats.transientImageCount, m_stats.lazyImageCount, m_stats.aliasedImageCount,
+        m_stats.transientMemory, m_stats.unaliasedMemory
+    );
+
+    return report;
+}
+
+    /**   PRIVATE   **/
+
+auto RenderGraph::add_resource(std::string name, bool image, bool imported, const ImageDesc& desc) -> ResourceID
+{
+    m_resources.push_back(Resource{
+        .name = std::move(name),
+        .image = image,
+        .imported = imported,
+        .desc = desc
+    });
+
+    return static_cast<ResourceID>(m_resources.size() - 1);
+}
+
+auto RenderGraph::add_use(uint32_t pass, ResourceID resource, Usage usage, const VkClearValue* clearValue) -> void
+{
+    const auto& used = m_resources.at(resource);
+    auto& target = m_passes[pass];
+
+    const auto info = get_usage_info(usage, used.desc.aspect);
+    const bool attachment = usage == Usage::COLOR_ATTACHMENT || usage == Usage::DEPTH_ATTACHMENT;
+
+    if ((used.image ? !info.image : !info.buffer) || usage == Usage::PRESENT || usage == Usage::HOST_READ) {
+        throw std::invalid_argument(std::format("Invalid usage of {} by render graph pass {}.", used.name, target.name));
+    }
+    if (attachment && !target.raster) {
+        throw std::invalid_argument(std::format("Compute pass {} cannot use {} as an attachment.", target.name, used.name));
+    }
+
+    // Attachments depend on their previous content unless cleared, storage writes may read it
+    const Access access{
+        .stages = info.stages,
+        .access = info.access,
+        .layout = info.layout,
+        .write = info.write,
+        .read = !info.write || usage == Usage::STORAGE_WRITE || (attachment && !clearValue)
+    };
+
+    const auto it = std::ranges::find(target.uses, resource, &ResourceUse::resource);
+    if (it == target.uses.end()) {
+        target.uses.push_back(ResourceUse{
+            .resource = resource,
+            .access = access,
+            .imageUsage = info.imageUsage,
+            .attachment = attachment,
+            .clear = clearValue != nullptr,
+            .clearValue = clearValue ? *clearValue : VkClearValue{}
+        });
+        return;
+    }
+
+    // An image is in a single layout during a pass
+    if (used.image && (it->attachment || attachment || it->access.layout != access.layout)) {
+        throw std::invalid_argument(std::format("Conflicting usages of {} by render graph pass {}.", used.name, target.name));
+    }
+
+    it->access.stages |= access.stages;
+    it->access.access |= access.access;
+    it->access.write |= access.write;
+    it->access.read |= access.read;
+    it->imageUsage |= info.imageUsage;
+}
+
+auto RenderGraph::cull_passes() -> void
+{
+    // Walking backwards, a resource is needed while a kept pass after the current one reads its content
+    std::vector<bool> needed(m_resources.size(), false);
+    for (ResourceID resource = 0; resource < m_resources.size(); resource++) {
+        needed[resource] = m_resources[resource].output;
+    }
+
+    for (size_t i = m_passes.size(); i-- > 0;) {
+        auto& pass = m_passes[i];
+
+        pass.culled = !pass.sideEffects && std::ranges::none_of(pass.uses, [&](const ResourceUse& use) {
+            return use.access.write && needed[use.resource];
+        });
+
+        if (pass.culled) {
+            m_stats.culledPassCount++;
+            continue;
+        }
+
+        // Cleared attachments don't depend on earlier writes
+        for (const auto& use : pass.uses) {
+            if (use.clear) {
+                needed[use.resource] = false;
+            }
+        }
+        for (const auto& use : pass.uses) {
+            if (use.access.read) {
+                needed[use.resource] = true;
+            }
+        }
+    }
+
+    for (uint32_t i = 0; i < m_passes.size(); i++) {
+        if (!m_passes[i].culled) {
+            m_order.push_back(i);
+        }
+    }
+}
+
+auto RenderGraph::allocate_images() -> void
+{
+    // Lifetimes & usage flags, over the kept passes only
+    std::vector<bool> seen(m_resources.size(), false);
+    for (uint32_t position = 0; position < m_order.size(); position++) {
+        for (const auto& use : m_passes[m_order[position]].uses) {
+            auto& resource = m_resources[use.resource];
+            if (!seen[use.resource]) {
+                resource.firstPass = position;
+                seen[use.resource] = true;
+            }
+            resource.lastPass = position;
+            resource.usageFlags |= use.imageUsage;
+        }
+    }
+
+    const auto last_use = [&](ResourceID resource) -> const Access& {
+        const auto& uses = m_passes[m_order[m_resources[resource].lastPass]].uses;
+        return std::ranges::find(uses, resource, &ResourceUse::resource)->access;
+    };
+
+    const bool lazySupported = m_memoryManager.supportsLazilyAllocatedMemory();
+    std::vector<ResourceID> aliased;
+
+    for (ResourceID id = 0; id < m_resources.size(); id++) {
+        auto& resource = m_resources[id];
+        if (!resource.image || resource.imported || !seen[id]) {
+            continue;
+        }
+
+        // Attachments of a single render pass are never loaded nor stored, tile memory is enough
+        resource.lazy =
+            (resource.usageFlags & ~ATTACHMENT_USAGE) == 0 &&
+            resource.firstPass == resource.lastPass &&
+            m_passes[m_order[resource.firstPass]].raster &&
+            !resource.output;
+
+        if (resource.lazy) {
+            resource.usageFlags |= VK_IMAGE_USAGE_TRANSIENT_ATTACHMENT_BIT;
+        }
+
+        const VkImageCreateInfo imageInfo{
+            .sType = VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO,
+            .pNext = nullptr,
+            .flags = 0,
+            .imageType = VK_IMAGE_TYPE_2D,
+            .format = resource.desc.format,
+            .extent = {resource.desc.extent.width, resource.desc.extent.height, 1},
+            .mipLevels = 1,
+            .arrayLayers = 1,
+            .samples = VK_SAMPLE_COUNT_1_BIT,
+            .tiling = VK_IMAGE_TILING_OPTIMAL,
+            .usage = resource.usageFlags,
+            .sharingMode = VK_SHARING_MODE_EXCLUSIVE,
+            .queueFamilyIndexCount = 0,
+            .pQueueFamilyIndices = nullptr,
+            .initialLayout = VK_IMAGE_LAYOUT_UNDEFINED
+        };
+
+        vulkan::CreateImage(m_device, &imageInfo, nullptr, &resource.handle);
+        vulkan::GetImageMemoryRequirements(m_device, resource.handle, &resource.requirements);
+        m_stats.transientImageCount++;
+
+        // The image is alone in its memory, its first use waits for its last one in the previous execution
+        resource.initialStages = last_use(id).stages;
+        resource.initialAccess = last_use(id).access & WRITE_ACCESS;
+
+        if (resource.lazy && lazySupported) {
+            m_allocations.push_back(m_memoryManager.allocateMemory(resource.requirements, systems::MemoryUsage::GPU_LAZILY_ALLOCATED));
+            m_memoryManager.bindImageMemory(m_allocations.back(), resource.handle);
+            m_stats.lazyImageCount++;
+        } else {
+            resource.lazy = false;
+            aliased.push_back(id);
+        }
+    }
+
+    // First fit of the largest images first into blocks of images with disjoint lifetimes
+    std::ranges::sort(aliased, std::greater{}, [&](ResourceID id) { return m_resources[id].requirements.size; });
+
+    struct Block {
+        VkMemoryRequirements requirements;
+        std::vector<ResourceID> images;
+    };
+    std::vector<Block> blocks;
+
+    for (const ResourceID id : aliased) {
+        const auto& resource = m_resources[id];
+        const auto& requirements = resource.requirements;
+        m_stats.unaliasedMemory += requirements.size;
+
+        const auto fits = [&](const Block& block) {
+            return (block.requirements.memoryTypeBits & requirements.memoryTypeBits) != 0 &&
+                std::ranges::none_of(block.images, [&](ResourceID other) {
+                    return m_resources[other].firstPass <= resource.lastPass && resource.firstPass <= m_resources[other].lastPass;
+                });
+        };
+
+        if (const auto block = std::ranges::find_if(blocks, fits); block != blocks.end()) {
+            block->requirements.size = std::max(block->requirements.size, requirements.size);
+            block->requirements.alignment = std::max(block->requirements.alignment, requirements.alignment);
+            block->requirements.memoryTypeBits &= requirements.memoryTypeBits;
+            block->images.push_back(id);
+        } else {
+            blocks.push_back(Block{requirements, {id}});
+        }
+    }
+
+    for (auto& block : blocks) {
+        m_allocations.push_back(m_memoryManager.allocateMemory(block.requirements));
+        m_stats.transientMemory += block.requirements.size;
+        m_stats.aliasedImageCount += block.images.size() > 1 ? static_cast<uint32_t>(block.images.size()) : 0;
+
+        // The first use of an image waits for the last use of the image before it in the memory,
+        // the first image of the execution for the last image of the previous one
+        std::ranges::sort(block.images, {}, [&](ResourceID id) { return m_resources[id].firstPass; });
+
+        for (size_t i = 0; i < block.images.size(); i++) {
+            const ResourceID previous = block.images[(i + block.images.size() - 1) % block.images.size()];
+            auto& resource = m_resources[block.images[i]];
+
+            // In first use order, every image of the memory must be dead before the next one is first used
+            if (i > 0 && m_resources[previous].lastPass >= resource.firstPass) {
+                throw std::logic_error(std::format(
+                    "Aliased images '{}' & '{}' have overlapping lifetimes", m_resources[previous].name, resource.name
+                ));
+            }
+
+            m_memoryManager.bindImageMemory(m_allocations.back(), resource.handle);
+            resource.initialStages = last_use(previous).stages;
+            resource.initialAccess = last_use(previous).access & WRITE_ACCESS;
+        }
+    }
+
+    for (ResourceID id = 0; id < m_resources.size(); id++) {
+        auto& resource = m_resources[id];
+        if (!resource.image || resource.imported || resource.handle == VK_NULL_HANDLE) {
+            continue;
+        }
+
+        const VkImageViewCreateInfo viewInfo{
+            .sType = VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO,
+            .pNext = nullptr,
+            .flags = 0,
+            .image = resource.handle,
+            .viewType = VK_IMAGE_VIEW_TYPE_2D,
+            .format = resource.desc.format,
+            .components = {},
+            .subresourceRange = {resource.desc.aspect, 0, 1, 0, 1}
+        };
+
+        vulkan::CreateImageView(m_device, &viewInfo, nullptr, &resource.view);
+    }
+}
+
+auto RenderGraph::create_render_pass(Pass& pass, uint32_t position, const std::vector<bool>& written) -> void
+{
+    // Color attachments in declaration order, then the depth attachment, like the pipelines expect them
+    std::vector<const ResourceUse*> attachments;
+    const ResourceUse* depth = nullptr;
+
+    for (const auto& use : pass.uses) {
+        if (!use.attachment) {
+            continue;
+        }
+
+        if (m_resources[use.resource].desc.aspect & VK_IMAGE_ASPECT_DEPTH_BIT) {
+            if (depth) {
+                throw std::invalid_argument(std::format("Raster pass {} has several depth attachments.", pass.name));
+            }
+            depth = &use;
+        } else {
+            attachments.push_back(&use);
+        }
+    }
+
+    const auto colorCount = static_cast<uint32_t>(attachments.size());
+    if (depth) {
+        attachments.push_back(depth);
+    }
+
+    if (attachments.empty()) {
+        throw std::invalid_argument(std::format("Raster pass {} has no attachment.", pass.name));
+    }
+
+    pass.extent = m_resources[attachments.front()->resource].desc.extent;
+    pass.colorAttachmentCount = colorCount;
+
+    std::vector<VkAttachmentDescription> descriptions;
+    std::vector<VkAttachmentReference> colorReferences;
+
+    for (uint32_t i = 0; i < attachments.size(); i++) {
+        const auto& use = *attachments[i];
+        const auto& resource = m_resources[use.resource];
+
+        if (resource.desc.extent.width != pass.extent.width || resource.desc.extent.height != pass.extent.height) {
+            throw std::invalid_argument(std::format("Attachments of raster pass {} differ in size.", pass.name));
+        }
+
+        const VkAttachmentLoadOp loadOp = use.clear ? VK_ATTACHMENT_LOAD_OP_CLEAR :
+            written[use.resource] ? VK_ATTACHMENT_LOAD_OP_LOAD : VK_ATTACHMENT_LOAD_OP_DONT_CARE;
+        const VkAttachmentStoreOp storeOp = is_read_after(use.resource, position) ?
+            VK_ATTACHMENT_STORE_OP_STORE : VK_ATTACHMENT_STORE_OP_DONT_CARE;
+
+        // The barriers before the pass put the attachments in their layout already
+        descriptions.push_back(VkAttachmentDescription{
+            .flags = 0,
+            .format = resource.desc.format,
+            .samples = VK_SAMPLE_COUNT_1_BIT,
+            .loadOp = loadOp,
+            .storeOp = storeOp,
+            .stencilLoadOp = VK_ATTACHMENT_LOAD_OP_DONT_CARE,
+            .stencilStoreOp = VK_ATTACHMENT_STORE_OP_DONT_CARE,
+            .initialLayout = use.access.layout,
+            .finalLayout = use.access.layout
+        });
+
+        if (i < colorCount) {
+            colorReferences.push_back({i, VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL});
+        }
+
+        pass.attachments.push_back(use.resource);
+        pass.loadOps.push_back(loadOp);
+        pass.storeOps.push_back(storeOp);
+        pass.clearValues.push_back(use.clearValue);
+    }
+
+    const VkAttachmentReference depthReference{colorCount, VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL};
+
+    const VkSubpassDescription subpass{
+        .flags = 0,
+        .pipelineBindPoint = VK_PIPELINE_BIND_POINT_GRAPHICS,
+        .inputAttachmentCount = 0,
+        .pInputAttachments = nullptr,
+        .colorAttachmentCount = colorCount,
+        .pColorAttachments = colorReferences.data(),
+        .pResolveAttachments = nullptr,
+        .pDepthStencilAttachment = depth ? &depthReference : nullptr,
+        .preserveAttachmentCount = 0,
+        .pPreserveAttachments = nullptr
+    };
+
+    // No subpass dependencies, the graph's barriers are recorded outside of the render pass
+    const VkRenderPassCreateInfo renderPassInfo{
+        .sType = VK_STRUCTURE_TYPE_RENDER_PASS_CREATE_INFO,
+        .pNext = nullptr,
+        .flags = 0,
+        .attachmentCount = static_cast<uint32_t>(descriptions.size()),
+        .pAttachments = descriptions.data(),
+        .subpassCount = 1,
+        .pSubpasses = &subpass,
+        .dependencyCount = 0,
+        .pDependencies = nullptr
+    };
+
+    vulkan::CreateRenderPass(m_device, &renderPassInfo, nullptr, &pass.renderPass);
+}
+
+auto RenderGraph::is_read_after(ResourceID resource, uint32_t position) const -> bool
+{
+    for (uint32_t next = position + 1; next < m_order.size(); next++) {
+        const auto& uses = m_passes[m_order[next]].uses;
+        const auto it = std::ranges::find(uses, resource, &ResourceUse::resource);
+
+        if (it != uses.end()) {
+            if (it->access.read) {
+                return true;
+            }
+            if (it->clear) {
+                return false;
+            }
+        }
+    }
+
+    return m_resources[resource].output;
+}
+
+auto RenderGraph::plan_barriers() -> void
+{
+    std::vector<SyncState> states(m_resources.size());
+
+    const auto count = [&](const BarrierBatch& batch) {
+        if (!batch.imageBarriers.empty() || !batch.memoryBarriers.empty()) {
+            m_stats.barrierCount++;
+            m_stats.imageBarrierCount += static_cast<uint32_t>(batch.imageBarriers.size());
+        }
+    };
+
+    for (const uint32_t index : m_order) {
+        auto& pass = m_passes[index];
+
+        for (const auto& use : pass.uses) {
+            add_barrier(pass.barriers, use.resource, use.access, states[use.resource]);
+        }
+        count(pass.barriers);
+    }
+
+    for (ResourceID id = 0; id < m_resources.size(); id++) {
+        const auto& resource = m_resources[id];
+        if (!resource.finalUsage || !states[id].used) {
+            continue;
+        }
+
+        const auto info = get_usage_info(*resource.finalUsage, resource.desc.aspect);
+        add_barrier(
+            m_finalBarriers,
+            id,
+            Access{.stages = info.stages, .access = info.access, .layout = info.layout, .write = false, .read = true},
+            states[id]
+        );
+    }
+    count(m_finalBarriers);
+}
+
+auto RenderGraph::add_barrier(BarrierBatch& batch, ResourceID id, const Access& access, SyncState& state) -> void
+{
+    const auto& resource = m_resources[id];
+
+    VkPipelineStageFlags srcStages = 0;
+    VkAccessFlags srcAccess = 0;
+    bool needed = false;
+    bool transition = false;
+
+    if (resource.image && !state.used) {
+        // The content is undefined, only the previous use of the memory has to be done. Imported images wait
+        // on the stages of their first use, which the semaphore that made them available waits for too
+        srcStages = resource.imported ? access.stages : resource.initialStages;
+        srcAccess = resource.imported ? 0 : resource.initialAccess;
+        needed = true;
+        transition = true;
+    } else if (resource.image && state.layout != access.layout) {
+        srcStages = state.writeStages | state.readStages;
+        srcAccess = state.writeAccess;
+        needed = true;
+        transition = true;
+    } else if (access.write) {
+        // Write after write, or after reads which only need to be done
+        srcStages = state.writeStages | state.readStages;
+        srcAccess = state.writeAccess;
+        needed = srcStages != 0;
+    } else if (state.writeStages != 0) {
+        // Read after write, unless an earlier barrier made the write visible to these stages already
+        srcStages = state.writeStages;
+        srcAccess = state.writeAccess;
+        needed = (access.stages & ~state.visibleStages) != 0 || (access.access & ~state.visibleAccess) != 0;
+    }
+
+    if (needed) {
+        batch.srcStages |= srcStages != 0 ? srcStages : VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT;
+        batch.dstStages |= access.stages;
+
+        if (resource.image) {
+            batch.imageBarriers.push_back(VkImageMemoryBarrier{
+                .sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER,
+                .pNext = nullptr,
+                .srcAccessMask = srcAccess,
+                .dstAccessMask = access.access,
+                .oldLayout = state.used ? state.layout : VK_IMAGE_LAYOUT_UNDEFINED,
+                .newLayout = access.layout,
+                .srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
+                .dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
+                .image = VK_NULL_HANDLE,
+                .subresourceRange = {resource.desc.aspect, 0, 1, 0, 1}
+            });
+            batch.images.push_back(id);
+        } else {
+            if (batch.memoryBarriers.empty()) {
+                batch.memoryBarriers.push_back(VkMemoryBarrier{VK_STRUCTURE_TYPE_MEMORY_BARRIER, nullptr, 0, 0});
+            }
+            batch.memoryBarriers.front().srcAccessMask |= srcAccess;
+            batch.memoryBarriers.front().dstAccessMask |= access.access;
+        }
+    }
+
+    if (access.write) {
+        state.writeStages = access.stages;
+        state.writeAccess = access.access & WRITE_ACCESS;
+        state.readStages = 0;
+        state.visibleStages = 0;
+        state.visibleAccess = 0;
+    } else if (transition) {
+        // A layout transition is a write, later reads in other stages have to wait for it
+        state.writeStages = access.stages;
+        state.writeAccess = 0;
+        state.readStages = access.stages;
+        state.visibleStages = access.stages;
+        state.visibleAccess = access.access;
+    } else {
+        state.readStages |= access.stages;
+        if (needed) {
+            state.visibleStages |= access.stages;
+            state.visibleAccess |= access.access;
+        }
+    }
+
+    state.layout = access.layout;
+    state.used = true;
+}
+
+auto RenderGraph::record_barriers(core::commands::CommandBuffer& cmd, BarrierBatch& batch) -> void
+{
+    for (size_t i = 0; i < batch.images.size(); i++) {
+        const VkImage image = m_resources[batch.images[i]].handle;
+        if (image == VK_NULL_HANDLE) {
+            throw std::runtime_error(std::format("Render graph image {} was not set.", m_resources[batch.images[i]].name));
+        }
+        batch.imageBarriers[i].image = image;
+    }
+
+    cmd.barrier(batch.srcStages, batch.dstStages, batch.memoryBarriers, batch.imageBarriers);
+}
+
+auto RenderGraph::get_framebuffer(Pass& pass) -> VkFramebuffer
+{
+    m_viewScratch.clear();
+    for (const ResourceID attachment : pass.attachments) {
+        m_viewScratch.push_back(m_resources[attachment].view);
+    }
+
+    // Imported attachments change from frame to frame, e.g. the swapchain image
+    if (const auto it = pass.framebuffers.find(m_viewScratch); it != pass.framebuffers.end()) {
+        return it->second;
+    }
+
+    const VkFramebufferCreateInfo framebufferInfo{
+        .sType = VK_STRUCTURE_TYPE_FRAMEBUFFER_CREATE_INFO,
+        .pNext = nullptr,
+        .flags = 0,
+        .renderPass = pass.renderPass,
+        .attachmentCount = static_cast<uint32_t>(m_viewScratch.size()),
+        .pAttachments = m_viewScratch.data(),
+        .width = pass.extent.width,
+        .height = pass.extent.height,
+        .layers = 1
+    };
+
+    VkFramebuffer framebuffer{VK_NULL_HANDLE};
+    vulkan::CreateFramebuffer(m_device, &framebufferInfo, nullptr, &framebuffer);
+
+    pass.framebuffers.emplace(m_viewScratch, framebuffer);
+    return framebuffer;
+}
+
+auto RenderGraph::release() -> void
+{
+    // Destroyed once the frames recorded with them completed, rebuilding the graph doesn't wait for the GPU
+    std::vector<VkFramebuffer> framebuffers;
+    std::vector<VkRenderPass> renderPasses;
+    std::vector<VkImageView> views;
+    std::vector<VkImage> images;
+
+    for (auto& pass : m_passes) {
+        for (const auto& [passViews, framebuffer] : pass.framebuffers) {
+            framebuffers.push_back(framebuffer);
+        }
+        if (pass.renderPass != VK_NULL_HANDLE) {
+            renderPasses.push_back(pass.renderPass);
+        }
+
+        pass.culled = false;
+        pass.barriers = BarrierBatch{};
+        pass.renderPass = VK_NULL_HANDLE;
+        pass.colorAttachmentCount = 0;
+        pass.attachments.clear();
+        pass.loadOps.clear();
+        pass.storeOps.clear();
+        pass.clearValues.clear();
+        pass.framebuffers.clear();
+    }
+
+    for (auto& resource : m_resources) {
+        if (!resource.imported) {
+            if (resource.view != VK_NULL_HANDLE) {
+                views.push_back(resource.view);
+            }
+            if (resource.handle != VK_NULL_HANDLE) {
+                images.push_back(resource.handle);
+            }
+            resource.handle = VK_NULL_HANDLE;
+            resource.view = VK_NULL_HANDLE;
+        }
+
+        resource.usageFlags = 0;
+        resource.lazy = false;
+    }
+
+    if (!framebuffers.empty() || !renderPasses.empty() || !views.empty() || !images.empty() || !m_allocations.empty()) {
+        m_memoryManager.defer([
+            device = m_device,
+            memoryManager = &m_memoryManager,
+            framebuffers = std::move(framebuffers),
+            renderPasses = std::move(renderPasses),
+            views = std::move(views),
+            images = std::move(images),
+            allocations = std::move(m_allocations)
+        ] {
+            for (const auto framebuffer : framebuffers) {
+                vulkan::DestroyFramebuffer(device, framebuffer, nullptr);
+            }
+            for (const auto renderPass : renderPasses) {
+                vulkan::DestroyRenderPass(device, renderPass, nullptr);
+            }
+            for (const auto view : views) {
+                vulkan::DestroyImageView(device, view, nullptr);
+            }
+            for (const auto image : images) {
+                vulkan::DestroyImage(device, image, nullptr);
+            }
+
+            // Images first, the memory is freed once nothing is bound to it anymore
+            for (const auto allocation : allocations) {
+                memoryManager->freeMemory(allocation);
+            }
+        });
+    }
+
+    m_allocations.clear();
+    m_order.clear();
+    m_finalBarriers = BarrierBatch{};
+}
+
+} // namespace graphics
@@ -3,6 +3,12 @@
 #include <stdexcept>
 #include <format>
 #include <chrono>
+#include <bit>
+#include <algorithm>
+#include <cmath>
+#include <span>
+#include <cstring>
+#include <thread>
 
 #include <assimp/scene.h>
 #include <assimp/Importer.hpp>
@@ -13,7 +19,9 @@
 #include <glm/glm.hpp>
 #include <glm/gtc/matrix_transform.hpp>
 
+#include "common/Profiler.hpp"
 #include "vulkan/utils.hpp"
+#include "core/sync/QueueTimeline.hpp"
 #include "core/pipeline/Shader.hpp"
 
 #include "shaders/generic/Descriptors.hpp"
@@ -38,20 +46,67 @@ auto get_default_shaders(core::device::Device& device) -> std::vector<core::pipe
     return shaders;
 }
 
+[[nodiscard]]
+auto get_prepass_shaders(core::device::Device& device) -> std::vector<core::pipeline::Shader> {
+    std::vector<core::pipeline::Shader> shaders;
+
+    shaders.emplace_back(
+        device,
+        std::filesystem::path{common::SHADER_DIRECTORY} / "depth.vert.spv",
+        core::pipeline::Shader::Type::Vertex
+    );
+
+    return shaders;
+}
+
+// Same post-processing for the models & their occluders, which have to find the same meshes
+[[nodiscard]]
+auto import_scene(Assimp::Importer& importer, const std::string& filepath) -> const aiScene* {
+    const aiScene* scene = importer.ReadFile(
+        filepath.c_str(),
+        aiProcess_Triangulate |
+        aiProcess_FlipUVs |
+        aiProcess_CalcTangentSpace |
+        aiProcess_SplitLargeMeshes
+    );
+
+    if (!scene || scene->mFlags & AI_SCENE_FLAGS_INCOMPLETE || !scene->mRootNode) {
+        std::println("Failed to load model: {}", importer.GetErrorString());
+        return nullptr;
+    }
+    return scene;
+}
+
 } // namespace
 
 namespace graphics {
 
 Renderer::Renderer(
     Window& window,
-    [[maybe_unused]] const Config& config)
+    const Config& config)
+    : Renderer{&window, config}
+{}
+
+Renderer::Renderer(const Config& config)
+    : Renderer{nullptr, config}
+{}
+
+Renderer::Renderer(
+    Window* window,
+    const Config& config)
     : m_window{window}
-    , m_instance{vulkan::get_default_validation_layers()}
-    , m_surface{m_instance, m_window}
-    , m_device{m_instance, m_surface}
-    , m_resourceManager{m_instance, m_device}
-    , m_swapchain{m_device, m_surface, m_window}
-    , m_maxFramesInFlight{static_cast<uint8_t>(m_swapchain.getImageCount())}
+    , m_instance{
+        vulkan::get_default_validation_layers(),
+        window ? window->getRequiredInstanceExtensions() : std::vector<const char*>{}
+    }
+    , m_surface{window ? std::make_unique<core::device::Surface>(m_instance, *window) : nullptr}
+    , m_device{m_instance, m_surface.get()}
+    , m_resourceManager{m_instance, m_device, config.stagingSize}
+    , m_swapchain{window ? std::make_unique<core::pipeline::Swapchain>(m_device, *m_surface, *window) : nullptr}
+    , m_offscreenTarget{
+        window ? nullptr : std::make_unique<OffscreenTarget>(m_resourceManager.getMemoryManager(), config.extent, config.frameCount)
+    }
+    , m_maxFramesInFlight{static_cast<uint8_t>(m_swapchain ? m_swapchain->getImageCount() : m_offscreenTarget->getImageCount())}
     , m_descriptorPool{
         m_device.getDevice(),
         shaders::generic::create_global_descset_layout(m_device.getDevice()),
@@ -61,92 +116,113 @@ Renderer::Renderer(
     , m_globalDescriptorSets{
         m_descriptorPool.allocateDescriptorSets(m_maxFramesInFlight)
     }
-    , m_depthImage{
-        m_resourceManager.getMemoryManager().createImage(
-            {
-                m_swapchain.getExtent().width,
-                m_swapchain.getExtent().height,
-                1
-            },
-            core::memory::ImageType::DEPTH_2D,
-            systems::MemoryUsage::GPU_ONLY
+    , m_renderGraph{m_device, m_resourceManager.getMemoryManager()}
+    , m_commandPool{m_device, m_device.getGraphicsQueue().familyIndex, m_maxFramesInFlight}
+    , m_gpuProfiler{m_device, m_maxFramesInFlight}
+    , m_recordThreads{config.recordThreads}
+    , m_frustumCulling{config.frustumCulling}
+    , m_lodBias{config.lodBias}
+    , m_depthPrepass{config.depthPrepass}
+    , m_frameRing{
+        m_resourceManager.getMemoryManager(),
+        m_maxFramesInFlight,
+        systems::FrameRingBuffer::worstCaseSize(
+            sizeof(shaders::generic::CameraUBO) +
+            sizeof(shaders::generic::LightUBO) +
+            (config.gpuDriven ? 0 : sizeof(uint32_t) * config.instanceCapacity),
+            shaders::generic::GLOBAL_DYNAMIC_OFFSET_COUNT
         )
     }
-    , m_pipeline{
-        m_device,
-        m_swapchain,
-        get_default_shaders(m_device),
-        m_descriptorPool.getLayout(),
-        m_resourceManager.getMemoryManager().getLayout()}
-    , m_framebuffer{m_device, m_swapchain, m_pipeline, m_depthImage.getView()}
-    , m_commandPool{m_device, m_device.getGraphicsQueue().familyIndex, m_maxFramesInFlight}
     , m_camera{
         Camera::resolution{
-            m_swapchain.getExtent().width,
-            m_swapchain.getExtent().height
+            get_extent().width,
+            get_extent().height
         },
         Camera::vector{10.f, 10.f, 10.f},
         glm::normalize(Camera::vector{-10.f, -10.f, -10.f}),
         Camera::normal{0.f, 1.f, 0.f}
     }
 {
-    // Create uniform buffers
-    m_cameraUBOs.reserve(m_maxFramesInFlight);
-    m_lightUBOs.reserve(m_maxFramesInFlight);
+    if (config.gpuDriven) {
+        // Culled draws keep their instances at firstInstance, gl_InstanceIndex must include it
+        if (!m_device.getFeatures().drawIndirectFirstInstance) {
+            throw std::runtime_error("GPU-driven rendering requires the drawIndirectFirstInstance feature");
+        }
 
-    for (uint8_t i = 0; i < m_maxFramesInFlight; ++i) {
-        m_cameraUBOs.emplace_back(
-            m_resourceManager.getMemoryManager().createBuffer(
-                sizeof(shaders::generic::CameraUBO),
-                core::memory::BufferType::UNIFORM
-            )
+        m_gpuCulling = std::make_unique<systems::GpuCulling>(
+            m_device,
+            m_resourceManager.getMemoryManager(),
+            m_maxFramesInFlight,
+            config.instanceCapacity,
+            get_extent()
         );
+        m_gpuCulling->setOcclusionCulling(config.occlusionCulling);
+    } else if (config.occlusionCulling) {
+        throw std::invalid_argument("Occlusion culling requires GPU-driven rendering");
+    }
 
-        m_lightUBOs.emplace_back(
-            m_resourceManager.getMemoryManager().createBuffer(
-                sizeof(shaders::generic::LightUBO),
-                core::memory::BufferType::UNIFORM
-            )
+    if (config.softwareOcclusion) {
+        if (m_gpuCulling) {
+            throw std::invalid_argument("Software occlusion culling is not available with GPU-driven rendering");
+        }
+        m_softwareOcclusion = std::make_unique<systems::SoftwareOcclusion>();
+    }
+
+    // The culling pass writes the visible transforms in GPU-driven mode, the CPU path draws from the instance buffer
+    if (!m_gpuCulling) {
+        m_instanceBuffer = std::make_unique<systems::InstanceBuffer>(
+            m_resourceManager.getMemoryManager(),
+            m_maxFramesInFlight,
+            config.instanceCapacity
         );
     }
 
+    // Written once, the frame's data is selected by the dynamic offsets
     for (size_t i = 0; i < m_maxFramesInFlight; i++) {
-        VkDescriptorBufferInfo bufferInfo{};
-        bufferInfo.buffer = m_cameraUBOs[i].getBuffer();
-        bufferInfo.offset = 0;
-        bufferInfo.range = sizeof(shaders::generic::CameraUBO);
-
-        std::array<VkWriteDescriptorSet, 2> descriptorWrites{};
-        descriptorWrites[0].sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
-        descriptorWrites[0].dstSet = m_globalDescriptorSets[i];
-        descriptorWrites[0].dstBinding = 0;
-        descriptorWrites[0].dstArrayElement = 0;
-        descriptorWrites[0].descriptorType = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER;
-        descriptorWrites[0].descriptorCount = 1;
-        descriptorWrites[0].pBufferInfo = &bufferInfo;
-
-        VkDescriptorBufferInfo lightBufferInfo{};
-        lightBufferInfo.buffer = m_lightUBOs[i].getBuffer();
-        lightBufferInfo.offset = 0;
-        lightBufferInfo.range = sizeof(shaders::generic::LightUBO);
-
-        descriptorWrites[1].sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
-        descriptorWrites[1].dstSet = m_globalDescriptorSets[i];
-        descriptorWrites[1].dstBinding = 1;
-        descriptorWrites[1].dstArrayElement = 0;
-        descriptorWrites[1].descriptorType = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER;
-        descriptorWrites[1].descriptorCount = 1;
-        descriptorWrites[1].pBufferInfo = &lightBufferInfo;
-
-        vulkan::UpdateDescriptorSets(
-            m_device.getDevice(),
-            static_cast<uint32_t>(descriptorWrites.size()),
-            descriptorWrites.data(),
-            0,
-            nullptr
-        );
+        update_global_descriptor_set(i);
+    }
+    m_staleGlobalSets.assign(m_maxFramesInFlight, false);
+    m_frameInstances.assign(m_maxFramesInFlight, FrameInstances{0, 0});
+
+    // Multi-threaded recording: one secondary command pool per frame and recording thread,
+    // each with a command buffer for the depth pre-pass and one for the shading pass
+    if (m_recordThreads > 0 && !m_gpuCulling) {
+        m_jobSystem = std::make_unique<systems::JobSystem>(m_recordThreads - 1);
+
+        m_secondaryPools.reserve(m_maxFramesInFlight * m_recordThreads);
+        for (size_t i = 0; i < m_maxFramesInFlight * m_recordThreads; i++) {
+            m_secondaryPools.push_back(
+                std::make_unique<core::commands::CommandPool>(
+                    m_device,
+                    m_device.getGraphicsQueue().familyIndex,
+                    2,
+                    VK_COMMAND_BUFFER_LEVEL_SECONDARY,
+                    VK_COMMAND_POOL_CREATE_TRANSIENT_BIT
+                )
+            );
+        }
+        m_secondaryBuffers.reserve(2 * m_recordThreads);
+    }
+
+    // The occluders are rasterized in parallel whatever the recording thread count
+    if (m_softwareOcclusion && !m_jobSystem) {
+        m_occlusionJobSystem = std::make_unique<systems::JobSystem>(std::max(std::thread::hardware_concurrency(), 2u) - 1);
     }
 
+    // Uploads are submitted on their own, possibly on the transfer queue, & timed separately
+    m_resourceManager.getMemoryManager().getUploadBatch().setProfiler(&m_gpuProfiler);
+
+    m_pipelineStatistics = m_gpuProfiler.isStatisticsSupported() && (!m_jobSystem || m_device.getFeatures().inheritedQueries);
+
+    build_render_graph();
+
+    m_drawCalls.reserve(config.instanceCapacity);
+    m_drawItems.reserve(config.instanceCapacity);
+    m_cullingSystem.reserve(config.instanceCapacity);
+    m_visibleHandles.reserve(config.instanceCapacity);
+    m_drawList.reserve(config.instanceCapacity);
+    m_drawInstances.reserve(config.instanceCapacity);
+
     m_imageAvailableVec.reserve(m_maxFramesInFlight);
     m_renderFinishedVec.reserve(m_maxFramesInFlight);
     m_inFlightVec.reserve(m_maxFramesInFlight);
@@ -160,11 +236,16 @@ Renderer::Renderer(
 
 Renderer::~Renderer()
 {
+    // The batch being recorded writes timestamps into the profiler's queries, which are destroyed first
+    auto& memoryManager = m_resourceManager.getMemoryManager();
+    memoryManager.submitUploads();
     vkDeviceWaitIdle(m_device.getDevice());
+    memoryManager.getUploadBatch().setProfiler(nullptr);
 }
 
 auto Renderer::loadModel(const std::filesystem::path& fpath) -> std::expected<ModelID, Error>
 {
+    PROFILE_SCOPE("Renderer::loadModel");
     Assimp::Importer importer;
 
     static ModelID nextID{0};
@@ -172,33 +253,63 @@ auto Renderer::loadModel(const std::filesystem::path& fpath) -> std::expected<Mo
 
     const std::string filepath = fpath.string();
 
-    const aiScene* scene = importer.ReadFile(
-        filepath.c_str(),
-        aiProcess_Triangulate |
-        aiProcess_FlipUVs |
-        aiProcess_CalcTangentSpace |
-        aiProcess_SplitLargeMeshes
-    );
-
-    if (!scene || scene->mFlags & AI_SCENE_FLAGS_INCOMPLETE || !scene->mRootNode) {
-        std::println("Failed to load model: {}", importer.GetErrorString());
+    const aiScene* scene = import_scene(importer, filepath);
+    if (!scene) {
         return std::unexpected(Error{});
     }
 
     const auto directory = filepath.substr(0, filepath.find_last_of("\\/"));
 
+    auto& memoryManager = m_resourceManager.getMemoryManager();
+
     try {
+        // One submission for all meshes & textures instead of one per copy. Not waited on, the frames
+        // drawing the model are submitted after it on the graphics queue & ordered by its barriers
+        memoryManager.beginUploads();
         Model model{
             scene,
             m_resourceManager,
-            m_resourceManager.getMemoryManager(),
+            memoryManager,
             directory
         };
+        memoryManager.submitUploads();
+
+        const uint32_t meshCount = static_cast<uint32_t>(model.getDrawables().size());
+        const uint32_t materialCount = static_cast<uint32_t>(model.getMaterialCount());
+
+        auto meshIDs = m_meshIDs.allocate(meshCount * Mesh::MAX_LODS);
+        auto materialIDs = m_materialIDs.allocate(materialCount);
+        if (!meshIDs || !materialIDs) {
+            if (meshIDs) {
+                m_meshIDs.free(*meshIDs);
+            }
+            if (materialIDs) {
+                m_materialIDs.free(*materialIDs);
+            }
+            // The submitted uploads still write into the model
+            memoryManager.retire(std::move(model));
+            std::println("Out of sort key ids for model: {}", filepath);
+            return std::unexpected(Error{});
+        }
 
-        m_loadedModels.emplace(modelID, std::move(model));
+        m_loadedModels.emplace(
+            modelID,
+            LoadedModel{
+                std::move(model),
+                *meshIDs,
+                *materialIDs,
+                fpath,
+                false
+            }
+        );
+
+        m_gpuDrawsDirty = true;
+        m_drawBatchesDirty = true;
 
         return modelID;
     } catch (const std::exception& e) {
+        // The destinations of the recorded uploads were destroyed with the model
+        memoryManager.discardUploads();
         std::println("Exception while creating model: {}", e.what());
         return std::unexpected(Error{});
     }
@@ -206,139 +317,1012 @@ auto Renderer::loadModel(const std::filesystem::path& fpath) -> std::expected<Mo
 
 auto Renderer::unloadModel(const ModelID model) -> void
 {
-    m_loadedModels.erase(model);
+    // Frames in flight may still draw the model, its buffers & textures outlive them
+    if (auto node = m_loadedModels.extract(model)) {
+        // Recorded frames already hold their sort keys, the ids can go to the next model right away
+        m_meshIDs.free(node.mapped().meshIDs);
+        m_materialIDs.free(node.mapped().materialIDs);
+        m_resourceManager.getMemoryManager().retire(std::move(node.mapped()));
+    }
+    m_gpuDrawsDirty = true;
+    m_drawBatchesDirty = true;
 }
 
 auto Renderer::submit(const ModelID model, const glm::mat4& modelMatrix) -> void
 {
-    m_drawQueue.push({model, modelMatrix});
+    m_drawCalls.push_back({model, modelMatrix});
+}
+
+auto Renderer::createInstance(const ModelID model, const glm::mat4& modelMatrix) -> InstanceHandle
+{
+    const InstanceHandle instance = m_instances.create(model, modelMatrix);
+    const uint32_t slot = systems::InstanceRegistry::getSlot(instance);
+
+    // Both reuse destroyed slots, the vectors only grow for new ones
+    const auto handle = m_spatialIndex.insert(instance_bounds(model, modelMatrix));
+    if (slot >= m_spatialHandles.size()) {
+        m_spatialHandles.resize(slot + 1);
+    }
+    if (handle >= m_spatialInstances.size()) {
+        m_spatialInstances.resize(handle + 1);
+    }
+    m_spatialHandles[slot] = handle;
+    m_spatialInstances[handle] = instance;
+
+    return instance;
+}
+
+auto Renderer::setTransform(const InstanceHandle instance, const glm::mat4& modelMatrix) -> void
+{
+    // Stale handles are rejected, their slot may hold another instance by now
+    if (!m_instances.contains(instance)) {
+        return;
+    }
+
+    const uint32_t slot = systems::InstanceRegistry::getSlot(instance);
+    m_instances.setTransform(instance, modelMatrix);
+    m_spatialIndex.setBounds(m_spatialHandles[slot], instance_bounds(m_instances.getModel(slot), modelMatrix));
+}
+
+auto Renderer::destroyInstance(const InstanceHandle instance) -> void
+{
+    if (!m_instances.contains(instance)) {
+        return;
+    }
+
+    m_instances.destroy(instance);
+    m_spatialIndex.remove(m_spatialHandles[systems::InstanceRegistry::getSlot(instance)]);
+}
+
+auto Renderer::setOccluder(const ModelID model, bool occluder) -> void
+{
+    const auto it = m_loadedModels.find(model);
+    if (it == m_loadedModels.end()) {
+        return;
+    }
+    auto& loaded = it->second;
+
+    // Only the software rasterizer reads the CPU geometry, loaded again from the file when needed
+    if (occluder && m_softwareOcclusion && !loaded.model.hasOccluders()) {
+        Assimp::Importer importer;
+        const std::string filepath = loaded.path.string();
+
+        const aiScene* scene = import_scene(importer, filepath);
+        if (!scene) {
+            return;
+        }
+
+        try {
+            loaded.model.loadOccluders(scene);
+        } catch (const std::exception& e) {
+            std::println("Exception while loading occluders: {}", e.what());
+            return;
+        }
+    } else if (!occluder) {
+        loaded.model.releaseOccluders();
+    }
+
+    loaded.occluder = occluder;
+    m_drawBatchesDirty = true;
 }
 
 auto Renderer::render() -> void
 {
+    PROFILE_SCOPE("Renderer::render");
     // 1. Wait for the previous frame to finish
     auto& m_commandBuffer = m_commandPool.getCmdBuffer(m_currentFrame);
     auto& m_imageAvailable = m_imageAvailableVec[m_currentFrame];
     auto& m_inFlight = m_inFlightVec[m_currentFrame];
 
+    using clock = std::chrono::steady_clock;
+    const auto waitStart = clock::now();
+
     constexpr uint64_t TIMEOUT = 1'000'000'000; // 1 second
     m_inFlight.wait(TIMEOUT);
     m_inFlight.reset();
 
-    // 2. Acquire the next image from the swapchain
-    const uint32_t imageIndex = m_swapchain.acquireNextImage(m_imageAvailable);
+    // Release what the completed frames & uploads were holding on to
+    m_device.getGraphicsTimeline().poll();
+    m_resourceManager.getMemoryManager().collectRetired();
+
+    // 2. Acquire the next image from the swapchain, offscreen images are free once the frame's fence was waited on
+    const uint32_t imageIndex = m_swapchain ? m_swapchain->acquireNextImage(m_imageAvailable) : m_offscreenTarget->acquireNextImage();
     auto& m_renderFinished = m_renderFinishedVec[imageIndex];   // need to use imageIndex because swapchain images are not
                                                                 // guaranteed to be returned in the same order every frame
+    const auto recordStart = clock::now();
+
+    // Culls the retained instances on the CPU path, queries between frames see the instances as of this one
+    m_spatialIndex.commit();
+
+    // 2.5 Sort the submitted draw calls by state and depth, then write their instance data for this frame
+    //  (in GPU-driven mode only the submitted instances are written, sorting & culling happen on the GPU)
+    if (m_gpuCulling) {
+        prepare_gpu_culling();
+    } else {
+        build_draw_batches();
+    }
+
+    // The frame's fence was waited on, its ring buffer region is free again
+    m_frameRing.begin(m_currentFrame);
+    write_frame_data();
 
     // 3. Record commands into the command buffer
     m_commandBuffer.reset();
     m_commandBuffer.begin();
 
-    m_commandBuffer.beginRenderPass(
-        m_pipeline.getRenderPass(),
-        m_framebuffer.getFramebuffer(imageIndex),
-        m_swapchain.getExtent(),
-        vulkan::ClearColor{
-            .color = {.float32 = {0.01f, 0.01f, 0.01f, 1.0f}},
-            .depthStencil = {1.0f, 0}
-        }
-    );
-    m_commandBuffer.set(m_swapchain.getViewport());
-    m_commandBuffer.set(m_swapchain.getScissor());
-    m_commandBuffer.bind(m_pipeline);
+    // The fence was waited on, the timestamps this frame slot wrote last time are readable
+    m_gpuProfiler.beginFrame(m_commandBuffer.getCommandBuffer(), m_currentFrame);
+    m_commandBuffer.setProfiler(&m_gpuProfiler);
+    m_commandBuffer.beginScope("frame");
+    if (m_pipelineStatistics) {
+        m_gpuProfiler.beginStatistics(m_commandBuffer.getCommandBuffer());
+    }
 
-    while (!m_drawQueue.empty()) {
-        const auto& drawCall = m_drawQueue.front();
-        draw(drawCall.model, drawCall.modelMatrix);
-        m_drawQueue.pop();
+    // The graph was compiled for the other occlusion culling state, its passes & depth usage differ.
+    // The previous graph's objects are retired, the frames in flight keep using them
+    if (m_gpuCulling && m_gpuCulling->isOcclusionCulling() != m_graphOcclusionCulling) {
+        build_render_graph();
     }
 
-    m_commandBuffer.endRenderPass();
+    const auto& images = m_swapchain ? m_swapchain->getImages() : m_offscreenTarget->getImages();
+    const auto& imageViews = m_swapchain ? m_swapchain->getImageViews() : m_offscreenTarget->getImageViews();
+    m_renderGraph.setImportedImage(m_backbuffer, images[imageIndex], imageViews[imageIndex]);
+    m_commandStats = core::commands::CommandBuffer::Stats{};
+    m_renderGraph.execute(m_commandBuffer);
 
+    if (m_pipelineStatistics) {
+        m_gpuProfiler.endStatistics(m_commandBuffer.getCommandBuffer());
+    }
+    m_commandBuffer.endScope();
     m_commandBuffer.end();
+    m_commandStats += m_commandBuffer.getStats();
+    publish_render_stats();
+    const auto submitStart = clock::now();
 
-    // 3.5 Update uniform buffer for the current frame (now without model matrix)
-    static shaders::generic::CameraUBO ubo{};
-    ubo.view = m_camera.getView();
-    ubo.proj = m_camera.getProjection();
-    ubo.proj[1][1] *= -1; // Vulkan uses a different coordinate system
-
-    ubo.debugConfig = static_cast<glm::uint32>(DEBUG_1);
-
-    m_resourceManager.getMemoryManager().copyDataToBuffer(
-        &ubo,
-        sizeof(ubo),
-        m_cameraUBOs[m_currentFrame]
-    );
-
-    // Update lighting UBO
-    m_resourceManager.getMemoryManager().copyDataToBuffer(
-        &m_lightingSystem.getLightUBO(),
-        sizeof(shaders::generic::LightUBO),
-        m_lightUBOs[m_currentFrame]
-    );
-
-    // 4. Submit the command buffer to the graphics queue (wait for the image to be available)
+    // 4. Submit the command buffer to the graphics queue (wait for the image to be available), the frame also advances its timeline
     const core::device::Queue::SubmitInfo submitInfo{
         .commandBuffers = {&m_commandBuffer.getCommandBuffer(), 1},
-        .waitSemaphore = m_imageAvailable,
-        .signalSemaphore = m_renderFinished,
+        .waitSemaphore = m_swapchain ? static_cast<VkSemaphore>(m_imageAvailable) : VK_NULL_HANDLE,
+        .signalSemaphore = m_swapchain ? static_cast<VkSemaphore>(m_renderFinished) : VK_NULL_HANDLE,
         .fence = m_inFlight,
         .waitStage = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT
     };
-    m_device.getGraphicsQueue().submit(submitInfo);
+    m_device.getGraphicsTimeline().submit(submitInfo);
 
-    // 5. Present the image to the swapchain (wait for the rendering to finish)
-    m_swapchain.present(
-        m_device.getPresentQueue(),
-        imageIndex,
-        m_renderFinished
-    );
+    // 5. Present the image to the swapchain (wait for the rendering to finish), headless frames end at the fence
+    if (m_swapchain) {
+        m_swapchain->present(
+            m_device.getPresentQueue(),
+            imageIndex,
+            m_renderFinished
+        );
+    }
+
+    const auto submitEnd = clock::now();
+    m_frameTimings = FrameTimings{
+        .waitMs = std::chrono::duration<float, std::milli>(recordStart - waitStart).count(),
+        .recordMs = std::chrono::duration<float, std::milli>(submitStart - recordStart).count(),
+        .submitMs = std::chrono::duration<float, std::milli>(submitEnd - submitStart).count()
+    };
 
     // 6. Move to the next frame
     m_currentFrame = (m_currentFrame + 1) % m_maxFramesInFlight;
 }
 
-auto Renderer::draw(const ModelID modelID, const glm::mat4& modelMatrix) -> void
+auto Renderer::lod_scale() const -> float
 {
-    auto& cmd = m_commandPool.getCmdBuffer(m_currentFrame);
+    const float pixelsPerUnit = std::abs(m_camera.getProjection()[1][1]) * 0.5f * static_cast<float>(get_extent().height);
+    return pixelsPerUnit / (LOD_PIXEL_ERROR * std::exp2(m_lodBias));
+}
+
+auto Renderer::instance_bounds(const ModelID model, const glm::mat4& modelMatrix) const -> systems::SpatialIndex::AABB
+{
+    const auto it = m_loadedModels.find(model);
+    if (it == m_loadedModels.end()) {
+        const glm::vec3 origin{modelMatrix[3]};
+        return {origin, origin};
+    }
+
+    const auto& aabb = it->second.model.getAABB();
+    return systems::SpatialIndex::transform({aabb.min, aabb.max}, modelMatrix);
+}
+
+auto Renderer::upload_instances() -> bool
+{
+    // Retained slots come first in the instance buffer, this frame's submitted instances follow them
+    const uint32_t slotCount = m_instances.getSlotCount();
+    const auto transientCount = static_cast<uint32_t>(m_drawCalls.size());
+
+    // Sets of the frames in flight still point at the retired buffer, each one is rewritten once its frame's fence was waited on
+    if (m_instanceBuffer->reserve(slotCount + transientCount)) {
+        m_instances.markAllDirty();
+        m_staleGlobalSets.assign(m_maxFramesInFlight, true);
+    }
+
+    m_instances.consumeDirtyRanges(m_dirtyInstanceRanges);
+
+    // Only the changed slots and the transient instances are written, destroyed slots are never drawn
+    auto* instances = m_instanceBuffer->map(m_currentFrame, m_dirtyInstanceRanges, slotCount, transientCount);
+    uint32_t written = 0;
+
+    for (const auto& [first, count] : m_dirtyInstanceRanges) {
+        for (uint32_t slot = first; slot < first + count; slot++) {
+            instances[written++] = {m_instances.isAlive(slot) ? m_instances.getTransform(slot) : glm::mat4{1.f}};
+        }
+    }
+
+    for (const auto& drawCall : m_drawCalls) {
+        instances[written++] = {drawCall.modelMatrix};
+    }
 
-    const auto& model = m_loadedModels.at(modelID);
+    return !m_dirtyInstanceRanges.empty();
+}
+
+auto Renderer::instance_transform(const uint32_t instance) const -> const glm::mat4&
+{
+    const uint32_t slotCount = m_instances.getSlotCount();
+    return instance < slotCount ? m_instances.getTransform(instance) : m_drawCalls[instance - slotCount].modelMatrix;
+}
+
+auto Renderer::build_draw_batches() -> void
+{
+    const glm::mat4& view = m_camera.getView();
+    const glm::mat4 viewProjection = m_camera.getProjection() * view;
+    const float nearPlane = m_camera.getNear();
+    const float farPlane = m_camera.getFar();
+    const float lodScale = lod_scale();
+
+    // Transforms stay in the instance buffer, only the sorted indices of the visible instances are rebuilt
+    const bool instancesChanged = upload_instances();
+
+    // A static scene seen from a still camera keeps last frame's sorted & culled batches
+    if (!m_drawBatchesDirty &&
+        m_drawCalls.empty() &&
+        !instancesChanged &&
+        viewProjection == m_batchViewProjection &&
+        lodScale == m_batchLodScale) {
+        return;
+    }
+
+    m_drawItems.clear();
+    m_drawList.clear();
+    m_drawInstances.clear();
+    m_drawBatches.clear();
+    m_cullingSystem.clear();
+
+    const auto push_items = [&](uint32_t instance, ModelID modelID, const glm::mat4& modelMatrix) {
+        const auto it = m_loadedModels.find(modelID);
+        if (it == m_loadedModels.end()) {
+            return;
+        }
+
+        const auto& [model, meshIDs, materialIDs, path, occluder] = it->second;
+
+        // View depth of the model origin, normalized so that closer draws get smaller keys
+        const float viewDepth = -(view * modelMatrix[3]).z;
+        const float depth = (viewDepth - nearPlane) / (farPlane - nearPlane);
+
+        // Model space errors grow with the largest axis scale, like the bounding spheres
+        const glm::mat4 modelView = view * modelMatrix;
+        const float scale = std::sqrt(std::max({
+            glm::dot(glm::vec3{modelMatrix[0]}, glm::vec3{modelMatrix[0]}),
+            glm::dot(glm::vec3{modelMatrix[1]}, glm::vec3{modelMatrix[1]}),
+            glm::dot(glm::vec3{modelMatrix[2]}, glm::vec3{modelMatrix[2]})
+        }));
+
+        const auto& drawables = model.getDrawables();
+        for (uint32_t j = 0; j < drawables.size(); j++) {
+            const auto& [mesh, material] = drawables[j];
+
+            // Level from the projected size of the bounding sphere, measured from its closest point
+            const glm::vec4& sphere = mesh->getBoundingSphere();
+            const glm::vec3 center{modelView * glm::vec4{glm::vec3{sphere}, 1.f}};
+            const float distance = std::max(glm::length(center) - sphere.w * scale, nearPlane);
+            const uint32_t lod = mesh->selectLod(scale * lodScale / distance);
+
+            const uint64_t key = DrawList::makeKey(
+                0, // single opaque pipeline
+                materialIDs.first + mesh->getMaterialIndex(),
+                meshIDs.first + j * Mesh::MAX_LODS + lod,
+                depth
+            );
+
+            m_drawItems.push_back({mesh, material, instance, key, lod, occluder});
+        }
+
+        if (m_frustumCulling) {
+            m_cullingSystem.push(modelMatrix, model.getBoundingSpheres());
+        }
+    };
+
+    // Depth, levels & visibility of every instance depend on the camera, their dirty slots only decide whether a rebuild is needed
+    const bool submitted = !m_drawCalls.empty();
+    const uint32_t slotCount = m_instances.getSlotCount();
+    uint32_t rejectedCount = 0;
+
+    if (m_frustumCulling) {
+        // The spatial index was committed this frame, whole subtrees of retained instances outside of the frustum are skipped
+        m_visibleHandles.clear();
+        m_spatialIndex.queryFrustum(m_camera.getFrustum(), m_visibleHandles);
+
+        for (const auto handle : m_visibleHandles) {
+            const uint32_t slot = systems::InstanceRegistry::getSlot(m_spatialInstances[handle]);
+            push_items(slot, m_instances.getModel(slot), m_instances.getTransform(slot));
+        }
+
+        // Meshes of the rejected instances never became draw items, they are culled all the same
+        for (const auto& [model, count] : m_instances.getModelCounts()) {
+            if (const auto it = m_loadedModels.find(model); it != m_loadedModels.end()) {
+                rejectedCount += count * static_cast<uint32_t>(it->second.model.getDrawables().size());
+            }
+        }
+        rejectedCount -= static_cast<uint32_t>(m_drawItems.size());
+    } else {
+        for (uint32_t slot = 0; slot < slotCount; slot++) {
+            if (m_instances.isAlive(slot)) {
+                push_items(slot, m_instances.getModel(slot), m_instances.getTransform(slot));
+            }
+        }
+    }
+
+    for (uint32_t i = 0; i < m_drawCalls.size(); i++) {
+        push_items(slotCount + i, m_drawCalls[i].model, m_drawCalls[i].modelMatrix);
+    }
+
+    // Every mesh of the remaining instances is tested separately, items and spheres share indices
+    const auto itemCount = static_cast<uint32_t>(m_drawItems.size());
+    if (m_frustumCulling) {
+        m_cullingSystem.cull(m_camera.getFrustum(), m_jobSystem.get());
+
+        const auto visibleCount = static_cast<uint32_t>(m_cullingSystem.getVisibleCount());
+        m_cullingStats = {.visible = visibleCount, .frustumCulled = rejectedCount + itemCount - visibleCount, .occlusionCulled = 0};
+    } else {
+        m_cullingStats = {.visible = itemCount, .frustumCulled = 0, .occlusionCulled = 0};
+    }
+
+    // Occluders are drawn into the software depth buffer first, the remaining visible items are tested against it
+    if (m_softwareOcclusion) {
+        m_softwareOcclusion->begin(m_camera.getProjection() * m_camera.getView());
+
+        for (uint32_t i = 0; i < m_drawItems.size(); i++) {
+            const auto& item = m_drawItems[i];
+            if (item.occluder && (!m_frustumCulling || m_cullingSystem.isVisible(i))) {
+                const auto& [positions, indices] = item.mesh->getOccluderGeometry();
+                m_softwareOcclusion->addOccluder(instance_transform(item.instance), positions, indices);
+            }
+        }
+
+        m_softwareOcclusion->rasterize(m_jobSystem ? m_jobSystem.get() : m_occlusionJobSystem.get());
+    }
+
+    for (uint32_t i = 0; i < m_drawItems.size(); i++) {
+        const auto& item = m_drawItems[i];
+        if (m_frustumCulling && !m_cullingSystem.isVisible(i)) {
+            continue;
+        }
+
+        if (m_softwareOcclusion && !item.occluder) {
+            const auto& aabb = item.mesh->getAABB();
+            if (m_softwareOcclusion->isOccluded(instance_transform(item.instance), aabb.min, aabb.max)) {
+                m_cullingStats.occlusionCulled++;
+                m_cullingStats.visible--;
+                continue;
+            }
+        }
+
+        m_drawList.push(item.key, i);
+    }
+
+    m_drawList.sort();
+
+    // Consecutive entries with the same mesh, level & material become one instanced draw,
+    // instances are listed in sorted order so each batch is front-to-back
+    for (const auto& entry : m_drawList.getEntries()) {
+        const auto& item = m_drawItems[entry.payload];
+        const auto drawIndex = static_cast<uint32_t>(m_drawInstances.size());
+
+        if (m_drawBatches.empty() ||
+            m_drawBatches.back().mesh != item.mesh ||
+            m_drawBatches.back().material != item.material ||
+            m_drawBatches.back().lod != item.lod) {
+            m_drawBatches.push_back({item.mesh, item.material, item.lod, drawIndex, 0});
+        }
+
+        m_drawInstances.push_back(item.instance);
+        m_drawBatches.back().instanceCount++;
+    }
+
+    // Submitted draw calls only last a frame, the next one has to drop them again
+    m_drawBatchesDirty = submitted;
+    m_batchViewProjection = viewProjection;
+    m_batchLodScale = lodScale;
+    m_drawBatchesVersion++;
+
+    m_drawCalls.clear();
+}
+
+auto Renderer::rebuild_gpu_draws() -> void
+{
+    std::vector<shaders::culling::CullModel> models;
+    std::vector<shaders::culling::CullDraw> draws;
+
+    m_gpuBuckets.clear();
+    m_gpuModelSlots.clear();
+
+    // Each mesh is a bucket of its own with a draw per level, the arena buffers are only bound once as long as they are shared
+    for (const auto& [modelID, loadedModel] : m_loadedModels) {
+        const auto& drawables = loadedModel.model.getDrawables();
+        const auto firstDraw = static_cast<glm::uint32>(draws.size());
+
+        m_gpuModelSlots.emplace(modelID, static_cast<uint32_t>(models.size()));
+
+        for (const auto& [mesh, material] : drawables) {
+            const auto bucket = static_cast<uint32_t>(m_gpuBuckets.size());
+            const auto firstCommand = static_cast<uint32_t>(draws.size());
+            const auto lods = mesh->getLods();
+
+            for (const auto& lod : lods) {
+                shaders::culling::CullDraw draw{};
+                draw.boundingSphere = mesh->getBoundingSphere();
+                draw.indexCount = lod.indexCount;
+                draw.firstIndex = mesh->getFirstIndex() + lod.firstIndex;
+                draw.vertexOffset = mesh->getVertexOffset();
+                draw.bucket = bucket;
+                draw.bucketFirstCommand = firstCommand;
+                draw.lodError = lod.error;
+                draw.lodCount = static_cast<glm::uint32>(lods.size());
+
+                draws.push_back(draw);
+            }
+
+            m_gpuBuckets.push_back({mesh, material, firstCommand, static_cast<uint32_t>(lods.size())});
+        }
+
+        models.push_back({
+            firstDraw,
+            static_cast<glm::uint32>(draws.size()) - firstDraw,
+            {0, 0}
+        });
+    }
+
+    m_gpuModelInstanceCounts.assign(models.size(), 0);
+    m_gpuCulling->setDraws(std::move(models), std::move(draws));
+    m_gpuDrawsDirty = false;
+}
+
+auto Renderer::prepare_gpu_culling() -> void
+{
+    using shaders::culling::INVALID_MODEL;
+
+    // Model slots are reassigned, every retained instance has to be rewritten with its new one
+    if (m_gpuDrawsDirty) {
+        rebuild_gpu_draws();
+        m_instances.markAllDirty();
+    }
+
+    // Retained slots come first in the instance buffer, this frame's submitted instances follow them
+    const uint32_t slotCount = m_instances.getSlotCount();
+    const auto transientCount = static_cast<uint32_t>(m_drawCalls.size());
+
+    if (m_gpuCulling->reserveInstances(slotCount + transientCount)) {
+        m_instances.markAllDirty();
+    }
+
+    m_instances.consumeDirtyRanges(m_dirtyInstanceRanges);
+
+    const auto model_slot = [&](ModelID model) {
+        const auto it = m_gpuModelSlots.find(model);
+        return it != m_gpuModelSlots.end() ? it->second : INVALID_MODEL;
+    };
+
+    // Only the changed slots and the transient instances are written, free slots are skipped by the culling pass
+    auto* instances = m_gpuCulling->mapInstanceUpload(m_currentFrame, m_dirtyInstanceRanges, slotCount, transientCount);
+    uint32_t written = 0;
+
+    for (const auto& [first, count] : m_dirtyInstanceRanges) {
+        for (uint32_t instance = first; instance < first + count; instance++) {
+            instances[written++] = m_instances.isAlive(instance)
+                ? shaders::culling::CullInstance{m_instances.getTransform(instance), model_slot(m_instances.getModel(instance)), {0, 0, 0}}
+                : shaders::culling::CullInstance{glm::mat4{1.f}, INVALID_MODEL, {0, 0, 0}};
+        }
+    }
+
+    std::ranges::fill(m_gpuModelInstanceCounts, 0);
+
+    for (const auto& [model, count] : m_instances.getModelCounts()) {
+        if (const uint32_t slot = model_slot(model); slot != INVALID_MODEL) {
+            m_gpuModelInstanceCounts[slot] += count;
+        }
+    }
+
+    for (const auto& drawCall : m_drawCalls) {
+        const uint32_t slot = model_slot(drawCall.model);
+        instances[written++] = {drawCall.modelMatrix, slot, {0, 0, 0}};
+
+        if (slot != INVALID_MODEL) {
+            m_gpuModelInstanceCounts[slot]++;
+        }
+    }
+
+    if (m_gpuCulling->prepare(m_currentFrame, slotCount + transientCount, m_gpuModelInstanceCounts)) {
+        update_global_descriptor_set(m_currentFrame);
+    }
+    m_cullingStats = m_gpuCulling->getStats();
+
+    m_drawCalls.clear();
+}
+
+auto Renderer::begin_draws(core::commands::CommandBuffer& cmd, const core::pipeline::Pipeline& pipeline) -> void
+{
+    const VkExtent2D extent = get_extent();
+    cmd.set(VkViewport{0.f, 0.f, static_cast<float>(extent.width), static_cast<float>(extent.height), 0.f, 1.f});
+    cmd.set(VkRect2D{{0, 0}, extent});
+    cmd.bind(pipeline);
+
+    // Global descriptor set and push constants are shared by every draw of the pass
+    cmd.bind(
+        m_globalDescriptorSets[m_currentFrame],
+        pipeline.getPipelineLayout(),
+        0,
+        VK_PIPELINE_BIND_POINT_GRAPHICS,
+        m_globalOffsets
+    );
+
+    shaders::generic::PushConstants pushConstants{};
+    // pushConstants.color = material->getColorTint();
+    pushConstants.color = glm::vec4(1.0f, 1.0f, 1.0f, 1.0f); // White for full alpha
+    pushConstants.time = 0.0f; // TODO: pass actual time
+    pushConstants.objectId = 0; // TODO: pass actual object ID
+    // The culling pass writes the visible instances in draw order, the CPU path sorts indices to them
+    pushConstants.indexedInstances = m_gpuCulling ? 0 : 1;
+    pushConstants.padding = 0.0f;
+
+    cmd.pushConstants(
+        pipeline.getPipelineLayout(),
+        VK_SHADER_STAGE_VERTEX_BIT | VK_SHADER_STAGE_FRAGMENT_BIT,
+        0,
+        sizeof(shaders::generic::PushConstants),
+        &pushConstants
+    );
+}
+
+auto Renderer::record_draws(core::commands::CommandBuffer& cmd, std::span<const DrawBatch> batches, bool depthOnly) -> void
+{
+    begin_draws(cmd, depthOnly ? *m_prepassPipeline : shading_pipeline());
+
+    for (const auto& batch : batches) {
+        draw(cmd, batch, depthOnly);
+    }
+}
+
+auto Renderer::record_indirect_draws(core::commands::CommandBuffer& cmd, bool depthOnly) -> void
+{
+    const auto& pipeline = depthOnly ? *m_prepassPipeline : shading_pipeline();
+    begin_draws(cmd, pipeline);
+
+    for (uint32_t bucket = 0; bucket < m_gpuBuckets.size(); bucket++) {
+        const auto& [mesh, material, firstCommand, commandCount] = m_gpuBuckets[bucket];
 
-    for (const auto& [mesh, material] : model.getDrawables()) {
         cmd.bind(mesh->getVertexBuffer());
         cmd.bind(mesh->getIndexBuffer());
+        if (!depthOnly) {
+            cmd.bind(material->getDescriptorSet(), pipeline.getPipelineLayout(), 1);
+        }
 
-        // Bind both global descriptor set (set 0) and material descriptor set (set 1)
-        std::vector<VkDescriptorSet> descriptorSets = {
-            m_globalDescriptorSets[m_currentFrame],
-            material->getDescriptorSet()
-        };
-        cmd.bindDescriptorSets(descriptorSets, m_pipeline.getPipelineLayout());
-
-        shaders::generic::PushConstants pushConstants{};
-        pushConstants.model = modelMatrix;
-
-        // pushConstants.color = material->getColorTint();
-        pushConstants.color = glm::vec4(1.0f, 1.0f, 1.0f, 1.0f); // White for full alpha
-        pushConstants.time = 0.0f; // TODO: pass actual time
-        pushConstants.objectId = 0; // TODO: pass actual object ID
-        pushConstants.padding[0] = 0.0f;
-        pushConstants.padding[1] = 0.0f;
-
-        cmd.pushConstants(
-            m_pipeline.getPipelineLayout(),
-            VK_SHADER_STAGE_VERTEX_BIT | VK_SHADER_STAGE_FRAGMENT_BIT,
-            0,
-            sizeof(shaders::generic::PushConstants),
-            &pushConstants
-        );
+        m_gpuCulling->drawBucket(cmd, m_currentFrame, bucket, firstCommand, commandCount);
+    }
+}
 
-        const core::commands::DrawIndexed draw_command{
-            mesh->getIndexCount()
-        };
-        cmd.record(draw_command);
+auto Renderer::record_passes(core::commands::CommandBuffer& cmd) -> void
+{
+    // Same draws twice, the shading pass only runs the fragment shader for the closest surface
+    if (m_gpuCulling) {
+        if (m_depthPrepass) {
+            record_indirect_draws(cmd, true);
+        }
+        record_indirect_draws(cmd);
+    } else {
+        if (m_depthPrepass) {
+            record_draws(cmd, m_drawBatches, true);
+        }
+        record_draws(cmd, m_drawBatches);
+    }
+}
+
+auto Renderer::record_draws_parallel(core::commands::CommandBuffer& primary, const RenderGraph::PassContext& pass) -> void
+{
+    const uint32_t chunkCount = m_recordThreads;
+    const size_t batchCount = m_drawBatches.size();
+    const size_t chunkSize = (batchCount + chunkCount - 1) / chunkCount;
+
+    const VkCommandBufferInheritanceInfo inheritanceInfo{
+        .sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_INHERITANCE_INFO,
+        .pNext = nullptr,
+        .renderPass = pass.renderPass,
+        .subpass = 0,
+        .framebuffer = pass.framebuffer,
+        .occlusionQueryEnable = VK_FALSE,
+        .queryFlags = 0,
+        .pipelineStatistics = m_pipelineStatistics ? core::commands::GpuProfiler::STATISTICS : 0
+    };
+
+    // Each chunk of the sorted batches goes to its own per-frame pool, so workers never share a pool.
+    // Buffer 0 of a pool holds the chunk's depth pre-pass, buffer 1 its shading pass
+    const bool depthPrepass = m_depthPrepass;
+    m_jobSystem->parallel_for(chunkCount, [&](uint32_t chunk) {
+        auto& pool = *m_secondaryPools[m_currentFrame * chunkCount + chunk];
+        pool.reset();
+
+        const size_t first = std::min(chunk * chunkSize, batchCount);
+        const size_t last = std::min(first + chunkSize, batchCount);
+        if (first == last) {
+            return;
+        }
+
+        const auto batches = std::span{m_drawBatches}.subspan(first, last - first);
+
+        if (depthPrepass) {
+            auto& prepass = pool.getCmdBuffer(0);
+            prepass.begin(inheritanceInfo);
+            record_draws(prepass, batches, true);
+            prepass.end();
+        }
+
+        auto& cmd = pool.getCmdBuffer(1);
+        cmd.begin(inheritanceInfo);
+        record_draws(cmd, batches);
+        cmd.end();
+    });
+
+    // All of the depth is laid down before any chunk shades
+    m_secondaryBuffers.clear();
+    for (uint32_t buffer = depthPrepass ? 0 : 1; buffer < 2; buffer++) {
+        for (uint32_t chunk = 0; chunk < chunkCount; chunk++) {
+            if (chunk * chunkSize >= batchCount) {
+                break;
+            }
+
+            auto& cmd = m_secondaryPools[m_currentFrame * chunkCount + chunk]->getCmdBuffer(buffer);
+            m_secondaryBuffers.push_back(cmd.getCommandBuffer());
+
+            m_commandStats += cmd.getStats();
+        }
+    }
+
+    primary.execute(m_secondaryBuffers);
+}
+
+auto Renderer::draw(core::commands::CommandBuffer& cmd, const DrawBatch& batch, bool depthOnly) -> void
+{
+    PROFILE_SCOPE("Renderer::draw");
+    cmd.bind(batch.mesh->getVertexBuffer());
+    cmd.bind(batch.mesh->getIndexBuffer());
+
+    // Global descriptor set (set 0) is bound once per command buffer, only the material set (set 1) changes
+    if (!depthOnly) {
+        cmd.bind(batch.material->getDescriptorSet(), shading_pipeline().getPipelineLayout(), 1);
+    }
+
+    // The model matrices come from the instance buffer through the drawn instance indices, the geometry is a range of the arena buffers
+    const auto& lod = batch.mesh->getLods()[batch.lod];
+    cmd.drawIndexed(
+        lod.indexCount,
+        batch.instanceCount,
+        batch.mesh->getFirstIndex() + lod.firstIndex,
+        batch.mesh->getVertexOffset(),
+        m_instanceBase + batch.firstInstance
+    );
+}
+
+auto Renderer::publish_render_stats() -> void
+{
+    auto& memoryManager = m_resourceManager.getMemoryManager();
+    const size_t descriptorSetCount =
+        m_descriptorPool.getAllocatedCount() +
+        memoryManager.getDescriptorPool().getAllocatedCount();
+    const auto staging = memoryManager.getStagingRing().endFrame();
+    const uint64_t bytesTransferred = memoryManager.getUploadBatch().endFrame();
+
+    // Gathered outside of the lock, readers only wait for the copy
+    const RenderStats stats{
+        .drawCalls = m_commandStats.drawCalls,
+        .instances = m_commandStats.instances,
+        .triangles = m_commandStats.triangles,
+        .pipelineBinds = m_commandStats.pipelineBinds,
+        .descriptorBinds = m_commandStats.descriptorBinds,
+        .bufferBinds = m_commandStats.bufferBinds,
+        .bytesUploaded = m_frameRing.getUsed() + m_commandStats.bytesCopied + bytesTransferred,
+        .descriptorSetsAllocated = static_cast<uint32_t>(descriptorSetCount - m_descriptorSetCount),
+        .stagingHighWater = staging.highWater,
+        .stagingSpilled = staging.spilled,
+        .stagingStalls = staging.stalls,
+        .pipeline = m_gpuProfiler.getPipelineStatistics()
+    };
+
+    m_descriptorSetCount = descriptorSetCount;
+
+    std::lock_guard lock{m_renderStatsMutex};
+    m_renderStats = stats;
+}
+
+auto Renderer::build_render_graph() -> void
+{
+    using Usage = RenderGraph::Usage;
+
+    m_renderGraph.reset();
+
+    m_backbuffer = m_renderGraph.importImage(
+        "backbuffer",
+        RenderGraph::ImageDesc{get_color_format(), get_extent(), VK_IMAGE_ASPECT_COLOR_BIT}
+    );
+    // Offscreen images stay in the attachment layout, nothing reads them after the frame
+    m_renderGraph.setOutput(m_backbuffer, m_swapchain ? std::optional{Usage::PRESENT} : std::nullopt);
+
+    // Cleared every frame, the occlusion culling keeps its own pyramid of it
+    const auto depth = m_renderGraph.createImage(
+        "depth",
+        RenderGraph::ImageDesc{VK_FORMAT_D32_SFLOAT, get_extent(), VK_IMAGE_ASPECT_DEPTH_BIT}
+    );
+
+    // The culling buffers are the frame's own, only the order of their accesses within the frame matters
+    auto draws = RenderGraph::INVALID_RESOURCE;
+    if (m_gpuCulling) {
+        draws = m_renderGraph.importBuffer("culled draws");
+        m_renderGraph.setOutput(draws, Usage::HOST_READ);
+
+        m_renderGraph.addComputePass("cull", [this](core::commands::CommandBuffer& cmd, const RenderGraph::PassContext&) {
+            m_gpuCulling->record(
+                cmd,
+                m_currentFrame,
+                systems::GpuCulling::View{
+                    .frustum = m_camera.getFrustum(),
+                    .view = m_camera.getView(),
+                    .projection = m_camera.getProjection(),
+                    .nearPlane = m_camera.getNear(),
+                    .lodScale = lod_scale()
+                }
+            );
+        })
+            .use(draws, Usage::TRANSFER_WRITE)
+            .use(draws, Usage::STORAGE_WRITE);
+    }
+
+    // Changed & submitted transforms of the CPU path, copied into the instance buffer the draws index
+    auto instances = RenderGraph::INVALID_RESOURCE;
+    if (m_instanceBuffer) {
+        instances = m_renderGraph.importBuffer("instances");
+
+        m_renderGraph.addComputePass("instance upload", [this](core::commands::CommandBuffer& cmd, const RenderGraph::PassContext&) {
+            m_instanceBuffer->record(cmd, m_currentFrame);
+        })
+            .use(instances, Usage::TRANSFER_WRITE);
+    }
+
+    auto mainPass = m_renderGraph.addRasterPass("main", [this](core::commands::CommandBuffer& cmd, const RenderGraph::PassContext& pass) {
+        if (m_jobSystem) {
+            record_draws_parallel(cmd, pass);
+        } else {
+            record_passes(cmd);
+        }
+    });
+    mainPass.clear(m_backbuffer, VkClearValue{.color = {.float32 = {0.01f, 0.01f, 0.01f, 1.0f}}})
+        .clear(depth, VkClearValue{.depthStencil = {1.0f, 0}});
+
+    if (m_jobSystem) {
+        mainPass.secondaryCommandBuffers();
     }
+    if (m_gpuCulling) {
+        mainPass.use(draws, Usage::INDIRECT_READ).use(draws, Usage::VERTEX_READ);
+    } else {
+        mainPass.use(instances, Usage::VERTEX_READ);
+    }
+
+    // Draw what the first pass wrongly culled as occluded on top, then keep the final depth for the next frame
+    m_graphOcclusionCulling = m_gpuCulling && m_gpuCulling->isOcclusionCulling();
+    if (m_graphOcclusionCulling) {
+        m_renderGraph.addComputePass("occlusion cull", [this](core::commands::CommandBuffer& cmd, const RenderGraph::PassContext&) {
+            m_gpuCulling->recordSecondPhase(cmd, m_currentFrame);
+        })
+            .use(depth, Usage::SAMPLED_COMPUTE)
+            .use(draws, Usage::TRANSFER_WRITE)
+            .use(draws, Usage::STORAGE_WRITE);
+
+        m_renderGraph.addRasterPass("occlusion draw", [this](core::commands::CommandBuffer& cmd, const RenderGraph::PassContext&) {
+            record_passes(cmd);
+        })
+            .use(m_backbuffer, Usage::COLOR_ATTACHMENT)
+            .use(depth, Usage::DEPTH_ATTACHMENT)
+            .use(draws, Usage::INDIRECT_READ)
+            .use(draws, Usage::VERTEX_READ);
+
+        m_renderGraph.addComputePass("depth pyramid", [this](core::commands::CommandBuffer& cmd, const RenderGraph::PassContext&) {
+            m_gpuCulling->recordPyramidUpdate(cmd, m_currentFrame);
+        })
+            .use(depth, Usage::SAMPLED_COMPUTE)
+            .sideEffects();
+    }
+
+    m_renderGraph.compile();
+    create_pipelines(mainPass.getPass());
+
+    // The pyramid rewrites the set of every frame on its next build, the frames in flight keep the previous depth
+    if (m_graphOcclusionCulling) {
+        m_gpuCulling->setDepthSource(m_renderGraph.getImageView(depth));
+    }
+}
+
+auto Renderer::create_pipelines(uint32_t pass) -> void
+{
+    using core::pipeline::Pipeline;
+
+    // The previous graph's pipelines may still be bound by the frames in flight, m_pipeline owns their layout & goes last
+    auto& memoryManager = m_resourceManager.getMemoryManager();
+    for (auto* pipeline : {&m_prepassPipeline, &m_equalPipeline, &m_pipeline}) {
+        if (*pipeline) {
+            memoryManager.retire(std::move(*pipeline));
+        }
+    }
+
+    // Drawn in the main pass and in the occlusion draw pass, which has the same attachments
+    const VkRenderPass renderPass = m_renderGraph.getRenderPass(pass);
+    const uint32_t colorAttachmentCount = m_renderGraph.getColorAttachmentCount(pass);
+
+    m_pipeline = std::make_unique<Pipeline>(
+        m_device,
+        renderPass,
+        get_extent(),
+        get_default_shaders(m_device),
+        m_descriptorPool.getLayout(),
+        memoryManager.getLayout(),
+        Pipeline::Config{.colorAttachmentCount = colorAttachmentCount}
+    );
+    // Same layout, the global & material sets bound by the pre-pass stay bound for the shading pass
+    m_prepassPipeline = std::make_unique<Pipeline>(
+        m_device,
+        renderPass,
+        get_extent(),
+        get_prepass_shaders(m_device),
+        *m_pipeline,
+        Pipeline::Config{
+            .colorWriteMask = 0,
+            .blend = false,
+            .positionOnly = true,
+            .colorAttachmentCount = colorAttachmentCount
+        }
+    );
+    m_equalPipeline = std::make_unique<Pipeline>(
+        m_device,
+        renderPass,
+        get_extent(),
+        get_default_shaders(m_device),
+        *m_pipeline,
+        Pipeline::Config{
+            .depthWrite = false,
+            .depthCompareOp = VK_COMPARE_OP_EQUAL,
+            .colorAttachmentCount = colorAttachmentCount
+        }
+    );
+}
+
+auto Renderer::write_frame_data() -> void
+{
+    using namespace shaders::generic;
+
+    // Visible instances are written by the culling pass in GPU-driven mode
+    const VkDeviceSize instanceSize = m_gpuCulling ? 0 : sizeof(uint32_t) * m_drawInstances.size();
+    const VkDeviceSize frameSize = systems::FrameRingBuffer::worstCaseSize(
+        sizeof(CameraUBO) + sizeof(LightUBO) + instanceSize,
+        GLOBAL_DYNAMIC_OFFSET_COUNT
+    );
+
+    // Sets of the frames in flight still point at the retired buffer, each one is rewritten once its frame's fence was waited on
+    if (m_frameRing.reserve(frameSize)) {
+        m_staleGlobalSets.assign(m_maxFramesInFlight, true);
+        m_frameInstances.assign(m_maxFramesInFlight, FrameInstances{0, 0});
+    }
+    if (m_staleGlobalSets[m_currentFrame]) {
+        update_global_descriptor_set(m_currentFrame);
+        m_staleGlobalSets[m_currentFrame] = false;
+    }
+
+    CameraUBO camera{};
+    camera.view = m_camera.getView();
+    camera.proj = m_camera.getProjection();
+    camera.proj[1][1] *= -1; // Vulkan uses a different coordinate system
+    camera.debugConfig = static_cast<glm::uint32>(DEBUG_1);
+
+    m_globalOffsets[CAMERA_OFFSET] = m_frameRing.pushUniform(camera);
+    m_globalOffsets[LIGHT_OFFSET] = m_frameRing.pushUniform(m_lightingSystem.getLightUBO());
+
+    // The instance binding covers a whole buffer in both modes, the draw instance binding is only read by the CPU path
+    m_globalOffsets[INSTANCE_OFFSET] = 0;
+    m_globalOffsets[DRAW_INSTANCE_OFFSET] = m_frameRing.getFrameOffset();
+
+    if (m_gpuCulling) {
+        m_instanceBase = 0;
+        return;
+    }
+
+    // The draw instance binding covers the whole region of the frame, draws index from its start.
+    // The uniforms before it have fixed sizes, unchanged batches land where the frame's region already holds them
+    const auto drawInstances = m_frameRing.allocate(instanceSize, sizeof(uint32_t));
+    auto& frameInstances = m_frameInstances[m_currentFrame];
+    if (instanceSize > 0 &&
+        (frameInstances.version != m_drawBatchesVersion || frameInstances.offset != drawInstances.offset)) {
+        std::memcpy(drawInstances.data, m_drawInstances.data(), instanceSize);
+        frameInstances = {m_drawBatchesVersion, drawInstances.offset};
+    }
+
+    m_instanceBase = static_cast<uint32_t>((drawInstances.offset - m_frameRing.getFrameOffset()) / sizeof(uint32_t));
+}
+
+auto Renderer::update_global_descriptor_set(size_t frame) -> void
+{
+    // Offsets within the ring buffer are the dynamic offsets passed when binding the set
+    VkDescriptorBufferInfo bufferInfo{};
+    bufferInfo.buffer = m_frameRing.getBuffer().getBuffer();
+    bufferInfo.offset = 0;
+    bufferInfo.range = sizeof(shaders::generic::CameraUBO);
+
+    std::array<VkWriteDescriptorSet, 4> descriptorWrites{};
+    descriptorWrites[0].sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+    descriptorWrites[0].dstSet = m_globalDescriptorSets[frame];
+    descriptorWrites[0].dstBinding = 0;
+    descriptorWrites[0].dstArrayElement = 0;
+    descriptorWrites[0].descriptorType = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC;
+    descriptorWrites[0].descriptorCount = 1;
+    descriptorWrites[0].pBufferInfo = &bufferInfo;
+
+    VkDescriptorBufferInfo lightBufferInfo{};
+    lightBufferInfo.buffer = m_frameRing.getBuffer().getBuffer();
+    lightBufferInfo.offset = 0;
+    lightBufferInfo.range = sizeof(shaders::generic::LightUBO);
+
+    descriptorWrites[1].sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+    descriptorWrites[1].dstSet = m_globalDescriptorSets[frame];
+    descriptorWrites[1].dstBinding = 1;
+    descriptorWrites[1].dstArrayElement = 0;
+    descriptorWrites[1].descriptorType = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC;
+    descriptorWrites[1].descriptorCount = 1;
+    descriptorWrites[1].pBufferInfo = &lightBufferInfo;
+
+    // The persistent instance buffer on the CPU path, the culling pass output in GPU-driven mode, both at dynamic offset 0
+    VkDescriptorBufferInfo instanceBufferInfo{};
+    instanceBufferInfo.buffer = m_gpuCulling
+        ? m_gpuCulling->getVisibleInstanceBuffer(static_cast<uint32_t>(frame)).getBuffer()
+        : m_instanceBuffer->getBuffer().getBuffer();
+    instanceBufferInfo.offset = 0;
+    instanceBufferInfo.range = VK_WHOLE_SIZE;
+
+    descriptorWrites[2].sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+    descriptorWrites[2].dstSet = m_globalDescriptorSets[frame];
+    descriptorWrites[2].dstBinding = 2;
+    descriptorWrites[2].dstArrayElement = 0;
+    descriptorWrites[2].descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER_DYNAMIC;
+    descriptorWrites[2].descriptorCount = 1;
+    descriptorWrites[2].pBufferInfo = &instanceBufferInfo;
+
+    // A whole region of the ring, unused in GPU-driven mode but valid like every binding of the set
+    VkDescriptorBufferInfo drawInstanceBufferInfo{};
+    drawInstanceBufferInfo.buffer = m_frameRing.getBuffer().getBuffer();
+    drawInstanceBufferInfo.offset = 0;
+    drawInstanceBufferInfo.range = m_frameRing.getFrameSize();
+
+    descriptorWrites[3].sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+    descriptorWrites[3].dstSet = m_globalDescriptorSets[frame];
+    descriptorWrites[3].dstBinding = 3;
+    descriptorWrites[3].dstArrayElement = 0;
+    descriptorWrites[3].descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER_DYNAMIC;
+    descriptorWrites[3].descriptorCount = 1;
+    descriptorWrites[3].pBufferInfo = &drawInstanceBufferInfo;
+
+    vulkan::UpdateDescriptorSets(
+        m_device.getDevice(),
+        static_cast<uint32_t>(descriptorWrites.size()),
+        descriptorWrites.data(),
+        0,
+        nullptr
+    );
 }
 
 } // namespace graphics
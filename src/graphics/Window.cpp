@@ -51,4 +51,16 @@ Window::~Window()
     }
 }
 
+auto Window::getRequiredInstanceExtensions() const -> std::vector<const char*>
+{
+    uint32_t extensionCount{};
+    const char** extensions = glfwGetRequiredInstanceExtensions(&extensionCount);
+
+    if (!extensions) {
+        throw std::runtime_error("Failed to get required instance extensions from GLFW.");
+    }
+
+    return std::vector<const char*>(extensions, extensions + extensionCount);
+}
+
 } // namespace graphics
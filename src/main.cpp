@@ -4,8 +4,12 @@
  */
 #include "graphics/Window.hpp"
 #include "graphics/Renderer.hpp"
+#include "common/Profiler.hpp"
 
 #include <array>
+#include <chrono>
+#include <string>
+#include <string_view>
 
 constexpr
 auto get_model_matrices() -> std::array<glm::mat4, 100> {
@@ -58,7 +62,60 @@ void debug_print(T x, Rest... rest) {
     debug_print(rest...);
 }
 
+// Renders the grid without a window as fast as the GPU allows, e.g. on CI machines with a software ICD
+auto run_headless(uint32_t frameCount) -> int {
+    graphics::Renderer renderer(graphics::Renderer::Config{});
+
+    const auto model = renderer.loadModel("models/Character_Male.fbx").value();
+    for (const auto& modelMatrix : get_model_matrices()) {
+        [[maybe_unused]] const auto instance = renderer.createInstance(model, modelMatrix);
+    }
+
+    const auto start = std::chrono::high_resolution_clock::now();
+    for (uint32_t frame = 0; frame < frameCount; frame++) {
+        renderer.render();
+    }
+    renderer.waitIdle();
+
+    const std::chrono::duration<float, std::milli> duration = std::chrono::high_resolution_clock::now() - start;
+    std::println(
+        "{} headless frames in {:.2f}ms | Frame Time: {:.3f}ms | FPS: {:.2f}",
+        frameCount, duration.count(), duration.count() / frameCount, 1000.f * frameCount / duration.count()
+    );
+
+    const auto stats = renderer.getRenderStats();
+    std::println(
+        "  {} draws, {} triangles, {} pipeline / {} descriptor / {} buffer binds, {} bytes uploaded",
+        stats.drawCalls, stats.triangles, stats.pipelineBinds, stats.descriptorBinds, stats.bufferBinds, stats.bytesUploaded
+    );
+    std::println(
+        "  Staging ring {} bytes peak, {} bytes spilled, {} stalls",
+        stats.stagingHighWater, stats.stagingSpilled, stats.stagingStalls
+    );
+    std::println(
+        "  GPU {} input vertices, {} vertex / {} fragment invocations, {} clipped primitives",
+        stats.pipeline.inputVertices, stats.pipeline.vertexShaderInvocations,
+        stats.pipeline.fragmentShaderInvocations, stats.pipeline.clippingPrimitives
+    );
+
+    for (const auto& scope : renderer.getGpuTimings()) {
+        std::println("  GPU {:16} {:.3f}ms", scope.name, scope.averageMs);
+    }
+
+    return 0;
+}
+
 auto main([[maybe_unused]] int argc, [[maybe_unused]] char** argv) -> int {
+#ifdef ENABLE_PROFILING
+    // Open in chrome://tracing or https://ui.perfetto.dev
+    common::Profiler::dumpOnExit("jacRender.trace.json");
+#endif
+
+    // JacRender --headless [frames]
+    if (argc > 1 && std::string_view{argv[1]} == "--headless") {
+        return run_headless(argc > 2 ? static_cast<uint32_t>(std::stoul(argv[2])) : 1000);
+    }
+
     const std::chrono::high_resolution_clock::time_point program_start = std::chrono::high_resolution_clock::now();
 
     graphics::Window window{};
@@ -90,12 +147,16 @@ auto main([[maybe_unused]] int argc, [[maybe_unused]] char** argv) -> int {
         GLFW_KEY_LEFT_BRACKET,  // Roll left
         GLFW_KEY_RIGHT_BRACKET, // Roll right
         // Debug
-        GLFW_KEY_1
+        GLFW_KEY_1,
+        GLFW_KEY_2  // Depth pre-pass
     };
 
     const auto model = renderer.loadModel("models/Character_Male.fbx").value();
 
-    const auto modelMatrices = get_model_matrices();
+    // The grid never moves, it is uploaded once and only culled & drawn every frame
+    for (const auto& modelMatrix : get_model_matrices()) {
+        [[maybe_unused]] const auto instance = renderer.createInstance(model, modelMatrix);
+    }
 
     while (!window.shouldClose()) {
         const std::chrono::high_resolution_clock::time_point frame_start = std::chrono::high_resolution_clock::now();
@@ -106,6 +167,7 @@ auto main([[maybe_unused]] int argc, [[maybe_unused]] char** argv) -> int {
         glm::vec3 cameraRotation{0.f};
         
         static bool keyLock1 = false;
+        static bool keyLock2 = false;
         for (const auto& [event, key] : events)
             if (event == GLFW_PRESS)
                 switch (key) {
@@ -133,19 +195,22 @@ auto main([[maybe_unused]] int argc, [[maybe_unused]] char** argv) -> int {
                         renderer.DEBUG_1 = keyLock1 ? renderer.DEBUG_1 : !renderer.DEBUG_1;
                         keyLock1 = true;
                         break;
+                    case GLFW_KEY_2:
+                        if (!keyLock2) {
+                            renderer.setDepthPrepass(!renderer.isDepthPrepass());
+                        }
+                        keyLock2 = true;
+                        break;
                 }
             else if (event == GLFW_RELEASE)
                 switch (key) {
                     case GLFW_KEY_1: keyLock1 = false; break;
+                    case GLFW_KEY_2: keyLock2 = false; break;
                 };
 
         camera.move(cameraMovement);
         camera.roll(cameraRotation.z);
 
-        for (const auto& modelMatrix : modelMatrices) {
-            renderer.submit(model, modelMatrix);
-        }
-
 
         const float current_time = std::chrono::duration<float>(
             frame_start - program_start
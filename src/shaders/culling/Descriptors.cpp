@@ -0,0 +1,109 @@
+#include "shaders/culling/Descriptors.hpp"
+
+namespace {
+
+[[nodiscard]]
+constexpr auto get_cull_descriptor_type(uint32_t binding) -> VkDescriptorType {
+    switch (binding) {
+        case shaders::culling::UNIFORM_BINDING:
+            return VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER;
+        case shaders::culling::PYRAMID_BINDING:
+            return VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+        default:
+            return VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+    }
+}
+
+[[nodiscard]]
+constexpr auto get_cull_descset_layout_bindings() -> std::array<VkDescriptorSetLayoutBinding, shaders::culling::BINDING_COUNT> {
+    std::array<VkDescriptorSetLayoutBinding, shaders::culling::BINDING_COUNT> bindings{};
+
+    for (uint32_t i = 0; i < bindings.size(); i++) {
+        auto& binding = bindings[i];
+        binding.binding = i;
+        binding.descriptorCount = 1;
+        binding.descriptorType = get_cull_descriptor_type(i);
+        binding.stageFlags = VK_SHADER_STAGE_COMPUTE_BIT;
+    }
+
+    return bindings;
+}
+
+[[nodiscard]]
+constexpr auto get_depth_pyramid_descset_layout_bindings() -> std::array<VkDescriptorSetLayoutBinding, shaders::culling::PYRAMID_BINDING_COUNT> {
+    std::array<VkDescriptorSetLayoutBinding, shaders::culling::PYRAMID_BINDING_COUNT> bindings{};
+
+    bindings[0].binding = 0;
+    bindings[0].descriptorCount = 1;
+    bindings[0].descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+    bindings[0].stageFlags = VK_SHADER_STAGE_COMPUTE_BIT;
+
+    bindings[1].binding = 1;
+    bindings[1].descriptorCount = 1;
+    bindings[1].descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_IMAGE;
+    bindings[1].stageFlags = VK_SHADER_STAGE_COMPUTE_BIT;
+
+    return bindings;
+}
+
+[[nodiscard]]
+auto create_descset_layout(VkDevice device, const VkDescriptorSetLayoutBinding* bindings, uint32_t bindingCount) -> VkDescriptorSetLayout {
+    VkDescriptorSetLayoutCreateInfo layoutInfo{};
+
+    layoutInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO;
+    layoutInfo.bindingCount = bindingCount;
+    layoutInfo.pBindings = bindings;
+    layoutInfo.flags = 0;
+
+    VkDescriptorSetLayout layout;
+    vulkan::CreateDescriptorSetLayout(device, &layoutInfo, nullptr, &layout);
+
+    return layout;
+}
+
+} // namespace
+
+namespace shaders::culling {
+
+[[nodiscard]]
+auto create_cull_descset_layout(VkDevice device) -> VkDescriptorSetLayout {
+    const auto bindings = get_cull_descset_layout_bindings();
+    return create_descset_layout(device, bindings.data(), static_cast<uint32_t>(bindings.size()));
+}
+
+[[nodiscard]]
+auto get_cull_desc_pool_sizes(uint32_t descCount) -> std::vector<VkDescriptorPoolSize> {
+    std::vector<VkDescriptorPoolSize> poolSizes(3);
+
+    poolSizes[0].type = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+    poolSizes[0].descriptorCount = descCount * (BINDING_COUNT - 2);
+
+    poolSizes[1].type = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER;
+    poolSizes[1].descriptorCount = descCount;
+
+    poolSizes[2].type = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+    poolSizes[2].descriptorCount = descCount;
+
+    return poolSizes;
+}
+
+[[nodiscard]]
+auto create_depth_pyramid_descset_layout(VkDevice device) -> VkDescriptorSetLayout {
+    const auto bindings = get_depth_pyramid_descset_layout_bindings();
+    return create_descset_layout(device, bindings.data(), static_cast<uint32_t>(bindings.size()));
+}
+
+[[nodiscard]]
+auto get_depth_pyramid_desc_pool_sizes(uint32_t descCount) -> std::vector<VkDescriptorPoolSize> {
+    std::vector<VkDescriptorPoolSize> poolSizes(2);
+
+    poolSizes[0].type = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+    poolSizes[0].descriptorCount = descCount;
+
+    poolSizes[1].type = VK_DESCRIPTOR_TYPE_STORAGE_IMAGE;
+    poolSizes[1].descriptorCount = descCount;
+
+    return poolSizes;
+}
+
+} // namespace shaders::culling
@@ -5,21 +5,33 @@
 namespace {
 
 [[nodiscard]]
-constexpr auto get_global_descset_layout_bindings() -> std::array<VkDescriptorSetLayoutBinding, 2> {
-    std::array<VkDescriptorSetLayoutBinding, 2> bindings{};
+constexpr auto get_global_descset_layout_bindings() -> std::array<VkDescriptorSetLayoutBinding, 4> {
+    std::array<VkDescriptorSetLayoutBinding, 4> bindings{};
 
     auto& cameraUbo = bindings[0];
     cameraUbo.binding = 0;
     cameraUbo.descriptorCount = 1;
-    cameraUbo.descriptorType = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER;
+    cameraUbo.descriptorType = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC;
     cameraUbo.stageFlags = VK_SHADER_STAGE_VERTEX_BIT | VK_SHADER_STAGE_FRAGMENT_BIT;
 
     auto& lightUbo = bindings[1];
     lightUbo.binding = 1;
     lightUbo.descriptorCount = 1;
-    lightUbo.descriptorType = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER;
+    lightUbo.descriptorType = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC;
     lightUbo.stageFlags = VK_SHADER_STAGE_VERTEX_BIT | VK_SHADER_STAGE_FRAGMENT_BIT;
 
+    auto& instanceSsbo = bindings[2];
+    instanceSsbo.binding = 2;
+    instanceSsbo.descriptorCount = 1;
+    instanceSsbo.descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER_DYNAMIC;
+    instanceSsbo.stageFlags = VK_SHADER_STAGE_VERTEX_BIT;
+
+    auto& drawInstanceSsbo = bindings[3];
+    drawInstanceSsbo.binding = 3;
+    drawInstanceSsbo.descriptorCount = 1;
+    drawInstanceSsbo.descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER_DYNAMIC;
+    drawInstanceSsbo.stageFlags = VK_SHADER_STAGE_VERTEX_BIT;
+
     return bindings;
 }
 
@@ -84,14 +96,20 @@ auto create_global_descset_layout(VkDevice device) -> VkDescriptorSetLayout {
 
 [[nodiscard]]
 auto get_global_desc_pool_sizes(uint32_t descCount) -> std::vector<VkDescriptorPoolSize> {
-    std::vector<VkDescriptorPoolSize> poolSizes(2);
+    std::vector<VkDescriptorPoolSize> poolSizes(4);
 
-    poolSizes[0].type = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER;
+    poolSizes[0].type = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC;
     poolSizes[0].descriptorCount = descCount;
 
-    poolSizes[1].type = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER;
+    poolSizes[1].type = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC;
     poolSizes[1].descriptorCount = descCount;
 
+    poolSizes[2].type = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER_DYNAMIC;
+    poolSizes[2].descriptorCount = descCount;
+
+    poolSizes[3].type = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER_DYNAMIC;
+    poolSizes[3].descriptorCount = descCount;
+
     return poolSizes;
 }
 
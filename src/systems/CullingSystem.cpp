@@ -0,0 +1,200 @@
+#include "systems/CullingSystem.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <bit>
+#include <cmath>
+
+#if defined(__AVX__)
+    #include <immintrin.h>
+    #define JR_CULL_AVX
+#elif defined(__SSE__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 1)
+    #include <xmmintrin.h>
+    #define JR_CULL_SSE
+#endif
+
+namespace {
+
+#if defined(JR_CULL_AVX)
+constexpr uint32_t LANES = 8;
+#elif defined(JR_CULL_SSE)
+constexpr uint32_t LANES = 4;
+#else
+constexpr uint32_t LANES = 1;
+#endif
+
+[[nodiscard]]
+inline auto sphere_visible(
+    const systems::CullingSystem::Frustum& frustum,
+    float x, float y, float z, float radius
+) noexcept -> bool {
+    for (const auto& plane : frustum) {
+        if (plane.x * x + plane.y * y + plane.z * z + plane.w < -radius) {
+            return false;
+        }
+    }
+    return true;
+}
+
+} // namespace
+
+namespace systems {
+
+auto CullingSystem::reserve(size_t count) -> void
+{
+    m_centerX.reserve(count);
+    m_centerY.reserve(count);
+    m_centerZ.reserve(count);
+    m_radius.reserve(count);
+    m_visible.reserve(count);
+}
+
+auto CullingSystem::clear() noexcept -> void
+{
+    m_centerX.clear();
+    m_centerY.clear();
+    m_centerZ.clear();
+    m_radius.clear();
+    m_visibleCount = 0;
+}
+
+auto CullingSystem::push(const glm::mat4& transform, std::span<const glm::vec4> spheres) -> void
+{
+    // Non-uniform scale stretches the sphere, the largest axis keeps it conservative
+    const float scale = std::sqrt(std::max({
+        glm::dot(glm::vec3{transform[0]}, glm::vec3{transform[0]}),
+        glm::dot(glm::vec3{transform[1]}, glm::vec3{transform[1]}),
+        glm::dot(glm::vec3{transform[2]}, glm::vec3{transform[2]})
+    }));
+
+    for (const auto& sphere : spheres) {
+        const glm::vec4 center = transform * glm::vec4{glm::vec3{sphere}, 1.f};
+
+        m_centerX.push_back(center.x);
+        m_centerY.push_back(center.y);
+        m_centerZ.push_back(center.z);
+        m_radius.push_back(sphere.w * scale);
+    }
+}
+
+auto CullingSystem::cull(const Frustum& frustum, JobSystem* jobSystem) -> void
+{
+    const size_t count = size();
+    m_visible.resize(count);
+
+    if (!jobSystem || jobSystem->getWorkerCount() == 0 || count < 2 * MIN_PARALLEL_CHUNK) {
+        m_visibleCount = cull_range(frustum, 0, count);
+        return;
+    }
+
+    // Chunks are multiples of the lane count so only the last one has a scalar tail
+    const size_t chunkCount = std::min<size_t>(jobSystem->getWorkerCount() + 1, count / MIN_PARALLEL_CHUNK);
+    const size_t chunkSize = ((count + chunkCount - 1) / chunkCount + LANES - 1) / LANES * LANES;
+
+    std::atomic<size_t> visibleCount{0};
+    jobSystem->parallel_for(static_cast<uint32_t>(chunkCount), [&](uint32_t chunk) {
+        const size_t first = std::min(chunk * chunkSize, count);
+        const size_t last = std::min(first + chunkSize, count);
+        visibleCount.fetch_add(cull_range(frustum, first, last), std::memory_order_relaxed);
+    });
+
+    m_visibleCount = visibleCount.load(std::memory_order_relaxed);
+}
+
+auto CullingSystem::getLaneCount() noexcept -> uint32_t
+{
+    return LANES;
+}
+
+    /**   PRIVATE   **/
+
+auto CullingSystem::cull_range(const Frustum& frustum, size_t first, size_t last) -> size_t
+{
+    const float* xs = m_centerX.data();
+    const float* ys = m_centerY.data();
+    const float* zs = m_centerZ.data();
+    const float* rs = m_radius.data();
+    uint8_t* visible = m_visible.data();
+
+    size_t visibleCount = 0;
+    size_t i = first;
+
+#if defined(JR_CULL_AVX)
+    // Plain arrays, std::array would drop the vector type alignment attributes
+    __m256 planes[6][4];
+    for (size_t p = 0; p < frustum.size(); p++) {
+        planes[p][0] = _mm256_set1_ps(frustum[p].x);
+        planes[p][1] = _mm256_set1_ps(frustum[p].y);
+        planes[p][2] = _mm256_set1_ps(frustum[p].z);
+        planes[p][3] = _mm256_set1_ps(frustum[p].w);
+    }
+
+    const __m256 zero = _mm256_setzero_ps();
+
+    for (; i + LANES <= last; i += LANES) {
+        const __m256 x = _mm256_loadu_ps(xs + i);
+        const __m256 y = _mm256_loadu_ps(ys + i);
+        const __m256 z = _mm256_loadu_ps(zs + i);
+        const __m256 negRadius = _mm256_sub_ps(zero, _mm256_loadu_ps(rs + i));
+
+        __m256 inside = _mm256_castsi256_ps(_mm256_set1_epi32(-1));
+        for (const auto& [a, b, c, d] : planes) {
+            const __m256 distance = _mm256_add_ps(
+                _mm256_add_ps(_mm256_mul_ps(a, x), _mm256_mul_ps(b, y)),
+                _mm256_add_ps(_mm256_mul_ps(c, z), d)
+            );
+            inside = _mm256_and_ps(inside, _mm256_cmp_ps(distance, negRadius, _CMP_GE_OQ));
+        }
+
+        const auto mask = static_cast<uint32_t>(_mm256_movemask_ps(inside));
+        for (uint32_t lane = 0; lane < LANES; lane++) {
+            visible[i + lane] = static_cast<uint8_t>((mask >> lane) & 1u);
+        }
+        visibleCount += static_cast<size_t>(std::popcount(mask));
+    }
+#elif defined(JR_CULL_SSE)
+    // Plain arrays, std::array would drop the vector type alignment attributes
+    __m128 planes[6][4];
+    for (size_t p = 0; p < frustum.size(); p++) {
+        planes[p][0] = _mm_set1_ps(frustum[p].x);
+        planes[p][1] = _mm_set1_ps(frustum[p].y);
+        planes[p][2] = _mm_set1_ps(frustum[p].z);
+        planes[p][3] = _mm_set1_ps(frustum[p].w);
+    }
+
+    const __m128 zero = _mm_setzero_ps();
+    const __m128 allSet = _mm_cmpeq_ps(zero, zero);
+
+    for (; i + LANES <= last; i += LANES) {
+        const __m128 x = _mm_loadu_ps(xs + i);
+        const __m128 y = _mm_loadu_ps(ys + i);
+        const __m128 z = _mm_loadu_ps(zs + i);
+        const __m128 negRadius = _mm_sub_ps(zero, _mm_loadu_ps(rs + i));
+
+        __m128 inside = allSet;
+        for (const auto& [a, b, c, d] : planes) {
+            const __m128 distance = _mm_add_ps(
+                _mm_add_ps(_mm_mul_ps(a, x), _mm_mul_ps(b, y)),
+                _mm_add_ps(_mm_mul_ps(c, z), d)
+            );
+            inside = _mm_and_ps(inside, _mm_cmpge_ps(distance, negRadius));
+        }
+
+        const auto mask = static_cast<uint32_t>(_mm_movemask_ps(inside));
+        for (uint32_t lane = 0; lane < LANES; lane++) {
+            visible[i + lane] = static_cast<uint8_t>((mask >> lane) & 1u);
+        }
+        visibleCount += static_cast<size_t>(std::popcount(mask));
+    }
+#endif
+
+    // Scalar tail, or everything when no SIMD path is available
+    for (; i < last; i++) {
+        visible[i] = sphere_visible(frustum, xs[i], ys[i], zs[i], rs[i]) ? 1 : 0;
+        visibleCount += visible[i];
+    }
+
+    return visibleCount;
+}
+
+} // namespace systems
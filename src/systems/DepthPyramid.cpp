@@ -0,0 +1,248 @@
+#include "systems/DepthPyramid.hpp"
+
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <filesystem>
+
+#include "common/defs.hpp"
+#include "core/pipeline/Shader.hpp"
+#include "shaders/culling/Descriptors.hpp"
+
+namespace {
+
+[[nodiscard]]
+constexpr auto pyramid_extent(VkExtent2D depthExtent) noexcept -> VkExtent2D {
+    return {
+        std::max((depthExtent.width + 1) / 2, 1u),
+        std::max((depthExtent.height + 1) / 2, 1u)
+    };
+}
+
+[[nodiscard]]
+constexpr auto mip_count(VkExtent2D extent) noexcept -> uint32_t {
+    return static_cast<uint32_t>(std::bit_width(std::max(extent.width, extent.height)));
+}
+
+[[nodiscard]]
+constexpr auto mip_extent(VkExtent2D extent, uint32_t level) noexcept -> VkExtent2D {
+    // Rounded up so the texels of a level always cover the whole level below
+    for (uint32_t i = 0; i < level; i++) {
+        extent = {std::max((extent.width + 1) / 2, 1u), std::max((extent.height + 1) / 2, 1u)};
+    }
+    return extent;
+}
+
+[[nodiscard]]
+auto create_sampler_config() -> graphics::TextureSampler::Config {
+    graphics::TextureSampler::Config config{};
+    config.magFilter = VK_FILTER_NEAREST;
+    config.minFilter = VK_FILTER_NEAREST;
+    config.mipmapMode = VK_SAMPLER_MIPMAP_MODE_NEAREST;
+    config.addressModeU = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE;
+    config.addressModeV = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE;
+    config.addressModeW = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE;
+    config.anisotropyEnable = VK_FALSE;
+    config.maxAnisotropy = 1.0f;
+    config.maxLod = VK_LOD_CLAMP_NONE;
+    return config;
+}
+
+[[nodiscard]]
+auto create_pyramid_pipeline(
+    core::device::Device& device,
+    VkDescriptorSetLayout layout
+) -> std::unique_ptr<core::pipeline::ComputePipeline> {
+    const core::pipeline::Shader shader{
+        device,
+        std::filesystem::path{common::SHADER_DIRECTORY} / "hiz.comp.spv",
+        core::pipeline::Shader::Type::Compute
+    };
+
+    return std::make_unique<core::pipeline::ComputePipeline>(
+        device,
+        shader,
+        std::vector<VkDescriptorSetLayout>{layout},
+        static_cast<uint32_t>(sizeof(shaders::culling::DepthPyramidPushConstants))
+    );
+}
+
+[[nodiscard]]
+constexpr auto group_count(uint32_t size) noexcept -> uint32_t {
+    return (size + shaders::culling::PYRAMID_WORKGROUP_SIZE - 1) / shaders::culling::PYRAMID_WORKGROUP_SIZE;
+}
+
+} // namespace
+
+namespace systems {
+
+DepthPyramid::DepthPyramid(
+    core::device::Device& device,
+    MemoryManager& memoryManager,
+    VkExtent2D depthExtent,
+    uint32_t frameCount) :
+    m_device{device.getDevice()},
+    m_depthExtent{depthExtent},
+    m_extent{pyramid_extent(depthExtent)},
+    m_mipCount{mip_count(m_extent)},
+    m_frameCount{frameCount},
+    m_image{memoryManager.createImage(
+        VkExtent3D{m_extent.width, m_extent.height, 1},
+        core::memory::ImageType::DEPTH_PYRAMID,
+        MemoryUsage::GPU_ONLY,
+        m_mipCount
+    )},
+    m_sampler{m_device, create_sampler_config()},
+    m_descriptorPool{
+        m_device,
+        shaders::culling::create_depth_pyramid_descset_layout(m_device),
+        shaders::culling::get_depth_pyramid_desc_pool_sizes(m_frameCount + m_mipCount - 1),
+        m_frameCount + m_mipCount - 1
+    },
+    m_descriptorSets{m_descriptorPool.allocateDescriptorSets(m_frameCount + m_mipCount - 1)},
+    m_pipeline{create_pyramid_pipeline(device, m_descriptorPool.getLayout())},
+    m_staleSourceSets(frameCount, true)
+{
+    m_mipViews.reserve(m_mipCount);
+    for (uint32_t level = 0; level < m_mipCount; level++) {
+        const VkImageViewCreateInfo viewInfo{
+            .sType = VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO,
+            .pNext = nullptr,
+            .flags = 0,
+            .image = m_image.getImage(),
+            .viewType = VK_IMAGE_VIEW_TYPE_2D,
+            .format = VK_FORMAT_R32G32_SFLOAT,
+            .components = {},
+            .subresourceRange = {
+                .aspectMask = VK_IMAGE_ASPECT_COLOR_BIT,
+                .baseMipLevel = level,
+                .levelCount = 1,
+                .baseArrayLayer = 0,
+                .layerCount = 1
+            }
+        };
+
+        VkImageView view{VK_NULL_HANDLE};
+        vulkan::CreateImageView(m_device, &viewInfo, nullptr, &view);
+        m_mipViews.push_back(view);
+    }
+
+    // Mip 0 reduces the depth buffer (see setSource), every other level the one above it
+    for (uint32_t level = 1; level < m_mipCount; level++) {
+        update_descriptor_set(level_set(level, 0), level, m_mipViews[level - 1], VK_IMAGE_LAYOUT_GENERAL);
+    }
+}
+
+DepthPyramid::~DepthPyramid()
+{
+    for (const auto view : m_mipViews) {
+        vulkan::DestroyImageView(m_device, view, nullptr);
+    }
+}
+
+auto DepthPyramid::setSource(VkImageView depthView) -> void
+{
+    m_sourceView = depthView;
+    m_staleSourceSets.assign(m_frameCount, true);
+}
+
+auto DepthPyramid::build(core::commands::CommandBuffer& cmd, uint32_t frame) -> void
+{
+    // The frame's previous build completed, its set is no longer read
+    if (m_staleSourceSets[frame]) {
+        update_descriptor_set(level_set(0, frame), 0, m_sourceView, VK_IMAGE_LAYOUT_DEPTH_STENCIL_READ_ONLY_OPTIMAL);
+        m_staleSourceSets[frame] = false;
+    }
+
+    if (!m_initialized) {
+        cmd.barrier(
+            m_image.getImage(),
+            VkImageSubresourceRange{VK_IMAGE_ASPECT_COLOR_BIT, 0, m_mipCount, 0, 1},
+            VK_IMAGE_LAYOUT_UNDEFINED,
+            VK_IMAGE_LAYOUT_GENERAL,
+            VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, 0,
+            VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_ACCESS_SHADER_WRITE_BIT
+        );
+        m_initialized = true;
+    } else {
+        // Culling reads of the previous pyramid have to finish before it is overwritten
+        cmd.barrier(
+            VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, 0,
+            VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, 0
+        );
+    }
+
+    cmd.bind(*m_pipeline);
+
+    VkExtent2D srcExtent = m_depthExtent;
+    for (uint32_t level = 0; level < m_mipCount; level++) {
+        const VkExtent2D dstExtent = mip_extent(m_extent, level);
+
+        const shaders::culling::DepthPyramidPushConstants pushConstants{
+            .srcSize = {srcExtent.width, srcExtent.height},
+            .dstSize = {dstExtent.width, dstExtent.height},
+            .srcIsDepth = level == 0 ? 1u : 0u,
+            .padding = {}
+        };
+
+        cmd.bind(level_set(level, frame), m_pipeline->getPipelineLayout(), 0, VK_PIPELINE_BIND_POINT_COMPUTE);
+        cmd.pushConstants(
+            m_pipeline->getPipelineLayout(),
+            VK_SHADER_STAGE_COMPUTE_BIT,
+            0,
+            sizeof(pushConstants),
+            &pushConstants
+        );
+        cmd.dispatch(group_count(dstExtent.width), group_count(dstExtent.height));
+
+        cmd.barrier(
+            VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_ACCESS_SHADER_WRITE_BIT,
+            VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_ACCESS_SHADER_READ_BIT
+        );
+
+        srcExtent = dstExtent;
+    }
+}
+
+    /**   PRIVATE   **/
+
+auto DepthPyramid::update_descriptor_set(VkDescriptorSet set, uint32_t level, VkImageView srcView, VkImageLayout srcLayout) -> void
+{
+    const VkDescriptorImageInfo srcInfo{
+        .sampler = m_sampler.getSampler(),
+        .imageView = srcView,
+        .imageLayout = srcLayout
+    };
+
+    const VkDescriptorImageInfo dstInfo{
+        .sampler = VK_NULL_HANDLE,
+        .imageView = m_mipViews[level],
+        .imageLayout = VK_IMAGE_LAYOUT_GENERAL
+    };
+
+    std::array<VkWriteDescriptorSet, shaders::culling::PYRAMID_BINDING_COUNT> descriptorWrites{};
+
+    descriptorWrites[0].sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+    descriptorWrites[0].dstSet = set;
+    descriptorWrites[0].dstBinding = 0;
+    descriptorWrites[0].descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+    descriptorWrites[0].descriptorCount = 1;
+    descriptorWrites[0].pImageInfo = &srcInfo;
+
+    descriptorWrites[1].sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+    descriptorWrites[1].dstSet = set;
+    descriptorWrites[1].dstBinding = 1;
+    descriptorWrites[1].descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_IMAGE;
+    descriptorWrites[1].descriptorCount = 1;
+    descriptorWrites[1].pImageInfo = &dstInfo;
+
+    vulkan::UpdateDescriptorSets(
+        m_device,
+        static_cast<uint32_t>(descriptorWrites.size()),
+        descriptorWrites.data(),
+        0,
+        nullptr
+    );
+}
+
+} // namespace systems
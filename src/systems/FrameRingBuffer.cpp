@@ -0,0 +1,70 @@
+#include "systems/FrameRingBuffer.hpp"
+
+#include <algorithm>
+#include <bit>
+#include <stdexcept>
+#include <utility>
+
+#include "systems/MemoryManager.hpp"
+#include "vulkan/api.hpp"
+
+namespace {
+
+[[nodiscard]]
+constexpr auto align_up(VkDeviceSize value, VkDeviceSize alignment) noexcept -> VkDeviceSize {
+    return (value + alignment - 1) / alignment * alignment;
+}
+
+} // namespace
+
+namespace systems {
+
+FrameRingBuffer::FrameRingBuffer(MemoryManager& memoryManager, uint32_t frameCount, VkDeviceSize frameSize)
+: m_memoryManager(memoryManager)
+, m_frameCount(frameCount)
+, m_uniformAlignment(memoryManager.getLimits().minUniformBufferOffsetAlignment)
+, m_storageAlignment(memoryManager.getLimits().minStorageBufferOffsetAlignment)
+, m_frameSize(align_up(std::max<VkDeviceSize>(frameSize, 1), REGION_ALIGNMENT))
+, m_buffer(memoryManager.createBuffer(m_frameSize * frameCount, core::memory::BufferType::DYNAMIC, MemoryUsage::CPU_TO_GPU))
+{}
+
+auto FrameRingBuffer::begin(uint32_t frame) noexcept -> void
+{
+    m_frame = frame;
+    m_cursor = 0;
+}
+
+auto FrameRingBuffer::reserve(VkDeviceSize frameSize) -> bool
+{
+    if (frameSize <= m_frameSize) {
+        return false;
+    }
+
+    // Frames in flight keep reading their region of the previous buffer
+    m_frameSize = std::bit_ceil(align_up(frameSize, REGION_ALIGNMENT));
+    m_memoryManager.retire(std::exchange(
+        m_buffer,
+        m_memoryManager.createBuffer(m_frameSize * m_frameCount, core::memory::BufferType::DYNAMIC, MemoryUsage::CPU_TO_GPU)
+    ));
+    m_cursor = 0;
+
+    return true;
+}
+
+auto FrameRingBuffer::allocate(VkDeviceSize size, VkDeviceSize alignment) -> Allocation
+{
+    const VkDeviceSize offset = align_up(m_cursor, std::max<VkDeviceSize>(alignment, 1));
+    if (offset + size > m_frameSize) {
+        throw std::runtime_error("Frame ring buffer region is full, reserve() more space before allocating.");
+    }
+
+    m_cursor = offset + size;
+
+    const VkDeviceSize bufferOffset = m_frame * m_frameSize + offset;
+    return Allocation{
+        static_cast<uint8_t*>(m_buffer.getMappedData()) + bufferOffset,
+        static_cast<uint32_t>(bufferOffset)
+    };
+}
+
+} // namespace systems
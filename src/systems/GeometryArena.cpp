@@ -0,0 +1,261 @@
+#include "systems/GeometryArena.hpp"
+
+#include <algorithm>
+#include <format>
+#include <stdexcept>
+
+#include "systems/MemoryManager.hpp"
+
+namespace {
+
+auto create_virtual_block(uint32_t capacity) -> VmaVirtualBlock
+{
+    VmaVirtualBlockCreateInfo createInfo{};
+    createInfo.size = capacity;
+
+    VmaVirtualBlock block = VK_NULL_HANDLE;
+    if (vmaCreateVirtualBlock(&createInfo, &block) != VK_SUCCESS) {
+        throw std::runtime_error("Failed to create geometry arena virtual block.");
+    }
+
+    return block;
+}
+
+auto accumulate(VmaVirtualBlock block, uint32_t capacity, systems::GeometryArena::RangeStats& stats) -> void
+{
+    VmaDetailedStatistics detailed{};
+    vmaCalculateVirtualBlockStatistics(block, &detailed);
+
+    stats.capacity += capacity;
+    stats.used += detailed.statistics.allocationBytes;
+    stats.allocationCount += detailed.statistics.allocationCount;
+    stats.freeRangeCount += detailed.unusedRangeCount;
+    stats.largestFreeRange = std::max<uint64_t>(stats.largestFreeRange, detailed.unusedRangeSizeMax);
+}
+
+} // namespace
+
+namespace systems {
+
+GeometryArena::Allocation::~Allocation()
+{
+    release();
+}
+
+GeometryArena::Allocation::Allocation(Allocation&& other) noexcept
+: m_arena(other.m_arena)
+, m_page(other.m_page)
+, m_vertexOffset(other.m_vertexOffset)
+, m_vertexCount(other.m_vertexCount)
+, m_firstIndex(other.m_firstIndex)
+, m_indexCount(other.m_indexCount)
+, m_vertexAllocation(other.m_vertexAllocation)
+, m_indexAllocation(other.m_indexAllocation)
+{
+    other.m_arena = nullptr;
+    other.m_vertexAllocation = VK_NULL_HANDLE;
+    other.m_indexAllocation = VK_NULL_HANDLE;
+}
+
+auto GeometryArena::Allocation::operator=(Allocation&& other) noexcept -> Allocation&
+{
+    if (this != &other) {
+        release();
+
+        m_arena = other.m_arena;
+        m_page = other.m_page;
+        m_vertexOffset = other.m_vertexOffset;
+        m_vertexCount = other.m_vertexCount;
+        m_firstIndex = other.m_firstIndex;
+        m_indexCount = other.m_indexCount;
+        m_vertexAllocation = other.m_vertexAllocation;
+        m_indexAllocation = other.m_indexAllocation;
+
+        other.m_arena = nullptr;
+        other.m_vertexAllocation = VK_NULL_HANDLE;
+        other.m_indexAllocation = VK_NULL_HANDLE;
+    }
+
+    return *this;
+}
+
+auto GeometryArena::Allocation::release() noexcept -> void
+{
+    if (m_arena) {
+        m_arena->free(*this);
+        m_arena = nullptr;
+    }
+}
+
+auto GeometryArena::RangeStats::fragmentation() const noexcept -> float
+{
+    const uint64_t freeSpace = capacity - used;
+    if (freeSpace == 0) {
+        return 0.f;
+    }
+
+    return 1.f - static_cast<float>(largestFreeRange) / static_cast<float>(freeSpace);
+}
+
+GeometryArena::GeometryArena(MemoryManager& memoryManager)
+: m_memoryManager(memoryManager)
+{}
+
+GeometryArena::~GeometryArena()
+{
+    // Meshes are expected to be gone, clearing avoids the VMA assert if one leaked
+    for (auto& page : m_pages) {
+        vmaClearVirtualBlock(page.vertexBlock);
+        vmaClearVirtualBlock(page.indexBlock);
+        vmaDestroyVirtualBlock(page.vertexBlock);
+        vmaDestroyVirtualBlock(page.indexBlock);
+    }
+}
+
+auto GeometryArena::allocate(
+    std::span<const shaders::generic::Vertex> vertices,
+    std::span<const uint32_t> indices) -> Allocation
+{
+    if (vertices.empty() || indices.empty()) {
+        throw std::invalid_argument("Geometry arena allocations need vertices and indices.");
+    }
+
+    const auto vertexCount = static_cast<uint32_t>(vertices.size());
+    const auto indexCount = static_cast<uint32_t>(indices.size());
+
+    Allocation allocation;
+    bool allocated = false;
+
+    for (uint32_t page = 0; page < m_pages.size() && !allocated; page++) {
+        allocated = try_allocate(page, vertexCount, indexCount, allocation);
+    }
+
+    if (!allocated) {
+        add_page(std::max(vertexCount, PAGE_VERTICES), std::max(indexCount, PAGE_INDICES));
+        if (!try_allocate(static_cast<uint32_t>(m_pages.size() - 1), vertexCount, indexCount, allocation)) {
+            throw std::runtime_error("Failed to allocate geometry in a new arena page.");
+        }
+    }
+
+    auto& page = m_pages[allocation.m_page];
+    m_memoryManager.copyDataToBuffer(
+        vertices.data(),
+        vertices.size_bytes(),
+        page.vertexBuffer,
+        sizeof(shaders::generic::Vertex) * static_cast<VkDeviceSize>(allocation.m_vertexOffset)
+    );
+    m_memoryManager.copyDataToBuffer(
+        indices.data(),
+        indices.size_bytes(),
+        page.indexBuffer,
+        sizeof(uint32_t) * static_cast<VkDeviceSize>(allocation.m_firstIndex)
+    );
+
+    return allocation;
+}
+
+auto GeometryArena::getStats() const -> Stats
+{
+    Stats stats{static_cast<uint32_t>(m_pages.size()), {}, {}};
+
+    for (const auto& page : m_pages) {
+        accumulate(page.vertexBlock, page.vertexCapacity, stats.vertices);
+        accumulate(page.indexBlock, page.indexCapacity, stats.indices);
+    }
+
+    return stats;
+}
+
+auto GeometryArena::getReport() const -> std::string
+{
+    const auto describe = [](std::string_view name, const RangeStats& stats) {
+        return std::format(
+            "  {:8} {:>10} / {:>10} used, {} allocations, {} free ranges, largest free {}, fragmentation {:.1f}%\n",
+            name, stats.used, stats.capacity, stats.allocationCount, stats.freeRangeCount,
+            stats.largestFreeRange, 100.f * stats.fragmentation()
+        );
+    };
+
+    std::string report = std::format("Geometry arena: {} pages\n", m_pages.size());
+    for (uint32_t i = 0; i < m_pages.size(); i++) {
+        Stats page{1, {}, {}};
+        accumulate(m_pages[i].vertexBlock, m_pages[i].vertexCapacity, page.vertices);
+        accumulate(m_pages[i].indexBlock, m_pages[i].indexCapacity, page.indices);
+
+        report += std::format(" page {}\n", i);
+        report += describe("vertices", page.vertices);
+        report += describe("indices", page.indices);
+    }
+
+    return report;
+}
+
+    /**   PRIVATE   **/
+
+auto GeometryArena::add_page(uint32_t vertexCapacity, uint32_t indexCapacity) -> void
+{
+    using core::memory::BufferType;
+
+    m_pages.push_back(Page{
+        .vertexBuffer = m_memoryManager.createBuffer(
+            sizeof(shaders::generic::Vertex) * static_cast<VkDeviceSize>(vertexCapacity), BufferType::VERTEX, MemoryUsage::GPU_ONLY),
+        .indexBuffer = m_memoryManager.createBuffer(
+            sizeof(uint32_t) * static_cast<VkDeviceSize>(indexCapacity), BufferType::INDEX, MemoryUsage::GPU_ONLY),
+        .vertexBlock = create_virtual_block(vertexCapacity),
+        .indexBlock = create_virtual_block(indexCapacity),
+        .vertexCapacity = vertexCapacity,
+        .indexCapacity = indexCapacity
+    });
+}
+
+auto GeometryArena::try_allocate(
+    uint32_t page,
+    uint32_t vertexCount,
+    uint32_t indexCount,
+    Allocation& allocation) -> bool
+{
+    const VmaVirtualBlock vertexBlock = m_pages[page].vertexBlock;
+    const VmaVirtualBlock indexBlock = m_pages[page].indexBlock;
+
+    VmaVirtualAllocationCreateInfo vertexInfo{};
+    vertexInfo.size = vertexCount;
+
+    VmaVirtualAllocation vertexAllocation = VK_NULL_HANDLE;
+    VkDeviceSize vertexOffset = 0;
+    if (vmaVirtualAllocate(vertexBlock, &vertexInfo, &vertexAllocation, &vertexOffset) != VK_SUCCESS) {
+        return false;
+    }
+
+    VmaVirtualAllocationCreateInfo indexInfo{};
+    indexInfo.size = indexCount;
+
+    VmaVirtualAllocation indexAllocation = VK_NULL_HANDLE;
+    VkDeviceSize firstIndex = 0;
+    if (vmaVirtualAllocate(indexBlock, &indexInfo, &indexAllocation, &firstIndex) != VK_SUCCESS) {
+        vmaVirtualFree(vertexBlock, vertexAllocation);
+        return false;
+    }
+
+    allocation.m_arena = this;
+    allocation.m_page = page;
+    allocation.m_vertexOffset = static_cast<int32_t>(vertexOffset);
+    allocation.m_vertexCount = vertexCount;
+    allocation.m_firstIndex = static_cast<uint32_t>(firstIndex);
+    allocation.m_indexCount = indexCount;
+    allocation.m_vertexAllocation = vertexAllocation;
+    allocation.m_indexAllocation = indexAllocation;
+    return true;
+}
+
+auto GeometryArena::free(Allocation& allocation) noexcept -> void
+{
+    auto& page = m_pages[allocation.m_page];
+
+    vmaVirtualFree(page.vertexBlock, allocation.m_vertexAllocation);
+    vmaVirtualFree(page.indexBlock, allocation.m_indexAllocation);
+
+    allocation.m_vertexAllocation = VK_NULL_HANDLE;
+    allocation.m_indexAllocation = VK_NULL_HANDLE;
+}
+
+} // namespace systems
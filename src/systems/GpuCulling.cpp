@@ -0,0 +1,474 @@
+#include "systems/GpuCulling.hpp"
+
+#include <algorithm>
+#include <bit>
+#include <cstring>
+#include <filesystem>
+#include <utility>
+
+#include "common/defs.hpp"
+#include "core/pipeline/Shader.hpp"
+#include "shaders/generic/Descriptors.hpp"
+
+namespace {
+
+[[nodiscard]]
+auto create_compute_pipeline(
+    core::device::Device& device,
+    const char* shaderName,
+    VkDescriptorSetLayout layout
+) -> std::unique_ptr<core::pipeline::ComputePipeline> {
+    const core::pipeline::Shader shader{
+        device,
+        std::filesystem::path{common::SHADER_DIRECTORY} / shaderName,
+        core::pipeline::Shader::Type::Compute
+    };
+
+    return std::make_unique<core::pipeline::ComputePipeline>(
+        device,
+        shader,
+        std::vector<VkDescriptorSetLayout>{layout},
+        static_cast<uint32_t>(sizeof(shaders::culling::CullPushConstants))
+    );
+}
+
+[[nodiscard]]
+constexpr auto group_count(uint32_t invocationCount) noexcept -> uint32_t {
+    return (invocationCount + shaders::culling::WORKGROUP_SIZE - 1) / shaders::culling::WORKGROUP_SIZE;
+}
+
+[[nodiscard]]
+auto projection_params(const glm::mat4& projection) noexcept -> glm::vec4 {
+    return {projection[0][0], projection[1][1], projection[2][2], projection[3][2]};
+}
+
+[[nodiscard]]
+constexpr auto rejected_size(uint32_t pairCount) noexcept -> VkDeviceSize {
+    return sizeof(shaders::culling::CullRejectedHeader) + sizeof(glm::uvec2) * pairCount;
+}
+
+} // namespace
+
+namespace systems {
+
+GpuCulling::GpuCulling(
+    core::device::Device& device,
+    MemoryManager& memoryManager,
+    uint32_t frameCount,
+    uint32_t instanceCapacity,
+    VkExtent2D depthExtent) :
+    m_memoryManager{memoryManager},
+    m_features{device.getFeatures()},
+    m_descriptorPool{
+        device.getDevice(),
+        shaders::culling::create_cull_descset_layout(device.getDevice()),
+        shaders::culling::get_cull_desc_pool_sizes(frameCount),
+        frameCount
+    },
+    m_descriptorSets{m_descriptorPool.allocateDescriptorSets(frameCount)},
+    m_cullPipeline{create_compute_pipeline(device, "cull.comp.spv", m_descriptorPool.getLayout())},
+    m_compactPipeline{create_compute_pipeline(device, "compact.comp.spv", m_descriptorPool.getLayout())},
+    m_depthPyramid{device, memoryManager, depthExtent, frameCount},
+    m_instances{memoryManager.createBuffer(
+        sizeof(shaders::culling::CullInstance) * std::max(instanceCapacity, 1u),
+        core::memory::BufferType::INDIRECT,
+        MemoryUsage::GPU_ONLY
+    )}
+{
+    using core::memory::BufferType;
+
+    instanceCapacity = std::max(instanceCapacity, 1u);
+
+    m_frames.reserve(frameCount);
+    for (uint32_t i = 0; i < frameCount; i++) {
+        m_frames.push_back(FrameBuffers{
+            .instanceUpload = m_memoryManager.createBuffer(
+                sizeof(shaders::culling::CullInstance) * instanceCapacity, BufferType::STAGING),
+            .uploadRegions = {},
+            .models = m_memoryManager.createBuffer(
+                sizeof(shaders::culling::CullModel), BufferType::STORAGE),
+            .draws = m_memoryManager.createBuffer(
+                sizeof(shaders::culling::CullDraw), BufferType::STORAGE),
+            .visibleCounts = m_memoryManager.createBuffer(
+                sizeof(uint32_t), BufferType::INDIRECT, MemoryUsage::GPU_ONLY),
+            .visibleInstances = m_memoryManager.createBuffer(
+                sizeof(shaders::generic::InstanceData) * instanceCapacity, BufferType::INDIRECT, MemoryUsage::GPU_ONLY),
+            .commands = m_memoryManager.createBuffer(
+                sizeof(VkDrawIndexedIndirectCommand), BufferType::INDIRECT, MemoryUsage::GPU_ONLY),
+            .bucketCounts = m_memoryManager.createBuffer(
+                sizeof(uint32_t), BufferType::INDIRECT, MemoryUsage::GPU_ONLY),
+            .uniforms = m_memoryManager.createBuffer(
+                sizeof(shaders::culling::CullUniforms), BufferType::UNIFORM),
+            .rejected = m_memoryManager.createBuffer(
+                rejected_size(instanceCapacity), BufferType::INDIRECT, MemoryUsage::GPU_ONLY),
+            .stats = m_memoryManager.createBuffer(
+                sizeof(shaders::culling::CullStats), BufferType::READBACK)
+        });
+
+        std::memset(m_frames.back().stats.getMappedData(), 0, sizeof(shaders::culling::CullStats));
+        update_descriptor_set(i);
+    }
+
+    m_pushConstants.compactCommands = m_features.drawIndirectCount ? 1 : 0;
+}
+
+auto GpuCulling::setDraws(
+    std::vector<shaders::culling::CullModel> models,
+    std::vector<shaders::culling::CullDraw> draws) -> void
+{
+    m_models = std::move(models);
+    m_draws = std::move(draws);
+
+    m_bucketCount = 0;
+    for (const auto& draw : m_draws) {
+        m_bucketCount = std::max(m_bucketCount, draw.bucket + 1);
+    }
+}
+
+auto GpuCulling::reserveInstances(uint32_t instanceCount) -> bool
+{
+    const VkDeviceSize size = sizeof(shaders::culling::CullInstance) * std::max(instanceCount, 1u);
+    if (size <= m_instances.getSize()) {
+        return false;
+    }
+
+    // Frames in flight keep reading the previous buffer, each frame's descriptor set switches in prepare()
+    m_memoryManager.retire(std::exchange(
+        m_instances,
+        m_memoryManager.createBuffer(std::bit_ceil(size), core::memory::BufferType::INDIRECT, MemoryUsage::GPU_ONLY)
+    ));
+
+    for (auto& frame : m_frames) {
+        frame.staleDescriptorSet = true;
+    }
+
+    return true;
+}
+
+auto GpuCulling::mapInstanceUpload(
+    uint32_t frame,
+    std::span<const InstanceRegistry::Range> ranges,
+    uint32_t transientFirst,
+    uint32_t transientCount) -> shaders::culling::CullInstance*
+{
+    constexpr VkDeviceSize stride = sizeof(shaders::culling::CullInstance);
+    auto& buffers = m_frames[frame];
+
+    buffers.uploadRegions.clear();
+    VkDeviceSize offset = 0;
+
+    for (const auto& [first, count] : ranges) {
+        buffers.uploadRegions.push_back({offset, first * stride, count * stride});
+        offset += count * stride;
+    }
+
+    if (transientCount > 0) {
+        buffers.uploadRegions.push_back({offset, transientFirst * stride, transientCount * stride});
+        offset += transientCount * stride;
+    }
+
+    // Only written by the host, the copies of the frame's previous use are complete
+    reserve(buffers.instanceUpload, std::max(offset, stride), core::memory::BufferType::STAGING, MemoryUsage::AUTO);
+
+    return static_cast<shaders::culling::CullInstance*>(buffers.instanceUpload.getMappedData());
+}
+
+auto GpuCulling::setOcclusionCulling(bool enabled) noexcept -> void
+{
+    m_occlusionCulling = enabled;
+    m_pyramidValid &= enabled;
+}
+
+auto GpuCulling::prepare(
+    uint32_t frame,
+    uint32_t instanceCount,
+    std::span<const uint32_t> modelInstanceCounts) -> bool
+{
+    using core::memory::BufferType;
+
+    auto& buffers = m_frames[frame];
+
+    // The frame's fence was waited on, its counters are final
+    m_memoryManager.invalidate(buffers.stats);
+    const auto* stats = static_cast<const shaders::culling::CullStats*>(buffers.stats.getMappedData());
+    m_stats = CullingStats{
+        .visible = stats->visible,
+        .frustumCulled = stats->frustumCulled,
+        .occlusionCulled = stats->occlusionCulled
+    };
+
+    const auto drawCount = static_cast<uint32_t>(m_draws.size());
+
+    // Every draw gets a region large enough for all instances of its model, any of them may pick any level
+    uint32_t visibleCapacity = 0;
+    for (uint32_t m = 0; m < m_models.size(); m++) {
+        const auto& model = m_models[m];
+        const uint32_t count = m < modelInstanceCounts.size() ? modelInstanceCounts[m] : 0;
+
+        for (uint32_t d = model.firstDraw; d < model.firstDraw + model.drawCount; d++) {
+            m_draws[d].instanceOffset = visibleCapacity;
+            visibleCapacity += count;
+        }
+    }
+
+    bool updated = false;
+    updated |= reserve(buffers.models, sizeof(shaders::culling::CullModel) * m_models.size(), BufferType::STORAGE, MemoryUsage::AUTO);
+    updated |= reserve(buffers.draws, sizeof(shaders::culling::CullDraw) * drawCount, BufferType::STORAGE, MemoryUsage::AUTO);
+    updated |= reserve(buffers.visibleCounts, sizeof(uint32_t) * drawCount, BufferType::INDIRECT, MemoryUsage::GPU_ONLY);
+    updated |= reserve(buffers.commands, sizeof(VkDrawIndexedIndirectCommand) * drawCount, BufferType::INDIRECT, MemoryUsage::GPU_ONLY);
+    updated |= reserve(buffers.bucketCounts, sizeof(uint32_t) * m_bucketCount, BufferType::INDIRECT, MemoryUsage::GPU_ONLY);
+    updated |= reserve(buffers.rejected, rejected_size(visibleCapacity), BufferType::INDIRECT, MemoryUsage::GPU_ONLY);
+
+    const bool instancesRecreated = reserve(
+        buffers.visibleInstances,
+        sizeof(shaders::generic::InstanceData) * visibleCapacity,
+        BufferType::INDIRECT,
+        MemoryUsage::GPU_ONLY
+    );
+
+    if (updated || instancesRecreated || buffers.staleDescriptorSet) {
+        update_descriptor_set(frame);
+        buffers.staleDescriptorSet = false;
+    }
+
+    if (!m_models.empty()) {
+        m_memoryManager.copyDataToBuffer(m_models.data(), sizeof(shaders::culling::CullModel) * m_models.size(), buffers.models);
+    }
+    if (!m_draws.empty()) {
+        m_memoryManager.copyDataToBuffer(m_draws.data(), sizeof(shaders::culling::CullDraw) * m_draws.size(), buffers.draws);
+    }
+
+    m_pushConstants.instanceCount = instanceCount;
+    m_pushConstants.drawCount = drawCount;
+    m_visibleCapacity = visibleCapacity;
+
+    return instancesRecreated;
+}
+
+auto GpuCulling::record(
+    core::commands::CommandBuffer& cmd,
+    uint32_t frame,
+    const View& view) -> void
+{
+    using shaders::culling::CullPhase;
+    auto& buffers = m_frames[frame];
+
+    const shaders::culling::CullUniforms uniforms{
+        .frustum = view.frustum,
+        .view = view.view,
+        .previousView = m_pyramidView.view,
+        .projection = projection_params(view.projection),
+        .previousProjection = projection_params(m_pyramidView.projection),
+        .pyramidSize = {
+            static_cast<float>(m_depthPyramid.getExtent().width),
+            static_cast<float>(m_depthPyramid.getExtent().height)
+        },
+        .nearPlane = view.nearPlane,
+        .previousPyramidValid = m_pyramidValid ? 1u : 0u,
+        .lodScale = view.lodScale,
+        .padding = {}
+    };
+    m_memoryManager.copyDataToBuffer(&uniforms, sizeof(uniforms), buffers.uniforms);
+    m_pyramidView = view;
+
+    // Earlier frames may still be culling the slots being overwritten, the barrier below covers the copy
+    if (!buffers.uploadRegions.empty()) {
+        cmd.barrier(
+            VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, 0,
+            VK_PIPELINE_STAGE_TRANSFER_BIT, 0
+        );
+        cmd.beginScope("instance upload");
+        cmd.copy(buffers.instanceUpload, m_instances, buffers.uploadRegions);
+        cmd.endScope();
+    }
+
+    // Counters start at 0 every frame, commands are rewritten in place when not compacted
+    cmd.fill(buffers.visibleCounts, 0);
+    cmd.fill(buffers.bucketCounts, 0);
+    cmd.fill(buffers.rejected, 0, 0, sizeof(shaders::culling::CullRejectedHeader));
+    cmd.fill(buffers.stats, 0);
+    cmd.barrier(
+        VK_PIPELINE_STAGE_TRANSFER_BIT, VK_ACCESS_TRANSFER_WRITE_BIT,
+        VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT
+    );
+
+    if (m_pushConstants.drawCount == 0) {
+        return;
+    }
+
+    m_pushConstants.phase = m_occlusionCulling ? CullPhase::FIRST : CullPhase::FRUSTUM;
+    dispatch_cull(cmd, frame, m_pushConstants.instanceCount);
+    dispatch_compact(cmd, frame);
+}
+
+auto GpuCulling::recordSecondPhase(core::commands::CommandBuffer& cmd, uint32_t frame) -> void
+{
+    auto& buffers = m_frames[frame];
+
+    m_depthPyramid.build(cmd, frame);
+
+    if (m_pushConstants.drawCount == 0) {
+        return;
+    }
+
+    // Only the newly visible instances are drawn next
+    cmd.fill(buffers.visibleCounts, 0);
+    cmd.fill(buffers.bucketCounts, 0);
+    cmd.barrier(
+        VK_PIPELINE_STAGE_TRANSFER_BIT, VK_ACCESS_TRANSFER_WRITE_BIT,
+        VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT
+    );
+
+    // Invocations past the rejected count exit right away
+    m_pushConstants.phase = shaders::culling::CullPhase::SECOND;
+    dispatch_cull(cmd, frame, m_visibleCapacity);
+    dispatch_compact(cmd, frame);
+}
+
+auto GpuCulling::recordPyramidUpdate(core::commands::CommandBuffer& cmd, uint32_t frame) -> void
+{
+    m_depthPyramid.build(cmd, frame);
+    m_pyramidValid = true;
+}
+
+auto GpuCulling::drawBucket(
+    core::commands::CommandBuffer& cmd,
+    uint32_t frame,
+    uint32_t bucket,
+    uint32_t firstCommand,
+    uint32_t commandCount) -> void
+{
+    const auto& buffers = m_frames[frame];
+    constexpr VkDeviceSize stride = sizeof(VkDrawIndexedIndirectCommand);
+
+    if (m_features.drawIndirectCount) {
+        cmd.drawIndexedIndirectCount(
+            buffers.commands,
+            firstCommand * stride,
+            buffers.bucketCounts,
+            bucket * sizeof(uint32_t),
+            commandCount
+        );
+    } else if (m_features.multiDrawIndirect) {
+        cmd.drawIndexedIndirect(buffers.commands, firstCommand * stride, commandCount);
+    } else {
+        for (uint32_t i = 0; i < commandCount; i++) {
+            cmd.drawIndexedIndirect(buffers.commands, (firstCommand + i) * stride, 1);
+        }
+    }
+}
+
+    /**   PRIVATE   **/
+
+auto GpuCulling::update_descriptor_set(uint32_t frame) -> void
+{
+    using shaders::culling::BINDING_COUNT;
+    using shaders::culling::PYRAMID_BINDING;
+    using shaders::culling::UNIFORM_BINDING;
+
+    const auto& buffers = m_frames[frame];
+
+    const std::array<const core::memory::Buffer*, BINDING_COUNT> bindings{
+        &m_instances,
+        &buffers.models,
+        &buffers.draws,
+        &buffers.visibleCounts,
+        &buffers.visibleInstances,
+        &buffers.commands,
+        &buffers.bucketCounts,
+        &buffers.uniforms,
+        nullptr,                // Depth pyramid
+        &buffers.rejected,
+        &buffers.stats
+    };
+
+    std::array<VkDescriptorBufferInfo, BINDING_COUNT> bufferInfos{};
+    std::array<VkWriteDescriptorSet, BINDING_COUNT> descriptorWrites{};
+
+    const VkDescriptorImageInfo pyramidInfo{
+        .sampler = m_depthPyramid.getSampler(),
+        .imageView = m_depthPyramid.getView(),
+        .imageLayout = VK_IMAGE_LAYOUT_GENERAL
+    };
+
+    for (uint32_t i = 0; i < BINDING_COUNT; i++) {
+        descriptorWrites[i].sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+        descriptorWrites[i].dstSet = m_descriptorSets[frame];
+        descriptorWrites[i].dstBinding = i;
+        descriptorWrites[i].dstArrayElement = 0;
+        descriptorWrites[i].descriptorCount = 1;
+
+        if (i == PYRAMID_BINDING) {
+            descriptorWrites[i].descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+            descriptorWrites[i].pImageInfo = &pyramidInfo;
+            continue;
+        }
+
+        bufferInfos[i].buffer = bindings[i]->getBuffer();
+        bufferInfos[i].offset = 0;
+        bufferInfos[i].range = VK_WHOLE_SIZE;
+
+        descriptorWrites[i].descriptorType = i == UNIFORM_BINDING ?
+            VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER :
+            VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+        descriptorWrites[i].pBufferInfo = &bufferInfos[i];
+    }
+
+    vulkan::UpdateDescriptorSets(
+        m_memoryManager.getDevice(),
+        static_cast<uint32_t>(descriptorWrites.size()),
+        descriptorWrites.data(),
+        0,
+        nullptr
+    );
+}
+
+auto GpuCulling::dispatch_cull(core::commands::CommandBuffer& cmd, uint32_t frame, uint32_t invocationCount) -> void
+{
+    cmd.bind(*m_cullPipeline);
+    cmd.bind(m_descriptorSets[frame], m_cullPipeline->getPipelineLayout(), 0, VK_PIPELINE_BIND_POINT_COMPUTE);
+    cmd.pushConstants(
+        m_cullPipeline->getPipelineLayout(),
+        VK_SHADER_STAGE_COMPUTE_BIT,
+        0,
+        sizeof(shaders::culling::CullPushConstants),
+        &m_pushConstants
+    );
+    cmd.dispatch(group_count(invocationCount));
+
+    cmd.barrier(
+        VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_ACCESS_SHADER_WRITE_BIT,
+        VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT
+    );
+}
+
+auto GpuCulling::dispatch_compact(core::commands::CommandBuffer& cmd, uint32_t frame) -> void
+{
+    cmd.bind(*m_compactPipeline);
+    cmd.bind(m_descriptorSets[frame], m_compactPipeline->getPipelineLayout(), 0, VK_PIPELINE_BIND_POINT_COMPUTE);
+    cmd.pushConstants(
+        m_compactPipeline->getPipelineLayout(),
+        VK_SHADER_STAGE_COMPUTE_BIT,
+        0,
+        sizeof(shaders::culling::CullPushConstants),
+        &m_pushConstants
+    );
+    cmd.dispatch(group_count(m_pushConstants.drawCount));
+}
+
+auto GpuCulling::reserve(
+    core::memory::Buffer& buffer,
+    VkDeviceSize size,
+    core::memory::BufferType type,
+    MemoryUsage usage) -> bool
+{
+    if (size <= buffer.getSize()) {
+        return false;
+    }
+
+    // Only called after the frame's fence was waited on, the old buffer is no longer in use
+    buffer = m_memoryManager.createBuffer(std::bit_ceil(size), type, usage);
+    return true;
+}
+
+} // namespace systems
@@ -0,0 +1,52 @@
+#include "systems/IdRangeAllocator.hpp"
+
+#include <stdexcept>
+
+namespace systems {
+
+IdRangeAllocator::IdRangeAllocator(uint32_t capacity)
+    : m_capacity{capacity}
+{
+    VmaVirtualBlockCreateInfo createInfo{};
+    createInfo.size = capacity;
+
+    if (vmaCreateVirtualBlock(&createInfo, &m_block) != VK_SUCCESS) {
+        throw std::runtime_error("Failed to create id range virtual block.");
+    }
+}
+
+IdRangeAllocator::~IdRangeAllocator()
+{
+    // Ranges still held by their owners at shutdown are dropped with the block
+    vmaClearVirtualBlock(m_block);
+    vmaDestroyVirtualBlock(m_block);
+}
+
+auto IdRangeAllocator::allocate(uint32_t count) -> std::optional<Range>
+{
+    if (count == 0) {
+        return Range{};
+    }
+
+    VmaVirtualAllocationCreateInfo allocationInfo{};
+    allocationInfo.size = count;
+
+    Range range{.count = count};
+    VkDeviceSize first = 0;
+    if (vmaVirtualAllocate(m_block, &allocationInfo, &range.allocation, &first) != VK_SUCCESS) {
+        return std::nullopt;
+    }
+
+    range.first = static_cast<uint32_t>(first);
+    return range;
+}
+
+auto IdRangeAllocator::free(Range& range) noexcept -> void
+{
+    if (range.allocation != VK_NULL_HANDLE) {
+        vmaVirtualFree(m_block, range.allocation);
+    }
+    range = Range{};
+}
+
+} // namespace systems
@@ -0,0 +1,93 @@
+#include "systems/InstanceBuffer.hpp"
+
+#include <algorithm>
+#include <bit>
+#include <utility>
+
+namespace systems {
+
+InstanceBuffer::InstanceBuffer(
+    MemoryManager& memoryManager,
+    uint32_t frameCount,
+    uint32_t instanceCapacity) :
+    m_memoryManager{memoryManager},
+    m_instances{memoryManager.createBuffer(
+        sizeof(shaders::generic::InstanceData) * std::max(instanceCapacity, 1u),
+        core::memory::BufferType::INDIRECT,
+        MemoryUsage::GPU_ONLY
+    )}
+{
+    m_frames.reserve(frameCount);
+    for (uint32_t i = 0; i < frameCount; i++) {
+        m_frames.push_back(FrameUpload{
+            .staging = m_memoryManager.createBuffer(
+                sizeof(shaders::generic::InstanceData) * std::max(instanceCapacity, 1u),
+                core::memory::BufferType::STAGING
+            ),
+            .regions = {}
+        });
+    }
+}
+
+auto InstanceBuffer::reserve(uint32_t instanceCount) -> bool
+{
+    const VkDeviceSize size = sizeof(shaders::generic::InstanceData) * std::max(instanceCount, 1u);
+    if (size <= m_instances.getSize()) {
+        return false;
+    }
+
+    // Frames in flight keep drawing from the previous buffer, their global sets are rewritten by the caller
+    m_memoryManager.retire(std::exchange(
+        m_instances,
+        m_memoryManager.createBuffer(std::bit_ceil(size), core::memory::BufferType::INDIRECT, MemoryUsage::GPU_ONLY)
+    ));
+
+    return true;
+}
+
+auto InstanceBuffer::map(
+    uint32_t frame,
+    std::span<const InstanceRegistry::Range> ranges,
+    uint32_t transientFirst,
+    uint32_t transientCount) -> shaders::generic::InstanceData*
+{
+    constexpr VkDeviceSize stride = sizeof(shaders::generic::InstanceData);
+    auto& upload = m_frames[frame];
+
+    upload.regions.clear();
+    VkDeviceSize offset = 0;
+
+    for (const auto& [first, count] : ranges) {
+        upload.regions.push_back({offset, first * stride, count * stride});
+        offset += count * stride;
+    }
+
+    if (transientCount > 0) {
+        upload.regions.push_back({offset, transientFirst * stride, transientCount * stride});
+        offset += transientCount * stride;
+    }
+
+    // Only written by the host, the copies of the frame's previous use are complete
+    if (offset > upload.staging.getSize()) {
+        upload.staging = m_memoryManager.createBuffer(std::bit_ceil(offset), core::memory::BufferType::STAGING);
+    }
+
+    return static_cast<shaders::generic::InstanceData*>(upload.staging.getMappedData());
+}
+
+auto InstanceBuffer::record(core::commands::CommandBuffer& cmd, uint32_t frame) -> void
+{
+    auto& upload = m_frames[frame];
+    if (upload.regions.empty()) {
+        return;
+    }
+
+    // Earlier frames may still draw the slots being overwritten
+    cmd.barrier(
+        VK_PIPELINE_STAGE_VERTEX_SHADER_BIT, 0,
+        VK_PIPELINE_STAGE_TRANSFER_BIT, 0
+    );
+    cmd.copy(upload.staging, m_instances, upload.regions);
+}
+
+} // namespace systems
@@ -0,0 +1,115 @@
+#include "systems/InstanceRegistry.hpp"
+
+#include <algorithm>
+#include <stdexcept>
+
+namespace systems {
+
+auto InstanceRegistry::create(size_t model, const glm::mat4& transform) -> Handle
+{
+    uint32_t slot;
+
+    if (!m_freeSlots.empty()) {
+        slot = m_freeSlots.back();
+        m_freeSlots.pop_back();
+
+        m_transforms[slot] = transform;
+        m_models[slot] = model;
+        m_alive[slot] = 1;
+    } else {
+        if (m_alive.size() >= MAX_SLOTS) {
+            throw std::length_error("Instance registry is full, handles only have room for 2^24 slots.");
+        }
+
+        slot = static_cast<uint32_t>(m_alive.size());
+
+        m_transforms.push_back(transform);
+        m_models.push_back(model);
+        m_alive.push_back(1);
+        m_dirty.push_back(0);
+        m_generations.push_back(0);
+    }
+
+    m_modelCounts[model]++;
+    mark_dirty(slot);
+    return make_handle(slot);
+}
+
+auto InstanceRegistry::destroy(Handle handle) -> void
+{
+    if (!contains(handle)) {
+        return;
+    }
+
+    const uint32_t slot = getSlot(handle);
+    const auto it = m_modelCounts.find(m_models[slot]);
+    if (--it->second == 0) {
+        m_modelCounts.erase(it);
+    }
+
+    // Wraps around, a handle kept through 2^GENERATION_BITS reuses of its slot is accepted again
+    m_generations[slot]++;
+    m_alive[slot] = 0;
+    m_freeSlots.push_back(slot);
+    mark_dirty(slot);
+}
+
+auto InstanceRegistry::setTransform(Handle handle, const glm::mat4& transform) -> void
+{
+    if (!contains(handle)) {
+        return;
+    }
+
+    const uint32_t slot = getSlot(handle);
+    m_transforms[slot] = transform;
+    mark_dirty(slot);
+}
+
+auto InstanceRegistry::markAllDirty() -> void
+{
+    for (uint32_t slot = 0; slot < m_alive.size(); slot++) {
+        mark_dirty(slot);
+    }
+}
+
+auto InstanceRegistry::clearDirty() -> void
+{
+    for (const uint32_t slot : m_dirtySlots) {
+        m_dirty[slot] = 0;
+    }
+    m_dirtySlots.clear();
+}
+
+auto InstanceRegistry::consumeDirtyRanges(std::vector<Range>& ranges) -> void
+{
+    ranges.clear();
+    std::sort(m_dirtySlots.begin(), m_dirtySlots.end());
+
+    for (const uint32_t slot : m_dirtySlots) {
+        m_dirty[slot] = 0;
+
+        if (!ranges.empty()) {
+            auto& last = ranges.back();
+            if (slot <= last.first + last.count + COALESCE_GAP) {
+                last.count = slot + 1 - last.first;
+                continue;
+            }
+        }
+
+        ranges.push_back({slot, 1});
+    }
+
+    m_dirtySlots.clear();
+}
+
+    /**   PRIVATE   **/
+
+auto InstanceRegistry::mark_dirty(uint32_t slot) -> void
+{
+    if (!m_dirty[slot]) {
+        m_dirty[slot] = 1;
+        m_dirtySlots.push_back(slot);
+    }
+}
+
+} // namespace systems
@@ -0,0 +1,111 @@
+#include "systems/JobSystem.hpp"
+
+namespace systems {
+
+JobSystem::JobSystem(uint32_t workerCount)
+{
+    m_workers.reserve(workerCount);
+    for (uint32_t i = 0; i < workerCount; i++) {
+        m_workers.emplace_back(&JobSystem::worker_loop, this);
+    }
+}
+
+JobSystem::~JobSystem()
+{
+    {
+        std::lock_guard lock{m_mutex};
+        m_stop = true;
+    }
+    m_wakeWorkers.notify_all();
+
+    for (auto& worker : m_workers) {
+        worker.join();
+    }
+}
+
+auto JobSystem::parallel_for(uint32_t taskCount, const Task& task) -> void
+{
+    if (taskCount == 0) {
+        return;
+    }
+
+    // Nothing to share, avoid waking the workers up
+    if (taskCount == 1 || m_workers.empty()) {
+        for (uint32_t i = 0; i < taskCount; i++) {
+            task(i);
+        }
+        return;
+    }
+
+    {
+        std::lock_guard lock{m_mutex};
+        m_task = &task;
+        m_taskCount = taskCount;
+        m_nextTask.store(0, std::memory_order_relaxed);
+        m_activeWorkers = static_cast<uint32_t>(m_workers.size());
+        m_exception = nullptr;
+        m_generation++;
+    }
+    m_wakeWorkers.notify_all();
+
+    run_tasks(task, taskCount);
+
+    std::unique_lock lock{m_mutex};
+    m_batchDone.wait(lock, [this] { return m_activeWorkers == 0; });
+    m_task = nullptr;
+
+    if (m_exception) {
+        std::rethrow_exception(std::exchange(m_exception, nullptr));
+    }
+}
+
+    /**   PRIVATE   **/
+
+auto JobSystem::worker_loop() -> void
+{
+    uint64_t seenGeneration = 0;
+
+    while (true) {
+        const Task* task = nullptr;
+        uint32_t taskCount = 0;
+
+        {
+            std::unique_lock lock{m_mutex};
+            m_wakeWorkers.wait(lock, [&] { return m_stop || m_generation != seenGeneration; });
+
+            if (m_stop) {
+                return;
+            }
+
+            seenGeneration = m_generation;
+            task = m_task;
+            taskCount = m_taskCount;
+        }
+
+        run_tasks(*task, taskCount);
+
+        {
+            std::lock_guard lock{m_mutex};
+            m_activeWorkers--;
+        }
+        m_batchDone.notify_one();
+    }
+}
+
+auto JobSystem::run_tasks(const Task& task, uint32_t taskCount) -> void
+{
+    for (uint32_t i = m_nextTask.fetch_add(1, std::memory_order_relaxed);
+         i < taskCount;
+         i = m_nextTask.fetch_add(1, std::memory_order_relaxed)) {
+        try {
+            task(i);
+        } catch (...) {
+            std::lock_guard lock{m_mutex};
+            if (!m_exception) {
+                m_exception = std::current_exception();
+            }
+        }
+    }
+}
+
+} // namespace systems
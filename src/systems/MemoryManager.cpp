@@ -1,4 +1,5 @@
 #include "systems/MemoryManager.hpp"
+#include "common/Profiler.hpp"
 
 #include <cstring>
 
@@ -40,6 +41,8 @@ auto get_memory_usage(systems::MemoryUsage usage) -> VmaMemoryUsage
             return VMA_MEMORY_USAGE_CPU_TO_GPU;
         case systems::MemoryUsage::GPU_TO_CPU:
             return VMA_MEMORY_USAGE_GPU_TO_CPU;
+        case systems::MemoryUsage::GPU_LAZILY_ALLOCATED:
+            return VMA_MEMORY_USAGE_GPU_LAZILY_ALLOCATED;
         case systems::MemoryUsage::AUTO:
             return VMA_MEMORY_USAGE_AUTO;
         default:
@@ -57,10 +60,16 @@ auto buffer_type_to_flags(core::memory::BufferType type) -> VmaAllocationCreateF
             return 0;
         case Type::UNIFORM:
             return VMA_ALLOCATION_CREATE_HOST_ACCESS_SEQUENTIAL_WRITE_BIT | VMA_ALLOCATION_CREATE_MAPPED_BIT;
-        // case Type::STORAGE:
-        //     return VMA_ALLOCATION_CREATE_DEDICATED_MEMORY_BIT | VMA_ALLOCATION_CREATE_HOST_ACCESS_SEQUENTIAL_WRITE_BIT;
+        case Type::STORAGE:
+            return VMA_ALLOCATION_CREATE_HOST_ACCESS_SEQUENTIAL_WRITE_BIT | VMA_ALLOCATION_CREATE_MAPPED_BIT;
+        case Type::INDIRECT:
+            return 0;
         case Type::STAGING:
             return VMA_ALLOCATION_CREATE_HOST_ACCESS_SEQUENTIAL_WRITE_BIT | VMA_ALLOCATION_CREATE_MAPPED_BIT;
+        case Type::READBACK:
+            return VMA_ALLOCATION_CREATE_HOST_ACCESS_RANDOM_BIT | VMA_ALLOCATION_CREATE_MAPPED_BIT;
+        case Type::DYNAMIC:
+            return VMA_ALLOCATION_CREATE_HOST_ACCESS_SEQUENTIAL_WRITE_BIT | VMA_ALLOCATION_CREATE_MAPPED_BIT;
         default:
             throw std::invalid_argument("Unsupported buffer type.");
     }
@@ -76,10 +85,16 @@ auto buffer_type_to_usage(core::memory::BufferType type) -> VkBufferUsageFlags
             return VK_BUFFER_USAGE_INDEX_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT;
         case Type::UNIFORM:
             return VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT;
-        // case Type::STORAGE:
-        //     return VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT;
+        case Type::STORAGE:
+            return VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT;
+        case Type::INDIRECT:
+            return VK_BUFFER_USAGE_INDIRECT_BUFFER_BIT | VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT;
         case Type::STAGING:
             return VK_BUFFER_USAGE_TRANSFER_SRC_BIT;
+        case Type::READBACK:
+            return VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT;
+        case Type::DYNAMIC:
+            return VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT | VK_BUFFER_USAGE_STORAGE_BUFFER_BIT;
         default:
             throw std::invalid_argument("Unsupported buffer type.");
     }
@@ -92,6 +107,10 @@ auto get_image_format(core::memory::ImageType type) -> VkFormat {
         case core::memory::ImageType::DEPTH_2D:
             // TODO: Choose format based on device capabilities
             return VK_FORMAT_D32_SFLOAT;
+        case core::memory::ImageType::DEPTH_PYRAMID:
+            return VK_FORMAT_R32G32_SFLOAT;
+        case core::memory::ImageType::COLOR_TARGET:
+            return VK_FORMAT_R8G8B8A8_SRGB;
         default:
             throw std::invalid_argument("Unsupported image type.");
     }
@@ -102,7 +121,11 @@ auto get_image_usage(core::memory::ImageType type) -> VkImageUsageFlags {
         case core::memory::ImageType::TEXTURE_2D:
             return VK_IMAGE_USAGE_SAMPLED_BIT | VK_IMAGE_USAGE_TRANSFER_DST_BIT;
         case core::memory::ImageType::DEPTH_2D:
-            return VK_IMAGE_USAGE_DEPTH_STENCIL_ATTACHMENT_BIT;
+            return VK_IMAGE_USAGE_DEPTH_STENCIL_ATTACHMENT_BIT | VK_IMAGE_USAGE_SAMPLED_BIT;
+        case core::memory::ImageType::DEPTH_PYRAMID:
+            return VK_IMAGE_USAGE_STORAGE_BIT | VK_IMAGE_USAGE_SAMPLED_BIT;
+        case core::memory::ImageType::COLOR_TARGET:
+            return VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT | VK_IMAGE_USAGE_TRANSFER_SRC_BIT;
         default:
             throw std::invalid_argument("Unsupported image type.");
     }
@@ -126,7 +149,8 @@ namespace systems {
 
 MemoryManager::MemoryManager(
     core::device::Instance& instance,
-    core::device::Device& device)
+    core::device::Device& device,
+    VkDeviceSize stagingSize)
 : m_allocator{create_vma_allocator(instance, device)}
 , m_device{device.getDevice()}
 , m_descriptorPool{
@@ -135,13 +159,27 @@ MemoryManager::MemoryManager(
     shaders::generic::get_material_desc_pool_sizes(100),
     100u
 }
-// , m_transferQueue{device.getTransferQueue()}
-, m_transferQueue{device.getGraphicsQueue()} // Using graphics queue for transfer for simplicity, TODO: change if improvement needed
-, m_commandPool{device, m_transferQueue.familyIndex}
+// The graphics queue when the device has no dedicated transfer family
+, m_transferQueue{device.getTransferQueue()}
+, m_graphicsTimeline{device.getGraphicsTimeline()}
+, m_uploads{device, device.getTransferTimeline(), m_graphicsTimeline}
+, m_stagingRing{std::make_unique<StagingRing>(*this, m_uploads, stagingSize)}
+, m_geometryArena{std::make_unique<GeometryArena>(*this)}
 {}
 
 MemoryManager::~MemoryManager()
 {
+    // Retained staging buffers are released by the timeline callback before the allocator
+    m_uploads.submit();
+    m_uploads.wait();
+
+    // Shutdown only: retired resources may hold geometry arena ranges, every frame has to be done with them
+    m_graphicsTimeline.waitIdle();
+    collectRetired();
+
+    m_geometryArena.reset();
+    m_stagingRing.reset();
+
     if (m_allocator) {
         vmaDestroyAllocator(m_allocator);
         m_allocator = VK_NULL_HANDLE;
@@ -198,7 +236,8 @@ auto MemoryManager::createBuffer(
 auto MemoryManager::createImage(
     const VkExtent3D& extent,
     core::memory::ImageType type,
-    MemoryUsage usage
+    MemoryUsage usage,
+    uint32_t mipLevels
 ) -> core::memory::Image {
     VmaAllocationCreateInfo allocInfo{};
     allocInfo.usage = get_memory_usage(usage);
@@ -208,7 +247,7 @@ auto MemoryManager::createImage(
     imageInfo.sType = VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO;
     imageInfo.imageType = VK_IMAGE_TYPE_2D;
     imageInfo.extent = extent;
-    imageInfo.mipLevels = 1;
+    imageInfo.mipLevels = mipLevels;
     imageInfo.arrayLayers = 1;
     imageInfo.format = get_image_format(type);
     imageInfo.tiling = VK_IMAGE_TILING_OPTIMAL;
@@ -250,7 +289,7 @@ auto MemoryManager::createImage(
     viewInfo.subresourceRange = {
         .aspectMask = aspectMask,
         .baseMipLevel = 0,
-        .levelCount = 1,
+        .levelCount = mipLevels,
         .baseArrayLayer = 0,
         .layerCount = 1
     };
@@ -269,7 +308,8 @@ auto MemoryManager::createImage(
         allocation,
         m_allocator,
         m_device,
-        type);
+        type,
+        imageInfo.format);
 }
 
 auto MemoryManager::copyDataToBuffer(
@@ -283,16 +323,15 @@ auto MemoryManager::copyDataToBuffer(
     switch (buffer.getType()) {
         case Type::VERTEX:
         case Type::INDEX: {
-            auto stagingBuffer = createBuffer(
-                size,
-                core::memory::BufferType::STAGING
-            );
-
-            std::memcpy(stagingBuffer.getMappedData(), data, size);
-            copy(stagingBuffer, buffer, size, 0, offset);
+            stage(data, size, [&](core::memory::Buffer& stagingBuffer, VkDeviceSize stagingOffset) {
+                m_uploads.copy(stagingBuffer, buffer, size, stagingOffset, offset);
+            });
+            flush_uploads();
         } break;
         case Type::STAGING:
-        case Type::UNIFORM: {
+        case Type::UNIFORM:
+        case Type::STORAGE:
+        case Type::DYNAMIC: {
             std::memcpy(
                 static_cast<uint8_t*>(buffer.getMappedData()) + offset,
                 data,
@@ -304,6 +343,113 @@ auto MemoryManager::copyDataToBuffer(
     }
 }
 
+auto MemoryManager::copyDataToImage(
+    const void* data,
+    VkDeviceSize size,
+    core::memory::Image& image,
+    VkExtent3D extent
+) -> void {
+    stage(data, size, [&](core::memory::Buffer& stagingBuffer, VkDeviceSize stagingOffset) {
+        m_uploads.copy(stagingBuffer, image, extent, stagingOffset);
+    });
+    flush_uploads();
+}
+
+auto MemoryManager::allocateMemory(const VkMemoryRequirements& requirements, MemoryUsage usage) -> VmaAllocation
+{
+    VmaAllocationCreateInfo allocInfo{};
+    allocInfo.usage = get_memory_usage(usage);
+
+    VmaAllocation allocation = VK_NULL_HANDLE;
+    if (vmaAllocateMemory(m_allocator, &requirements, &allocInfo, &allocation, nullptr) != VK_SUCCESS) {
+        throw std::runtime_error("Failed to allocate memory.");
+    }
+
+    return allocation;
+}
+
+auto MemoryManager::bindImageMemory(VmaAllocation allocation, VkImage image) -> void
+{
+    if (vmaBindImageMemory(m_allocator, allocation, image) != VK_SUCCESS) {
+        throw std::runtime_error("Failed to bind image memory.");
+    }
+}
+
+auto MemoryManager::freeMemory(VmaAllocation allocation) -> void
+{
+    vmaFreeMemory(m_allocator, allocation);
+}
+
+auto MemoryManager::supportsLazilyAllocatedMemory() const -> bool
+{
+    const VkPhysicalDeviceMemoryProperties* properties = nullptr;
+    vmaGetMemoryProperties(m_allocator, &properties);
+
+    for (uint32_t i = 0; i < properties->memoryTypeCount; i++) {
+        if (properties->memoryTypes[i].propertyFlags & VK_MEMORY_PROPERTY_LAZILY_ALLOCATED_BIT) {
+            return true;
+        }
+    }
+
+    return false;
+}
+
+auto MemoryManager::getLimits() const -> const VkPhysicalDeviceLimits&
+{
+    const VkPhysicalDeviceProperties* properties = nullptr;
+    vmaGetPhysicalDeviceProperties(m_allocator, &properties);
+    return properties->limits;
+}
+
+auto MemoryManager::invalidate(core::memory::Buffer& buffer) -> void
+{
+    vmaInvalidateAllocation(m_allocator, buffer.getAllocation(), 0, VK_WHOLE_SIZE);
+}
+
+auto MemoryManager::beginUploads() -> void
+{
+    m_batchingUploads = true;
+}
+
+auto MemoryManager::submitUploads() -> void
+{
+    m_batchingUploads = false;
+    m_uploads.submit();
+}
+
+auto MemoryManager::discardUploads() -> void
+{
+    m_batchingUploads = false;
+    m_uploads.discard();
+}
+
+auto MemoryManager::waitUploads() -> void
+{
+    m_uploads.wait();
+}
+
+auto MemoryManager::defer(std::move_only_function<void()> destroy) -> void
+{
+    // The open batch isn't submitted, it keeps recording & its serial stands for its future value
+    m_retired.push_back(Retired{
+        .graphicsValue = m_graphicsTimeline.getSubmittedValue(),
+        .uploadSerial = m_uploads.empty() ? m_uploads.getRecordingSerial() - 1 : m_uploads.getRecordingSerial(),
+        .destroy = std::move(destroy)
+    });
+}
+
+auto MemoryManager::collectRetired() -> void
+{
+    while (!m_retired.empty() &&
+           m_graphicsTimeline.isComplete(m_retired.front().graphicsValue) &&
+           is_uploaded(m_retired.front().uploadSerial)) {
+        // Popped first, destroying a resource may retire others
+        auto destroy = std::move(m_retired.front().destroy);
+        m_retired.pop_front();
+        destroy();
+    }
+}
+
 auto MemoryManager::copy(
     core::memory::Buffer& srcBuffer,
     core::memory::Buffer& dstBuffer,
@@ -311,26 +457,9 @@ auto MemoryManager::copy(
     VkDeviceSize srcOffset,
     VkDeviceSize dstOffset
 ) -> void {
-    auto& cmdBuffer = m_commandPool.getCmdBuffer(0);
-
-    if (size == VK_WHOLE_SIZE) {
-        size = srcBuffer.getSize() - srcOffset;
-    }
-
-    cmdBuffer.begin(true); // One-time submit
-    cmdBuffer.copy(
-        srcBuffer,
-        dstBuffer,
-        size,
-        srcOffset,
-        dstOffset
-    );
-    cmdBuffer.end();
-
-    m_transferQueue.submit(
-        cmdBuffer.getCommandBuffer()
-    );
-    m_transferQueue.waitIdle();
+    PROFILE_SCOPE("MemoryManager::copy");
+    m_uploads.copy(srcBuffer, dstBuffer, size, srcOffset, dstOffset);
+    flush_uploads();
 }
 
 auto MemoryManager::copy(
@@ -339,21 +468,9 @@ auto MemoryManager::copy(
     VkExtent3D extent,
     VkDeviceSize srcOffset
 ) -> void {
-    auto& cmdBuffer = m_commandPool.getCmdBuffer(0);
-
-    cmdBuffer.begin(true); // One-time submit
-    cmdBuffer.copy(
-        srcBuffer,
-        dstImage,
-        extent,
-        srcOffset
-    );
-    cmdBuffer.end();
-
-    m_transferQueue.submit(
-        cmdBuffer.getCommandBuffer()
-    );
-    m_transferQueue.waitIdle();
+    PROFILE_SCOPE("MemoryManager::copy");
+    m_uploads.copy(srcBuffer, dstImage, extent, srcOffset);
+    flush_uploads();
 }
 
 auto MemoryManager::transitionImageLayout(
@@ -361,57 +478,8 @@ auto MemoryManager::transitionImageLayout(
     VkImageLayout oldLayout,
     VkImageLayout newLayout
 ) -> void {
-    auto& cmdBuffer = m_commandPool.getCmdBuffer(0);
-
-    cmdBuffer.begin(true); // One-time submit
-
-    VkImageMemoryBarrier barrier{};
-    barrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
-    barrier.oldLayout = oldLayout;
-    barrier.newLayout = newLayout;
-    barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
-    barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
-    barrier.image = image.getImage();
-    barrier.subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
-    barrier.subresourceRange.baseMipLevel = 0;
-    barrier.subresourceRange.levelCount = 1;
-    barrier.subresourceRange.baseArrayLayer = 0;
-    barrier.subresourceRange.layerCount = 1;
-
-    VkPipelineStageFlags sourceStage;
-    VkPipelineStageFlags destinationStage;
-
-    if (oldLayout == VK_IMAGE_LAYOUT_UNDEFINED && newLayout == VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL) {
-        barrier.srcAccessMask = 0;
-        barrier.dstAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
-
-        sourceStage = VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT;
-        destinationStage = VK_PIPELINE_STAGE_TRANSFER_BIT;
-    } else if (oldLayout == VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL && newLayout == VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL) {
-        barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
-        barrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT;
-
-        sourceStage = VK_PIPELINE_STAGE_TRANSFER_BIT;
-        destinationStage = VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT;
-    } else {
-        throw std::invalid_argument("unsupported layout transition!");
-    }
-
-    vkCmdPipelineBarrier(
-        cmdBuffer.getCommandBuffer(),
-        sourceStage, destinationStage,
-        0,
-        0, nullptr,
-        0, nullptr,
-        1, &barrier
-    );
-
-    cmdBuffer.end();
-
-    m_transferQueue.submit(
-        cmdBuffer.getCommandBuffer()
-    );
-    m_transferQueue.waitIdle();
+    m_uploads.transition(image, oldLayout, newLayout);
+    flush_uploads();
 }
 
 // auto MemoryManager::map(const core::memory::Buffer& buffer) -> void*
@@ -438,4 +506,43 @@ auto MemoryManager::transitionImageLayout(
 //     vmaUnmapMemory(m_allocator, image.getAllocation());
 // }
 
+    /**   PRIVATE   **/
+
+auto MemoryManager::is_uploaded(uint64_t uploadSerial) const -> bool
+{
+    if (uploadSerial <= m_uploads.getCompletedSerial()) {
+        return true;
+    }
+
+    // The batch was discarded, a submitted one would have taken its serial
+    return m_uploads.empty() && uploadSerial >= m_uploads.getRecordingSerial();
+}
+
+template <typename Record>
+auto MemoryManager::stage(const void* data, VkDeviceSize size, Record&& record) -> void
+{
+    PROFILE_SCOPE("MemoryManager::stage");
+
+    if (const auto offset = m_stagingRing->stage(data, size)) {
+        record(m_stagingRing->getBuffer(), *offset);
+        return;
+    }
+
+    auto stagingBuffer = createBuffer(size, core::memory::BufferType::STAGING);
+    std::memcpy(stagingBuffer.getMappedData(), data, size);
+    m_stagingRing->countSpill(size);
+
+    record(stagingBuffer, 0);
+    m_uploads.retain(std::move(stagingBuffer));
+}
+
+auto MemoryManager::flush_uploads() -> void
+{
+    // Not waited on, later submissions on the owner queue are ordered after the upload and its
+    // value is UploadBatch::getSubmittedValue(). The next upload records into another command buffer
+    if (!m_batchingUploads) {
+        m_uploads.submit();
+    }
+}
+
 } // namespace systems
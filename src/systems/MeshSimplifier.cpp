@@ -0,0 +1,304 @@
+#include "systems/MeshSimplifier.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <numeric>
+#include <tuple>
+
+namespace {
+
+// Cosine of the largest rotation a collapse may apply to a triangle normal
+constexpr float MIN_NORMAL_COSINE = 0.25f;
+
+} // namespace
+
+namespace systems {
+
+auto MeshSimplifier::Quadric::operator+=(const Quadric& other) noexcept -> Quadric&
+{
+    a2 += other.a2; ab += other.ab; ac += other.ac; ad += other.ad;
+    b2 += other.b2; bc += other.bc; bd += other.bd;
+    c2 += other.c2; cd += other.cd;
+    d2 += other.d2;
+    weight += other.weight;
+    return *this;
+}
+
+auto MeshSimplifier::Quadric::evaluate(const glm::vec3& p) const noexcept -> double
+{
+    const double x = p.x;
+    const double y = p.y;
+    const double z = p.z;
+
+    const double sum =
+        a2 * x * x + 2.0 * ab * x * y + 2.0 * ac * x * z + 2.0 * ad * x +
+        b2 * y * y + 2.0 * bc * y * z + 2.0 * bd * y +
+        c2 * z * z + 2.0 * cd * z +
+        d2;
+
+    // Rounding can push the sum slightly below 0 for points on every plane
+    return weight > 0.0 ? std::max(sum / weight, 0.0) : 0.0;
+}
+
+MeshSimplifier::MeshSimplifier(std::span<const glm::vec3> positions, std::span<const uint32_t> indices)
+: m_positions(positions.begin(), positions.end())
+, m_indices(indices.begin(), indices.end())
+{
+    weld();
+    lock_boundaries();
+    compute_quadrics();
+}
+
+auto MeshSimplifier::simplify(size_t targetIndexCount, float maxError) -> float
+{
+    const double maxCost = static_cast<double>(maxError) * static_cast<double>(maxError);
+
+    while (m_indices.size() > targetIndexCount) {
+        if (collapse_pass(targetIndexCount, maxCost) == 0) {
+            break;
+        }
+    }
+
+    return m_error;
+}
+
+    /**   PRIVATE   **/
+
+auto MeshSimplifier::weld() -> void
+{
+    const auto vertexCount = static_cast<uint32_t>(m_positions.size());
+
+    std::vector<uint32_t> order(vertexCount);
+    std::iota(order.begin(), order.end(), 0u);
+
+    const auto less = [&](uint32_t a, uint32_t b) {
+        const auto& pa = m_positions[a];
+        const auto& pb = m_positions[b];
+        return std::tie(pa.x, pa.y, pa.z, a) < std::tie(pb.x, pb.y, pb.z, b);
+    };
+    std::sort(order.begin(), order.end(), less);
+
+    m_welded.resize(vertexCount);
+    for (uint32_t i = 0; i < vertexCount; i++) {
+        const bool same = i > 0 && m_positions[order[i]] == m_positions[order[i - 1]];
+        m_welded[order[i]] = same ? m_welded[order[i - 1]] : order[i];
+    }
+}
+
+auto MeshSimplifier::lock_boundaries() -> void
+{
+    const auto vertexCount = static_cast<uint32_t>(m_positions.size());
+    m_locked.assign(vertexCount, 0);
+
+    // Positions referenced through more than one vertex are on an attribute seam
+    std::vector<uint32_t> firstUse(vertexCount, UINT32_MAX);
+    for (const uint32_t index : m_indices) {
+        auto& first = firstUse[m_welded[index]];
+        if (first == UINT32_MAX) {
+            first = index;
+        } else if (first != index) {
+            m_locked[m_welded[index]] = 1;
+        }
+    }
+
+    // A directed edge without its opposite is on a border, one used twice is non-manifold
+    std::vector<uint64_t> edges;
+    edges.reserve(m_indices.size());
+    for (size_t i = 0; i < m_indices.size(); i += 3) {
+        for (size_t e = 0; e < 3; e++) {
+            const uint64_t a = m_welded[m_indices[i + e]];
+            const uint64_t b = m_welded[m_indices[i + (e + 1) % 3]];
+            edges.push_back(a << 32 | b);
+        }
+    }
+    std::sort(edges.begin(), edges.end());
+
+    for (size_t i = 0; i < edges.size(); i++) {
+        const uint64_t edge = edges[i];
+        const uint64_t opposite = edge << 32 | edge >> 32;
+
+        const bool duplicated = (i > 0 && edges[i - 1] == edge) || (i + 1 < edges.size() && edges[i + 1] == edge);
+        if (duplicated || !std::binary_search(edges.begin(), edges.end(), opposite)) {
+            m_locked[static_cast<uint32_t>(edge >> 32)] = 1;
+            m_locked[static_cast<uint32_t>(edge)] = 1;
+        }
+    }
+}
+
+auto MeshSimplifier::compute_quadrics() -> void
+{
+    m_quadrics.assign(m_positions.size(), Quadric{});
+
+    for (size_t i = 0; i < m_indices.size(); i += 3) {
+        const glm::vec3& p0 = m_positions[m_indices[i]];
+        const glm::vec3& p1 = m_positions[m_indices[i + 1]];
+        const glm::vec3& p2 = m_positions[m_indices[i + 2]];
+
+        const glm::vec3 normal = glm::cross(p1 - p0, p2 - p0);
+        const float length = glm::length(normal);
+        if (length == 0.f) {
+            continue;
+        }
+
+        const double a = normal.x / length;
+        const double b = normal.y / length;
+        const double c = normal.z / length;
+        const double d = -(a * p0.x + b * p0.y + c * p0.z);
+        const double area = 0.5 * length;
+
+        const Quadric quadric{
+            area * a * a, area * a * b, area * a * c, area * a * d,
+            area * b * b, area * b * c, area * b * d,
+            area * c * c, area * c * d,
+            area * d * d,
+            area
+        };
+
+        for (size_t v = 0; v < 3; v++) {
+            m_quadrics[m_welded[m_indices[i + v]]] += quadric;
+        }
+    }
+}
+
+auto MeshSimplifier::build_adjacency() -> void
+{
+    const size_t vertexCount = m_positions.size();
+
+    m_triangleOffsets.assign(vertexCount + 1, 0);
+    for (const uint32_t index : m_indices) {
+        m_triangleOffsets[index + 1]++;
+    }
+    std::partial_sum(m_triangleOffsets.begin(), m_triangleOffsets.end(), m_triangleOffsets.begin());
+
+    m_vertexTriangles.resize(m_indices.size());
+    std::vector<uint32_t> cursor(m_triangleOffsets.begin(), m_triangleOffsets.end() - 1);
+    for (size_t i = 0; i < m_indices.size(); i++) {
+        m_vertexTriangles[cursor[m_indices[i]]++] = static_cast<uint32_t>(i / 3);
+    }
+}
+
+auto MeshSimplifier::collapse_pass(size_t targetIndexCount, double maxCost) -> size_t
+{
+    build_adjacency();
+
+    const auto cost = [&](uint32_t from, uint32_t to) {
+        Quadric quadric = m_quadrics[m_welded[from]];
+        quadric += m_quadrics[m_welded[to]];
+        return quadric.evaluate(m_positions[to]);
+    };
+
+    // Every undirected edge once from the triangle listing it in increasing order, both directions
+    m_collapses.clear();
+    for (size_t i = 0; i < m_indices.size(); i += 3) {
+        for (size_t e = 0; e < 3; e++) {
+            const uint32_t a = m_indices[i + e];
+            const uint32_t b = m_indices[i + (e + 1) % 3];
+            if (a > b) {
+                continue;
+            }
+
+            if (!m_locked[m_welded[a]]) {
+                m_collapses.push_back({a, b, cost(a, b)});
+            }
+            if (!m_locked[m_welded[b]]) {
+                m_collapses.push_back({b, a, cost(b, a)});
+            }
+        }
+    }
+
+    std::sort(m_collapses.begin(), m_collapses.end(), [](const Collapse& a, const Collapse& b) {
+        return a.cost < b.cost;
+    });
+
+    m_remap.resize(m_positions.size());
+    std::iota(m_remap.begin(), m_remap.end(), 0u);
+    m_touched.assign(m_positions.size(), 0);
+
+    const size_t removable = (m_indices.size() - targetIndexCount) / 3;
+    size_t removed = 0;
+    size_t applied = 0;
+
+    for (const auto& [from, to, collapseCost] : m_collapses) {
+        if (collapseCost > maxCost || removed >= removable) {
+            break;
+        }
+
+        // Collapses of a pass must not see each other's changes, so their neighbourhoods stay disjoint
+        if (m_touched[from] || m_touched[to] || flips(from, to)) {
+            continue;
+        }
+
+        m_remap[from] = to;
+        m_quadrics[m_welded[to]] += m_quadrics[m_welded[from]];
+        m_error = std::max(m_error, static_cast<float>(std::sqrt(collapseCost)));
+        applied++;
+
+        for (uint32_t t = m_triangleOffsets[from]; t < m_triangleOffsets[from + 1]; t++) {
+            const uint32_t* triangle = &m_indices[m_vertexTriangles[t] * 3];
+            bool degenerate = false;
+
+            for (size_t v = 0; v < 3; v++) {
+                m_touched[triangle[v]] = 1;
+                degenerate |= m_welded[triangle[v]] == m_welded[to];
+            }
+            removed += degenerate ? 1 : 0;
+        }
+    }
+
+    if (applied == 0) {
+        return 0;
+    }
+
+    // Remap in place and drop the triangles that lost an edge
+    size_t write = 0;
+    for (size_t i = 0; i < m_indices.size(); i += 3) {
+        const uint32_t a = m_remap[m_indices[i]];
+        const uint32_t b = m_remap[m_indices[i + 1]];
+        const uint32_t c = m_remap[m_indices[i + 2]];
+
+        if (m_welded[a] == m_welded[b] || m_welded[b] == m_welded[c] || m_welded[a] == m_welded[c]) {
+            continue;
+        }
+
+        m_indices[write++] = a;
+        m_indices[write++] = b;
+        m_indices[write++] = c;
+    }
+    m_indices.resize(write);
+
+    return applied;
+}
+
+auto MeshSimplifier::flips(uint32_t from, uint32_t to) const -> bool
+{
+    const glm::vec3& target = m_positions[to];
+
+    for (uint32_t t = m_triangleOffsets[from]; t < m_triangleOffsets[from + 1]; t++) {
+        const uint32_t* triangle = &m_indices[m_vertexTriangles[t] * 3];
+
+        // Triangles sharing the collapsed edge disappear
+        if (m_welded[triangle[0]] == m_welded[to] ||
+            m_welded[triangle[1]] == m_welded[to] ||
+            m_welded[triangle[2]] == m_welded[to]) {
+            continue;
+        }
+
+        glm::vec3 moved[3];
+        for (size_t v = 0; v < 3; v++) {
+            moved[v] = triangle[v] == from ? target : m_positions[triangle[v]];
+        }
+
+        const glm::vec3& p0 = m_positions[triangle[0]];
+        const glm::vec3 before = glm::cross(m_positions[triangle[1]] - p0, m_positions[triangle[2]] - p0);
+        const glm::vec3 after = glm::cross(moved[1] - moved[0], moved[2] - moved[0]);
+
+        // Large rotations are rejected too, several of them in a row could flip the triangle over passes
+        if (glm::dot(before, after) <= MIN_NORMAL_COSINE * glm::length(before) * glm::length(after)) {
+            return true;
+        }
+    }
+
+    return false;
+}
+
+} // namespace systems
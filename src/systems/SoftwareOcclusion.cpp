@@ -0,0 +1,329 @@
+#include "systems/SoftwareOcclusion.hpp"
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <limits>
+
+#if defined(__SSE__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 1)
+    #include <xmmintrin.h>
+    #define JR_OCCLUSION_SSE
+#endif
+
+namespace {
+
+// Pixels written per iteration of the inner loop, rows are padded to a multiple of it
+constexpr uint32_t LANES = 4;
+
+[[nodiscard]]
+constexpr auto round_up(uint32_t value, uint32_t multiple) noexcept -> uint32_t {
+    return (std::max(value, 1u) + multiple - 1) / multiple * multiple;
+}
+
+// Signed distance to the near plane z = -w, positive in front of it
+[[nodiscard]]
+inline auto near_distance(const glm::vec4& v) noexcept -> float {
+    return v.z + v.w;
+}
+
+[[nodiscard]]
+inline auto outside_same_plane(const glm::vec4& v0, const glm::vec4& v1, const glm::vec4& v2) noexcept -> bool {
+    return
+        (v0.x >  v0.w && v1.x >  v1.w && v2.x >  v2.w) ||
+        (v0.x < -v0.w && v1.x < -v1.w && v2.x < -v2.w) ||
+        (v0.y >  v0.w && v1.y >  v1.w && v2.y >  v2.w) ||
+        (v0.y < -v0.w && v1.y < -v1.w && v2.y < -v2.w) ||
+        (v0.z >  v0.w && v1.z >  v1.w && v2.z >  v2.w);
+}
+
+} // namespace
+
+namespace systems {
+
+SoftwareOcclusion::SoftwareOcclusion(uint32_t width, uint32_t height) :
+    m_width{round_up(width, TILE_SIZE)},
+    m_height{round_up(height, TILE_SIZE)},
+    m_tilesX{m_width / TILE_SIZE},
+    m_tilesY{m_height / TILE_SIZE},
+    m_depth(static_cast<size_t>(m_width) * m_height, 0.f),
+    m_tileDepth(static_cast<size_t>(m_tilesX) * m_tilesY, 0.f)
+{
+    static_assert(TILE_SIZE % LANES == 0, "Tiles must hold whole SIMD groups");
+}
+
+auto SoftwareOcclusion::begin(const glm::mat4& viewProj) -> void
+{
+    m_viewProj = viewProj;
+    m_triangles.clear();
+}
+
+auto SoftwareOcclusion::addOccluder(
+    const glm::mat4& model,
+    std::span<const glm::vec3> positions,
+    std::span<const uint32_t> indices) -> void
+{
+    const glm::mat4 modelViewProj = m_viewProj * model;
+
+    m_clipVertices.resize(positions.size());
+    for (size_t i = 0; i < positions.size(); i++) {
+        m_clipVertices[i] = modelViewProj * glm::vec4{positions[i], 1.f};
+    }
+
+    for (size_t i = 0; i + 2 < indices.size(); i += 3) {
+        const glm::vec4& v0 = m_clipVertices[indices[i]];
+        const glm::vec4& v1 = m_clipVertices[indices[i + 1]];
+        const glm::vec4& v2 = m_clipVertices[indices[i + 2]];
+
+        if (outside_same_plane(v0, v1, v2)) {
+            continue;
+        }
+
+        const std::array<float, 3> distances{near_distance(v0), near_distance(v1), near_distance(v2)};
+        const auto frontCount = std::ranges::count_if(distances, [](float d) { return d >= 0.f; });
+
+        if (frontCount == 3) {
+            setup_triangle(v0, v1, v2);
+            continue;
+        }
+        if (frontCount == 0) {
+            continue;
+        }
+
+        // Sutherland-Hodgman against the near plane, one triangle becomes at most a quad
+        const std::array<const glm::vec4*, 3> vertices{&v0, &v1, &v2};
+        std::array<glm::vec4, 4> clipped{};
+        uint32_t clippedCount = 0;
+
+        for (uint32_t a = 0; a < 3; a++) {
+            const uint32_t b = (a + 1) % 3;
+
+            if (distances[a] >= 0.f) {
+                clipped[clippedCount++] = *vertices[a];
+            }
+            if ((distances[a] >= 0.f) != (distances[b] >= 0.f)) {
+                const float t = distances[a] / (distances[a] - distances[b]);
+                clipped[clippedCount++] = glm::mix(*vertices[a], *vertices[b], t);
+            }
+        }
+
+        for (uint32_t v = 2; v < clippedCount; v++) {
+            setup_triangle(clipped[0], clipped[v - 1], clipped[v]);
+        }
+    }
+}
+
+auto SoftwareOcclusion::rasterize(JobSystem* jobSystem) -> void
+{
+    const uint32_t bandCount = jobSystem ? std::min(jobSystem->getWorkerCount() + 1, m_tilesY) : 1;
+    const uint32_t rowsPerBand = (m_tilesY + bandCount - 1) / bandCount;
+
+    if (bandCount == 1) {
+        rasterize_band(0, m_tilesY);
+        return;
+    }
+
+    jobSystem->parallel_for(bandCount, [&](uint32_t band) {
+        const uint32_t first = std::min(band * rowsPerBand, m_tilesY);
+        rasterize_band(first, std::min(first + rowsPerBand, m_tilesY));
+    });
+}
+
+auto SoftwareOcclusion::isOccluded(const glm::mat4& model, const glm::vec3& min, const glm::vec3& max) const -> bool
+{
+    const glm::mat4 modelViewProj = m_viewProj * model;
+
+    float minX = std::numeric_limits<float>::max();
+    float minY = std::numeric_limits<float>::max();
+    float maxX = std::numeric_limits<float>::lowest();
+    float maxY = std::numeric_limits<float>::lowest();
+    float nearest = 0.f;
+
+    for (uint32_t corner = 0; corner < 8; corner++) {
+        const glm::vec3 position{
+            (corner & 1) ? max.x : min.x,
+            (corner & 2) ? max.y : min.y,
+            (corner & 4) ? max.z : min.z
+        };
+        const glm::vec4 clip = modelViewProj * glm::vec4{position, 1.f};
+
+        // Part of the box is in front of the near plane, its screen bounds are unbounded
+        if (near_distance(clip) < 0.f) {
+            return false;
+        }
+
+        const float invW = 1.f / clip.w;
+        const float x = (clip.x * invW * 0.5f + 0.5f) * static_cast<float>(m_width);
+        const float y = (0.5f - clip.y * invW * 0.5f) * static_cast<float>(m_height);
+
+        minX = std::min(minX, x);
+        maxX = std::max(maxX, x);
+        minY = std::min(minY, y);
+        maxY = std::max(maxY, y);
+        nearest = std::max(nearest, invW);
+    }
+
+    if (maxX < 0.f || maxY < 0.f || minX >= static_cast<float>(m_width) || minY >= static_cast<float>(m_height)) {
+        return false;
+    }
+
+    const auto tileX0 = static_cast<uint32_t>(std::max(minX, 0.f)) / TILE_SIZE;
+    const auto tileY0 = static_cast<uint32_t>(std::max(minY, 0.f)) / TILE_SIZE;
+    const auto tileX1 = std::min(static_cast<uint32_t>(maxX) / TILE_SIZE, m_tilesX - 1);
+    const auto tileY1 = std::min(static_cast<uint32_t>(maxY) / TILE_SIZE, m_tilesY - 1);
+
+    // Occluded only if every covered tile is closer than the closest point of the box, even at its farthest pixel
+    for (uint32_t ty = tileY0; ty <= tileY1; ty++) {
+        for (uint32_t tx = tileX0; tx <= tileX1; tx++) {
+            if (m_tileDepth[ty * m_tilesX + tx] <= nearest) {
+                return false;
+            }
+        }
+    }
+
+    return true;
+}
+
+    /**   PRIVATE   **/
+
+auto SoftwareOcclusion::setup_triangle(const glm::vec4& v0, const glm::vec4& v1, const glm::vec4& v2) -> void
+{
+    const auto project = [&](const glm::vec4& v) {
+        const float invW = 1.f / v.w;
+        return glm::vec3{
+            (v.x * invW * 0.5f + 0.5f) * static_cast<float>(m_width),
+            (0.5f - v.y * invW * 0.5f) * static_cast<float>(m_height),
+            invW
+        };
+    };
+
+    const std::array<glm::vec3, 3> p{project(v0), project(v1), project(v2)};
+
+    const float area = (p[1].x - p[0].x) * (p[2].y - p[0].y) - (p[2].x - p[0].x) * (p[1].y - p[0].y);
+    if (std::abs(area) < 1e-6f) {
+        return;
+    }
+
+    const float boundsMinX = std::min({p[0].x, p[1].x, p[2].x});
+    const float boundsMaxX = std::max({p[0].x, p[1].x, p[2].x});
+    const float boundsMinY = std::min({p[0].y, p[1].y, p[2].y});
+    const float boundsMaxY = std::max({p[0].y, p[1].y, p[2].y});
+
+    if (boundsMaxX < 0.f || boundsMaxY < 0.f ||
+        boundsMinX >= static_cast<float>(m_width) || boundsMinY >= static_cast<float>(m_height)) {
+        return;
+    }
+
+    Triangle triangle{};
+
+    // Both windings are kept, occluders may be seen from either side
+    const float sign = area > 0.f ? -1.f : 1.f;
+    for (uint32_t edge = 0; edge < 3; edge++) {
+        const glm::vec3& a = p[(edge + 1) % 3];
+        const glm::vec3& b = p[(edge + 2) % 3];
+
+        triangle.edgeA[edge] = sign * (b.y - a.y);
+        triangle.edgeB[edge] = sign * (a.x - b.x);
+        triangle.edgeC[edge] = sign * (b.x * a.y - a.x * b.y);
+    }
+
+    triangle.depthA = ((p[1].z - p[0].z) * (p[2].y - p[0].y) - (p[2].z - p[0].z) * (p[1].y - p[0].y)) / area;
+    triangle.depthB = ((p[2].z - p[0].z) * (p[1].x - p[0].x) - (p[1].z - p[0].z) * (p[2].x - p[0].x)) / area;
+    triangle.depthC = p[0].z - triangle.depthA * p[0].x - triangle.depthB * p[0].y;
+
+    triangle.minX = std::max(static_cast<int32_t>(boundsMinX), 0);
+    triangle.minY = std::max(static_cast<int32_t>(boundsMinY), 0);
+    triangle.maxX = std::min(static_cast<int32_t>(boundsMaxX), static_cast<int32_t>(m_width) - 1);
+    triangle.maxY = std::min(static_cast<int32_t>(boundsMaxY), static_cast<int32_t>(m_height) - 1);
+
+    m_triangles.push_back(triangle);
+}
+
+auto SoftwareOcclusion::rasterize_band(uint32_t firstTileRow, uint32_t lastTileRow) -> void
+{
+    const auto bandMinY = static_cast<int32_t>(firstTileRow * TILE_SIZE);
+    const auto bandMaxY = static_cast<int32_t>(lastTileRow * TILE_SIZE) - 1;
+
+    std::fill(
+        m_depth.begin() + static_cast<ptrdiff_t>(bandMinY) * m_width,
+        m_depth.begin() + static_cast<ptrdiff_t>(bandMaxY + 1) * m_width,
+        0.f
+    );
+
+    for (const auto& triangle : m_triangles) {
+        if (triangle.maxY < bandMinY || triangle.minY > bandMaxY) {
+            continue;
+        }
+
+        const int32_t y0 = std::max(triangle.minY, bandMinY);
+        const int32_t y1 = std::min(triangle.maxY, bandMaxY);
+        const int32_t x1 = triangle.maxX;
+
+        // Pixel centers are sampled, rows are padded so a group never runs past the row
+        for (int32_t y = y0; y <= y1; y++) {
+            const float centerY = static_cast<float>(y) + 0.5f;
+            float* row = m_depth.data() + static_cast<size_t>(y) * m_width;
+
+            const float rowEdge0 = triangle.edgeB[0] * centerY + triangle.edgeC[0];
+            const float rowEdge1 = triangle.edgeB[1] * centerY + triangle.edgeC[1];
+            const float rowEdge2 = triangle.edgeB[2] * centerY + triangle.edgeC[2];
+            const float rowDepth = triangle.depthB * centerY + triangle.depthC;
+
+#if defined(JR_OCCLUSION_SSE)
+            const __m128 zero = _mm_setzero_ps();
+            const __m128 laneOffsets = _mm_setr_ps(0.5f, 1.5f, 2.5f, 3.5f);
+            const __m128 a0 = _mm_set1_ps(triangle.edgeA[0]);
+            const __m128 a1 = _mm_set1_ps(triangle.edgeA[1]);
+            const __m128 a2 = _mm_set1_ps(triangle.edgeA[2]);
+            const __m128 depthA = _mm_set1_ps(triangle.depthA);
+            const __m128 e0 = _mm_set1_ps(rowEdge0);
+            const __m128 e1 = _mm_set1_ps(rowEdge1);
+            const __m128 e2 = _mm_set1_ps(rowEdge2);
+            const __m128 depth0 = _mm_set1_ps(rowDepth);
+
+            for (int32_t x = triangle.minX & ~static_cast<int32_t>(LANES - 1); x <= x1; x += LANES) {
+                const __m128 centerX = _mm_add_ps(_mm_set1_ps(static_cast<float>(x)), laneOffsets);
+
+                const __m128 inside = _mm_and_ps(
+                    _mm_and_ps(
+                        _mm_cmpge_ps(_mm_add_ps(_mm_mul_ps(a0, centerX), e0), zero),
+                        _mm_cmpge_ps(_mm_add_ps(_mm_mul_ps(a1, centerX), e1), zero)),
+                    _mm_cmpge_ps(_mm_add_ps(_mm_mul_ps(a2, centerX), e2), zero)
+                );
+                if (_mm_movemask_ps(inside) == 0) {
+                    continue;
+                }
+
+                // 1/w is positive, masked out lanes become 0 and never win the max
+                const __m128 depth = _mm_and_ps(inside, _mm_add_ps(_mm_mul_ps(depthA, centerX), depth0));
+                _mm_storeu_ps(row + x, _mm_max_ps(_mm_loadu_ps(row + x), depth));
+            }
+#else
+            for (int32_t x = triangle.minX; x <= x1; x++) {
+                const float centerX = static_cast<float>(x) + 0.5f;
+
+                if (triangle.edgeA[0] * centerX + rowEdge0 >= 0.f &&
+                    triangle.edgeA[1] * centerX + rowEdge1 >= 0.f &&
+                    triangle.edgeA[2] * centerX + rowEdge2 >= 0.f) {
+                    row[x] = std::max(row[x], triangle.depthA * centerX + rowDepth);
+                }
+            }
+#endif
+        }
+    }
+
+    // Farthest depth of every tile of the band
+    for (uint32_t ty = firstTileRow; ty < lastTileRow; ty++) {
+        for (uint32_t tx = 0; tx < m_tilesX; tx++) {
+            float farthest = std::numeric_limits<float>::max();
+
+            for (uint32_t y = ty * TILE_SIZE; y < (ty + 1) * TILE_SIZE; y++) {
+                const float* row = m_depth.data() + static_cast<size_t>(y) * m_width + tx * TILE_SIZE;
+                farthest = std::min(farthest, *std::min_element(row, row + TILE_SIZE));
+            }
+
+            m_tileDepth[ty * m_tilesX + tx] = farthest;
+        }
+    }
+}
+
+} // namespace systems
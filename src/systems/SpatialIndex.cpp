@@ -0,0 +1,705 @@
+#include "systems/SpatialIndex.hpp"
+
+#include <algorithm>
+#include <cmath>
+
+namespace {
+
+using AABB = systems::SpatialIndex::AABB;
+
+[[nodiscard]]
+constexpr auto empty_box() noexcept -> AABB {
+    return {
+        glm::vec3{std::numeric_limits<float>::max()},
+        glm::vec3{std::numeric_limits<float>::lowest()}
+    };
+}
+
+inline auto grow(AABB& box, const AABB& other) noexcept -> void {
+    box.min = glm::min(box.min, other.min);
+    box.max = glm::max(box.max, other.max);
+}
+
+[[nodiscard]]
+inline auto center(const AABB& box) noexcept -> glm::vec3 {
+    return (box.min + box.max) * 0.5f;
+}
+
+[[nodiscard]]
+inline auto surface_area(const AABB& box) noexcept -> float {
+    const glm::vec3 extent = glm::max(box.max - box.min, glm::vec3{0.f});
+    return 2.f * (extent.x * extent.y + extent.y * extent.z + extent.z * extent.x);
+}
+
+enum class Containment { OUTSIDE, INTERSECTS, INSIDE };
+
+[[nodiscard]]
+inline auto classify(const systems::SpatialIndex::Frustum& frustum, const AABB& box) noexcept -> Containment {
+    Containment result = Containment::INSIDE;
+
+    for (const auto& plane : frustum) {
+        const glm::vec3 normal{plane};
+
+        // Corner furthest along the plane normal, and the one opposite to it
+        const glm::vec3 positive = glm::mix(box.min, box.max, glm::greaterThanEqual(normal, glm::vec3{0.f}));
+        const glm::vec3 negative = glm::mix(box.max, box.min, glm::greaterThanEqual(normal, glm::vec3{0.f}));
+
+        if (glm::dot(normal, positive) + plane.w < 0.f) {
+            return Containment::OUTSIDE;
+        }
+        if (glm::dot(normal, negative) + plane.w < 0.f) {
+            result = Containment::INTERSECTS;
+        }
+    }
+
+    return result;
+}
+
+[[nodiscard]]
+inline auto classify(const glm::vec3& sphereCenter, float radius, const AABB& box) noexcept -> Containment {
+    const glm::vec3 closest = glm::clamp(sphereCenter, box.min, box.max);
+    const glm::vec3 toClosest = closest - sphereCenter;
+    if (glm::dot(toClosest, toClosest) > radius * radius) {
+        return Containment::OUTSIDE;
+    }
+
+    const glm::vec3 farthest = glm::max(glm::abs(box.min - sphereCenter), glm::abs(box.max - sphereCenter));
+    return glm::dot(farthest, farthest) <= radius * radius ? Containment::INSIDE : Containment::INTERSECTS;
+}
+
+/// @brief Distance along the ray to the box entry point, or nullopt if missed within maxDistance
+[[nodiscard]]
+inline auto intersect(
+    const glm::vec3& origin,
+    const glm::vec3& inverseDirection,
+    float maxDistance,
+    const AABB& box
+) noexcept -> std::optional<float> {
+    const glm::vec3 t0 = (box.min - origin) * inverseDirection;
+    const glm::vec3 t1 = (box.max - origin) * inverseDirection;
+
+    const glm::vec3 tNear = glm::min(t0, t1);
+    const glm::vec3 tFar = glm::max(t0, t1);
+
+    const float enter = std::max({tNear.x, tNear.y, tNear.z, 0.f});
+    const float exit = std::min({tFar.x, tFar.y, tFar.z, maxDistance});
+
+    if (enter > exit) {
+        return std::nullopt;
+    }
+    return enter;
+}
+
+} // namespace
+
+namespace systems {
+
+auto SpatialIndex::insert(const AABB& bounds) -> Handle
+{
+    Handle handle;
+
+    if (!m_freeHandles.empty()) {
+        handle = m_freeHandles.back();
+        m_freeHandles.pop_back();
+
+        m_bounds[handle] = bounds;
+        m_alive[handle] = 1;
+    } else {
+        handle = static_cast<Handle>(m_bounds.size());
+        m_bounds.push_back(bounds);
+        m_alive.push_back(1);
+        m_leaves.push_back(NO_NODE);
+    }
+
+    m_pendingInserts.push_back(handle);
+    return handle;
+}
+
+auto SpatialIndex::remove(Handle handle) -> void
+{
+    if (handle >= m_alive.size() || !m_alive[handle]) {
+        return;
+    }
+
+    m_alive[handle] = 0;
+    m_pendingRemovals.push_back(handle);
+}
+
+auto SpatialIndex::setBounds(Handle handle, const AABB& bounds) -> void
+{
+    m_bounds[handle] = bounds;
+    m_boundsDirty = true;
+}
+
+auto SpatialIndex::commit() -> void
+{
+    if (m_pendingInserts.empty() && m_pendingRemovals.empty() && !m_boundsDirty) {
+        return;
+    }
+
+    for (const Handle handle : m_pendingRemovals) {
+        remove_item(handle);
+
+        m_bounds[handle] = empty_box();
+        m_freeHandles.push_back(handle);
+    }
+    m_pendingRemovals.clear();
+
+    // Inserting one by one into an empty or much smaller tree costs more than building it
+    if (m_nodes.empty() || m_pendingInserts.size() > m_itemCount) {
+        build();
+        return;
+    }
+
+    for (const Handle handle : m_pendingInserts) {
+        // Removed again before this commit
+        if (m_alive[handle]) {
+            insert_item(handle);
+        }
+    }
+    m_pendingInserts.clear();
+
+    if (m_boundsDirty) {
+        refit();
+    }
+
+    if (relative_cost() > m_builtCost * REBUILD_COST_RATIO ||
+        m_unusedNodes > m_nodes.size() / 2 ||
+        m_unusedItems > m_items.size() / 2) {
+        build();
+    }
+}
+
+auto SpatialIndex::build() -> void
+{
+    m_items.clear();
+    m_nodes.clear();
+    m_pendingInserts.clear();
+
+    for (Handle handle = 0; handle < m_alive.size(); handle++) {
+        if (m_alive[handle]) {
+            m_items.push_back(handle);
+        }
+    }
+
+    m_itemCount = static_cast<uint32_t>(m_items.size());
+    m_unusedNodes = 0;
+    m_unusedItems = 0;
+    m_boundsDirty = false;
+
+    if (m_items.empty()) {
+        m_cost = 0.f;
+        m_builtCost = 0.f;
+        return;
+    }
+
+    m_nodes.reserve(2 * m_items.size());
+    m_centroids.resize(m_bounds.size());
+
+    Node root{empty_box(), 0, static_cast<uint32_t>(m_items.size()), NO_NODE};
+    for (const Handle handle : m_items) {
+        grow(root.bounds, m_bounds[handle]);
+        m_centroids[handle] = center(m_bounds[handle]);
+    }
+    m_nodes.push_back(root);
+
+    std::vector<uint32_t> stack{0};
+    while (!stack.empty()) {
+        const uint32_t nodeIndex = stack.back();
+        stack.pop_back();
+
+        split(nodeIndex);
+
+        const auto& node = m_nodes[nodeIndex];
+        if (node.count == 0) {
+            stack.push_back(node.first);
+            stack.push_back(node.first + 1);
+            continue;
+        }
+
+        for (uint32_t item = node.first; item < node.first + node.count; item++) {
+            m_leaves[m_items[item]] = nodeIndex;
+        }
+    }
+
+    m_cost = compute_cost();
+    m_builtCost = relative_cost();
+}
+
+auto SpatialIndex::refit() -> void
+{
+    for (size_t i = m_nodes.size(); i-- > 0;) {
+        auto& node = m_nodes[i];
+        if (node.first == UNUSED_NODE) {
+            continue;
+        }
+
+        node.bounds = empty_box();
+
+        if (node.count > 0) {
+            for (uint32_t item = node.first; item < node.first + node.count; item++) {
+                grow(node.bounds, m_bounds[m_items[item]]);
+            }
+        } else {
+            grow(node.bounds, m_nodes[node.first].bounds);
+            grow(node.bounds, m_nodes[node.first + 1].bounds);
+        }
+    }
+
+    m_cost = compute_cost();
+    m_boundsDirty = false;
+}
+
+auto SpatialIndex::queryFrustum(const Frustum& frustum, std::vector<Handle>& out) const -> void
+{
+    if (m_nodes.empty()) {
+        return;
+    }
+
+    // Second member marks subtrees already known to be fully inside
+    std::vector<std::pair<uint32_t, bool>> stack{{0, false}};
+
+    while (!stack.empty()) {
+        const auto [nodeIndex, inside] = stack.back();
+        stack.pop_back();
+
+        const auto& node = m_nodes[nodeIndex];
+
+        const Containment containment = inside ? Containment::INSIDE : classify(frustum, node.bounds);
+        if (containment == Containment::OUTSIDE) {
+            continue;
+        }
+
+        if (node.count == 0) {
+            const bool childrenInside = containment == Containment::INSIDE;
+            stack.emplace_back(node.first, childrenInside);
+            stack.emplace_back(node.first + 1, childrenInside);
+            continue;
+        }
+
+        for (uint32_t item = node.first; item < node.first + node.count; item++) {
+            const Handle handle = m_items[item];
+            if (containment == Containment::INSIDE || classify(frustum, m_bounds[handle]) != Containment::OUTSIDE) {
+                out.push_back(handle);
+            }
+        }
+    }
+}
+
+auto SpatialIndex::querySphere(const glm::vec3& sphereCenter, float radius, std::vector<Handle>& out) const -> void
+{
+    if (m_nodes.empty()) {
+        return;
+    }
+
+    std::vector<std::pair<uint32_t, bool>> stack{{0, false}};
+
+    while (!stack.empty()) {
+        const auto [nodeIndex, inside] = stack.back();
+        stack.pop_back();
+
+        const auto& node = m_nodes[nodeIndex];
+
+        const Containment containment = inside ? Containment::INSIDE : classify(sphereCenter, radius, node.bounds);
+        if (containment == Containment::OUTSIDE) {
+            continue;
+        }
+
+        if (node.count == 0) {
+            const bool childrenInside = containment == Containment::INSIDE;
+            stack.emplace_back(node.first, childrenInside);
+            stack.emplace_back(node.first + 1, childrenInside);
+            continue;
+        }
+
+        for (uint32_t item = node.first; item < node.first + node.count; item++) {
+            const Handle handle = m_items[item];
+            if (containment == Containment::INSIDE ||
+                classify(sphereCenter, radius, m_bounds[handle]) != Containment::OUTSIDE) {
+                out.push_back(handle);
+            }
+        }
+    }
+}
+
+auto SpatialIndex::queryRay(
+    const glm::vec3& origin,
+    const glm::vec3& direction,
+    float maxDistance
+) const -> std::optional<RayHit> {
+    if (m_nodes.empty()) {
+        return std::nullopt;
+    }
+
+    const glm::vec3 inverseDirection = 1.f / direction;
+    std::optional<RayHit> closest{};
+
+    std::vector<uint32_t> stack{0};
+    while (!stack.empty()) {
+        const auto& node = m_nodes[stack.back()];
+        stack.pop_back();
+
+        const float limit = closest ? closest->distance : maxDistance;
+        if (!intersect(origin, inverseDirection, limit, node.bounds)) {
+            continue;
+        }
+
+        if (node.count > 0) {
+            for (uint32_t item = node.first; item < node.first + node.count; item++) {
+                const Handle handle = m_items[item];
+                const auto distance = intersect(
+                    origin, inverseDirection, closest ? closest->distance : maxDistance, m_bounds[handle]
+                );
+
+                if (distance && (!closest || *distance < closest->distance)) {
+                    closest = RayHit{handle, *distance};
+                }
+            }
+            continue;
+        }
+
+        // Visit the nearer child first so the closest hit shrinks the search early
+        const auto nearDistance = intersect(origin, inverseDirection, limit, m_nodes[node.first].bounds);
+        const auto farDistance = intersect(origin, inverseDirection, limit, m_nodes[node.first + 1].bounds);
+
+        uint32_t nearChild = node.first;
+        uint32_t farChild = node.first + 1;
+        if (farDistance && (!nearDistance || *farDistance < *nearDistance)) {
+            std::swap(nearChild, farChild);
+        }
+
+        stack.push_back(farChild);
+        stack.push_back(nearChild);
+    }
+
+    return closest;
+}
+
+auto SpatialIndex::transform(const AABB& bounds, const glm::mat4& transform) noexcept -> AABB
+{
+    // Arvo's method, each matrix column stretches the box along the matching axis
+    const glm::vec3 translation{transform[3]};
+    AABB result{translation, translation};
+
+    for (int axis = 0; axis < 3; axis++) {
+        const glm::vec3 column{transform[axis]};
+        const glm::vec3 a = column * bounds.min[axis];
+        const glm::vec3 b = column * bounds.max[axis];
+
+        result.min += glm::min(a, b);
+        result.max += glm::max(a, b);
+    }
+
+    return result;
+}
+
+    /**   PRIVATE   **/
+
+auto SpatialIndex::split(uint32_t nodeIndex) -> void
+{
+    const Node node = m_nodes[nodeIndex];
+    if (node.count <= MAX_LEAF_ITEMS) {
+        return;
+    }
+
+    const auto begin = m_items.begin() + node.first;
+    const auto end = begin + node.count;
+
+    AABB centroidBounds = empty_box();
+    for (auto it = begin; it != end; ++it) {
+        centroidBounds.min = glm::min(centroidBounds.min, m_centroids[*it]);
+        centroidBounds.max = glm::max(centroidBounds.max, m_centroids[*it]);
+    }
+
+    // Binned SAH, the best plane over all axes wins
+    float bestCost = std::numeric_limits<float>::max();
+    int bestAxis = -1;
+    uint32_t bestBin = 0;
+
+    for (int axis = 0; axis < 3; axis++) {
+        const float extent = centroidBounds.max[axis] - centroidBounds.min[axis];
+        if (extent <= 0.f) {
+            continue;
+        }
+
+        const float scale = SAH_BINS / extent;
+        std::array<AABB, SAH_BINS> binBounds;
+        std::array<uint32_t, SAH_BINS> binCounts{};
+        binBounds.fill(empty_box());
+
+        for (auto it = begin; it != end; ++it) {
+            const auto& box = m_bounds[*it];
+            const auto bin = std::min(
+                static_cast<uint32_t>((m_centroids[*it][axis] - centroidBounds.min[axis]) * scale),
+                SAH_BINS - 1
+            );
+            binCounts[bin]++;
+            grow(binBounds[bin], box);
+        }
+
+        // Sweep from the right to get the cost of everything above each plane
+        std::array<float, SAH_BINS> rightCosts{};
+        AABB right = empty_box();
+        uint32_t rightCount = 0;
+        for (uint32_t bin = SAH_BINS - 1; bin > 0; bin--) {
+            grow(right, binBounds[bin]);
+            rightCount += binCounts[bin];
+            rightCosts[bin] = rightCount > 0 ? surface_area(right) * static_cast<float>(rightCount) : 0.f;
+        }
+
+        AABB left = empty_box();
+        uint32_t leftCount = 0;
+        for (uint32_t bin = 0; bin < SAH_BINS - 1; bin++) {
+            grow(left, binBounds[bin]);
+            leftCount += binCounts[bin];
+
+            if (leftCount == 0 || leftCount == node.count) {
+                continue;
+            }
+
+            const float cost = surface_area(left) * static_cast<float>(leftCount) + rightCosts[bin + 1];
+            if (cost < bestCost) {
+                bestCost = cost;
+                bestAxis = axis;
+                bestBin = bin + 1;
+            }
+        }
+    }
+
+    auto middle = begin;
+    if (bestAxis >= 0) {
+        const float scale = SAH_BINS / (centroidBounds.max[bestAxis] - centroidBounds.min[bestAxis]);
+        middle = std::partition(begin, end, [&](Handle handle) {
+            const auto bin = std::min(
+                static_cast<uint32_t>((m_centroids[handle][bestAxis] - centroidBounds.min[bestAxis]) * scale),
+                SAH_BINS - 1
+            );
+            return bin < bestBin;
+        });
+    }
+
+    // Every centroid in the same spot, split the range in half to bound the leaf size
+    if (middle == begin || middle == end) {
+        middle = begin + node.count / 2;
+    }
+
+    const auto leftCount = static_cast<uint32_t>(middle - begin);
+    const auto childIndex = static_cast<uint32_t>(m_nodes.size());
+
+    Node leftNode{empty_box(), node.first, leftCount, nodeIndex};
+    Node rightNode{empty_box(), node.first + leftCount, node.count - leftCount, nodeIndex};
+
+    for (auto it = begin; it != middle; ++it) {
+        grow(leftNode.bounds, m_bounds[*it]);
+    }
+    for (auto it = middle; it != end; ++it) {
+        grow(rightNode.bounds, m_bounds[*it]);
+    }
+
+    m_nodes.push_back(leftNode);
+    m_nodes.push_back(rightNode);
+
+    m_nodes[nodeIndex].first = childIndex;
+    m_nodes[nodeIndex].count = 0;
+}
+
+auto SpatialIndex::insert_item(Handle handle) -> void
+{
+    const AABB& box = m_bounds[handle];
+
+    // Every node on the way grows to hold the box, the child growing the least in surface area adds the least cost
+    uint32_t nodeIndex = 0;
+    while (true) {
+        auto& node = m_nodes[nodeIndex];
+        m_cost -= node_cost(node);
+        grow(node.bounds, box);
+
+        if (node.count > 0) {
+            break;
+        }
+        m_cost += node_cost(node);
+
+        AABB left = m_nodes[node.first].bounds;
+        AABB right = m_nodes[node.first + 1].bounds;
+        const float leftArea = surface_area(left);
+        const float rightArea = surface_area(right);
+        grow(left, box);
+        grow(right, box);
+
+        nodeIndex = surface_area(left) - leftArea <= surface_area(right) - rightArea ? node.first : node.first + 1;
+    }
+
+    // The leaf's range has to end at the array's end to grow, its previous slots are left unused
+    auto& leaf = m_nodes[nodeIndex];
+    if (leaf.first + leaf.count != m_items.size()) {
+        const auto first = static_cast<uint32_t>(m_items.size());
+        for (uint32_t item = leaf.first; item < leaf.first + leaf.count; item++) {
+            const Handle moved = m_items[item];
+            m_items.push_back(moved);
+        }
+
+        m_unusedItems += leaf.count;
+        leaf.first = first;
+    }
+
+    m_items.push_back(handle);
+    leaf.count++;
+    m_leaves[handle] = nodeIndex;
+    m_itemCount++;
+
+    if (leaf.count <= MAX_LEAF_ITEMS) {
+        m_cost += node_cost(leaf);
+        return;
+    }
+
+    // Split like build() does, the children are appended after every existing node
+    m_centroids.resize(m_bounds.size());
+    for (uint32_t item = leaf.first; item < leaf.first + leaf.count; item++) {
+        m_centroids[m_items[item]] = center(m_bounds[m_items[item]]);
+    }
+
+    split(nodeIndex);
+
+    const auto& node = m_nodes[nodeIndex];
+    m_cost += node_cost(node);
+    for (const uint32_t child : {node.first, node.first + 1}) {
+        const auto& childNode = m_nodes[child];
+        m_cost += node_cost(childNode);
+
+        for (uint32_t item = childNode.first; item < childNode.first + childNode.count; item++) {
+            m_leaves[m_items[item]] = child;
+        }
+    }
+}
+
+auto SpatialIndex::remove_item(Handle handle) -> void
+{
+    const uint32_t leafIndex = m_leaves[handle];
+    m_leaves[handle] = NO_NODE;
+
+    // Inserted & removed between two commits, never made it into the tree
+    if (leafIndex == NO_NODE) {
+        return;
+    }
+
+    // The last item of the leaf takes its place, the slot at the end of the range is left unused
+    auto& leaf = m_nodes[leafIndex];
+    const auto begin = m_items.begin() + leaf.first;
+    const auto end = begin + leaf.count;
+    std::iter_swap(std::find(begin, end, handle), end - 1);
+
+    m_cost -= node_cost(leaf);
+    leaf.count--;
+    m_itemCount--;
+    m_unusedItems++;
+
+    if (leaf.count > 0) {
+        m_cost += node_cost(leaf);
+        refit_path(leafIndex);
+        return;
+    }
+
+    // A leaf without items would read as an inner node, the last item empties the whole tree
+    if (leaf.parent == NO_NODE) {
+        m_nodes.clear();
+        m_items.clear();
+        m_unusedNodes = 0;
+        m_unusedItems = 0;
+        m_cost = 0.f;
+        return;
+    }
+
+    // The sibling takes the parent's place, its own children are stored after it so after the parent too
+    const uint32_t parentIndex = leaf.parent;
+    auto& parent = m_nodes[parentIndex];
+    const uint32_t siblingIndex = parent.first == leafIndex ? leafIndex + 1 : leafIndex - 1;
+    const uint32_t grandParentIndex = parent.parent;
+
+    m_cost -= node_cost(parent) + node_cost(m_nodes[siblingIndex]);
+    parent = m_nodes[siblingIndex];
+    parent.parent = grandParentIndex;
+    m_cost += node_cost(parent);
+    adopt(parentIndex);
+
+    for (const uint32_t unused : {leafIndex, siblingIndex}) {
+        m_nodes[unused] = Node{empty_box(), UNUSED_NODE, 0, NO_NODE};
+    }
+    m_unusedNodes += 2;
+
+    if (grandParentIndex != NO_NODE) {
+        refit_path(grandParentIndex);
+    }
+}
+
+auto SpatialIndex::refit_path(uint32_t nodeIndex) -> void
+{
+    while (nodeIndex != NO_NODE) {
+        auto& node = m_nodes[nodeIndex];
+
+        AABB bounds = empty_box();
+        if (node.count > 0) {
+            for (uint32_t item = node.first; item < node.first + node.count; item++) {
+                grow(bounds, m_bounds[m_items[item]]);
+            }
+        } else {
+            grow(bounds, m_nodes[node.first].bounds);
+            grow(bounds, m_nodes[node.first + 1].bounds);
+        }
+
+        // Ancestors of an unchanged node are unchanged too
+        if (bounds.min == node.bounds.min && bounds.max == node.bounds.max) {
+            return;
+        }
+
+        m_cost -= node_cost(node);
+        node.bounds = bounds;
+        m_cost += node_cost(node);
+
+        nodeIndex = node.parent;
+    }
+}
+
+auto SpatialIndex::adopt(uint32_t nodeIndex) -> void
+{
+    const auto& node = m_nodes[nodeIndex];
+
+    if (node.count > 0) {
+        for (uint32_t item = node.first; item < node.first + node.count; item++) {
+            m_leaves[m_items[item]] = nodeIndex;
+        }
+    } else {
+        m_nodes[node.first].parent = nodeIndex;
+        m_nodes[node.first + 1].parent = nodeIndex;
+    }
+}
+
+auto SpatialIndex::node_cost(const Node& node) noexcept -> float
+{
+    // Inner nodes cost 1 and leaves 1 per item, weighted by the chance of a ray or query reaching them
+    return surface_area(node.bounds) * static_cast<float>(std::max(node.count, 1u));
+}
+
+auto SpatialIndex::compute_cost() const -> float
+{
+    float cost = 0.f;
+    for (const auto& node : m_nodes) {
+        if (node.first != UNUSED_NODE) {
+            cost += node_cost(node);
+        }
+    }
+
+    return cost;
+}
+
+auto SpatialIndex::relative_cost() const noexcept -> float
+{
+    if (m_nodes.empty()) {
+        return 0.f;
+    }
+
+    // Expected traversal cost relative to the root
+    const float rootArea = surface_area(m_nodes.front().bounds);
+    return rootArea > 0.f ? m_cost / rootArea : m_cost;
+}
+
+} // namespace systems
@@ -0,0 +1,122 @@
+#include "systems/StagingRing.hpp"
+
+#include <algorithm>
+#include <cstring>
+#include <stdexcept>
+
+#include "systems/MemoryManager.hpp"
+
+namespace {
+
+[[nodiscard]]
+constexpr auto align_up(VkDeviceSize value, VkDeviceSize alignment) noexcept -> VkDeviceSize {
+    return (value + alignment - 1) / alignment * alignment;
+}
+
+} // namespace
+
+namespace systems {
+
+StagingRing::StagingRing(MemoryManager& memoryManager, UploadBatch& uploads, VkDeviceSize size)
+: m_uploads(uploads)
+, m_capacity(align_up(std::max<VkDeviceSize>(size, ALIGNMENT), ALIGNMENT))
+, m_buffer(memoryManager.createBuffer(m_capacity, core::memory::BufferType::STAGING))
+{}
+
+auto StagingRing::stage(const void* data, VkDeviceSize size) -> std::optional<VkDeviceSize>
+{
+    if (size > m_capacity / 2) {
+        return std::nullopt;
+    }
+
+    release(m_uploads.getCompletedSerial());
+    auto offset = try_allocate(size, m_uploads.getRecordingSerial());
+
+    if (!offset) {
+        // Overflow only: the space is held by the batches in flight and the one being recorded, this waits
+        // for their timeline value, not for the queue, and is counted as a stall
+        m_frameStats.stalls++;
+        m_uploads.submit();
+        m_uploads.wait();
+
+        release(m_uploads.getCompletedSerial());
+        offset = try_allocate(size, m_uploads.getRecordingSerial());
+
+        if (!offset) {
+            throw std::runtime_error("Staging ring is full after every upload batch completed.");
+        }
+    }
+
+    std::memcpy(static_cast<uint8_t*>(m_buffer.getMappedData()) + *offset, data, size);
+
+    m_frameStats.staged += size;
+    m_frameStats.highWater = std::max(m_frameStats.highWater, getUsed());
+
+    return offset;
+}
+
+auto StagingRing::endFrame() noexcept -> FrameStats
+{
+    const FrameStats stats = m_frameStats;
+    m_frameStats = FrameStats{.highWater = getUsed()};
+    return stats;
+}
+
+auto StagingRing::getUsed() const noexcept -> VkDeviceSize
+{
+    if (m_regions.empty()) {
+        return 0;
+    }
+
+    // Equal head & tail with regions in use is a full ring
+    return m_head > m_tail ? m_head - m_tail : m_capacity - m_tail + m_head;
+}
+
+    /**   PRIVATE   **/
+
+auto StagingRing::release(uint64_t completedSerial) noexcept -> void
+{
+    while (!m_regions.empty() && m_regions.front().serial <= completedSerial) {
+        m_tail = m_regions.front().end;
+        m_regions.pop_front();
+    }
+}
+
+auto StagingRing::try_allocate(VkDeviceSize size, uint64_t serial) noexcept -> std::optional<VkDeviceSize>
+{
+    if (m_regions.empty()) {
+        m_head = 0;
+        m_tail = 0;
+    }
+
+    const VkDeviceSize offset = align_up(m_head, ALIGNMENT);
+    std::optional<VkDeviceSize> start;
+
+    if (m_regions.empty() || m_head > m_tail) {
+        // Space in use is [tail, head), free after it and before it once wrapped around
+        if (offset + size <= m_capacity) {
+            start = offset;
+        } else if (size <= m_tail) {
+            start = 0;
+        }
+    } else if (offset + size <= m_tail) {
+        // Wrapped around, space in use is [tail, capacity) and [0, head)
+        start = offset;
+    }
+
+    if (!start) {
+        return std::nullopt;
+    }
+
+    m_head = *start + size;
+
+    if (!m_regions.empty() && m_regions.back().serial == serial) {
+        m_regions.back().end = m_head;
+    } else {
+        m_regions.push_back(Region{serial, m_head});
+    }
+
+    return start;
+}
+
+} // namespace systems
@@ -0,0 +1,345 @@
+#include "systems/UploadBatch.hpp"
+
+#include <stdexcept>
+#include <utility>
+
+#include "common/Profiler.hpp"
+#include "vulkan/api.hpp"
+
+namespace {
+
+// Everything reading uploaded buffers, on the owner queue
+constexpr VkPipelineStageFlags BUFFER_READ_STAGES =
+    VK_PIPELINE_STAGE_DRAW_INDIRECT_BIT | VK_PIPELINE_STAGE_VERTEX_INPUT_BIT |
+    VK_PIPELINE_STAGE_VERTEX_SHADER_BIT | VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT |
+    VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT;
+
+constexpr VkAccessFlags BUFFER_READ_ACCESS =
+    VK_ACCESS_VERTEX_ATTRIBUTE_READ_BIT | VK_ACCESS_INDEX_READ_BIT |
+    VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_INDIRECT_COMMAND_READ_BIT;
+
+} // namespace
+
+namespace systems {
+
+UploadBatch::UploadBatch(core::device::Device& device, core::sync::QueueTimeline& timeline, core::sync::QueueTimeline& ownerTimeline)
+: m_timeline(timeline)
+, m_ownerTimeline(ownerTimeline)
+, m_queue(timeline.getQueue())
+, m_ownerQueue(ownerTimeline.getQueue())
+, m_transfersOwnership(m_queue.familyIndex != m_ownerQueue.familyIndex)
+, m_completionTimeline(m_transfersOwnership ? ownerTimeline : timeline)
+, m_commandPool{device, m_queue.familyIndex, MAX_BATCHES_IN_FLIGHT}
+, m_acquirePool{device, m_ownerQueue.familyIndex, MAX_BATCHES_IN_FLIGHT}
+{}
+
+UploadBatch::~UploadBatch()
+{
+    // The command buffers may still be used by the GPU, batches complete in submission order
+    wait();
+}
+
+auto UploadBatch::copy(
+    core::memory::Buffer& srcBuffer,
+    core::memory::Buffer& dstBuffer,
+    VkDeviceSize size,
+    VkDeviceSize srcOffset,
+    VkDeviceSize dstOffset
+) -> void {
+    if (size == VK_WHOLE_SIZE) {
+        size = srcBuffer.getSize() - srcOffset;
+    }
+
+    begin_recording().copy(srcBuffer, dstBuffer, size, srcOffset, dstOffset);
+    m_commandCount++;
+    m_buffersWritten = true;
+
+    // Only the written range is handed over, the rest of the buffer may be in use by the owner
+    if (m_transfersOwnership) {
+        m_bufferAcquires.push_back(VkBufferMemoryBarrier{
+            .sType = VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER,
+            .pNext = nullptr,
+            .srcAccessMask = 0,
+            .dstAccessMask = BUFFER_READ_ACCESS,
+            .srcQueueFamilyIndex = m_queue.familyIndex,
+            .dstQueueFamilyIndex = m_ownerQueue.familyIndex,
+            .buffer = dstBuffer.getBuffer(),
+            .offset = dstOffset,
+            .size = size
+        });
+    }
+}
+
+auto UploadBatch::copy(
+    core::memory::Buffer& srcBuffer,
+    core::memory::Image& dstImage,
+    VkExtent3D extent,
+    VkDeviceSize srcOffset
+) -> void {
+    begin_recording().copy(srcBuffer, dstImage, extent, srcOffset);
+    m_commandCount++;
+}
+
+auto UploadBatch::transition(
+    core::memory::Image& image,
+    VkImageLayout oldLayout,
+    VkImageLayout newLayout
+) -> void {
+    VkImageMemoryBarrier barrier{};
+    barrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
+    barrier.oldLayout = oldLayout;
+    barrier.newLayout = newLayout;
+    barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+    barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+    barrier.image = image.getImage();
+    barrier.subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+    barrier.subresourceRange.baseMipLevel = 0;
+    barrier.subresourceRange.levelCount = 1;
+    barrier.subresourceRange.baseArrayLayer = 0;
+    barrier.subresourceRange.layerCount = 1;
+
+    VkPipelineStageFlags sourceStage;
+    VkPipelineStageFlags destinationStage;
+
+    if (oldLayout == VK_IMAGE_LAYOUT_UNDEFINED && newLayout == VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL) {
+        barrier.srcAccessMask = 0;
+        barrier.dstAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+
+        sourceStage = VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT;
+        destinationStage = VK_PIPELINE_STAGE_TRANSFER_BIT;
+    } else if (oldLayout == VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL && newLayout == VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL && m_transfersOwnership) {
+        // Released with the layout transition, the upload queue may not support the fragment stage
+        barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+        barrier.dstAccessMask = 0;
+        barrier.srcQueueFamilyIndex = m_queue.familyIndex;
+        barrier.dstQueueFamilyIndex = m_ownerQueue.familyIndex;
+
+        sourceStage = VK_PIPELINE_STAGE_TRANSFER_BIT;
+        destinationStage = VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT;
+
+        VkImageMemoryBarrier acquire = barrier;
+        acquire.srcAccessMask = 0;
+        acquire.dstAccessMask = VK_ACCESS_SHADER_READ_BIT;
+        m_imageAcquires.push_back(acquire);
+    } else if (oldLayout == VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL && newLayout == VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL) {
+        barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+        barrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT;
+
+        sourceStage = VK_PIPELINE_STAGE_TRANSFER_BIT;
+        destinationStage = VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT;
+    } else {
+        throw std::invalid_argument("unsupported layout transition!");
+    }
+
+    vulkan::CmdPipelineBarrier(
+        begin_recording().getCommandBuffer(),
+        sourceStage, destinationStage,
+        0,
+        0, nullptr,
+        0, nullptr,
+        1, &barrier
+    );
+    m_commandCount++;
+}
+
+auto UploadBatch::retain(core::memory::Buffer&& buffer) -> void
+{
+    if (m_recording) {
+        m_retained.push_back(std::move(buffer));
+    }
+}
+
+auto UploadBatch::submit() -> void
+{
+    if (!m_recording) {
+        return;
+    }
+
+    PROFILE_SCOPE("UploadBatch::submit");
+    const uint32_t slot = current_slot();
+    auto& cmdBuffer = m_commandPool.getCmdBuffer(slot);
+
+    if (m_transfersOwnership && !m_bufferAcquires.empty()) {
+        std::vector<VkBufferMemoryBarrier> releases = m_bufferAcquires;
+        for (auto& release : releases) {
+            release.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+            release.dstAccessMask = 0;
+        }
+
+        vulkan::CmdPipelineBarrier(
+            cmdBuffer.getCommandBuffer(),
+            VK_PIPELINE_STAGE_TRANSFER_BIT,
+            VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT,
+            0,
+            0, nullptr,
+            static_cast<uint32_t>(releases.size()), releases.data(),
+            0, nullptr
+        );
+    } else if (!m_transfersOwnership && m_buffersWritten) {
+        // Later submissions on the queue read the buffers without waiting on the timeline
+        const VkMemoryBarrier barrier{
+            .sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER,
+            .pNext = nullptr,
+            .srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT,
+            .dstAccessMask = BUFFER_READ_ACCESS
+        };
+
+        vulkan::CmdPipelineBarrier(
+            cmdBuffer.getCommandBuffer(),
+            VK_PIPELINE_STAGE_TRANSFER_BIT,
+            BUFFER_READ_STAGES,
+            0,
+            1, &barrier,
+            0, nullptr,
+            0, nullptr
+        );
+    }
+
+    const uint32_t submission = std::exchange(m_profilerSubmission, core::commands::GpuProfiler::NO_SUBMISSION);
+    if (m_profiler) {
+        m_profiler->endSubmission(cmdBuffer.getCommandBuffer(), submission);
+    }
+
+    cmdBuffer.end();
+
+    VkCommandBuffer commandBuffer = cmdBuffer.getCommandBuffer();
+    const uint64_t uploadValue = m_timeline.submit({
+        .commandBuffers = {&commandBuffer, 1}
+    });
+
+    m_submittedValue = m_transfersOwnership ? submit_acquire(uploadValue) : uploadValue;
+    m_slotValues[slot] = m_submittedValue;
+    m_bytesSubmitted += cmdBuffer.getStats().bytesCopied;
+
+    if (!m_retained.empty()) {
+        m_completionTimeline.onComplete(m_submittedValue, [buffers = std::move(m_retained)]() mutable {
+            buffers.clear();
+        });
+        m_retained.clear();
+    }
+
+    m_commandCount = 0;
+    m_recording = false;
+    m_buffersWritten = false;
+    m_submitCount++;
+}
+
+auto UploadBatch::discard() -> void
+{
+    if (!m_recording) {
+        return;
+    }
+
+    m_commandPool.getCmdBuffer(current_slot()).reset();
+    m_profilerSubmission = core::commands::GpuProfiler::NO_SUBMISSION;
+    m_retained.clear();
+    m_bufferAcquires.clear();
+    m_imageAcquires.clear();
+    m_commandCount = 0;
+    m_recording = false;
+    m_buffersWritten = false;
+}
+
+auto UploadBatch::wait() -> void
+{
+    if (m_submittedValue > 0) {
+        m_completionTimeline.wait(m_submittedValue);
+    }
+}
+
+auto UploadBatch::isComplete() const -> bool
+{
+    return m_submittedValue == 0 || m_completionTimeline.isComplete(m_submittedValue);
+}
+
+auto UploadBatch::getCompletedSerial() const -> uint64_t
+{
+    // Batches older than the ones in the slots were waited on before their slot was reused
+    const uint64_t oldest = m_submitCount > MAX_BATCHES_IN_FLIGHT ? m_submitCount - MAX_BATCHES_IN_FLIGHT : 0;
+
+    for (uint64_t serial = m_submitCount; serial > oldest; serial--) {
+        if (m_completionTimeline.isComplete(m_slotValues[(serial - 1) % MAX_BATCHES_IN_FLIGHT])) {
+            return serial;
+        }
+    }
+
+    return oldest;
+}
+
+    /**   PRIVATE   **/
+
+auto UploadBatch::begin_recording() -> core::commands::CommandBuffer&
+{
+    const uint32_t slot = current_slot();
+    auto& cmdBuffer = m_commandPool.getCmdBuffer(slot);
+    if (m_recording) {
+        return cmdBuffer;
+    }
+
+    // Only blocks once every slot is in flight, on the oldest batch
+    if (m_slotValues[slot] > 0) {
+        PROFILE_SCOPE("UploadBatch::wait_slot");
+        m_completionTimeline.wait(m_slotValues[slot]);
+    }
+
+    cmdBuffer.begin(true); // One-time submit
+
+    if (m_profiler) {
+        m_profilerSubmission = m_profiler->beginSubmission(cmdBuffer.getCommandBuffer(), m_queue.familyIndex, "upload");
+    }
+
+    // Earlier batches may still be running on the queue, their copies to the same destinations land first
+    const VkMemoryBarrier barrier{
+        .sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER,
+        .pNext = nullptr,
+        .srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT,
+        .dstAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT
+    };
+
+    vulkan::CmdPipelineBarrier(
+        cmdBuffer.getCommandBuffer(),
+        VK_PIPELINE_STAGE_TRANSFER_BIT,
+        VK_PIPELINE_STAGE_TRANSFER_BIT,
+        0,
+        1, &barrier,
+        0, nullptr,
+        0, nullptr
+    );
+    m_recording = true;
+
+    return cmdBuffer;
+}
+
+auto UploadBatch::submit_acquire(uint64_t uploadValue) -> uint64_t
+{
+    // Same slot as the upload, its previous acquire completed before the batch started recording
+    auto& cmdBuffer = m_acquirePool.getCmdBuffer(current_slot());
+    cmdBuffer.begin(true); // One-time submit
+
+    // The semaphore wait covers every stage, the barriers chain onto it
+    vulkan::CmdPipelineBarrier(
+        cmdBuffer.getCommandBuffer(),
+        VK_PIPELINE_STAGE_ALL_COMMANDS_BIT,
+        BUFFER_READ_STAGES,
+        0,
+        0, nullptr,
+        static_cast<uint32_t>(m_bufferAcquires.size()), m_bufferAcquires.data(),
+        static_cast<uint32_t>(m_imageAcquires.size()), m_imageAcquires.data()
+    );
+
+    cmdBuffer.end();
+
+    VkCommandBuffer commandBuffer = cmdBuffer.getCommandBuffer();
+    const uint64_t value = m_ownerTimeline.submit({
+        .commandBuffers = {&commandBuffer, 1},
+        .waitTimeline = m_timeline.getSemaphore(),
+        .waitValue = uploadValue
+    });
+
+    m_bufferAcquires.clear();
+    m_imageAcquires.clear();
+
+    return value;
+}
+
+} // namespace systems
@@ -138,6 +138,118 @@ void CmdDrawIndexed(
     );
 }
 
+void CmdDrawIndexedIndirect(
+    VkCommandBuffer                             commandBuffer,
+    VkBuffer                                    buffer,
+    VkDeviceSize                                offset,
+    uint32_t                                    drawCount,
+    uint32_t                                    stride,
+    const std::source_location&                 location)
+{
+    EXEC_VK_FUNCTION(
+        location,
+        "Failed to draw indexed indirect",
+        vkCmdDrawIndexedIndirect,
+        commandBuffer,
+        buffer,
+        offset,
+        drawCount,
+        stride
+    );
+}
+
+void CmdDrawIndexedIndirectCount(
+    VkCommandBuffer                             commandBuffer,
+    VkBuffer                                    buffer,
+    VkDeviceSize                                offset,
+    VkBuffer                                    countBuffer,
+    VkDeviceSize                                countBufferOffset,
+    uint32_t                                    maxDrawCount,
+    uint32_t                                    stride,
+    const std::source_location&                 location)
+{
+    EXEC_VK_FUNCTION(
+        location,
+        "Failed to draw indexed indirect count",
+        vkCmdDrawIndexedIndirectCount,
+        commandBuffer,
+        buffer,
+        offset,
+        countBuffer,
+        countBufferOffset,
+        maxDrawCount,
+        stride
+    );
+}
+
+void CmdDispatch(
+    VkCommandBuffer                             commandBuffer,
+    uint32_t                                    groupCountX,
+    uint32_t                                    groupCountY,
+    uint32_t                                    groupCountZ,
+    const std::source_location&                 location)
+{
+    EXEC_VK_FUNCTION(
+        location,
+        "Failed to dispatch compute work",
+        vkCmdDispatch,
+        commandBuffer,
+        groupCountX,
+        groupCountY,
+        groupCountZ
+    );
+}
+
+void CmdPipelineBarrier(
+    VkCommandBuffer                             commandBuffer,
+    VkPipelineStageFlags                        srcStageMask,
+    VkPipelineStageFlags                        dstStageMask,
+    VkDependencyFlags                           dependencyFlags,
+    uint32_t                                    memoryBarrierCount,
+    const VkMemoryBarrier*                      pMemoryBarriers,
+    uint32_t                                    bufferMemoryBarrierCount,
+    const VkBufferMemoryBarrier*                pBufferMemoryBarriers,
+    uint32_t                                    imageMemoryBarrierCount,
+    const VkImageMemoryBarrier*                 pImageMemoryBarriers,
+    const std::source_location&                 location)
+{
+    EXEC_VK_FUNCTION(
+        location,
+        "Failed to record pipeline barrier",
+        vkCmdPipelineBarrier,
+        commandBuffer,
+        srcStageMask,
+        dstStageMask,
+        dependencyFlags,
+        memoryBarrierCount,
+        pMemoryBarriers,
+        bufferMemoryBarrierCount,
+        pBufferMemoryBarriers,
+        imageMemoryBarrierCount,
+        pImageMemoryBarriers
+    );
+}
+
+void CmdFillBuffer(
+    VkCommandBuffer                             commandBuffer,
+    VkBuffer                                    dstBuffer,
+    VkDeviceSize                                dstOffset,
+    VkDeviceSize                                size,
+    uint32_t                                    data,
+    const std::source_location&                 location)
+{
+    EXEC_VK_FUNCTION(
+        location,
+        "Failed to fill buffer",
+        vkCmdFillBuffer,
+        commandBuffer,
+        dstBuffer,
+        dstOffset,
+        size,
+        data
+    );
+}
+
 void AcquireNextImageKHR(
     VkDevice                                    device,
     VkSwapchainKHR                              swapchain,
@@ -396,6 +508,49 @@ VkResult GetFenceStatus(
     );
 }
 
+VkResult WaitSemaphores(
+    VkDevice                                    device,
+    const VkSemaphoreWaitInfo*                  pWaitInfo,
+    uint64_t                                    timeout,
+    const std::source_location&                         )
+{
+    return vkWaitSemaphores(
+        device,
+        pWaitInfo,
+        timeout
+    );
+}
+
+void GetSemaphoreCounterValue(
+    VkDevice                                    device,
+    VkSemaphore                                 semaphore,
+    uint64_t*                                   pValue,
+    const std::source_location&                 location)
+{
+    EXEC_VK_FUNCTION(
+        location,
+        "Failed to get semaphore counter value",
+        vkGetSemaphoreCounterValue,
+        device,
+        semaphore,
+        pValue
+    );
+}
+
+void SignalSemaphore(
+    VkDevice                                    device,
+    const VkSemaphoreSignalInfo*                pSignalInfo,
+    const std::source_location&                 location)
+{
+    EXEC_VK_FUNCTION(
+        location,
+        "Failed to signal semaphore",
+        vkSignalSemaphore,
+        device,
+        pSignalInfo
+    );
+}
+
 
 // Device functions
 void EnumeratePhysicalDevices(
@@ -691,6 +846,22 @@ void GetSwapchainImagesKHR(
     );
 }
 
+void GetImageMemoryRequirements(
+    VkDevice                                    device,
+    VkImage                                     image,
+    VkMemoryRequirements*                       pMemoryRequirements,
+    const std::source_location&                 location)
+{
+    EXEC_VK_FUNCTION(
+        location,
+        "Failed to get image memory requirements",
+        vkGetImageMemoryRequirements,
+        device,
+        image,
+        pMemoryRequirements
+    );
+}
+
 void CreateImageView(
     VkDevice                                    device,
     const VkImageViewCreateInfo*                pCreateInfo,
@@ -899,6 +1070,22 @@ void DestroyCommandPool(
     );
 }
 
+void ResetCommandPool(
+    VkDevice                                    device,
+    VkCommandPool                               commandPool,
+    VkCommandPoolResetFlags                     flags,
+    const std::source_location&                 location)
+{
+    EXEC_VK_FUNCTION(
+        location,
+        "Failed to reset command pool",
+        vkResetCommandPool,
+        device,
+        commandPool,
+        flags
+    );
+}
+
 void AllocateCommandBuffers(
     VkDevice                                    device,
     const VkCommandBufferAllocateInfo*          pAllocateInfo,
@@ -1001,6 +1188,22 @@ void CmdEndRenderPass(
     );
 }
 
+void CmdExecuteCommands(
+    VkCommandBuffer                             commandBuffer,
+    uint32_t                                    commandBufferCount,
+    const VkCommandBuffer*                      pCommandBuffers,
+    const std::source_location&                 location)
+{
+    EXEC_VK_FUNCTION(
+        location,
+        "Failed to execute secondary command buffers",
+        vkCmdExecuteCommands,
+        commandBuffer,
+        commandBufferCount,
+        pCommandBuffers
+    );
+}
+
 void CmdBindPipeline(
     VkCommandBuffer                             commandBuffer,
     VkPipelineBindPoint                         pipelineBindPoint,
@@ -1182,6 +1385,28 @@ void CreateGraphicsPipelines(
     );
 }
 
+void CreateComputePipelines(
+    VkDevice                                    device,
+    VkPipelineCache                             pipelineCache,
+    uint32_t                                    createInfoCount,
+    const VkComputePipelineCreateInfo*          pCreateInfos,
+    const VkAllocationCallbacks*                pAllocator,
+    VkPipeline*                                 pPipelines,
+    const std::source_location&                 location)
+{
+    EXEC_VK_FUNCTION(
+        location,
+        "Failed to create compute pipelines",
+        vkCreateComputePipelines,
+        device,
+        pipelineCache,
+        createInfoCount,
+        pCreateInfos,
+        pAllocator,
+        pPipelines
+    );
+}
+
 void DestroyPipeline(
     VkDevice                                    device,
     VkPipeline                                  pipeline,
@@ -1444,4 +1669,158 @@ void DestroyImage(
     );
 }
 
+/// Query functions
+/// @see https://registry.khronos.org/vulkan/specs/latest/man/html/vkCreateQueryPool.html
+void CreateQueryPool(
+    VkDevice                                    device,
+    const VkQueryPoolCreateInfo*                pCreateInfo,
+    const VkAllocationCallbacks*                pAllocator,
+    VkQueryPool*                                pQueryPool,
+    const std::source_location&                 location)
+{
+    EXEC_VK_FUNCTION(
+        location,
+        "Failed to create query pool",
+        vkCreateQueryPool,
+        device,
+        pCreateInfo,
+        pAllocator,
+        pQueryPool
+    );
+}
+
+/// @see https://registry.khronos.org/vulkan/specs/latest/man/html/vkDestroyQueryPool.html
+void DestroyQueryPool(
+    VkDevice                                    device,
+    VkQueryPool                                 queryPool,
+    const VkAllocationCallbacks*                pAllocator,
+    const std::source_location&                 location)
+{
+    EXEC_VK_FUNCTION(
+        location,
+        "Failed to destroy query pool",
+        vkDestroyQueryPool,
+        device,
+        queryPool,
+        pAllocator
+    );
+}
+
+/// @see https://registry.khronos.org/vulkan/specs/latest/man/html/vkCmdResetQueryPool.html
+void CmdResetQueryPool(
+    VkCommandBuffer                             commandBuffer,
+    VkQueryPool                                 queryPool,
+    uint32_t                                    firstQuery,
+    uint32_t                                    queryCount,
+    const std::source_location&                 location)
+{
+    EXEC_VK_FUNCTION(
+        location,
+        "Failed to reset query pool",
+        vkCmdResetQueryPool,
+        commandBuffer,
+        queryPool,
+        firstQuery,
+        queryCount
+    );
+}
+
+/// @see https://registry.khronos.org/vulkan/specs/latest/man/html/vkResetQueryPool.html
+void ResetQueryPool(
+    VkDevice                                    device,
+    VkQueryPool                                 queryPool,
+    uint32_t                                    firstQuery,
+    uint32_t                                    queryCount,
+    const std::source_location&                 location)
+{
+    EXEC_VK_FUNCTION(
+        location,
+        "Failed to reset query pool",
+        vkResetQueryPool,
+        device,
+        queryPool,
+        firstQuery,
+        queryCount
+    );
+}
+
+/// @see https://registry.khronos.org/vulkan/specs/latest/man/html/vkCmdWriteTimestamp.html
+void CmdWriteTimestamp(
+    VkCommandBuffer                             commandBuffer,
+    VkPipelineStageFlagBits                     pipelineStage,
+    VkQueryPool                                 queryPool,
+    uint32_t                                    query,
+    const std::source_location&                 location)
+{
+    EXEC_VK_FUNCTION(
+        location,
+        "Failed to write timestamp",
+        vkCmdWriteTimestamp,
+        commandBuffer,
+        pipelineStage,
+        queryPool,
+        query
+    );
+}
+
+/// @see https://registry.khronos.org/vulkan/specs/latest/man/html/vkCmdBeginQuery.html
+void CmdBeginQuery(
+    VkCommandBuffer                             commandBuffer,
+    VkQueryPool                                 queryPool,
+    uint32_t                                    query,
+    VkQueryControlFlags                         flags,
+    const std::source_location&                 location)
+{
+    EXEC_VK_FUNCTION(
+        location,
+        "Failed to begin query",
+        vkCmdBeginQuery,
+        commandBuffer,
+        queryPool,
+        query,
+        flags
+    );
+}
+
+/// @see https://registry.khronos.org/vulkan/specs/latest/man/html/vkCmdEndQuery.html
+void CmdEndQuery(
+    VkCommandBuffer                             commandBuffer,
+    VkQueryPool                                 queryPool,
+    uint32_t                                    query,
+    const std::source_location&                 location)
+{
+    EXEC_VK_FUNCTION(
+        location,
+        "Failed to end query",
+        vkCmdEndQuery,
+        commandBuffer,
+        queryPool,
+        query
+    );
+}
+
+/// @see https://registry.khronos.org/vulkan/specs/latest/man/html/vkGetQueryPoolResults.html
+VkResult GetQueryPoolResults(
+    VkDevice                                    device,
+    VkQueryPool                                 queryPool,
+    uint32_t                                    firstQuery,
+    uint32_t                                    queryCount,
+    size_t                                      dataSize,
+    void*                                       pData,
+    VkDeviceSize                                stride,
+    VkQueryResultFlags                          flags,
+    const std::source_location&                         )
+{
+    return vkGetQueryPoolResults(
+        device,
+        queryPool,
+        firstQuery,
+        queryCount,
+        dataSize,
+        pData,
+        stride,
+        flags
+    );
+}
+
 } // namespace vulkan
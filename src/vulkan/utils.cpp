@@ -2,6 +2,7 @@
 
 #include <iostream>
 #include <format>
+#include <stdexcept>
 
 namespace {
 
@@ -160,4 +161,31 @@ auto get_default_validation_layers() noexcept -> std::vector<const char*> {
     };
 }
 
+[[nodiscard]]
+auto get_format_size(const VkFormat format) -> uint32_t {
+    switch (format) {
+        case VK_FORMAT_R8_UNORM:
+        case VK_FORMAT_R8_SRGB:
+            return 1;
+        case VK_FORMAT_R8G8_UNORM:
+        case VK_FORMAT_R8G8_SRGB:
+        case VK_FORMAT_R16_SFLOAT:
+            return 2;
+        case VK_FORMAT_R8G8B8A8_UNORM:
+        case VK_FORMAT_R8G8B8A8_SRGB:
+        case VK_FORMAT_B8G8R8A8_UNORM:
+        case VK_FORMAT_B8G8R8A8_SRGB:
+        case VK_FORMAT_R32_SFLOAT:
+        case VK_FORMAT_D32_SFLOAT:
+            return 4;
+        case VK_FORMAT_R16G16B16A16_SFLOAT:
+        case VK_FORMAT_R32G32_SFLOAT:
+            return 8;
+        case VK_FORMAT_R32G32B32A32_SFLOAT:
+            return 16;
+        default:
+            throw std::invalid_argument(std::format("Unsupported format {} for texel size.", static_cast<int>(format)));
+    }
+}
+
 } // namespace vulkan